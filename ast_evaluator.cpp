@@ -0,0 +1,734 @@
+#include "ast_evaluator.h"
+#include "type_checking.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  
+
+static double EvalConst (EvalProgram* program, const EvalNode* node)
+{
+    (void) program;
+    return node->value;
+}
+
+static double EvalLoad (EvalProgram* program, const EvalNode* node)
+{
+    return program->slots[node->slot];
+}
+
+#define EVAL_BINARY(name, op)                                                   \
+    static double Eval##name (EvalProgram* program, const EvalNode* node)       \
+    {                                                                           \
+        double a = node->left->expr (program, node->left);                      \
+        double b = node->right->expr (program, node->right);                    \
+        return a op b;                                                          \
+    }                                                                           \
+                                                                                \
+    static double Eval##name##Const (EvalProgram* program, const EvalNode* node) \
+    {                                                                           \
+        return node->left->expr (program, node->left) op node->value;           \
+    }                                                                           \
+                                                                                \
+    static double Eval##name##Slots (EvalProgram* program, const EvalNode* node) \
+    {                                                                           \
+        return program->slots[node->slot] op program->slots[node->right_slot];  \
+    }
+
+EVAL_BINARY (Add, +)
+EVAL_BINARY (Sub, -)
+EVAL_BINARY (Mul, *)
+EVAL_BINARY (Div, /)
+EVAL_BINARY (Gt,  >)
+EVAL_BINARY (Lt,  <)
+EVAL_BINARY (Eq,  ==)
+EVAL_BINARY (Ne,  !=)
+
+#undef EVAL_BINARY
+
+//    double ;    32 ,  IADD..IDIV
+static double EvalWrapInt (long long value)
+{
+    return (int) (unsigned) value;
+}
+
+static double EvalIntegerDivide (EvalProgram* program, double a, double b)
+{
+    if (b == 0)
+    {
+        program->failed = 1;
+        program->error = "   ";
+        return 0;
+    }
+
+    return EvalWrapInt ((long long) a / (long long) b);
+}
+
+#define EVAL_INT_BINARY(name, result)                                           \
+    static double Eval##name (EvalProgram* program, const EvalNode* node)       \
+    {                                                                           \
+        double a = node->left->expr (program, node->left);                      \
+        double b = node->right->expr (program, node->right);                    \
+        return result;                                                          \
+    }                                                                           \
+                                                                                \
+    static double Eval##name##Const (EvalProgram* program, const EvalNode* node) \
+    {                                                                           \
+        double a = node->left->expr (program, node->left);                      \
+        double b = node->value;                                                 \
+        return result;                                                          \
+    }                                                                           \
+                                                                                \
+    static double Eval##name##Slots (EvalProgram* program, const EvalNode* node) \
+    {                                                                           \
+        double a = program->slots[node->slot];                                  \
+        double b = program->slots[node->right_slot];                            \
+        return result;                                                          \
+    }
+
+EVAL_INT_BINARY (IAdd, EvalWrapInt ((long long) a + (long long) b))
+EVAL_INT_BINARY (ISub, EvalWrapInt ((long long) a - (long long) b))
+EVAL_INT_BINARY (IMul, EvalWrapInt ((long long) a * (long long) b))
+EVAL_INT_BINARY (IDiv, EvalIntegerDivide (program, a, b))
+
+#undef EVAL_INT_BINARY
+
+//      ,  FTOI/ITOB
+static double EvalToInt (EvalProgram* program, const EvalNode* node)
+{
+    return ConvertValue (node->left->expr (program, node->left), NODE_TYPE_INT);
+}
+
+static double EvalToChar (EvalProgram* program, const EvalNode* node)
+{
+    return ConvertValue (node->left->expr (program, node->left), NODE_TYPE_CHAR);
+}
+
+//      ( ), slot -  ;
+//   
+static void EvalArguments (EvalProgram* program, const EvalNode* arg, double* args)
+{
+    for (; arg; arg = arg->right)
+        args[arg->slot] = arg->left->expr (program, arg->left);
+}
+
+//      :   
+//   ,     
+static int EnterEvalFunction (EvalProgram* program, const EvalFunction* func, const double* args)
+{
+    if (program->saved_count + func->local_count > program->saved_capacity)
+    {
+        int new_capacity = program->saved_capacity ? program->saved_capacity * 2 : 64;
+        while (new_capacity < program->saved_count + func->local_count)
+            new_capacity *= 2;
+
+        double* new_saved = (double*) realloc (program->saved_locals, new_capacity * sizeof(double));
+        if (!new_saved)
+        {
+            program->failed = 1;
+            program->error = "    ";
+            return 0;
+        }
+
+        program->saved_locals = new_saved;
+        program->saved_capacity = new_capacity;
+    }
+
+    for (int i = 0; i < func->local_count; i++)
+        program->saved_locals[program->saved_count++] = program->slots[func->local_slots[i]];
+
+    for (int i = 0; i < func->param_count; i++)
+        program->slots[func->param_slots[i]] = args[i];
+
+    return 1;
+}
+
+static void LeaveEvalFunction (EvalProgram* program, const EvalFunction* func)
+{
+    for (int i = func->local_count - 1; i >= 0; i--)
+        program->slots[func->local_slots[i]] = program->saved_locals[--program->saved_count];
+}
+
+static double EvalCall (EvalProgram* program, const EvalNode* node)
+{
+    double args[MAX_FUNC_PARAMS] = {};
+    EvalArguments (program, node->left, args);
+
+    if (program->call_depth >= EVAL_MAX_CALL_DEPTH)
+    {
+        program->failed = 1;
+        program->error = "  ";
+        return 0;
+    }
+
+    const EvalFunction* func = &program->funcs[node->func];
+    if (!EnterEvalFunction (program, func, args)) return 0;
+
+    program->call_depth++;
+    int status = func->body ? func->body->stmt (program, func->body) : EVAL_NEXT;
+
+    //    ,  C-  
+    while (status == EVAL_TAIL_CALL)
+    {
+        LeaveEvalFunction (program, func);
+        func = &program->funcs[program->tail_func];
+        if (!EnterEvalFunction (program, func, program->tail_args))
+        {
+            program->call_depth--;
+            return 0;
+        }
+        status = func->body ? func->body->stmt (program, func->body) : EVAL_NEXT;
+    }
+
+    LeaveEvalFunction (program, func);
+    program->call_depth--;
+
+    //   return,  PUSH 0 / RET   
+    return status == EVAL_RETURNED ? program->return_value : 0;
+}
+
+static double EvalMissingCall (EvalProgram* program, const EvalNode* node)
+{
+    (void) program;
+    (void) node;
+    return 0;
+}
+
+//  
+
+static int EvalNop (EvalProgram* program, const EvalNode* node)
+{
+    (void) program;
+    (void) node;
+    return EVAL_NEXT;
+}
+
+static int EvalSequence (EvalProgram* program, const EvalNode* node)
+{
+    int status = node->left->stmt (program, node->left);
+    if (status != EVAL_NEXT) return status;
+
+    return node->right->stmt (program, node->right);
+}
+
+static int EvalExpressionStatement (EvalProgram* program, const EvalNode* node)
+{
+    node->left->expr (program, node->left);
+    return EVAL_NEXT;
+}
+
+static int EvalStore (EvalProgram* program, const EvalNode* node)
+{
+    program->slots[node->slot] = node->left->expr (program, node->left);
+    return EVAL_NEXT;
+}
+
+static int EvalIf (EvalProgram* program, const EvalNode* node)
+{
+    if (node->left->expr (program, node->left) != 0)
+        return node->right->stmt (program, node->right);
+
+    return EVAL_NEXT;
+}
+
+static int EvalWhile (EvalProgram* program, const EvalNode* node)
+{
+    while (node->left->expr (program, node->left) != 0)
+    {
+        int status = node->right->stmt (program, node->right);
+        if (status != EVAL_NEXT) return status;
+        if (program->failed) return EVAL_RETURNED;
+    }
+
+    return EVAL_NEXT;
+}
+
+static int EvalReturn (EvalProgram* program, const EvalNode* node)
+{
+    program->return_value = node->left ? node->left->expr (program, node->left) : 0;
+    return EVAL_RETURNED;
+}
+
+//       tail_args,     
+static int EvalTailCall (EvalProgram* program, const EvalNode* node)
+{
+    double args[MAX_FUNC_PARAMS] = {};
+    EvalArguments (program, node->left, args);
+
+    memcpy (program->tail_args, args, sizeof(args));
+    program->tail_func = node->func;
+    return EVAL_TAIL_CALL;
+}
+
+// 
+
+static int CountNodes (Node* node)
+{
+    if (!node) return 0;
+    return 1 + CountNodes (node->left) + CountNodes (node->right);
+}
+
+static int GrowArray (void** array, int* capacity, int count, size_t element_size)
+{
+    if (count < *capacity) return 1;
+
+    int new_capacity = *capacity ? *capacity * 2 : 8;
+    void* new_array = realloc (*array, new_capacity * element_size);
+    if (!new_array) return 0;
+
+    *array = new_array;
+    *capacity = new_capacity;
+    return 1;
+}
+
+static int NewSlot (EvalProgram* program, const char* name, int owner)
+{
+    if (!GrowArray ((void**) &program->slot_names, &program->slot_capacity,
+                    program->slot_count, sizeof(char*)))
+        return 0;
+
+    // slot_owners    slot_names,    
+    int* new_owners = (int*) realloc (program->slot_owners, program->slot_capacity * sizeof(int));
+    if (!new_owners) return 0;
+    program->slot_owners = new_owners;
+
+    program->slot_names[program->slot_count] = strdup (name);
+    program->slot_owners[program->slot_count] = owner;
+    return program->slot_count++;
+}
+
+static int FindSlot (EvalProgram* program, const char* name, int owner)
+{
+    for (int i = 0; i < program->slot_count; i++)
+    {
+        if (program->slot_owners[i] == owner && strcmp (program->slot_names[i], name) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+//  ,     :     ,
+// ,       , - 
+static int BindSlot (EvalProgram* program, const char* name)
+{
+    int slot = program->compile_func >= 0 ? FindSlot (program, name, program->compile_func) : -1;
+    if (slot < 0)
+        slot = FindSlot (program, name, -1);
+
+    return slot >= 0 ? slot : NewSlot (program, name, -1);
+}
+
+//       ,   - 
+static int DeclareSlot (EvalProgram* program, const char* name)
+{
+    int slot = FindSlot (program, name, program->compile_func);
+    return slot >= 0 ? slot : NewSlot (program, name, program->compile_func);
+}
+
+static int FindEvalFunction (EvalProgram* program, const char* name)
+{
+    for (int i = 0; i < program->func_count; i++)
+    {
+        if (strcmp (program->funcs[i].name, name) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+static void CollectEvalFunctions (EvalProgram* program, Node* node)
+{
+    if (!node) return;
+
+    if (node->type == NODE_FUNC_DECL)
+    {
+        if (FindEvalFunction (program, node->data.string_value) >= 0) return;
+        if (!GrowArray ((void**) &program->funcs, &program->func_capacity,
+                        program->func_count, sizeof(EvalFunction)))
+            return;
+
+        EvalFunction* func = &program->funcs[program->func_count];
+        func->name = strdup (node->data.string_value);
+        func->body = NULL;
+        func->param_count = 0;
+        func->local_slots = NULL;
+        func->local_count = 0;
+        func->return_type = DeclaredType (node->data.type_value);
+
+        program->compile_func = program->func_count;
+        for (Node* param = node->left; param && func->param_count < MAX_FUNC_PARAMS; param = param->right)
+        {
+            func->param_types[func->param_count] = DeclaredType (param->data.type_value);
+            func->param_slots[func->param_count++] = DeclareSlot (program, param->data.string_value);
+        }
+        program->compile_func = -1;
+
+        program->func_count++;
+        return;
+    }
+
+    if (node->type == NODE_SEQUENCE)
+    {
+        CollectEvalFunctions (program, node->left);
+        CollectEvalFunctions (program, node->right);
+    }
+}
+
+//      ,     
+static EvalNode* NewEvalNode (EvalProgram* program)
+{
+    EvalNode* node = &program->nodes[program->node_count++];
+    memset (node, 0, sizeof(*node));
+    node->stmt = EvalNop;
+    node->expr = EvalConst;
+    return node;
+}
+
+static const EvalNode* CompileExpression (EvalProgram* program, Node* node);
+static const EvalNode* CompileArguments (EvalProgram* program, Node* call, const EvalFunction* func);
+
+//     double,     
+struct EvalBinaryHandlers
+{
+    NodeType type;
+    int integer;
+    EvalExprFn generic;
+    EvalExprFn with_const;
+    EvalExprFn with_slots;
+};
+
+static const EvalBinaryHandlers eval_binary_handlers[] =
+{
+    {NODE_ADD, 0, EvalAdd,  EvalAddConst,  EvalAddSlots},
+    {NODE_SUB, 0, EvalSub,  EvalSubConst,  EvalSubSlots},
+    {NODE_MUL, 0, EvalMul,  EvalMulConst,  EvalMulSlots},
+    {NODE_DIV, 0, EvalDiv,  EvalDivConst,  EvalDivSlots},
+    {NODE_ADD, 1, EvalIAdd, EvalIAddConst, EvalIAddSlots},
+    {NODE_SUB, 1, EvalISub, EvalISubConst, EvalISubSlots},
+    {NODE_MUL, 1, EvalIMul, EvalIMulConst, EvalIMulSlots},
+    {NODE_DIV, 1, EvalIDiv, EvalIDivConst, EvalIDivSlots},
+    {NODE_GT,  0, EvalGt,   EvalGtConst,   EvalGtSlots},
+    {NODE_LT,  0, EvalLt,   EvalLtConst,   EvalLtSlots},
+    {NODE_EQ,  0, EvalEq,   EvalEqConst,   EvalEqSlots},
+    {NODE_NE,  0, EvalNe,   EvalNeConst,   EvalNeSlots},
+    {NODE_GT,  1, EvalGt,   EvalGtConst,   EvalGtSlots},
+    {NODE_LT,  1, EvalLt,   EvalLtConst,   EvalLtSlots},
+    {NODE_EQ,  1, EvalEq,   EvalEqConst,   EvalEqSlots},
+    {NODE_NE,  1, EvalNe,   EvalNeConst,   EvalNeSlots},
+};
+
+//   "x op 5"  "x op y"      
+static const EvalNode* CompileBinary (EvalProgram* program, Node* node, const EvalBinaryHandlers* handlers)
+{
+    EvalNode* result = NewEvalNode (program);
+    Node* left = node->left;
+    Node* right = node->right;
+
+    if (left && right && right->type == NODE_NUMBER)
+    {
+        result->expr = handlers->with_const;
+        result->left = CompileExpression (program, left);
+        result->value = right->data.number_value;
+        return result;
+    }
+
+    if (left && right && left->type == NODE_VARIABLE && right->type == NODE_VARIABLE)
+    {
+        result->expr = handlers->with_slots;
+        result->slot = BindSlot (program, left->data.string_value);
+        result->right_slot = BindSlot (program, right->data.string_value);
+        return result;
+    }
+
+    result->expr = handlers->generic;
+    result->left = CompileExpression (program, left);
+    result->right = CompileExpression (program, right);
+    return result;
+}
+
+static const EvalNode* CompileExpression (EvalProgram* program, Node* node)
+{
+    EvalNode* result = NULL;
+
+    if (!node)
+    {
+        result = NewEvalNode (program);
+        result->expr = EvalConst;
+        return result;
+    }
+
+    int integer = IsIntegerType (OperandType (node));
+
+    for (size_t i = 0; i < sizeof(eval_binary_handlers) / sizeof(eval_binary_handlers[0]); i++)
+    {
+        if (eval_binary_handlers[i].type == node->type && eval_binary_handlers[i].integer == integer)
+            return CompileBinary (program, node, &eval_binary_handlers[i]);
+    }
+
+    result = NewEvalNode (program);
+
+    switch (node->type)
+    {
+        case NODE_NUMBER:
+            result->expr = EvalConst;
+            result->value = node->data.number_value;
+            break;
+
+        case NODE_VARIABLE:
+            result->expr = EvalLoad;
+            result->slot = BindSlot (program, node->data.string_value);
+            break;
+
+        case NODE_FUNC_CALL:
+            result->func = FindEvalFunction (program, node->data.string_value);
+            result->expr = result->func >= 0 ? EvalCall : EvalMissingCall;
+            if (result->func >= 0)
+                result->left = CompileArguments (program, node, &program->funcs[result->func]);
+            break;
+
+        default:
+            fprintf (stderr, "Eval:    %d\n", node->type);
+            program->failed = 1;
+            break;
+    }
+
+    return result;
+}
+
+//   type:  ,  -  
+static const EvalNode* CompileTyped (EvalProgram* program, Node* node, NodeType type)
+{
+    const EvalNode* value = CompileExpression (program, node);
+
+    NodeType from = ExpressionType (node);
+    type = DeclaredType (type);
+
+    if (from == type || type == NODE_TYPE_DOUBLE || (from == NODE_TYPE_CHAR && type == NODE_TYPE_INT))
+        return value;
+
+    EvalNode* result = NewEvalNode (program);
+    result->expr = type == NODE_TYPE_INT ? EvalToInt : EvalToChar;
+    result->left = value;
+    return result;
+}
+
+//     -   ;    
+static const EvalNode* CompileArguments (EvalProgram* program, Node* call, const EvalFunction* func)
+{
+    const EvalNode* chain = NULL;
+
+    for (int i = 0; i < func->param_count; i++)
+    {
+        Node* arg = NthArgument (call, i);
+        if (!arg) continue;
+
+        EvalNode* link = NewEvalNode (program);
+        link->slot = i;
+        link->left = CompileTyped (program, arg, func->param_types[i]);
+        link->right = chain;
+        chain = link;
+    }
+
+    return chain;
+}
+
+static const EvalNode* CompileStatement (EvalProgram* program, Node* node)
+{
+    EvalNode* result = NewEvalNode (program);
+    if (!node) return result;
+
+    switch (node->type)
+    {
+        case NODE_SEQUENCE:
+            result->stmt = EvalSequence;
+            result->left = CompileStatement (program, node->left);
+            result->right = CompileStatement (program, node->right);
+            break;
+
+        case NODE_ASSIGNMENT:
+            if (node->left && node->left->type == NODE_VARIABLE)
+            {
+                result->stmt = EvalStore;
+                result->slot = BindSlot (program, node->left->data.string_value);
+            }
+            else
+                result->stmt = EvalExpressionStatement;
+
+            result->left = CompileTyped (program, node->right, ExpressionType (node->left));
+            break;
+
+        case NODE_VAR_DECL:
+            result->slot = DeclareSlot (program, node->data.string_value);
+            if (node->left)
+            {
+                result->stmt = EvalStore;
+                result->left = CompileTyped (program, node->left, node->data.type_value);
+            }
+            break;
+
+        case NODE_IF:
+            result->stmt = EvalIf;
+            result->left = CompileExpression (program, node->left);
+            result->right = CompileStatement (program, node->right);
+            break;
+
+        case NODE_WHILE:
+            result->stmt = EvalWhile;
+            result->left = CompileExpression (program, node->left);
+            result->right = CompileStatement (program, node->right);
+            break;
+
+        case NODE_RETURN:
+            //     ,    
+            if (node->left && node->left->type == NODE_FUNC_CALL &&
+                ExpressionType (node->left) == program->compile_return_type)
+            {
+                result->func = FindEvalFunction (program, node->left->data.string_value);
+                if (result->func >= 0)
+                {
+                    result->stmt = EvalTailCall;
+                    result->left = CompileArguments (program, node->left, &program->funcs[result->func]);
+                    break;
+                }
+            }
+
+            result->stmt = EvalReturn;
+            if (node->left)
+                result->left = CompileTyped (program, node->left, program->compile_return_type);
+            break;
+
+        case NODE_FUNC_DECL:
+        {
+            int func = FindEvalFunction (program, node->data.string_value);
+            if (func < 0) break;
+
+            program->compile_return_type = program->funcs[func].return_type;
+            program->compile_func = func;
+            program->funcs[func].body = CompileStatement (program, node->right);
+            program->compile_return_type = NODE_TYPE_DOUBLE;
+            program->compile_func = -1;
+            break;
+        }
+
+        case NODE_EMPTY:
+            break;
+
+        default:
+            result->stmt = EvalExpressionStatement;
+            result->left = CompileExpression (program, node);
+            break;
+    }
+
+    return result;
+}
+
+//   ,   ;     
+static int CollectLocalSlots (EvalProgram* program)
+{
+    for (int f = 0; f < program->func_count; f++)
+    {
+        EvalFunction* func = &program->funcs[f];
+
+        func->local_slots = (int*) malloc ((program->slot_count + 1) * sizeof(int));
+        if (!func->local_slots) return 0;
+
+        for (int i = 0; i < program->slot_count; i++)
+        {
+            if (program->slot_owners[i] == f)
+                func->local_slots[func->local_count++] = i;
+        }
+    }
+
+    return 1;
+}
+
+EvalProgram* CompileEvalProgram (Node* root)
+{
+    if (!root) return NULL;
+
+    EvalProgram* program = (EvalProgram*) calloc (1, sizeof(EvalProgram));
+    if (!program) return NULL;
+
+    //    AST    EvalNode,     NULL-
+    //    
+    program->node_capacity = 3 * CountNodes (root) + 1;
+    program->nodes = (EvalNode*) calloc (program->node_capacity, sizeof(EvalNode));
+    if (!program->nodes)
+    {
+        FreeEvalProgram (program);
+        return NULL;
+    }
+
+    program->compile_return_type = NODE_TYPE_DOUBLE;
+    program->compile_func = -1;
+    CollectEvalFunctions (program, root);
+
+    program->entry_is_function = FirstFunction (root) != NULL;
+    program->entry = CompileStatement (program, root);
+
+    program->slots = (double*) calloc (program->slot_count + 1, sizeof(double));
+    if (!program->slots || program->failed || !CollectLocalSlots (program))
+    {
+        FreeEvalProgram (program);
+        return NULL;
+    }
+
+    return program;
+}
+
+void FreeEvalProgram (EvalProgram* program)
+{
+    if (!program) return;
+
+    for (int i = 0; i < program->slot_count; i++)
+        free (program->slot_names[i]);
+
+    for (int i = 0; i < program->func_count; i++)
+    {
+        free (program->funcs[i].name);
+        free (program->funcs[i].local_slots);
+    }
+
+    free (program->slot_names);
+    free (program->slot_owners);
+    free (program->slots);
+    free (program->saved_locals);
+    free (program->funcs);
+    free (program->nodes);
+    free (program);
+}
+
+//      : CALL :func_0 / OUT / HLT
+int RunEvalProgram (EvalProgram* program, FILE* out)
+{
+    if (!program) return 0;
+
+    memset (program->slots, 0, program->slot_count * sizeof(double));
+    program->call_depth = 0;
+    program->saved_count = 0;
+    program->failed = 0;
+    program->error = NULL;
+
+    if (program->entry_is_function)
+    {
+        EvalNode call = {};
+        call.func = 0;
+
+        double result = EvalCall (program, &call);
+        if (out && !program->failed)
+        {
+            if (IsIntegerType (program->funcs[0].return_type))
+                fprintf (out, "%lld\n", (long long) result);
+            else
+                fprintf (out, "%g\n", result);
+        }
+    }
+    else
+        program->entry->stmt (program, program->entry);
+
+    if (program->failed)
+        fprintf (stderr, "Eval: %s\n", program->error ? program->error : " ");
+
+    return !program->failed;
+}
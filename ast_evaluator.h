@@ -0,0 +1,85 @@
+#ifndef AST_EVALUATOR_H
+#define AST_EVALUATOR_H
+
+#include "tree_base.h"
+#include <stdio.h>
+
+struct EvalProgram;
+
+enum EvalStatus
+{
+    EVAL_NEXT,
+    EVAL_RETURNED,
+    EVAL_TAIL_CALL      // return f(...):   EvalCall,   
+};
+struct EvalNode;
+
+typedef double (*EvalExprFn) (EvalProgram* program, const EvalNode* node);
+typedef int (*EvalStmtFn) (EvalProgram* program, const EvalNode* node);   // EvalStatus
+
+//     :     
+//   ,      switch,   .
+struct EvalNode
+{
+    EvalExprFn expr;
+    EvalStmtFn stmt;
+    const EvalNode* left;
+    const EvalNode* right;
+    double value;
+    int slot;
+    int right_slot;         //  "x op y":      
+    int func;               //   left -     
+};
+
+struct EvalFunction
+{
+    char* name;
+    const EvalNode* body;
+    int param_slots[MAX_FUNC_PARAMS];
+    NodeType param_types[MAX_FUNC_PARAMS];
+    int param_count;
+    int* local_slots;       //   ,  
+    int local_count;
+    NodeType return_type;
+};
+
+struct EvalProgram
+{
+    EvalNode* nodes;
+    int node_count;
+    int node_capacity;
+
+    char** slot_names;
+    int* slot_owners;       //   , -1  
+    int slot_count;
+    int slot_capacity;
+    double* slots;
+
+    EvalFunction* funcs;
+    int func_count;
+    int func_capacity;
+
+    const EvalNode* entry;
+    int entry_is_function;
+
+    double return_value;
+    int tail_func;
+    double tail_args[MAX_FUNC_PARAMS];
+    int call_depth;
+    double* saved_locals;   //   ,   
+    int saved_count;
+    int saved_capacity;
+    int failed;
+    const char* error;
+
+    NodeType compile_return_type;   //    
+    int compile_func;               //  , -1  
+};
+
+const int EVAL_MAX_CALL_DEPTH = 1 << 16;
+
+EvalProgram* CompileEvalProgram (Node* root);
+void FreeEvalProgram (EvalProgram* program);
+int RunEvalProgram (EvalProgram* program, FILE* out);
+
+#endif
@@ -0,0 +1,638 @@
+#include "batch_driver.h"
+#include "compile_pipeline.h"
+#include "lexical_analysis.h"
+#include "monotonic_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+char** ReadManifest (const char* filename, int* count)
+{
+    *count = 0;
+
+    FILE* manifest = fopen (filename, "r");
+    if (!manifest)
+    {
+        fprintf (stderr, "Cannot open file: %s\n", filename);
+        return NULL;
+    }
+
+    char** paths = NULL;
+    int capacity = 0;
+    char line[MAX_MANIFEST_LINE] = "";
+
+    while (fgets (line, sizeof(line), manifest))
+    {
+        line[strcspn (line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        if (*count >= capacity)
+        {
+            int new_capacity = capacity ? capacity * 2 : 16;
+            char** new_paths = (char**) realloc (paths, new_capacity * sizeof(char*));
+            if (!new_paths) break;
+            paths = new_paths;
+            capacity = new_capacity;
+        }
+
+        //   -   
+        const char* slash = strrchr (filename, '/');
+        int dir_length = line[0] != '/' && slash ? (int) (slash - filename + 1) : 0;
+
+        char* path = (char*) calloc (dir_length + strlen (line) + 1, 1);
+        if (!path) break;
+        memcpy (path, filename, dir_length);
+        strcpy (path + dir_length, line);
+
+        paths[(*count)++] = path;
+    }
+
+    fclose (manifest);
+    return paths;
+}
+
+void FreeManifest (char** paths, int count)
+{
+    for (int i = 0; i < count; i++)
+        free (paths[i]);
+
+    free (paths);
+}
+
+// x.txt -> x.asm;     .asm
+static char* OutputPath (const char* input)
+{
+    const char* slash = strrchr (input, '/');
+    const char* dot = strrchr (input, '.');
+    size_t stem = dot && (!slash || dot > slash) ? (size_t) (dot - input) : strlen (input);
+
+    char* output = (char*) calloc (stem + sizeof(".asm"), 1);
+    if (!output) return NULL;
+
+    memcpy (output, input, stem);
+    strcpy (output + stem, ".asm");
+    return output;
+}
+
+//    :   realpath,    - 
+//     .    -   
+static char* PathKey (const char* path)
+{
+    const char* slash = strrchr (path, '/');
+    const char* name = slash ? slash + 1 : path;
+
+    char dir[PATH_MAX] = "";
+    if (slash)
+        snprintf (dir, sizeof(dir), "%.*s", (int) (slash - path + 1), path);
+    else
+        strcpy (dir, ".");
+
+    char resolved[PATH_MAX] = "";
+    if (!realpath (dir, resolved))
+        return strdup (path);
+
+    char* key = (char*) calloc (strlen (resolved) + strlen (name) + 2, 1);
+    if (!key) return NULL;
+
+    sprintf (key, "%s/%s", resolved, name);
+    return key;
+}
+
+//     ,    ,   
+static const char** UniqueInputs (const char** inputs, int input_count, int* unique_count)
+{
+    *unique_count = 0;
+
+    const char** unique = (const char**) calloc (input_count, sizeof(const char*));
+    char** keys = (char**) calloc (input_count, sizeof(char*));
+    if (!unique || !keys)
+    {
+        free (unique);
+        free (keys);
+        return NULL;
+    }
+
+    for (int i = 0; i < input_count; i++)
+    {
+        char* key = PathKey (inputs[i]);
+        if (!key) continue;
+
+        int repeated = 0;
+        for (int j = 0; j < *unique_count && !repeated; j++)
+            repeated = strcmp (keys[j], key) == 0;
+
+        if (repeated)
+        {
+            printf (" : %s\n", inputs[i]);
+            free (key);
+            continue;
+        }
+
+        keys[*unique_count] = key;
+        unique[(*unique_count)++] = inputs[i];
+    }
+
+    for (int i = 0; i < *unique_count; i++)
+        free (keys[i]);
+    free (keys);
+
+    return unique;
+}
+
+static void RunBatchJob (BatchJob* job, int opt_level, CompileCache* cache)
+{
+    double start = NowMs ();
+
+    size_t diagnostics_size = 0;
+    FILE* diagnostics = open_memstream (&job->diagnostics, &diagnostics_size);
+    if (!diagnostics) return;
+
+    char* source = ReadFile (job->input);
+    if (!source)
+    {
+        fprintf (diagnostics, "   %s\n", job->input);
+        fclose (diagnostics);
+        job->ms = NowMs () - start;
+        return;
+    }
+
+    job->source_bytes = (long) strlen (source);
+
+    FILE* asm_out = fopen (job->output, "w");
+    if (asm_out)
+    {
+        job->ok = CompileSourceToAsm (source, opt_level, cache, asm_out, diagnostics);
+        job->asm_bytes = ftell (asm_out);
+        fclose (asm_out);
+    }
+    else
+        fprintf (diagnostics, " %s  \n", job->output);
+
+    fclose (diagnostics);
+    free (source);
+
+    job->ms = NowMs () - start;
+}
+
+static int PopOwnJob (BatchQueue* queue)
+{
+    int job = -1;
+
+    pthread_mutex_lock (&queue->lock);
+    if (queue->tail > queue->head)
+        job = queue->jobs[--queue->tail];
+    pthread_mutex_unlock (&queue->lock);
+
+    return job;
+}
+
+static int StealJob (BatchQueue* queue)
+{
+    int job = -1;
+
+    pthread_mutex_lock (&queue->lock);
+    if (queue->tail > queue->head)
+        job = queue->jobs[queue->head++];
+    pthread_mutex_unlock (&queue->lock);
+
+    return job;
+}
+
+typedef struct
+{
+    BatchRun* run;
+    int index;
+} BatchWorker;
+
+//   ,      -  
+static void* BatchWorkerMain (void* arg)
+{
+    BatchWorker* worker = (BatchWorker*) arg;
+    BatchRun* run = worker->run;
+
+    //   :  ,      
+    CompileCache* cache = run->cache_dir ? OpenCompileCache (run->cache_dir, LLONG_MAX) : NULL;
+    int steals = 0;
+
+    for (;;)
+    {
+        int job = PopOwnJob (&run->queues[worker->index]);
+
+        for (int i = 1; job < 0 && i < run->worker_count; i++)
+        {
+            job = StealJob (&run->queues[(worker->index + i) % run->worker_count]);
+            if (job >= 0) steals++;
+        }
+
+        if (job < 0) break;
+
+        run->jobs[job].worker = worker->index;
+        RunBatchJob (&run->jobs[job], run->opt_level, cache);
+    }
+
+    pthread_mutex_lock (&run->stats_lock);
+    run->steals += steals;
+    if (cache)
+    {
+        run->cache_hits += cache->hits;
+        run->cache_misses += cache->misses;
+    }
+    pthread_mutex_unlock (&run->stats_lock);
+
+    CloseCompileCache (cache, NULL);
+    return NULL;
+}
+
+static int InitBatchRun (BatchRun* run, const char** inputs, int input_count, int worker_count)
+{
+    run->job_count = input_count;
+    run->worker_count = worker_count;
+    run->jobs = (BatchJob*) calloc (input_count, sizeof(BatchJob));
+    run->queues = (BatchQueue*) calloc (worker_count, sizeof(BatchQueue));
+    if (!run->jobs || !run->queues) return 0;
+
+    pthread_mutex_init (&run->stats_lock, NULL);
+
+    for (int w = 0; w < worker_count; w++)
+    {
+        run->queues[w].jobs = (int*) calloc (input_count / worker_count + 1, sizeof(int));
+        if (!run->queues[w].jobs) return 0;
+        pthread_mutex_init (&run->queues[w].lock, NULL);
+    }
+
+    char** input_keys = (char**) calloc (input_count, sizeof(char*));
+    if (!input_keys) return 0;
+
+    for (int i = 0; i < input_count; i++)
+        input_keys[i] = PathKey (inputs[i]);
+
+    // asm,     (x.asm -> x.asm)   asm (x.txt  x.src),
+    //  :    .
+    //  :        
+    int queued = 0;
+    int ok = 1;
+
+    for (int i = 0; i < input_count && ok; i++)
+    {
+        BatchJob* job = &run->jobs[i];
+        job->input = inputs[i];
+        job->output = OutputPath (inputs[i]);
+
+        char* output_key = job->output ? PathKey (job->output) : NULL;
+        if (!output_key)
+        {
+            ok = 0;
+            break;
+        }
+
+        const char* clash = NULL;
+        for (int j = 0; j < input_count && !clash; j++)
+            if (input_keys[j] && strcmp (input_keys[j], output_key) == 0) clash = inputs[j];
+
+        for (int j = 0; j < i && !clash; j++)
+            if (!run->jobs[j].diagnostics && strcmp (run->jobs[j].output, job->output) == 0)
+                clash = run->jobs[j].input;
+
+        free (output_key);
+
+        if (clash)
+        {
+            const char format[] = " %s  :       %s\n";
+            size_t size = sizeof(format) + strlen (job->output) + strlen (clash);
+            job->diagnostics = (char*) calloc (size, 1);
+            if (job->diagnostics)
+                snprintf (job->diagnostics, size, format, job->output, clash);
+            continue;
+        }
+
+        BatchQueue* queue = &run->queues[queued++ % worker_count];
+        queue->jobs[queue->tail++] = i;
+    }
+
+    for (int i = 0; i < input_count; i++)
+        free (input_keys[i]);
+    free (input_keys);
+
+    return ok;
+}
+
+static void FreeBatchRun (BatchRun* run)
+{
+    if (run->jobs)
+    {
+        for (int i = 0; i < run->job_count; i++)
+        {
+            free (run->jobs[i].output);
+            free (run->jobs[i].diagnostics);
+        }
+    }
+
+    if (run->queues)
+    {
+        for (int w = 0; w < run->worker_count; w++)
+        {
+            free (run->queues[w].jobs);
+            pthread_mutex_destroy (&run->queues[w].lock);
+        }
+    }
+
+    pthread_mutex_destroy (&run->stats_lock);
+    free (run->jobs);
+    free (run->queues);
+}
+
+//      ,       
+static int ReportBatch (const BatchRun* run, double wall_ms)
+{
+    int failed = 0;
+    long long source_bytes = 0;
+    double job_ms = 0;
+
+    for (int i = 0; i < run->job_count; i++)
+    {
+        const BatchJob* job = &run->jobs[i];
+
+        printf ("[%d/%d] %s: %s -> %s, %.3f  ( %d)\n", i + 1, run->job_count, job->input,
+                job->ok ? "OK" : "", job->output, job->ms, job->worker);
+
+        if (job->diagnostics && job->diagnostics[0])
+            printf ("%s", job->diagnostics);
+
+        failed += !job->ok;
+        source_bytes += job->source_bytes;
+        job_ms += job->ms;
+    }
+
+    double seconds = wall_ms / 1000;
+    printf ("\n: %d, : %d,  : %d\n", run->job_count, run->job_count - failed, failed);
+    printf (": %d,  : %d\n", run->worker_count, run->steals);
+    printf (": %.3f  (   %.3f ), %.1f /, %.1f /\n", wall_ms, job_ms,
+            seconds > 0 ? run->job_count / seconds : 0.0,
+            seconds > 0 ? source_bytes / 1024.0 / seconds : 0.0);
+
+    if (run->cache_dir)
+        printf (" :  %d,  %d\n", run->cache_hits, run->cache_misses);
+
+    return failed;
+}
+
+int RunBatchCompile (const char** all_inputs, int all_count, int worker_count, int opt_level,
+                     const char* cache_dir, long long cache_limit)
+{
+    int input_count = 0;
+    const char** inputs = all_count > 0 ? UniqueInputs (all_inputs, all_count, &input_count) : NULL;
+
+    if (input_count <= 0)
+    {
+        printf ("   \n");
+        free (inputs);
+        return all_count > 0 ? all_count : 0;
+    }
+
+    if (worker_count <= 0)
+        worker_count = (int) sysconf (_SC_NPROCESSORS_ONLN);
+    if (worker_count <= 0)
+        worker_count = 1;
+    if (worker_count > input_count)
+        worker_count = input_count;
+
+    BatchRun run = {};
+    run.opt_level = opt_level;
+    run.cache_dir = cache_dir;
+    run.cache_limit = cache_limit;
+
+    BatchWorker* workers = (BatchWorker*) calloc (worker_count, sizeof(BatchWorker));
+    pthread_t* threads = (pthread_t*) calloc (worker_count, sizeof(pthread_t));
+
+    if (!workers || !threads || !InitBatchRun (&run, inputs, input_count, worker_count))
+    {
+        printf ("    \n");
+        free (workers);
+        free (threads);
+        FreeBatchRun (&run);
+        free (inputs);
+        return input_count;
+    }
+
+    double start = NowMs ();
+
+    int started = 0;
+    for (int w = 0; w < worker_count; w++)
+    {
+        workers[w].run = &run;
+        workers[w].index = w;
+        if (pthread_create (&threads[w], NULL, BatchWorkerMain, &workers[w]) == 0)
+            started++;
+        else
+            break;
+    }
+
+    //     :    
+    if (started == 0)
+        BatchWorkerMain (&workers[0]);
+
+    for (int w = 0; w < started; w++)
+        pthread_join (threads[w], NULL);
+
+    int failed = ReportBatch (&run, NowMs () - start);
+
+    if (cache_dir)
+        CloseCompileCache (OpenCompileCache (cache_dir, cache_limit), NULL);
+
+    free (workers);
+    free (threads);
+    FreeBatchRun (&run);
+    free (inputs);
+
+    return failed;
+}
+
+typedef struct
+{
+    const char* filename;
+    CompileOptions options;
+    int index;
+
+    int ok;
+    char* output;
+    char* asm_text;
+    double ms;
+} StressJob;
+
+static void* StressWorkerMain (void* arg)
+{
+    StressJob* job = (StressJob*) arg;
+    double start = NowMs ();
+
+    size_t output_size = 0;
+    FILE* out = open_memstream (&job->output, &output_size);
+    if (!out) return NULL;
+
+    char dir[MAX_CONTEXT_PATH] = "";
+    snprintf (dir, sizeof(dir), "%s/%d", STRESS_OUTPUT_DIR, job->index);
+
+    CompilerContext* ctx = CtorCompilerContext (dir, out, out);
+    if (ctx)
+    {
+        ctx->options = job->options;
+        job->ok = RunCompilation (ctx, job->filename);
+
+        char asm_path[MAX_CONTEXT_PATH] = "";
+        if (access (ContextPath (ctx, "asm_code_gen.asm", asm_path, sizeof(asm_path)), R_OK) == 0)
+            job->asm_text = ReadFile (asm_path);
+
+        DtorCompilerContext (ctx);
+    }
+
+    fclose (out);
+
+    //     :    diff
+    char output_path[MAX_CONTEXT_PATH + 16] = "";
+    snprintf (output_path, sizeof(output_path), "%s/output.txt", dir);
+    FILE* output_file = job->output ? fopen (output_path, "w") : NULL;
+    if (output_file)
+    {
+        fputs (job->output, output_file);
+        fclose (output_file);
+    }
+    job->ms = NowMs () - start;
+    return NULL;
+}
+
+// ,     :      
+static const char* const stress_volatile_marks[] = {" ", " :"};
+
+static int IsVolatileLine (const char* line, const char* end)
+{
+    for (size_t i = 0; i < sizeof(stress_volatile_marks) / sizeof(stress_volatile_marks[0]); i++)
+        if (memmem (line, end - line, stress_volatile_marks[i], strlen (stress_volatile_marks[i])))
+            return 1;
+
+    return 0;
+}
+
+static const char* SkipVolatileLines (const char* text)
+{
+    while (*text)
+    {
+        const char* end = strchrnul (text, '\n');
+        if (!IsVolatileLine (text, end)) break;
+
+        text = *end ? end + 1 : end;
+    }
+
+    return text;
+}
+
+// ,  ,     
+static int SameOutput (const char* first, const char* second)
+{
+    if (!first || !second) return first == second;
+
+    for (;;)
+    {
+        first = SkipVolatileLines (first);
+        second = SkipVolatileLines (second);
+        if (!*first || !*second) return *first == *second;
+
+        size_t first_length = strchrnul (first, '\n') - first;
+        size_t second_length = strchrnul (second, '\n') - second;
+        if (first_length != second_length || memcmp (first, second, first_length) != 0) return 0;
+
+        first += first_length + (first[first_length] == '\n');
+        second += second_length + (second[second_length] == '\n');
+    }
+}
+
+int RunStressCompile (const char* filename, int count, const CompileOptions* options)
+{
+    if (count <= 0)
+        count = STRESS_DEFAULT_COUNT;
+
+    StressJob* jobs = (StressJob*) calloc (count, sizeof(StressJob));
+    pthread_t* threads = (pthread_t*) calloc (count, sizeof(pthread_t));
+    int* started = (int*) calloc (count, sizeof(int));
+    if (!jobs || !threads || !started)
+    {
+        printf ("    -\n");
+        free (jobs);
+        free (threads);
+        free (started);
+        return count;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        jobs[i].filename = filename;
+        jobs[i].options = *options;
+        jobs[i].index = i;
+
+        //       ,   ;
+        //      ,   
+        jobs[i].options.time_passes = 0;
+        jobs[i].options.mem_report = 0;
+        jobs[i].options.cache_limit = LLONG_MAX;
+    }
+
+    double start = NowMs ();
+
+    for (int i = 0; i < count; i++)
+        started[i] = pthread_create (&threads[i], NULL, StressWorkerMain, &jobs[i]) == 0;
+
+    //     ,   
+    for (int i = 0; i < count; i++)
+    {
+        if (started[i])
+            pthread_join (threads[i], NULL);
+        else
+            StressWorkerMain (&jobs[i]);
+    }
+
+    double wall_ms = NowMs () - start;
+
+    int mismatches = 0;
+    double job_ms = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const StressJob* job = &jobs[i];
+        job_ms += job->ms;
+
+        int same_asm = (!job->asm_text && !jobs[0].asm_text) ||
+                       (job->asm_text && jobs[0].asm_text && strcmp (job->asm_text, jobs[0].asm_text) == 0);
+        int same_output = SameOutput (job->output, jobs[0].output);
+
+        if (!job->output || job->ok != jobs[0].ok || !same_asm || !same_output)
+        {
+            printf (" %d: %s%s%s\n", i, !job->output ? "  " : "",
+                    !same_asm ? "asm  " : "", !same_output ? " " : "");
+            mismatches++;
+        }
+    }
+
+    if (!jobs[0].ok)
+    {
+        printf (" %s  ,   :\n%s", filename,
+                jobs[0].output ? jobs[0].output : "");
+        mismatches++;
+    }
+
+    printf (": %d  %s , : %d\n", count, filename, mismatches);
+    printf (": %.3f  (   %.3f ),   output.txt  %s/<>\n",
+            wall_ms, job_ms, STRESS_OUTPUT_DIR);
+
+    if (options->cache_dir)
+        CloseCompileCache (OpenCompileCache (options->cache_dir, options->cache_limit), NULL);
+
+    for (int i = 0; i < count; i++)
+    {
+        free (jobs[i].output);
+        free (jobs[i].asm_text);
+    }
+    free (jobs);
+    free (threads);
+    free (started);
+
+    return mismatches;
+}
@@ -0,0 +1,71 @@
+#ifndef BATCH_DRIVER_H
+#define BATCH_DRIVER_H
+
+#include "compiler_context.h"
+#include <pthread.h>
+
+//  :   -     ,
+//   CodeGenContext; asm     (x.txt -> x.asm).
+typedef struct
+{
+    const char* input;
+    char* output;
+
+    int ok;
+    char* diagnostics;
+    long source_bytes;
+    long asm_bytes;
+    double ms;
+    int worker;
+} BatchJob;
+
+//  :     ,    
+typedef struct
+{
+    int* jobs;
+    int head;
+    int tail;
+    pthread_mutex_t lock;
+} BatchQueue;
+
+typedef struct
+{
+    BatchJob* jobs;
+    int job_count;
+
+    BatchQueue* queues;
+    int worker_count;
+
+    int opt_level;
+    const char* cache_dir;
+    long long cache_limit;
+
+    int steals;
+    int cache_hits;
+    int cache_misses;
+    pthread_mutex_t stats_lock;
+} BatchRun;
+
+const int MAX_MANIFEST_LINE = 1024;
+
+//   ,    ,  -   ;
+//    '#' 
+char** ReadManifest (const char* filename, int* count);
+void FreeManifest (char** paths, int count);
+
+// worker_count <= 0 -   .    
+//  ; ,  asm        asm,  
+//   .    
+int RunBatchCompile (const char** all_inputs, int all_count, int worker_count, int opt_level,
+                     const char* cache_dir, long long cache_limit);
+
+//  : count     ,
+//       CompilerContext (  stress/<i>,   ).
+// asm      ,      
+// ; --time-passes  --mem-report  .     
+const int STRESS_DEFAULT_COUNT = 64;
+const char STRESS_OUTPUT_DIR[] = "stress";
+
+int RunStressCompile (const char* filename, int count, const CompileOptions* options);
+
+#endif
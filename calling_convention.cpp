@@ -0,0 +1,98 @@
+#include "calling_convention.h"
+#include "register_allocation.h"
+
+//  VM : char - 1 , int - 4, double    - 8
+const char* LoadOpcode (NodeType type)
+{
+    switch (type)
+    {
+        case NODE_TYPE_INT:  return "PUSHMI";
+        case NODE_TYPE_CHAR: return "PUSHMB";
+        default:             return "PUSHM";
+    }
+}
+
+const char* StoreOpcode (NodeType type)
+{
+    switch (type)
+    {
+        case NODE_TYPE_INT:  return "POPMI";
+        case NODE_TYPE_CHAR: return "POPMB";
+        default:             return "POPM";
+    }
+}
+
+void EmitSaveSlots (FILE* out, const CallSaveSlot* slots, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (slots[i].reg >= 0)
+        {
+            fprintf (out, "PUSHR %s\n", RegisterName (slots[i].reg));
+            continue;
+        }
+
+        fprintf (out, "PUSH %d\n", slots[i].address);
+        fprintf (out, "POPR RAX\n");
+        fprintf (out, "%s RAX\n", LoadOpcode (slots[i].type));
+    }
+}
+
+//     :    RCX   
+void EmitRestoreSlots (FILE* out, const CallSaveSlot* slots, int count)
+{
+    if (count == 0) return;
+
+    fprintf (out, "POPR RCX\n");
+
+    for (int i = count - 1; i >= 0; i--)
+    {
+        if (slots[i].reg >= 0)
+        {
+            fprintf (out, "POPR %s\n", RegisterName (slots[i].reg));
+            continue;
+        }
+
+        fprintf (out, "PUSH %d\n", slots[i].address);
+        fprintf (out, "POPR RAX\n");
+        fprintf (out, "%s RAX\n", StoreOpcode (slots[i].type));
+    }
+
+    fprintf (out, "PUSHR RCX\n");
+}
+
+//    ,  :  ARG_REG_COUNT   
+void EmitArgumentPops (FILE* out, int arg_count)
+{
+    for (int i = 0; i < arg_count && i < ARG_REG_COUNT; i++)
+        fprintf (out, "POPR %s\n", RegisterName (ARG_REG_FIRST + i));
+}
+
+void EmitCalleeSavedPrologue (FILE* out, int mask)
+{
+    for (int reg = 0; reg < ALLOC_REG_COUNT; reg++)
+    {
+        if (mask & (1 << reg))
+            fprintf (out, "PUSHR %s\n", RegisterName (reg));
+    }
+}
+
+//  JMP  :    
+void EmitCalleeSavedRestore (FILE* out, int mask)
+{
+    for (int reg = ALLOC_REG_COUNT - 1; reg >= 0; reg--)
+    {
+        if (mask & (1 << reg))
+            fprintf (out, "POPR %s\n", RegisterName (reg));
+    }
+}
+
+//  RET:    
+void EmitCalleeSavedEpilogue (FILE* out, int mask)
+{
+    if (!mask) return;
+
+    fprintf (out, "POPR RCX\n");
+    EmitCalleeSavedRestore (out, mask);
+    fprintf (out, "PUSHR RCX\n");
+}
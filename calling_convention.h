@@ -0,0 +1,26 @@
+#ifndef CALLING_CONVENTION_H
+#define CALLING_CONVENTION_H
+
+#include "tree_base.h"
+#include <stdio.h>
+
+//    CALL:  (reg >= 0)     type
+typedef struct
+{
+    int reg;
+    int address;
+    NodeType type;
+} CallSaveSlot;
+
+const char* LoadOpcode (NodeType type);
+const char* StoreOpcode (NodeType type);
+
+void EmitSaveSlots (FILE* out, const CallSaveSlot* slots, int count);
+void EmitRestoreSlots (FILE* out, const CallSaveSlot* slots, int count);
+void EmitArgumentPops (FILE* out, int arg_count);
+
+void EmitCalleeSavedPrologue (FILE* out, int mask);
+void EmitCalleeSavedEpilogue (FILE* out, int mask);
+void EmitCalleeSavedRestore (FILE* out, int mask);
+
+#endif
@@ -0,0 +1,443 @@
+#include "compile_cache.h"
+#include "fnv_hash.h"
+#include "type_checking.h"
+#include "pass_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <errno.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const int MAX_CACHE_PATH = 512;
+static const int MAX_CACHE_LINE = 512;
+static const char CACHE_LABEL_PREFIX[] = ":label_";
+static const char CACHE_FRAGMENT_SUFFIX[] = ".frag";
+
+CompileCache* OpenCompileCache (const char* dir, long long max_bytes)
+{
+    if (!dir) return NULL;
+
+    if (mkdir (dir, 0755) != 0 && errno != EEXIST)
+    {
+        printf (":     %s\n", dir);
+        return NULL;
+    }
+
+    CompileCache* cache = (CompileCache*) calloc (1, sizeof(CompileCache));
+    if (!cache) return NULL;
+
+    cache->dir = strdup (dir);
+    cache->max_bytes = max_bytes;
+
+    return cache;
+}
+
+//  (FNV-1a)  ,    
+
+static uint64_t HashInt (uint64_t hash, long long value)
+{
+    return HashBytes (hash, &value, sizeof(value));
+}
+
+static uint64_t HashString (uint64_t hash, const char* string)
+{
+    return string ? HashBytes (hash, string, strlen (string) + 1) : HashInt (hash, -1);
+}
+
+static int HasName (NodeType type)
+{
+    return type == NODE_VARIABLE || type == NODE_VAR_DECL || type == NODE_FUNC_DECL ||
+           type == NODE_FUNC_CALL || type == NODE_PARAMETER;
+}
+
+static uint64_t HashTree (uint64_t hash, const Node* node)
+{
+    if (!node) return HashInt (hash, -1);
+
+    hash = HashInt (hash, node->type);
+    hash = HashInt (hash, node->value_type);
+    hash = HashInt (hash, node->data.type_value);
+
+    if (node->type == NODE_NUMBER)
+        hash = HashBytes (hash, &node->data.number_value, sizeof(double));
+
+    if (HasName (node->type))
+        hash = HashString (hash, node->data.string_value);
+
+    hash = HashTree (hash, node->left);
+    return HashTree (hash, node->right);
+}
+
+//   ,    :     ,
+//         
+static uint64_t HashEnvironment (uint64_t hash, CodeGenContext* ctx, const Node* node)
+{
+    if (!node) return hash;
+
+    if (node->type == NODE_FUNC_CALL)
+    {
+        FunctionInfo* func = FindFunctionInfo (ctx, node->data.string_value);
+        hash = HashInt (hash, func ? func->start_label : -1);
+
+        if (func && func->decl)
+        {
+            hash = HashInt (hash, DeclaredType (func->decl->data.type_value));
+            for (const Node* param = func->decl->left; param; param = param->right)
+                hash = HashInt (hash, DeclaredType (param->data.type_value));
+        }
+    }
+    else if (HasName (node->type))
+    {
+        for (int i = 0; i < ctx->var_count; i++)
+        {
+            const VariableInfo* var = &ctx->var_table[i];
+            if (strcmp (var->name, node->data.string_value) != 0) continue;
+
+            hash = HashInt (hash, var->is_local);
+            hash = HashInt (hash, var->type);
+            hash = HashInt (hash, var->address);
+        }
+    }
+
+    hash = HashEnvironment (hash, ctx, node->left);
+    return HashEnvironment (hash, ctx, node->right);
+}
+
+uint64_t FunctionCacheKey (CodeGenContext* ctx, Node* func)
+{
+    uint64_t hash = HashString (FNV_OFFSET, COMPILE_CACHE_VERSION);
+
+    hash = HashInt (hash, ctx->opt_level);
+    hash = HashInt (hash, ctx->dump_ir);
+    hash = HashInt (hash, ctx->data_size);
+    hash = HashInt (hash, FindFunctionLabel (ctx, func->data.string_value));
+
+    hash = HashTree (hash, func);
+    return HashEnvironment (hash, ctx, func);
+}
+
+// 0 -   :       
+static int FragmentPath (CompileCache* cache, uint64_t key, char* path, size_t size)
+{
+    int length = snprintf (path, size, "%s/%016llx%s", cache->dir, (unsigned long long) key, CACHE_FRAGMENT_SUFFIX);
+    return length >= 0 && (size_t) length < size;
+}
+
+//  :label_N     base   
+static void WriteRelocated (FILE* output, const char* code, int base, int new_base)
+{
+    size_t prefix_length = strlen (CACHE_LABEL_PREFIX);
+    const char* label = NULL;
+
+    while ((label = strstr (code, CACHE_LABEL_PREFIX)) != NULL)
+    {
+        label += prefix_length;
+        fwrite (code, 1, label - code, output);
+
+        char* end = NULL;
+        long number = strtol (label, &end, 10);
+        if (end == label)
+        {
+            code = label;
+            continue;
+        }
+
+        fprintf (output, "%ld", number - base + new_base);
+        code = end;
+    }
+
+    fputs (code, output);
+}
+
+static char* ReadFragment (const char* path)
+{
+    FILE* file = fopen (path, "rb");
+    if (!file) return NULL;
+
+    fseek (file, 0, SEEK_END);
+    long size = ftell (file);
+    fseek (file, 0, SEEK_SET);
+
+    char* text = size >= 0 ? (char*) calloc (size + 1, 1) : NULL;
+    if (text && fread (text, 1, size, file) != (size_t) size)
+    {
+        free (text);
+        text = NULL;
+    }
+
+    fclose (file);
+    return text;
+}
+
+//    ,     
+static void ReplayVariable (CodeGenContext* ctx, const char* name, const char* owner, int is_local,
+                            NodeType type, int address)
+{
+    for (int i = 0; i < ctx->var_count; i++)
+    {
+        VariableInfo* var = &ctx->var_table[i];
+        if (strcmp (var->name, name) != 0 || var->is_local != is_local) continue;
+        if (is_local && (!var->owner || strcmp (var->owner, owner) != 0)) continue;
+
+        var->type = type;
+        var->address = address;
+        return;
+    }
+
+    char* current = ctx->current_func;
+    ctx->current_func = is_local ? (char*) owner : NULL;
+    AddVariable (ctx, name, is_local, type);
+    ctx->current_func = current;
+
+    ctx->var_table[ctx->var_count - 1].address = address;
+}
+
+//   ;      ,    
+static char* NextLine (char** cursor)
+{
+    char* line = *cursor;
+    char* end = line ? strchr (line, '\n') : NULL;
+    if (!end) return NULL;
+
+    *end = '\0';
+    *cursor = end + 1;
+    return line;
+}
+
+// :   ,     ,  
+static int ReplayFragment (CodeGenContext* ctx, char* text)
+{
+    char name[MAX_CACHE_LINE] = "";
+    char owner[MAX_CACHE_LINE] = "";
+    char* cursor = text;
+    int base = 0, label_count = 0, data_size = 0, var_count = 0;
+
+    char* version = NextLine (&cursor);
+    if (!version || strcmp (version, COMPILE_CACHE_VERSION) != 0) return 0;
+
+    char* labels = NextLine (&cursor);
+    char* data = NextLine (&cursor);
+    char* vars = NextLine (&cursor);
+    if (!vars ||
+        sscanf (labels, "labels %d %d", &base, &label_count) != 2 ||
+        sscanf (data, "data_size %d", &data_size) != 1 ||
+        sscanf (vars, "vars %d", &var_count) != 1)
+        return 0;
+
+    for (int i = 0; i < var_count; i++)
+    {
+        int is_local = 0, type = 0, address = 0;
+        char* var = NextLine (&cursor);
+        if (!var || sscanf (var, "%d %d %d %511s %511s", &is_local, &type, &address, owner, name) != 5)
+            return 0;
+
+        ReplayVariable (ctx, name, owner, is_local, (NodeType) type, address);
+    }
+
+    WriteRelocated (ctx->output, cursor, base, ctx->label_counter);
+    ctx->label_counter += label_count;
+    TRACE_COUNT (COUNTER_LABELS, label_count);
+    ctx->data_size = data_size;
+
+    return 1;
+}
+
+//    :      ,
+//        
+static void StoreFragment (CompileCache* cache, CodeGenContext* ctx, uint64_t key, const char* code,
+                           int base, int old_var_count, const VariableInfo* old_vars)
+{
+    char path[MAX_CACHE_PATH] = "";
+    char temp_path[MAX_CACHE_PATH] = "";
+    if (!FragmentPath (cache, key, path, sizeof(path))) return;
+
+    //          
+    int length = snprintf (temp_path, sizeof(temp_path), "%s.%d.%p.tmp", path, (int) getpid (), (void*) cache);
+    if (length < 0 || (size_t) length >= sizeof(temp_path)) return;
+
+    FILE* file = fopen (temp_path, "wb");
+    if (!file) return;
+
+    int changed = 0;
+    for (int i = 0; i < ctx->var_count; i++)
+    {
+        if (i >= old_var_count || ctx->var_table[i].address != old_vars[i].address ||
+            ctx->var_table[i].type != old_vars[i].type)
+            changed++;
+    }
+
+    fprintf (file, "%s\n", COMPILE_CACHE_VERSION);
+    fprintf (file, "labels %d %d\n", base, ctx->label_counter - base);
+    fprintf (file, "data_size %d\n", ctx->data_size);
+    fprintf (file, "vars %d\n", changed);
+
+    for (int i = 0; i < ctx->var_count; i++)
+    {
+        const VariableInfo* var = &ctx->var_table[i];
+        if (i < old_var_count && var->address == old_vars[i].address && var->type == old_vars[i].type)
+            continue;
+
+        fprintf (file, "%d %d %d %s %s\n", var->is_local, var->type, var->address,
+                 var->owner ? var->owner : "-", var->name);
+    }
+
+    fputs (code, file);
+
+    if (fclose (file) == 0 && rename (temp_path, path) == 0)
+        cache->stores++;
+    else
+        remove (temp_path);
+}
+
+void GenCachedFunction (CompileCache* cache, CodeGenContext* ctx, Node* func, GenFunctionFn generate)
+{
+    uint64_t key = FunctionCacheKey (ctx, func);
+
+    char path[MAX_CACHE_PATH] = "";
+    if (!FragmentPath (cache, key, path, sizeof(path)))
+    {
+        generate (ctx, func);
+        return;
+    }
+
+    char* cached = ReadFragment (path);
+    int replayed = cached && ReplayFragment (ctx, cached);
+    free (cached);
+
+    if (replayed)
+    {
+        //    :     
+        utime (path, NULL);
+        cache->hits++;
+        return;
+    }
+
+    cache->misses++;
+
+    char* code = NULL;
+    size_t code_size = 0;
+    FILE* capture = open_memstream (&code, &code_size);
+    VariableInfo* old_vars = (VariableInfo*) malloc ((ctx->var_count + 1) * sizeof(VariableInfo));
+    if (!capture || !old_vars)
+    {
+        if (capture) fclose (capture);
+        free (code);
+        free (old_vars);
+        generate (ctx, func);
+        return;
+    }
+
+    int base = ctx->label_counter;
+    int old_var_count = ctx->var_count;
+    memcpy (old_vars, ctx->var_table, ctx->var_count * sizeof(VariableInfo));
+
+    FILE* output = ctx->output;
+    ctx->output = capture;
+    generate (ctx, func);
+    ctx->output = output;
+    fclose (capture);
+
+    fputs (code, output);
+    StoreFragment (cache, ctx, key, code, base, old_var_count, old_vars);
+
+    free (code);
+    free (old_vars);
+}
+
+// 
+
+typedef struct
+{
+    char* path;
+    long long size;
+    time_t mtime;
+} CacheFile;
+
+static int CompareCacheFiles (const void* a, const void* b)
+{
+    time_t left = ((const CacheFile*) a)->mtime;
+    time_t right = ((const CacheFile*) b)->mtime;
+
+    return (left > right) - (left < right);
+}
+
+static int IsFragmentName (const char* name)
+{
+    size_t length = strlen (name);
+    size_t suffix = strlen (CACHE_FRAGMENT_SUFFIX);
+
+    return length > suffix && strcmp (name + length - suffix, CACHE_FRAGMENT_SUFFIX) == 0;
+}
+
+static void EvictFragments (CompileCache* cache)
+{
+    DIR* dir = opendir (cache->dir);
+    if (!dir) return;
+
+    CacheFile* files = NULL;
+    int count = 0, capacity = 0;
+    long long total = 0;
+
+    for (dirent* entry = readdir (dir); entry; entry = readdir (dir))
+    {
+        if (!IsFragmentName (entry->d_name)) continue;
+
+        char path[MAX_CACHE_PATH] = "";
+        int length = snprintf (path, sizeof(path), "%s/%s", cache->dir, entry->d_name);
+        if (length < 0 || (size_t) length >= sizeof(path)) continue;
+
+        struct stat info = {};
+        if (stat (path, &info) != 0) continue;
+
+        if (count >= capacity)
+        {
+            int new_capacity = capacity ? capacity * 2 : 64;
+            CacheFile* new_files = (CacheFile*) realloc (files, new_capacity * sizeof(CacheFile));
+            if (!new_files) break;
+            files = new_files;
+            capacity = new_capacity;
+        }
+
+        files[count].path = strdup (path);
+        files[count].size = info.st_size;
+        files[count].mtime = info.st_mtime;
+        total += info.st_size;
+        count++;
+    }
+
+    closedir (dir);
+
+    if (total > cache->max_bytes)
+        qsort (files, count, sizeof(CacheFile), CompareCacheFiles);
+
+    for (int i = 0; i < count && total > cache->max_bytes; i++)
+    {
+        if (remove (files[i].path) != 0) continue;
+
+        total -= files[i].size;
+        cache->evictions++;
+    }
+
+    for (int i = 0; i < count; i++)
+        free (files[i].path);
+
+    free (files);
+}
+
+// report -   , NULL - 
+void CloseCompileCache (CompileCache* cache, FILE* report)
+{
+    if (!cache) return;
+
+    EvictFragments (cache);
+
+    if (report)
+        fprintf (report, " :  %d,  %d,  %d,  %d\n",
+                 cache->hits, cache->misses, cache->stores, cache->evictions);
+
+    free (cache->dir);
+    free (cache);
+}
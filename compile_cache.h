@@ -0,0 +1,35 @@
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include "create_asm_code_from_tree.h"
+#include <stdint.h>
+
+//     :    ,  -  ,  
+//   (     , 
+// ,   ,    ).
+//         .
+struct CompileCache
+{
+    char* dir;
+    long long max_bytes;    //        
+
+    int hits;
+    int misses;
+    int stores;
+    int evictions;
+};
+
+typedef void (*GenFunctionFn) (CodeGenContext* ctx, Node* func);
+
+//     :    
+const char COMPILE_CACHE_VERSION[] = "lexxer-codegen-6";
+const char COMPILE_CACHE_DEFAULT_DIR[] = ".lexxer_cache";
+const long long COMPILE_CACHE_DEFAULT_LIMIT = 64ll << 20;
+
+CompileCache* OpenCompileCache (const char* dir, long long max_bytes);
+void CloseCompileCache (CompileCache* cache, FILE* report);
+
+uint64_t FunctionCacheKey (CodeGenContext* ctx, Node* func);
+void GenCachedFunction (CompileCache* cache, CodeGenContext* ctx, Node* func, GenFunctionFn generate);
+
+#endif
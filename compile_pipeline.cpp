@@ -0,0 +1,490 @@
+#include "compile_pipeline.h"
+#include "lexical_analysis.h"
+#include "tree_base.h"
+#include "syntactic_analysis.h"
+#include "create_asm_code_from_tree.h"
+#include "inlining.h"
+#include "loop_optimization.h"
+#include "type_checking.h"
+#include "create_AST_dump.h"
+#include "create_tree_AST.h"
+#include "read_AST_tree.h"
+#include "x86_codegen.h"
+#include "stack_vm.h"
+#include "vm_object.h"
+#include "ast_evaluator.h"
+#include "monotonic_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//       (TraceCapture);   
+//        
+static void CountRemainingInstructions (const char* path, long long counted_before)
+{
+    if (!active_trace) return;
+
+    char* asm_text = ReadFile (path);
+    if (!asm_text) return;
+
+    long long counted = active_trace->counters[COUNTER_INSTRUCTIONS] - counted_before;
+    TRACE_COUNT (COUNTER_INSTRUCTIONS, CountAsmInstructions (asm_text) - counted);
+    free (asm_text);
+}
+
+void OptimizeTree (Node** root, int opt_level, int native)
+{
+    CheckTypes (*root);
+
+    if (opt_level >= 1)
+    {
+        InlineFunctions (*root);
+        CheckTypes (*root);
+
+        LoopContext loops = {};
+        loops.unroll_factor = opt_level >= 2 ? LOOP_UNROLL_DEFAULT_FACTOR : 1;
+        loops.strength_reduction = opt_level >= 2 && native;
+        OptimizeLoops (root, &loops);
+    }
+
+    CheckTypes (*root);
+}
+
+int CompileSourceToAsm (const char* source, int opt_level, CompileCache* cache, FILE* asm_out, FILE* diagnostics)
+{
+    Lexer* lexer = CtorLexer (source);
+    if (!lexer) return 0;
+
+    lexer->errors = diagnostics;
+    LexerScanTokens (lexer);
+
+    Getter* getter = CtorGetter (lexer);
+    Node* root = getter ? GetProgram (getter) : NULL;
+    int ok = root && getter->error_count == 0;
+
+    if (!root && getter && getter->error_count == 0)
+        fprintf (diagnostics, "  NULL  \n");
+
+    if (ok)
+    {
+        OptimizeTree (&root, opt_level, 0);
+
+        CodeGenContext* codegen = CtorCodeGen (asm_out);
+        if (codegen)
+        {
+            codegen->opt_level = opt_level;
+            codegen->cache = cache;
+
+            DeclareFunctions (codegen, root);
+            int has_function = GenEntryPoint (codegen, root);
+            GenerateCode (codegen, root);
+
+            if (!has_function)
+                fprintf (asm_out, "HLT\n");
+
+            //   , DtorCodeGen   
+            codegen->output = NULL;
+            DtorCodeGen (codegen);
+        }
+        else
+            ok = 0;
+    }
+
+    FreeTree (root);
+    DtorGetter (getter);
+    DtorLexer (lexer);
+
+    return ok;
+}
+
+int RunCompilation (CompilerContext* ctx, const char* filename)
+{
+    const CompileOptions* options = &ctx->options;
+    FILE* out = ctx->out;
+    int stages = options->stages;
+    int run = options->run;
+    int native_built = 0;
+    char* Lisp_code = NULL;
+
+    char asm_path[MAX_CONTEXT_PATH] = "";
+    char object_path[MAX_CONTEXT_PATH] = "";
+    char native_path[MAX_CONTEXT_PATH] = "";
+    char exe_path[MAX_CONTEXT_PATH] = "";
+    char lisp_path[MAX_CONTEXT_PATH] = "";
+    ContextPath (ctx, "asm_code_gen.asm", asm_path, sizeof(asm_path));
+    ContextPath (ctx, "asm_code_gen.svmo", object_path, sizeof(object_path));
+    ContextPath (ctx, "native_code_gen.s", native_path, sizeof(native_path));
+    ContextPath (ctx, "ast_tree.txt", lisp_path, sizeof(lisp_path));
+    ContextPath (ctx, "native_code_gen", exe_path, sizeof(exe_path));
+
+    // VM  asm  ,      
+    if (stages & STAGE_RUN)
+        run = 1;
+    if (run || options->object)
+        stages |= STAGE_ASM;
+
+    if (stages & STAGE_SOURCE)
+        fprintf (out, "Loading tree from file: %s\n", filename);
+
+    char* test_program = ReadFile (filename);
+    if (!test_program)
+    {
+        fprintf (out, "ERORR: in ReadFile\n");
+        return 0;
+    }
+
+    if (stages & STAGE_SOURCE)
+    {
+        fprintf (out, " :\n");
+        fprintf (out, "-------------------------------------------------\n");
+        fprintf (out, "%s\n", test_program);
+        fprintf (out, "-------------------------------------------------\n\n");
+    }
+
+    if ((options->time_passes || options->trace_file) && !ctx->trace)
+        ctx->trace = CtorPassTrace ();
+    if (options->mem_report && !ctx->memory)
+        ctx->memory = CtorMemoryAccounting ();
+    BindCompilerContext (ctx);
+
+    TRACE_BEGIN ("", "pass", NULL);
+    SetMemoryPhase (MEM_PHASE_LEXING);
+    Lexer* lexer = CtorLexer (test_program);
+    if (lexer) lexer->errors = ctx->errors;
+    int scanned = lexer && LexerScanTokens (lexer);
+    TRACE_END ();
+
+    if (scanned && (stages & STAGE_TOKENS))
+    {
+        LexerPrintTokens (lexer, out);
+    }
+
+    TRACE_BEGIN ("", "pass", NULL);
+    SetMemoryPhase (MEM_PHASE_PARSING);
+    Getter* Getter = CtorGetter (lexer);
+    if (!Getter)
+    {
+        fprintf (out, "  \n");
+        DtorLexer (lexer);
+        free (test_program);
+        BindCompilerContext (NULL);
+        return 0;
+    }
+
+    Node* Ast_root = GetProgram (Getter);
+    TRACE_END ();
+
+    //     ;    
+    TRACE_BEGIN ("", "pass", NULL);
+    SetMemoryPhase (MEM_PHASE_OPTIMIZATION);
+    if (Ast_root)
+        CheckTypes (Ast_root);
+    TRACE_END ();
+
+    //    ,      
+    if (options->eval && Ast_root)
+    {
+        double eval_start = NowMs ();
+        EvalProgram* eval_program = CompileEvalProgram (Ast_root);
+        double eval_compiled = NowMs ();
+
+        fprintf (out, "\n===  (eval) ===\n");
+        RunEvalProgram (eval_program, out);
+        double eval_finish = NowMs ();
+
+        fprintf (out, "eval:  %.3f ,     %.3f \n",
+                 eval_compiled - eval_start, eval_finish - eval_start);
+        FreeEvalProgram (eval_program);
+    }
+
+    if (Getter->error_count > 0)
+    {
+        fprintf (out, "\n   %d \n", Getter->error_count);
+    }
+    else if (Ast_root)
+    {
+        if (stages & STAGE_TREE)
+        {
+            fprintf (out, "\n===    ===\n");
+            PrintTree (out, Ast_root, 0);
+        }
+
+        if ((stages & STAGE_DOT) && options->detail_dump)
+            CreateGraphvizDetailDump (ctx, Ast_root, "ast_graph.dot", &options->dump_detail, NULL, 0);
+        else if (stages & STAGE_DOT)
+            CreateGraphvizDump (ctx, Ast_root, "ast_graph.dot", NULL, 0);
+
+        //     ast_dumps.html
+        if (options->json_file && ExportTreeJson (ctx, Ast_root, options->json_file))
+            CreateTreeViewer (ctx, Ast_root, "ast_viewer.html");
+    }
+    else
+    {
+        fprintf (out, "\n  NULL  \n");
+    }
+
+    if (Ast_root && (stages & STAGE_TREE))
+        DumpAST (Ast_root, out);
+
+    Node* Ast_tree_after_reading = NULL;
+
+    if (Ast_root && (stages & STAGE_LISP))
+    {
+        TRACE_BEGIN ("", "pass", NULL);
+        SetMemoryPhase (MEM_PHASE_SERIALIZATION);
+        FILE* Dump = fopen (lisp_path, "w");
+        if (Dump)
+        {
+            DumpAST (Ast_root, Dump);
+            fclose (Dump);
+        }
+        else
+            fprintf (out, "\n ast_tree.txt  \n");
+
+        fprintf (out, "Parsing LISP Ast_tree_after_reading...\n");
+
+        Lisp_code = ReadFile (lisp_path);
+        Ast_tree_after_reading = ParseLispAST (Lisp_code);
+        TRACE_END ();
+
+        if (Ast_tree_after_reading)
+        {
+            fprintf (out, "\nAST Structure after reading:\n");
+            PrintTree (out, Ast_tree_after_reading, 0);
+        } else
+            fprintf (out, "Parsing failed\n");
+    }
+
+    TRACE_BEGIN ("", "pass", NULL);
+    SetMemoryPhase (MEM_PHASE_OPTIMIZATION);
+
+    if (Ast_root && options->opt_level >= 1)
+    {
+        int inlined = InlineFunctions (Ast_root);
+        if (stages & STAGE_STATS)
+            fprintf (out, "\n : %d\n", inlined);
+        CheckTypes (Ast_root);
+    }
+
+    if (Ast_root && options->opt_level >= 1)
+    {
+        LoopContext loops = {};
+        loops.unroll_factor = options->unroll_factor >= 0 ? options->unroll_factor :
+                              options->opt_level >= 2 ? LOOP_UNROLL_DEFAULT_FACTOR : 1;
+        //  VM    ,  ,   
+        //  :      
+        loops.strength_reduction = options->opt_level >= 2 && options->native;
+
+        OptimizeLoops (&Ast_root, &loops);
+        if (stages & STAGE_STATS)
+            fprintf (out, " : %d,   : %d\n",
+                     loops.unrolled_loops, loops.reduced_multiplications);
+    }
+
+    if (Ast_root)
+    {
+        int integer_exprs = CheckTypes (Ast_root);
+        if (stages & STAGE_STATS)
+            fprintf (out, " : %d\n", integer_exprs);
+    }
+
+    TRACE_END ();
+
+    TRACE_BEGIN ("", "pass", NULL);
+    SetMemoryPhase (MEM_PHASE_CODEGEN);
+    long long counted_before = active_trace ? active_trace->counters[COUNTER_INSTRUCTIONS] : 0;
+    double codegen_start = NowMs ();
+    FILE* Asm_code = (stages & STAGE_ASM) ? fopen (asm_path, "w") : NULL;
+    CodeGenContext* codegen = Asm_code ? CtorCodeGen (Asm_code) : NULL;
+    if (codegen)
+    {
+        codegen->opt_level = options->opt_level;
+        codegen->dump_ir = options->dump_ir;
+        codegen->cache = options->cache_dir ? OpenCompileCache (options->cache_dir, options->cache_limit) : NULL;
+    }
+    if (codegen && Ast_root)
+    {
+        DeclareFunctions (codegen, Ast_root);
+        int has_function = GenEntryPoint (codegen, Ast_root);
+        GenerateCode (codegen, Ast_root);
+
+        if (!has_function)
+            fprintf (Asm_code, "HLT\n");
+    }
+
+    if (codegen)
+        CloseCompileCache (codegen->cache, (stages & STAGE_STATS) ? out : NULL);
+    DtorCodeGen (codegen);
+
+    if (Asm_code)
+        CountRemainingInstructions (asm_path, counted_before);
+    TRACE_END ();
+
+    if (options->native && Ast_root)
+    {
+        X86Context* x86 = CtorX86CodeGen (fopen (native_path, "w"));
+        if (x86 && x86->output)
+        {
+            TRACE_BEGIN ("x86-64", "pass", NULL);
+            long long native_counted_before = active_trace ? active_trace->counters[COUNTER_INSTRUCTIONS] : 0;
+            GenerateX86Program (x86, Ast_root);
+            DtorX86CodeGen (x86);
+            CountRemainingInstructions (native_path, native_counted_before);
+            TRACE_END ();
+            native_built = BuildNativeExecutable (native_path, exe_path, out);
+            if (native_built)
+                fprintf (out, "   : native_code_gen\n");
+        }
+        else
+        {
+            fprintf (out, "\n native_code_gen.s  \n");
+            DtorX86CodeGen (x86);
+        }
+    }
+
+    VmProgram* program = NULL;
+    if ((run || options->object) && Ast_root)
+    {
+        char* asm_text = ReadFile (asm_path);
+        program = AssembleVmProgram (asm_text);
+        free (asm_text);
+
+        if (!program)
+            fprintf (out, "\n  asm_code_gen.asm  VM\n");
+    }
+
+    //       : --run   
+    if (options->object && program)
+    {
+        int written = WriteVmObject (program, object_path);
+        FreeVmProgram (program);
+        program = NULL;
+
+        VmObject* loaded = written ? LoadVmObject (object_path) : NULL;
+        if (loaded)
+        {
+            fprintf (out, "\n   : asm_code_gen.svmo\n");
+            if (options->disasm)
+            {
+                fprintf (out, "\n===  ===\n");
+                DisassembleVmObject (loaded, out);
+            }
+
+            program = VmProgramFromObject (loaded);
+            FreeVmObject (loaded);
+        }
+    }
+
+    if (run && program)
+    {
+        VmStats stats = {};
+        fprintf (out, "\n===  (VM) ===\n");
+        RunVmProgram (program, out, &stats);
+        fprintf (out, "VM: %lld   %.3f  (%.1f  /)\n",
+                 stats.executed, stats.seconds * 1000,
+                 stats.seconds > 0 ? stats.executed / stats.seconds / 1e6 : 0.0);
+        fprintf (out, "VM:      %.3f \n",
+                 NowMs () - codegen_start);
+    }
+
+    FreeVmProgram (program);
+
+    //      stdout ,  ctx->out
+    if (run && native_built)
+    {
+        fprintf (out, "\n===  (x86-64) ===\n");
+        fflush (out);
+        // system()    '/'  PATH,     
+        char run_path[MAX_CONTEXT_PATH + 2] = "";
+        snprintf (run_path, sizeof(run_path), "%s%s", strchr (exe_path, '/') ? "" : "./", exe_path);
+
+        double seconds = RunNativeExecutable (run_path);
+        fprintf (out, "x86-64: %.3f     \n", seconds * 1000);
+    }
+
+    if (options->time_passes == 1)
+        PrintTraceTable (ctx->trace, out);
+    else if (options->time_passes == 2)
+        PrintTraceJson (ctx->trace, out);
+    if (options->trace_file)
+    {
+        char trace_path[MAX_CONTEXT_PATH] = "";
+        WriteChromeTrace (ctx->trace, ContextPath (ctx, options->trace_file, trace_path, sizeof(trace_path)));
+    }
+    DtorPassTrace (ctx->trace);
+    ctx->trace = NULL;
+
+    int ok = Ast_root && Getter->error_count == 0;
+
+    SetMemoryPhase (MEM_PHASE_SHUTDOWN);
+    FreeTree (Ast_tree_after_reading);
+    FreeTree (Ast_root);
+    CloseHtmlFile (ctx);
+    DtorGetter (Getter);
+    DtorLexer (lexer);
+    free (Lisp_code);
+    free (test_program);
+
+    //      :  - 
+    if (ctx->memory)
+    {
+        PrintMemoryReport (ctx->memory, out);
+        ReportMemoryLeaks (ctx->memory, out);
+        DtorMemoryAccounting (ctx->memory);
+        ctx->memory = NULL;
+    }
+    if (stages & STAGE_STATS)
+        fprintf (out, "\n \n");
+
+    BindCompilerContext (NULL);
+    return ok;
+}
+
+struct StageName
+{
+    const char* name;
+    int mask;
+};
+
+static const StageName stage_names[] =
+{
+    {"source", STAGE_SOURCE},
+    {"tokens", STAGE_TOKENS},
+    {"tree",   STAGE_TREE},
+    {"dot",    STAGE_DOT},
+    {"lisp",   STAGE_LISP},
+    {"stats",  STAGE_STATS},
+    {"asm",    STAGE_ASM},
+    {"run",    STAGE_RUN},
+    {"all",    STAGE_DEFAULT},
+};
+
+int ParseStages (const char* list)
+{
+    int stages = 0;
+
+    while (list && *list)
+    {
+        size_t length = strcspn (list, ",");
+        int found = 0;
+
+        for (size_t i = 0; i < sizeof(stage_names) / sizeof(stage_names[0]); i++)
+        {
+            if (strlen (stage_names[i].name) == length && strncmp (stage_names[i].name, list, length) == 0)
+            {
+                stages |= stage_names[i].mask;
+                found = 1;
+            }
+        }
+
+        if (!found && length > 0) return -1;
+
+        list += length;
+        if (*list == ',') list++;
+    }
+
+    if (stages & STAGE_RUN)
+        stages |= STAGE_ASM;
+
+    return stages;
+}
@@ -0,0 +1,42 @@
+#ifndef COMPILE_PIPELINE_H
+#define COMPILE_PIPELINE_H
+
+#include "compile_cache.h"
+#include "compiler_context.h"
+#include <stdio.h>
+
+//     ,   RunCompilation   ;
+// native -    x86-64,     
+void OptimizeTree (Node** root, int opt_level, int native);
+
+//   ,   main,     : asm   
+//   .   ,     .
+int CompileSourceToAsm (const char* source, int opt_level, CompileCache* cache, FILE* asm_out, FILE* diagnostics);
+
+//      ,     ctx->options:
+//  -   ,  -  ctx->out. 0 -   
+int RunCompilation (CompilerContext* ctx, const char* filename);
+
+//   main  : --emit=asm   , ,
+//   ,      
+enum PipelineStage
+{
+    STAGE_SOURCE = 1 << 0,  //    
+    STAGE_TOKENS = 1 << 1,  //  
+    STAGE_TREE   = 1 << 2,  // PrintTree  DumpAST  stdout
+    STAGE_DOT    = 1 << 3,  // ast_graph.dot    dot
+    STAGE_LISP   = 1 << 4,  // ast_tree.txt     ParseLispAST
+    STAGE_STATS  = 1 << 5,  //     
+    STAGE_ASM    = 1 << 6,  // asm_code_gen.asm
+    STAGE_RUN    = 1 << 7   //   VM ( x86-64  --native)
+};
+
+//  --emit   :     asm
+const int STAGE_DEFAULT = STAGE_SOURCE | STAGE_TOKENS | STAGE_TREE | STAGE_DOT |
+                          STAGE_LISP | STAGE_STATS | STAGE_ASM;
+
+//   : source,tokens,tree,dot,lisp,stats,asm,run  all.
+//   - -1.   : run  asm.
+int ParseStages (const char* list);
+
+#endif
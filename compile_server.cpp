@@ -0,0 +1,228 @@
+#include "compile_server.h"
+#include "compile_pipeline.h"
+#include "monotonic_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+
+static void RecordLatency (CompileServer* server, double ms)
+{
+    if (server->request_count >= server->latency_capacity)
+    {
+        int new_capacity = server->latency_capacity ? server->latency_capacity * 2 : 256;
+        double* new_latencies = (double*) realloc (server->latencies, new_capacity * sizeof(double));
+        if (!new_latencies) return;
+        server->latencies = new_latencies;
+        server->latency_capacity = new_capacity;
+    }
+
+    server->latencies[server->request_count++] = ms;
+}
+
+static int CompareDoubles (const void* a, const void* b)
+{
+    double left = *(const double*) a;
+    double right = *(const double*) b;
+
+    return (left > right) - (left < right);
+}
+
+//  : p50  10  -   
+double LatencyPercentile (const CompileServer* server, double fraction)
+{
+    if (!server || server->request_count == 0) return 0;
+
+    int count = server->request_count;
+    double* sorted = (double*) malloc (count * sizeof(double));
+    if (!sorted) return 0;
+
+    memcpy (sorted, server->latencies, count * sizeof(double));
+    qsort (sorted, count, sizeof(double), CompareDoubles);
+
+    int rank = (int) (fraction * count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+
+    double result = sorted[rank - 1];
+    free (sorted);
+
+    return result;
+}
+
+static void PrintServerStats (const CompileServer* server, FILE* out)
+{
+    fprintf (out, ": %d,  : %d, p50 %.3f , p99 %.3f \n",
+             server->request_count, server->failed_count,
+             LatencyPercentile (server, 0.50), LatencyPercentile (server, 0.99));
+
+    if (server->cache)
+        fprintf (out, " :  %d,  %d\n", server->cache->hits, server->cache->misses);
+}
+
+// 0 -    ,    
+static int HandleCompile (CompileServer* server, FILE* in, FILE* out, int opt_level, long length)
+{
+    if (length > MAX_SERVER_SOURCE)
+    {
+        fprintf (out, "FAIL 0 0 0\n");
+        fflush (out);
+        fprintf (server->log, " : %ld  ,  %ld\n", length, MAX_SERVER_SOURCE);
+        return 0;
+    }
+
+    char* source = (char*) calloc (length + 1, 1);
+    size_t received = source ? fread (source, 1, length, in) : 0;
+    if (!source || received != (size_t) length)
+    {
+        fprintf (server->log, " :  %zu    %ld\n", received, length);
+        free (source);
+        return 0;
+    }
+
+    double start = NowMs ();
+
+    char* asm_text = NULL;
+    char* diag_text = NULL;
+    size_t asm_size = 0, diag_size = 0;
+    FILE* asm_out = open_memstream (&asm_text, &asm_size);
+    FILE* diagnostics = open_memstream (&diag_text, &diag_size);
+
+    int ok = asm_out && diagnostics && CompileSourceToAsm (source, opt_level, server->cache, asm_out, diagnostics);
+
+    if (asm_out) fclose (asm_out);
+    if (diagnostics) fclose (diagnostics);
+    if (!ok) asm_size = 0;
+
+    double ms = NowMs () - start;
+    RecordLatency (server, ms);
+    if (!ok) server->failed_count++;
+
+    fprintf (out, "%s %zu %zu %lld\n", ok ? "OK" : "FAIL", asm_size, diag_size, (long long) (ms * 1000));
+    if (asm_size) fwrite (asm_text, 1, asm_size, out);
+    if (diag_size) fwrite (diag_text, 1, diag_size, out);
+    fflush (out);
+
+    fprintf (server->log, " %d: %s, %ld  , %.3f \n",
+             server->request_count, ok ? "OK" : "FAIL", length, ms);
+
+    free (asm_text);
+    free (diag_text);
+    free (source);
+    return 1;
+}
+
+//     , SHUTDOWN  ,   
+static void ServeConnection (CompileServer* server, FILE* in, FILE* out)
+{
+    char header[MAX_SERVER_HEADER] = "";
+
+    while (!server->stop && fgets (header, sizeof(header), in))
+    {
+        int opt_level = 1;
+        long length = 0;
+
+        if (sscanf (header, "COMPILE %d %ld", &opt_level, &length) == 2 && length >= 0)
+        {
+            if (!HandleCompile (server, in, out, opt_level, length))
+                break;
+        }
+        else if (strncmp (header, "STATS", 5) == 0)
+        {
+            char* text = NULL;
+            size_t size = 0;
+            FILE* stats = open_memstream (&text, &size);
+            if (!stats) continue;
+
+            PrintServerStats (server, stats);
+            fclose (stats);
+
+            fprintf (out, "STATS %zu\n", size);
+            fwrite (text, 1, size, out);
+            fflush (out);
+            free (text);
+        }
+        else if (strncmp (header, "SHUTDOWN", 8) == 0)
+            server->stop = 1;
+        else
+        {
+            fprintf (out, "FAIL 0 0 0\n");
+            fflush (out);
+        }
+    }
+}
+
+static int ServeSocket (CompileServer* server, const char* socket_path)
+{
+    int listener = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        perror ("socket");
+        return 0;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy (address.sun_path, socket_path, sizeof(address.sun_path) - 1);
+
+    unlink (socket_path);
+    if (bind (listener, (sockaddr*) &address, sizeof(address)) != 0 ||
+        listen (listener, COMPILE_SERVER_BACKLOG) != 0)
+    {
+        perror (socket_path);
+        close (listener);
+        return 0;
+    }
+
+    // ,    ,    
+    signal (SIGPIPE, SIG_IGN);
+    fprintf (server->log, "   %s\n", socket_path);
+    fflush (server->log);
+
+    while (!server->stop)
+    {
+        int connection = accept (listener, NULL, NULL);
+        if (connection < 0) continue;
+
+        //     :     
+        timeval timeout = {};
+        timeout.tv_sec = COMPILE_SERVER_READ_TIMEOUT_S;
+        setsockopt (connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        FILE* in = fdopen (connection, "rb");
+        FILE* out = fdopen (dup (connection), "wb");
+
+        if (in && out)
+            ServeConnection (server, in, out);
+
+        if (in) fclose (in);
+        else close (connection);
+        if (out) fclose (out);
+    }
+
+    close (listener);
+    unlink (socket_path);
+    return 1;
+}
+
+int RunCompileServer (const char* socket_path, CompileCache* cache)
+{
+    CompileServer server = {};
+    server.cache = cache;
+    server.log = socket_path ? stdout : stderr;
+
+    int ok = 1;
+    if (socket_path)
+        ok = ServeSocket (&server, socket_path);
+    else
+        ServeConnection (&server, stdin, stdout);
+
+    PrintServerStats (&server, server.log);
+    free (server.latencies);
+
+    return ok;
+}
@@ -0,0 +1,42 @@
+#ifndef COMPILE_SERVER_H
+#define COMPILE_SERVER_H
+
+#include "compile_cache.h"
+#include <stdio.h>
+
+//   :    , asm 
+//    ,      .
+//
+//  (  ,   <> ):
+//     COMPILE < -O> <>\n<>
+//     STATS\n
+//     SHUTDOWN\n
+// :
+//     OK < asm> < > <>\n<asm><>
+//     FAIL 0 < > <>\n<>
+//     STATS <>\n<>
+//   MAX_SERVER_SOURCE     
+//   :         
+typedef struct
+{
+    CompileCache* cache;
+    FILE* log;              //  ;   stdin/stdout  stderr
+
+    double* latencies;      //    COMPILE,   
+    int request_count;
+    int latency_capacity;
+    int failed_count;
+    int stop;
+} CompileServer;
+
+const int COMPILE_SERVER_BACKLOG = 16;
+const int MAX_SERVER_HEADER = 128;
+const long MAX_SERVER_SOURCE = 64L << 20;           //     COMPILE
+const int COMPILE_SERVER_READ_TIMEOUT_S = 10;       //    
+
+// socket_path == NULL -   stdin/stdout
+int RunCompileServer (const char* socket_path, CompileCache* cache);
+
+double LatencyPercentile (const CompileServer* server, double fraction);
+
+#endif
@@ -0,0 +1,90 @@
+#include "compiler_context.h"
+#include "compile_pipeline.h"
+#include "compile_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+void InitCompileOptions (CompileOptions* options)
+{
+    memset (options, 0, sizeof(CompileOptions));
+
+    options->opt_level = 1;
+    options->unroll_factor = -1;
+    options->stages = STAGE_DEFAULT;
+    options->cache_limit = COMPILE_CACHE_DEFAULT_LIMIT;
+    options->dump_detail = DEFAULT_DUMP_DETAIL;
+}
+
+// mkdir -p:     
+static int MakeDirectories (const char* dir)
+{
+    char path[MAX_CONTEXT_PATH] = "";
+    snprintf (path, sizeof(path), "%s", dir);
+
+    for (char* slash = strchr (path + 1, '/'); slash; slash = strchr (slash + 1, '/'))
+    {
+        *slash = '\0';
+        if (mkdir (path, 0755) != 0 && errno != EEXIST) return 0;
+        *slash = '/';
+    }
+
+    return mkdir (path, 0755) == 0 || errno == EEXIST;
+}
+
+CompilerContext* CtorCompilerContext (const char* output_dir, FILE* out, FILE* errors)
+{
+    if (output_dir && *output_dir && !MakeDirectories (output_dir))
+    {
+        fprintf (errors, "    %s\n", output_dir);
+        return NULL;
+    }
+
+    CompilerContext* ctx = (CompilerContext*) calloc (1, sizeof(CompilerContext));
+    if (!ctx) return NULL;
+
+    InitCompileOptions (&ctx->options);
+    snprintf (ctx->output_dir, sizeof(ctx->output_dir), "%s", output_dir ? output_dir : "");
+    ctx->out = out;
+    ctx->errors = errors;
+    ctx->html_dump_counter = 1;
+
+    ctx->renderer = CtorGraphvizRenderer (ctx->output_dir, out);
+    if (!ctx->renderer)
+    {
+        free (ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+void DtorCompilerContext (CompilerContext* ctx)
+{
+    if (!ctx) return;
+
+    //        Dtor-  
+    CloseHtmlFile (ctx);
+    DtorGraphvizRenderer (ctx->renderer);
+    DtorPassTrace (ctx->trace);
+    DtorMemoryAccounting (ctx->memory);
+
+    free (ctx);
+}
+
+const char* ContextPath (const CompilerContext* ctx, const char* name, char* path, size_t size)
+{
+    if (!ctx->output_dir[0] || name[0] == '/')
+        snprintf (path, size, "%s", name);
+    else
+        snprintf (path, size, "%s/%s", ctx->output_dir, name);
+
+    return path;
+}
+
+void BindCompilerContext (CompilerContext* ctx)
+{
+    active_trace = ctx ? ctx->trace : NULL;
+    memory_accounting = ctx ? ctx->memory : NULL;
+}
@@ -0,0 +1,66 @@
+#ifndef COMPILER_CONTEXT_H
+#define COMPILER_CONTEXT_H
+
+#include "create_AST_dump.h"
+#include "graphviz_render.h"
+#include "pass_trace.h"
+#include "memory_accounting.h"
+#include <stdio.h>
+
+//    - ,  main    
+typedef struct
+{
+    int opt_level;
+    int dump_ir;
+    int native;
+    int run;
+    int object;
+    int disasm;
+    int eval;
+    int unroll_factor;          // -1 -   
+    int stages;                 // PipelineStage
+    int time_passes;            // 1 - , 2 - JSON
+    const char* trace_file;
+    int mem_report;
+    const char* cache_dir;
+    long long cache_limit;
+    DumpDetail dump_detail;
+    int detail_dump;
+    const char* json_file;
+} CompileOptions;
+
+const int MAX_CONTEXT_PATH = 256;
+
+//       :    output_dir,
+//  -  out,  -  errors.    , 
+// ,          .
+struct CompilerContext
+{
+    CompileOptions options;
+
+    char output_dir[MAX_CONTEXT_PATH];      // "" -  
+    FILE* out;
+    FILE* errors;
+
+    FILE* html_file;                        // ast_dumps.html,   CreateHtmlDump
+    int html_dump_counter;
+    GraphvizRenderer* renderer;
+
+    PassTrace* trace;
+    MemoryAccounting* memory;
+};
+
+void InitCompileOptions (CompileOptions* options);
+
+//  ,   ;   
+CompilerContext* CtorCompilerContext (const char* output_dir, FILE* out, FILE* errors);
+void DtorCompilerContext (CompilerContext* ctx);
+
+//    : name  output_dir,  name -  
+const char* ContextPath (const CompilerContext* ctx, const char* name, char* path, size_t size);
+
+//       active_trace  memory_accounting
+//  ; NULL - 
+void BindCompilerContext (CompilerContext* ctx);
+
+#endif
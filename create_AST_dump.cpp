@@ -1,4 +1,7 @@
 #include "create_AST_dump.h"
+#include "compiler_context.h"
+#include "graphviz_render.h"
+#include "pass_trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,14 +16,36 @@ void SafePrintNodeType (FILE* dot_file, NodeType type)
     fprintf(dot_file, "%s", type_str);
 }
 
-void CreateGraphvizDump (Node* root, const char* filename)
+int CountTreeNodes (const Node* root)
 {
+    if (!root) return 0;
+
+    return 1 + CountTreeNodes (root->left) + CountTreeNodes (root->right);
+}
+
+void CreateGraphvizDump (CompilerContext* ctx, Node* root, const char* filename, char* svg_filename, size_t size)
+{
+    const DumpDetail* detail = CountTreeNodes (root) > GRAPHVIZ_FULL_DUMP_LIMIT ? &DEFAULT_DUMP_DETAIL : NULL;
+
+    CreateGraphvizDetailDump (ctx, root, filename, detail, svg_filename, size);
+}
+
+void CreateGraphvizDetailDump (CompilerContext* ctx, Node* root, const char* filename, const DumpDetail* detail,
+                               char* svg_filename, size_t size)
+{
+    assert (ctx);
     assert (filename);
 
-    FILE* dot_file = fopen (filename, "w");
+    char dot_path[MAX_CONTEXT_PATH] = "";
+    ContextPath (ctx, filename, dot_path, sizeof(dot_path));
+
+    //  dot     
+    ReleaseDotFile (ctx->renderer, dot_path);
+
+    FILE* dot_file = fopen (dot_path, "w");
     if (!dot_file)
     {
-        fprintf (stderr, "  DOT : %s\n", filename);
+        fprintf (ctx->errors, "  DOT : %s\n", filename);
         return;
     }
 
@@ -31,6 +56,10 @@ void CreateGraphvizDump (Node* root, const char* filename)
         fprintf (dot_file, "    empty [label=\"EMPTY TREE\\nRoot: NULL\", "
                            "shape=box, color=red, fontcolor=white];\n");
     }
+    else if (detail)
+    {
+        CreateGraphvizDetailNodes (dot_file, root, detail);
+    }
     else
     {
         CreateGraphvizNodes (dot_file, root);
@@ -40,7 +69,11 @@ void CreateGraphvizDump (Node* root, const char* filename)
     fprintf (dot_file, "}\n");
     fclose (dot_file);
 
-    GenerateImage (filename);
+    char image_filename[MAX_COMMAND_LENGTH] = "";
+    GenerateImage (ctx, filename, image_filename, sizeof(image_filename));
+
+    if (svg_filename)
+        snprintf (svg_filename, size, "%s", image_filename);
 }
 
 void CreateGraphvizHeader (FILE* dot_file)
@@ -65,7 +98,7 @@ void CreateGraphvizNodes(FILE* dot_file, Node* node)
     if (node->type == NODE_NUMBER) {
         fillcolor = "#445c00";
         color = "#fdfdfd";
-    } else if (node->type == NODE_VARIABLE || node->type == NODE_VAR_DECL) {
+    } else if (node->type == NODE_VARIABLE || node->type == NODE_VAR_DECL || node->type == NODE_PARAMETER) {
         fillcolor = "#2799a0";
         color = "#fdfdfd";
     } else if (node->type == NODE_FUNC_DECL || node->type == NODE_FUNC_CALL) {
@@ -103,6 +136,7 @@ void CreateGraphvizNodes(FILE* dot_file, Node* node)
 
         case NODE_VARIABLE:
         case NODE_VAR_DECL:
+        case NODE_PARAMETER:
         case NODE_FUNC_DECL:
         case NODE_FUNC_CALL:
             if (node->data.string_value)
@@ -111,7 +145,7 @@ void CreateGraphvizNodes(FILE* dot_file, Node* node)
                 SafePrintString (dot_file, node->data.string_value);
                 fprintf (dot_file, "</FONT></TD></TR>\n");
             }
-            if (node->type == NODE_VAR_DECL || node->type == NODE_FUNC_DECL) {
+            if (node->type == NODE_VAR_DECL || node->type == NODE_PARAMETER || node->type == NODE_FUNC_DECL) {
                 fprintf (dot_file, "        <TR><TD COLSPAN='2'>type: %d</TD></TR>\n", node->data.type_value);
             }
             break;
@@ -166,45 +200,301 @@ void CreateGraphvizEdges (FILE* dot_file, Node* node)
     CreateGraphvizEdges (dot_file, node->right);
 }
 
-void GenerateImage(const char* dot_filename)
+// dot   , svg   JoinGraphvizRenders
+typedef struct
+{
+    FILE* dot_file;
+    const DumpDetail* detail;
+    int shown;
+    int next_id;
+} DetailDumpState;
+
+//   SEQUENCE  ,       ;
+//     SEQUENCE
+static int CollectSequence (Node* node, Node*** items, int* count, int* capacity)
 {
-    static int image_counter = 1;
-    char command[MAX_COMMAND_LENGTH] = "";
-    char output_filename[MAX_COMMAND_LENGTH] = "";
+    if (!node) return 0;
+
+    if (node->type == NODE_SEQUENCE)
+        return 1 + CollectSequence (node->left, items, count, capacity) +
+                   CollectSequence (node->right, items, count, capacity);
+
+    if (*count >= *capacity)
+    {
+        int new_capacity = *capacity ? *capacity * 2 : 16;
+        Node** new_items = (Node**) realloc (*items, new_capacity * sizeof(Node*));
+        if (!new_items) return 0;
+        *items = new_items;
+        *capacity = new_capacity;
+    }
 
-    #ifdef _WIN32
-        system ("if not exist ast_images mkdir ast_images");
-    #else
-        system ("mkdir -p ast_images 2>/dev/null");
-    #endif
+    (*items)[(*count)++] = node;
+    return 0;
+}
+
+static int EmitCollapsedNode (DetailDumpState* state, int hidden_nodes, const char* what)
+{
+    int id = state->next_id++;
 
-    snprintf (output_filename, sizeof(output_filename), "ast_images/ast_dump%d.svg", image_counter);
+    fprintf (state->dot_file, "    n%d [label=\"... %s%d nodes\", shape=folder, fillcolor=\"#34495e\", "
+                              "fontcolor=\"#fdfdfd\"];\n", id, what, hidden_nodes);
+    return id;
+}
 
-    snprintf (command, sizeof(command), "dot -Tsvg -Gcharset=latin1 %s -o %s", dot_filename, output_filename);
+static void EmitDetailEdge (DetailDumpState* state, int from, int to, const char* label, const char* color)
+{
+    fprintf (state->dot_file, "    n%d -> n%d [color=\"%s\", fontcolor=\"%s\", label=\"%s\"];\n",
+             from, to, color, color, label);
+}
 
-    int result = system (command);
-    if (result != 0)
+//  :     ,    
+static int EmitDetailNode (DetailDumpState* state, Node* node, int depth)
+{
+    if (depth > state->detail->max_depth || state->shown >= state->detail->max_nodes)
+        return EmitCollapsedNode (state, CountTreeNodes (node), "");
+
+    int id = state->next_id++;
+    state->shown++;
+
+    if (node->type == NODE_SEQUENCE)
     {
-        printf("  SVG.   charset...\n");
-        snprintf (command, sizeof(command), "dot -Tsvg %s -o %s", dot_filename, output_filename);
-        system (command);
+        Node** items = NULL;
+        int count = 0, capacity = 0;
+        CollectSequence (node, &items, &count, &capacity);
+
+        fprintf (state->dot_file, "    n%d [label=\"SEQUENCE x%d\", shape=box, fillcolor=\"#3498db\", "
+                                  "fontcolor=\"#fdfdfd\"];\n", id, count);
+
+        int shown_items = count < state->detail->max_chain ? count : state->detail->max_chain;
+        for (int i = 0; i < shown_items; i++)
+        {
+            char label[32] = "";
+            snprintf (label, sizeof(label), "%d", i + 1);
+            EmitDetailEdge (state, id, EmitDetailNode (state, items[i], depth + 1), label, "#adebff");
+        }
+
+        if (count > shown_items)
+        {
+            int hidden = 0;
+            for (int i = shown_items; i < count; i++)
+                hidden += CountTreeNodes (items[i]);
+
+            char what[64] = "";
+            snprintf (what, sizeof(what), "%d more statements, ", count - shown_items);
+            EmitDetailEdge (state, id, EmitCollapsedNode (state, hidden, what), "...", "#adebff");
+        }
+
+        free (items);
+        return id;
     }
 
-    printf ("  : ast_images/ast_dump%d.svg\n", image_counter);
-    image_counter++;
+    fprintf (state->dot_file, "    n%d [label=\"%s", id, NodeTypeToString (node->type));
+    if (node->type == NODE_NUMBER)
+        fprintf (state->dot_file, "\\n%g", node->data.number_value);
+    else if (node->data.string_value)
+    {
+        fprintf (state->dot_file, "\\n");
+        SafePrintString (state->dot_file, node->data.string_value);
+    }
+    fprintf (state->dot_file, "\", shape=box, fillcolor=\"#2c3e50\", fontcolor=\"#fdfdfd\"];\n");
+
+    if (node->left)
+        EmitDetailEdge (state, id, EmitDetailNode (state, node->left, depth + 1), "L", "#adebff");
+    if (node->right)
+        EmitDetailEdge (state, id, EmitDetailNode (state, node->right, depth + 1), "R", "#ffadb1");
+
+    return id;
 }
 
-static FILE* html_file = NULL;
-static int html_dump_counter = 1;
+void CreateGraphvizDetailNodes (FILE* dot_file, Node* root, const DumpDetail* detail)
+{
+    DetailDumpState state = {dot_file, detail, 0, 0};
+
+    EmitDetailNode (&state, root, 0);
+}
 
-void CreateHtmlDump (Node* tree, const char* func, const char* reason, ...)
+//    :    ,     
+static int WriteTreeJson (FILE* out, Node* node)
 {
+    if (!node)
+    {
+        fprintf (out, "null");
+        return 0;
+    }
+
+    fprintf (out, "{\"type\":\"%s\"", NodeTypeToString (node->type));
+    if (node->type == NODE_NUMBER)
+        fprintf (out, ",\"value\":%.17g", node->data.number_value);
+    else if (node->data.string_value)
+    {
+        fprintf (out, ",\"name\":");
+        PrintJsonString (out, node->data.string_value);
+    }
+
+    int size = 1;
+
+    if (node->type == NODE_SEQUENCE)
+    {
+        Node** items = NULL;
+        int count = 0, capacity = 0;
+        size = CollectSequence (node, &items, &count, &capacity);
+
+        fprintf (out, ",\"chain\":true,\"children\":[");
+        for (int i = 0; i < count; i++)
+        {
+            if (i) fputc (',', out);
+            size += WriteTreeJson (out, items[i]);
+        }
+        fprintf (out, "]");
+
+        free (items);
+    }
+    else if (node->left || node->right)
+    {
+        fprintf (out, ",\"children\":[");
+        size += WriteTreeJson (out, node->left);
+        fputc (',', out);
+        size += WriteTreeJson (out, node->right);
+        fprintf (out, "]");
+    }
+
+    fprintf (out, ",\"size\":%d}", size);
+    return size;
+}
+
+int ExportTreeJson (CompilerContext* ctx, Node* root, const char* filename)
+{
+    char path[MAX_CONTEXT_PATH] = "";
+    FILE* out = fopen (ContextPath (ctx, filename, path, sizeof(path)), "w");
+    if (!out)
+    {
+        fprintf (ctx->errors, "  JSON : %s\n", filename);
+        return 0;
+    }
+
+    WriteTreeJson (out, root);
+    fputc ('\n', out);
+    fclose (out);
+
+    fprintf (ctx->out, "  JSON  : %s\n", filename);
+    return 1;
+}
+
+static const char tree_viewer_head[] =
+    "<!DOCTYPE html>\n"
+    "<html lang='ru'>\n"
+    "<head>\n"
+    "<meta charset='windows-1251'>\n"
+    "<title>AST Viewer</title>\n"
+    "<style>\n"
+    "  body { background-color: #001f29; color: #ffffff; font-family: monospace; }\n"
+    "  h1 { color: #00ccff; }\n"
+    "  ul { list-style: none; padding-left: 20px; margin: 0; }\n"
+    "  .node { cursor: pointer; }\n"
+    "  .node:before { content: '+ '; color: #00ccff; }\n"
+    "  .open > .node:before { content: '- '; }\n"
+    "  .leaf:before { content: '  '; white-space: pre; }\n"
+    "  .edge { color: #adebff; }\n"
+    "  .name { color: yellow; }\n"
+    "  .size { color: #95a5a6; }\n"
+    "  .more { cursor: pointer; color: #00ccff; }\n"
+    "</style>\n"
+    "</head>\n"
+    "<body>\n"
+    "<h1>AST</h1>\n"
+    "<div id='tree'></div>\n"
+    "<script type='application/json' id='ast-data'>";
+
+static const char tree_viewer_tail[] =
+    "</script>\n"
+    "<script>\n"
+    "var CHUNK = 200;\n"
+    "function span(cls, text) {\n"
+    "  var s = document.createElement('span'); s.className = cls; s.textContent = text; return s;\n"
+    "}\n"
+    "function item(n, edge) {\n"
+    "  var li = document.createElement('li');\n"
+    "  if (n === null) { li.appendChild(span('leaf edge', edge + ': nil')); return li; }\n"
+    "  var hasKids = n.children && n.children.some(function (c) { return c !== null; });\n"
+    "  var head = span(hasKids ? 'node' : 'leaf', '');\n"
+    "  head.appendChild(span('edge', edge + ': '));\n"
+    "  head.appendChild(document.createTextNode(n.chain ? 'SEQUENCE x' + n.children.length : n.type));\n"
+    "  if (n.name !== undefined) head.appendChild(span('name', ' ' + n.name));\n"
+    "  if (n.value !== undefined) head.appendChild(span('name', ' ' + n.value));\n"
+    "  if (hasKids) head.appendChild(span('size', ' [' + n.size + ' ]'));\n"
+    "  if (hasKids) head.onclick = function () { toggle(li, n); };\n"
+    "  li.appendChild(head);\n"
+    "  return li;\n"
+    "}\n"
+    "function toggle(li, n) {\n"
+    "  if (li.sub) { li.sub.hidden = !li.sub.hidden; li.classList.toggle('open'); return; }\n"
+    "  li.sub = document.createElement('ul'); li.appendChild(li.sub); li.classList.add('open');\n"
+    "  more(li.sub, n, 0);\n"
+    "}\n"
+    "function more(ul, n, from) {\n"
+    "  var kids = n.children, to = Math.min(kids.length, from + CHUNK);\n"
+    "  for (var i = from; i < to; i++)\n"
+    "    ul.appendChild(item(kids[i], n.chain ? String(i + 1) : (i ? 'R' : 'L')));\n"
+    "  if (to < kids.length) {\n"
+    "    var rest = document.createElement('li');\n"
+    "    rest.appendChild(span('more', '...  ' + (kids.length - to)));\n"
+    "    rest.onclick = function () { ul.removeChild(rest); more(ul, n, to); };\n"
+    "    ul.appendChild(rest);\n"
+    "  }\n"
+    "}\n"
+    "var root = JSON.parse(document.getElementById('ast-data').textContent);\n"
+    "var list = document.createElement('ul');\n"
+    "list.appendChild(item(root, 'root'));\n"
+    "document.getElementById('tree').appendChild(list);\n"
+    "</script>\n"
+    "</body>\n"
+    "</html>\n";
+
+int CreateTreeViewer (CompilerContext* ctx, Node* root, const char* filename)
+{
+    char path[MAX_CONTEXT_PATH] = "";
+    FILE* html = fopen (ContextPath (ctx, filename, path, sizeof(path)), "w");
+    if (!html)
+    {
+        fprintf (ctx->errors, "  HTML : %s\n", filename);
+        return 0;
+    }
+
+    // JSON   ASCII,  '<' : </script>    
+    fputs (tree_viewer_head, html);
+    WriteTreeJson (html, root);
+    fputs (tree_viewer_tail, html);
+    fclose (html);
+
+    fprintf (ctx->out, "   : %s\n", filename);
+    return 1;
+}
+
+void GenerateImage (CompilerContext* ctx, const char* dot_filename, char* svg_filename, size_t size)
+{
+    char dot_path[MAX_CONTEXT_PATH] = "";
+    ContextPath (ctx, dot_filename, dot_path, sizeof(dot_path));
+
+    if (!SubmitGraphvizRender (ctx->renderer, dot_path, svg_filename, size))
+    {
+        fprintf (ctx->out, "  DOT : %s\n", dot_filename);
+        return;
+    }
+
+    fprintf (ctx->out, "  : %s\n", svg_filename);
+}
+
+void CreateHtmlDump (CompilerContext* ctx, Node* tree, const char* func, const char* reason, ...)
+{
+    FILE* html_file = ctx->html_file;
+
     if (!html_file)
     {
-        html_file = fopen ("ast_dumps.html", "w");
+        char path[MAX_CONTEXT_PATH] = "";
+        html_file = ctx->html_file = fopen (ContextPath (ctx, "ast_dumps.html", path, sizeof(path)), "w");
         if (!html_file)
         {
-            fprintf (stderr, "  HTML \n");
+            fprintf (ctx->errors, "  HTML \n");
             return;
         }
 
@@ -225,7 +515,7 @@ void CreateHtmlDump (Node* tree, const char* func, const char* reason, ...)
     }
 
     fprintf (html_file, "<div class='dump'>\n");
-    fprintf (html_file, "<h2>Dump #%d</h2>\n", html_dump_counter);
+    fprintf (html_file, "<h2>Dump #%d</h2>\n", ctx->html_dump_counter);
     fprintf (html_file, "<p><b>:</b> %s</p>\n", func);
 
     va_list args = {};
@@ -239,146 +529,97 @@ void CreateHtmlDump (Node* tree, const char* func, const char* reason, ...)
     char dot_filename[MAX_COMMAND_LENGTH] = {};
     char svg_filename[MAX_COMMAND_LENGTH] = {};
 
-    snprintf (dot_filename, sizeof (dot_filename), "dump_%d.dot", html_dump_counter);
-    snprintf (svg_filename, sizeof (svg_filename), "ast_images/dump_%d.svg", html_dump_counter);
+    snprintf (dot_filename, sizeof (dot_filename), "dump_%d.dot", ctx->html_dump_counter);
 
-    CreateGraphvizDump (tree, dot_filename);
+    //     , img     svg
+    CreateGraphvizDump (ctx, tree, dot_filename, svg_filename, sizeof (svg_filename));
 
     fprintf (html_file, "<h3> AST</h3>\n");
-    fprintf (html_file, "<img src='%s' alt='AST Dump #%d'>\n", svg_filename, html_dump_counter);
+    fprintf (html_file, "<img src='%s' alt='AST Dump #%d'>\n", svg_filename, ctx->html_dump_counter);
 
     fprintf(html_file, "</div>\n");
     fflush(html_file);
 
-    html_dump_counter++;
+    ctx->html_dump_counter++;
 }
 
-void CloseHtmlFile(void)
+void CloseHtmlFile (CompilerContext* ctx)
 {
-    if (html_file)
+    JoinGraphvizRenders (ctx->renderer, ctx->out);
+
+    if (ctx->html_file)
     {
-        fprintf (html_file, "</body>\n</html>\n");
-        fclose (html_file);
-        html_file = NULL;
-        printf ("HTML   : ast_dumps.html\n");
+        fprintf (ctx->html_file, "</body>\n</html>\n");
+        fclose (ctx->html_file);
+        ctx->html_file = NULL;
+        fprintf (ctx->out, "HTML   : ast_dumps.html\n");
     }
 }
 
 const char* NodeTypeToString (NodeType type)
 {
-     switch ((int)type)
+     switch (type)
      {
-        case 0:  return "NODE_EMPTY";
-        case 1:  return "NODE_SEQUENCE";
-        case 2:  return "NODE_NUMBER";
-        case 3:  return "NODE_VARIABLE";
-        case 4:  return "NODE_ADD";
-        case 5:  return "NODE_SUB";
-        case 6:  return "NODE_MUL";
-        case 7:  return "NODE_DIV";
-        case 8:  return "NODE_EQ";
-        case 9:  return "NODE_NE";
-        case 10: return "NODE_GT";
-        case 11: return "NODE_LT";
-        case 12: return "NODE_ASSIGNMENT";
-        case 13: return "NODE_VAR_DECL";
-        case 14: return "NODE_FUNC_DECL";
-        case 15: return "NODE_FUNC_CALL";
-        case 16: return "NODE_IF";
-        case 17: return "NODE_RETURN";
-        case 18: return "NODE_TYPE_INT";
-        case 19: return "NODE_TYPE_CHAR";
-        case 20: return "NODE_TYPE_DOUBLE";
-        default: return "UNKNOWN";
+        case NODE_EMPTY:       return "NODE_EMPTY";
+        case NODE_SEQUENCE:    return "NODE_SEQUENCE";
+        case NODE_NUMBER:      return "NODE_NUMBER";
+        case NODE_VARIABLE:    return "NODE_VARIABLE";
+        case NODE_ADD:         return "NODE_ADD";
+        case NODE_SUB:         return "NODE_SUB";
+        case NODE_MUL:         return "NODE_MUL";
+        case NODE_DIV:         return "NODE_DIV";
+        case NODE_EQ:          return "NODE_EQ";
+        case NODE_NE:          return "NODE_NE";
+        case NODE_GT:          return "NODE_GT";
+        case NODE_LT:          return "NODE_LT";
+        case NODE_ASSIGNMENT:  return "NODE_ASSIGNMENT";
+        case NODE_VAR_DECL:    return "NODE_VAR_DECL";
+        case NODE_FUNC_DECL:   return "NODE_FUNC_DECL";
+        case NODE_FUNC_CALL:   return "NODE_FUNC_CALL";
+        case NODE_IF:          return "NODE_IF";
+        case NODE_WHILE:       return "NODE_WHILE";
+        case NODE_RETURN:      return "NODE_RETURN";
+        case NODE_TYPE_INT:    return "NODE_TYPE_INT";
+        case NODE_TYPE_CHAR:   return "NODE_TYPE_CHAR";
+        case NODE_TYPE_DOUBLE: return "NODE_TYPE_DOUBLE";
+        case NODE_PARAMETER:   return "NODE_PARAMETER";
+        case NODE_ARGUMENT:    return "NODE_ARGUMENT";
+        case NODE_ERROR:       return "NODE_ERROR";
+        default:               return "UNKNOWN";
     }
 }
 
+//  ,   :     .
+//  -   cp1251  0xC0 ()  0xE0 ()
+static const char* const translit_upper[32] =
+{
+    "A", "B", "V", "G", "D", "E", "Zh", "Z",
+    "I", "J", "K", "L", "M", "N", "O", "P",
+    "R", "S", "T", "U", "F", "H", "C", "Ch",
+    "Sh", "Sch", "\"", "Y", "'", "E", "Yu", "Ya",
+};
+
+static const char* const translit_lower[32] =
+{
+    "a", "b", "v", "g", "d", "e", "zh", "z",
+    "i", "j", "k", "l", "m", "n", "o", "p",
+    "r", "s", "t", "u", "f", "h", "c", "ch",
+    "sh", "sch", "\"", "y", "'", "e", "yu", "ya",
+};
+
 static const char* TransliterateChar(unsigned char c)
 {
-    static const char* translit[256] = {NULL};
-    static int initialized = 0;
+    if (c >= 0xE0) return translit_lower[c - 0xE0];
+    if (c >= 0xC0) return translit_upper[c - 0xC0];
 
-    if (!initialized)
+    switch (c)
     {
-        for (int i = 0; i < 256; i++) translit[i] = NULL;
-
-        //    (CP1251)
-        translit[0xC0] = "A";   // 
-        translit[0xC1] = "B";   // 
-        translit[0xC2] = "V";   // 
-        translit[0xC3] = "G";   // 
-        translit[0xC4] = "D";   // 
-        translit[0xC5] = "E";   // 
-        translit[0xA8] = "Yo";  // 
-        translit[0xC6] = "Zh";  // 
-        translit[0xC7] = "Z";   // 
-        translit[0xC8] = "I";   // 
-        translit[0xC9] = "J";   // 
-        translit[0xCA] = "K";   // 
-        translit[0xCB] = "L";   // 
-        translit[0xCC] = "M";   // 
-        translit[0xCD] = "N";   // 
-        translit[0xCE] = "O";   // 
-        translit[0xCF] = "P";   // 
-        translit[0xD0] = "R";   // 
-        translit[0xD1] = "S";   // 
-        translit[0xD2] = "T";   // 
-        translit[0xD3] = "U";   // 
-        translit[0xD4] = "F";   // 
-        translit[0xD5] = "H";   // 
-        translit[0xD6] = "C";   // 
-        translit[0xD7] = "Ch";  // 
-        translit[0xD8] = "Sh";  // 
-        translit[0xD9] = "Sch"; // 
-        translit[0xDA] = "\"";  // 
-        translit[0xDB] = "Y";   // 
-        translit[0xDC] = "'";   // 
-        translit[0xDD] = "E";   // 
-        translit[0xDE] = "Yu";  // 
-        translit[0xDF] = "Ya";  // 
-
-        //   
-        translit[0xE0] = "a";   // 
-        translit[0xE1] = "b";   // 
-        translit[0xE2] = "v";   // 
-        translit[0xE3] = "g";   // 
-        translit[0xE4] = "d";   // 
-        translit[0xE5] = "e";   // 
-        translit[0xB8] = "yo";  // 
-        translit[0xE6] = "zh";  // 
-        translit[0xE7] = "z";   // 
-        translit[0xE8] = "i";   // 
-        translit[0xE9] = "j";   // 
-        translit[0xEA] = "k";   // 
-        translit[0xEB] = "l";   // 
-        translit[0xEC] = "m";   // 
-        translit[0xED] = "n";   // 
-        translit[0xEE] = "o";   // 
-        translit[0xEF] = "p";   // 
-        translit[0xF0] = "r";   // 
-        translit[0xF1] = "s";   // 
-        translit[0xF2] = "t";   // 
-        translit[0xF3] = "u";   // 
-        translit[0xF4] = "f";   // 
-        translit[0xF5] = "h";   // 
-        translit[0xF6] = "c";   // 
-        translit[0xF7] = "ch";  // 
-        translit[0xF8] = "sh";  // 
-        translit[0xF9] = "sch"; // 
-        translit[0xFA] = "\"";  // 
-        translit[0xFB] = "y";   // 
-        translit[0xFC] = "'";   // 
-        translit[0xFD] = "e";   // 
-        translit[0xFE] = "yu";  // 
-        translit[0xFF] = "ya";  // 
-
-        translit[0x2D] = "-";
-        translit[0x5F] = "_";
-
-        initialized = 1;
+        case 0xA8: return "Yo";  // 
+        case 0xB8: return "yo";  // 
+        case 0x2D: return "-";
+        case 0x5F: return "_";
+        default:   return NULL;
     }
-
-    return translit[c];
 }
 
 void SafePrintString(FILE* dot_file, const char* str)
@@ -405,8 +646,7 @@ void SafePrintString(FILE* dot_file, const char* str)
                 default: fputc (c, dot_file); break;
             }
         }
-        else if ((c >= 0xC0 && c <= 0xDF) ||  // - ( )
-                 (c >= 0xE0 && c <= 0xFF) ||  // - ( )
+        else if (c >= 0xC0 ||                 // -  0xC0, -  0xE0   
                  c == 0xA8 || c == 0xB8)
         {
             const char* translit = TransliterateChar (c);
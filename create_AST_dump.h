@@ -5,17 +5,49 @@
 #include <stdarg.h>
 #include <stdio.h>
 
-void CreateGraphvizDump (Node* root, const char* filename);
+struct CompilerContext;
+
+//   :  max_depth   max_nodes  
+//          ;   SEQUENCE
+//   max_chain ,  -  
+typedef struct
+{
+    int max_depth;
+    int max_nodes;
+    int max_chain;
+} DumpDetail;
+
+const DumpDetail DEFAULT_DUMP_DETAIL = {12, 400, 16};
+//      ,   
+const int GRAPHVIZ_FULL_DUMP_LIMIT = 1000;
+
+//   -   ,    svg;
+//    ctx->out,  -  ctx->errors.
+// svg   ;    -  svg_filename,    NULL.
+//   GRAPHVIZ_FULL_DUMP_LIMIT   DEFAULT_DUMP_DETAIL.
+void CreateGraphvizDump (CompilerContext* ctx, Node* root, const char* filename,
+                         char* svg_filename, size_t size);
+// detail == NULL -     
+void CreateGraphvizDetailDump (CompilerContext* ctx, Node* root, const char* filename,
+                               const DumpDetail* detail, char* svg_filename, size_t size);
+int CountTreeNodes (const Node* root);
+
+//    JSON: {"type", "name" | "value", "children", "size"};
+//  SEQUENCE      "chain": true
+int ExportTreeJson (CompilerContext* ctx, Node* root, const char* filename);
+//      JSON :    ,
+//     ,   - 
+int CreateTreeViewer (CompilerContext* ctx, Node* root, const char* filename);
 void CreateGraphvizHeader (FILE* dot_file);
 void CreateGraphvizNodes (FILE* dot_file, Node* node);
 void CreateGraphvizEdges (FILE* dot_file, Node* node);
-void GenerateImage (const char* dot_filename);
-void CreateHtmlDump (Node* tree, const char* func, const char* reason, ...);
-void CloseHtmlFile (void);
+void CreateGraphvizDetailNodes (FILE* dot_file, Node* root, const DumpDetail* detail);
+void GenerateImage (CompilerContext* ctx, const char* dot_filename, char* svg_filename, size_t size);
+void CreateHtmlDump (CompilerContext* ctx, Node* tree, const char* func, const char* reason, ...);
+void CloseHtmlFile (CompilerContext* ctx);
 const char* NodeTypeToString (NodeType type);
 void EscapeHtml (FILE* html_file, const char* text, size_t len);
 void SafePrintString (FILE* dot_file, const char* str);
 void SafePrintNodeType (FILE* dot_file, NodeType type);
-static void TransliterateToLatin(FILE* dot_file, const char* str);
 
 #endif
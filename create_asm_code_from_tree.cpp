@@ -1,4 +1,11 @@
 #include "create_asm_code_from_tree.h"
+#include "register_allocation.h"
+#include "calling_convention.h"
+#include "ssa_ir.h"
+#include "type_checking.h"
+#include "compile_cache.h"
+#include "pass_trace.h"
+#include "memory_accounting.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,23 +18,31 @@ CodeGenContext* CtorCodeGen(FILE* output)
 
     ctx->output = output;
     ctx->label_counter = 0;
-    ctx->var_counter = 0;
+    ctx->data_size = 0;
     ctx->temp_counter = 0;
     ctx->var_count = 0;
     ctx->func_count = 0;
     ctx->in_function = 0;
     ctx->current_func = NULL;
+    ctx->current_decl = NULL;
+    ctx->callee_saved = 0;
+    ctx->entry_label = -1;
+    ctx->reg_plan = NULL;
+    ctx->reg_plan_count = 0;
+    ctx->opt_level = 1;
+    ctx->dump_ir = 0;
+    ctx->cache = NULL;
 
     ctx->var_capacity = 20;
     ctx->func_capacity = 10;
 
-    ctx->var_table = (VariableInfo*) calloc (ctx->var_capacity, sizeof(VariableInfo));
-    ctx->func_table = (FunctionInfo*) calloc (ctx->func_capacity, sizeof(FunctionInfo));
+    ctx->var_table = (VariableInfo*) MemAlloc (MEM_VARIABLES, ctx->var_capacity, sizeof(VariableInfo));
+    ctx->func_table = (FunctionInfo*) MemAlloc (MEM_FUNCTIONS, ctx->func_capacity, sizeof(FunctionInfo));
 
     if (!ctx->var_table || !ctx->func_table)
     {
-        if (ctx->var_table) free (ctx->var_table);
-        if (ctx->func_table) free (ctx->func_table);
+        MemFree (MEM_VARIABLES, ctx->var_table);
+        MemFree (MEM_FUNCTIONS, ctx->func_table);
         free (ctx);
         return NULL;
     }
@@ -40,16 +55,21 @@ void DtorCodeGen (CodeGenContext* ctx)
     if (!ctx) return;
 
     for (int i = 0; i < ctx->var_count; i++)
-        free (ctx->var_table[i].name);
+    {
+        MemFree (MEM_VARIABLES, ctx->var_table[i].name);
+        MemFree (MEM_VARIABLES, ctx->var_table[i].owner);
+    }
 
-    free (ctx->var_table);
+    MemFree (MEM_VARIABLES, ctx->var_table);
 
     for (int i = 0; i < ctx->func_count; i++)
-        free (ctx->func_table[i].name);
+        MemFree (MEM_FUNCTIONS, ctx->func_table[i].name);
+
+    MemFree (MEM_FUNCTIONS, ctx->func_table);
 
-    free (ctx->func_table);
+    MemFree (MEM_FUNCTIONS, ctx->current_func);
 
-    free (ctx->current_func);
+    FreeRegisterPlan (ctx);
 
     if (ctx->output && ctx->output != stdout && ctx->output != stderr)
         fclose (ctx->output);
@@ -58,39 +78,60 @@ void DtorCodeGen (CodeGenContext* ctx)
 }
 
 int NewLabel(CodeGenContext* ctx) {
+    TRACE_COUNT (COUNTER_LABELS, 1);
     return ctx->label_counter++;
 }
 
-int AddVariable (CodeGenContext* ctx, const char* var_name, int is_local)
+//     
+static int IsOwnLocal (CodeGenContext* ctx, const VariableInfo* var)
 {
+    return var->is_local && var->owner && ctx->current_func && strcmp (var->owner, ctx->current_func) == 0;
+}
+
+//       ,     .
+//      :      ,
+//  ,    ,   .  
+//      .
+int AddVariable (CodeGenContext* ctx, const char* var_name, int is_local, NodeType type)
+{
+    type = DeclaredType (type);
+    int size = TypeSize (type);
+
     for (int i = 0; i < ctx->var_count; i++)
     {
-        if (strcmp(ctx->var_table[i].name, var_name) == 0 &&
-            ctx->var_table[i].is_local == is_local)
-            return ctx->var_table[i].address;
+        VariableInfo* var = &ctx->var_table[i];
+        if (strcmp(var->name, var_name) != 0 || var->is_local != is_local)
+            continue;
+        if (is_local && !IsOwnLocal (ctx, var))
+            continue;
+
+        if (var->type != type)
+        {
+            var->address = (ctx->data_size + size - 1) / size * size;
+            var->type = type;
+            ctx->data_size = var->address + size;
+        }
+
+        return var->address;
     }
 
     if (ctx->var_count >= ctx->var_capacity)
     {
         ctx->var_capacity *= 2;
-        VariableInfo* new_table = (VariableInfo*) realloc (ctx->var_table,
-                                                          ctx->var_capacity * sizeof(VariableInfo));
+        VariableInfo* new_table = (VariableInfo*) MemRealloc (MEM_VARIABLES, ctx->var_table,
+                                                              ctx->var_capacity * sizeof(VariableInfo));
         if (!new_table) return -1;
         ctx->var_table = new_table;
     }
 
-    ctx->var_table[ctx->var_count].name = strdup (var_name);
+    ctx->var_table[ctx->var_count].name = MemStrdup (MEM_VARIABLES, var_name);
     ctx->var_table[ctx->var_count].is_local = is_local;
-
-    if (is_local)
-    {
-        ctx->var_table[ctx->var_count].address = 400 -(ctx->var_count + 1) * 4;
-    }
-    else
-    {
-        ctx->var_table[ctx->var_count].address = ctx->var_counter * 4;
-        ctx->var_counter++;
-    }
+    ctx->var_table[ctx->var_count].owner = is_local && ctx->current_func ?
+                                           MemStrdup (MEM_VARIABLES, ctx->current_func) : NULL;
+    ctx->var_table[ctx->var_count].reg = -1;
+    ctx->var_table[ctx->var_count].type = type;
+    ctx->var_table[ctx->var_count].address = (ctx->data_size + size - 1) / size * size;
+    ctx->data_size = ctx->var_table[ctx->var_count].address + size;
 
     int address = ctx->var_table[ctx->var_count].address;
     ctx->var_count++;
@@ -109,15 +150,17 @@ int AddFunction(CodeGenContext* ctx, const char* func_name)
     if (ctx->func_count >= ctx->func_capacity)
     {
         ctx->func_capacity *= 2;
-        FunctionInfo* new_table = (FunctionInfo*) realloc (ctx->func_table,
-                                                          ctx->func_capacity * sizeof(FunctionInfo));
+        FunctionInfo* new_table = (FunctionInfo*) MemRealloc (MEM_FUNCTIONS, ctx->func_table,
+                                                              ctx->func_capacity * sizeof(FunctionInfo));
         if (!new_table) return -1;
         ctx->func_table = new_table;
     }
 
-    ctx->func_table[ctx->func_count].name = strdup (func_name);
+    ctx->func_table[ctx->func_count].name = MemStrdup (MEM_FUNCTIONS, func_name);
     ctx->func_table[ctx->func_count].start_label = NewLabel (ctx);
     ctx->func_table[ctx->func_count].local_var_count = 0;
+    ctx->func_table[ctx->func_count].param_count = 0;
+    ctx->func_table[ctx->func_count].decl = NULL;
 
     int label = ctx->func_table[ctx->func_count].start_label;
     ctx->func_count++;
@@ -125,15 +168,63 @@ int AddFunction(CodeGenContext* ctx, const char* func_name)
     return label;
 }
 
-int GetVarAddress(CodeGenContext* ctx, const char* var_name)
+int FindFunctionLabel (CodeGenContext* ctx, const char* func_name)
+{
+    for (int i = 0; i < ctx->func_count; i++)
+    {
+        if (strcmp(ctx->func_table[i].name, func_name) == 0)
+            return ctx->func_table[i].start_label;
+    }
+
+    return -1;
+}
+
+FunctionInfo* FindFunctionInfo (CodeGenContext* ctx, const char* func_name)
+{
+    for (int i = 0; i < ctx->func_count; i++)
+    {
+        if (strcmp(ctx->func_table[i].name, func_name) == 0)
+            return &ctx->func_table[i];
+    }
+
+    return NULL;
+}
+
+//      :     ,
+//     :func_0,     
+void DeclareFunctions (CodeGenContext* ctx, Node* node)
+{
+    if (!node) return;
+
+    if (node->type == NODE_FUNC_DECL)
+    {
+        AddFunction (ctx, node->data.string_value);
+
+        FunctionInfo* func = FindFunctionInfo (ctx, node->data.string_value);
+        if (!func->decl)
+        {
+            func->param_count = CountParameters (node);
+            func->decl = node;
+        }
+        return;
+    }
+
+    if (node->type == NODE_SEQUENCE)
+    {
+        DeclareFunctions (ctx, node->left);
+        DeclareFunctions (ctx, node->right);
+    }
+}
+
+VariableInfo* FindVariable (CodeGenContext* ctx, const char* var_name)
 {
     if (ctx->in_function)
     {
         for (int i = 0; i < ctx->var_count; i++)
         {
             if (strcmp(ctx->var_table[i].name, var_name) == 0 &&
-                ctx->var_table[i].is_local)
-                return ctx->var_table[i].address;
+                IsOwnLocal (ctx, &ctx->var_table[i]))
+                return &ctx->var_table[i];
         }
     }
 
@@ -141,26 +232,177 @@ int GetVarAddress(CodeGenContext* ctx, const char* var_name)
     {
         if (strcmp(ctx->var_table[i].name, var_name) == 0 &&
             !ctx->var_table[i].is_local)
-            return ctx->var_table[i].address;
+            return &ctx->var_table[i];
     }
 
-    return AddVariable (ctx, var_name, 0);
+    return NULL;
+}
+
+int GetVarAddress(CodeGenContext* ctx, const char* var_name)
+{
+    VariableInfo* var = FindVariable (ctx, var_name);
+    if (var)
+        return var->address;
+
+    //   -  double,    
+    return AddVariable (ctx, var_name, 0, NODE_TYPE_DOUBLE);
+}
+
+//          type
+void GenLoadVariable (CodeGenContext* ctx, const char* var_name, NodeType type)
+{
+    int addr = GetVarAddress (ctx, var_name);
+    VariableInfo* var = FindVariable (ctx, var_name);
+
+    if (var->reg >= 0)
+        fprintf (ctx->output, "PUSHR %s\n", RegisterName (var->reg));
+    else
+    {
+        fprintf (ctx->output, "PUSH %d\n", addr);
+        fprintf (ctx->output, "POPR RAX\n");
+        fprintf (ctx->output, "%s RAX\n", LoadOpcode (var->type));
+    }
+
+    GenConvert (ctx, var->type, type);
+}
+
+//     type:       
+void GenStoreVariable (CodeGenContext* ctx, const char* var_name, NodeType type)
+{
+    int addr = GetVarAddress (ctx, var_name);
+    VariableInfo* var = FindVariable (ctx, var_name);
+
+    GenConvert (ctx, type, var->type);
+
+    if (var->reg >= 0)
+    {
+        fprintf (ctx->output, "POPR %s\n", RegisterName (var->reg));
+        return;
+    }
+
+    //      POPM: RBX    
+    fprintf (ctx->output, "PUSH %d\n", addr);
+    fprintf (ctx->output, "POPR RAX\n");
+    fprintf (ctx->output, "%s RAX\n", StoreOpcode (var->type));
+}
+
+//   -      I: IADD, IJA, ...
+const char* TypedOpcodePrefix (NodeType type)
+{
+    return IsIntegerType (type) ? "I" : "";
+}
+
+// char    int,  char -> int   
+void GenConvert (CodeGenContext* ctx, NodeType from, NodeType to)
+{
+    from = DeclaredType (from);
+    to = DeclaredType (to);
+
+    if (from == to || (from == NODE_TYPE_CHAR && to == NODE_TYPE_INT))
+        return;
+
+    if (to == NODE_TYPE_DOUBLE)
+    {
+        fprintf (ctx->output, "ITOF\n");
+        return;
+    }
+
+    if (from == NODE_TYPE_DOUBLE)
+        fprintf (ctx->output, "FTOI\n");
+
+    if (to == NODE_TYPE_CHAR)
+        fprintf (ctx->output, "ITOB\n");
+}
+
+// 17  :    1/3   
+//    double,    
+void GenPushConstant (CodeGenContext* ctx, double value, NodeType type)
+{
+    value = ConvertValue (value, type);
+
+    if (IsIntegerType (type))
+        fprintf (ctx->output, "IPUSH %d\n", (int) value);
+    else
+        fprintf (ctx->output, "PUSH %.17g\n", value);
+}
+
+//    ,  -   
+void GenTypedExpression (CodeGenContext* ctx, Node* node, NodeType type)
+{
+    if (!node)
+    {
+        GenPushConstant (ctx, 0, type);
+        return;
+    }
+
+    if (node->type == NODE_NUMBER)
+    {
+        GenPushConstant (ctx, node->data.number_value, type);
+        return;
+    }
+
+    if (node->type == NODE_VARIABLE)
+    {
+        GenLoadVariable (ctx, node->data.string_value, type);
+        return;
+    }
+
+    GenExpression (ctx, node);
+    GenConvert (ctx, ExpressionType (node), type);
 }
 
 void EnterFunction (CodeGenContext* ctx, const char* func_name)
 {
-    free (ctx->current_func);
-    ctx->current_func = strdup (func_name);
+    MemFree (MEM_FUNCTIONS, ctx->current_func);
+    ctx->current_func = MemStrdup (MEM_FUNCTIONS, func_name);
     ctx->in_function = 1;
 }
 
 void ExitFunction (CodeGenContext* ctx)
 {
-    free (ctx->current_func);
+    for (int i = 0; i < ctx->var_count; i++)
+    {
+        if (ctx->var_table[i].is_local)
+            ctx->var_table[i].reg = -1;
+    }
+
+    FreeRegisterPlan (ctx);
+
+    MemFree (MEM_FUNCTIONS, ctx->current_func);
     ctx->current_func = NULL;
+    ctx->current_decl = NULL;
+    ctx->callee_saved = 0;
+    ctx->entry_label = -1;
     ctx->in_function = 0;
 }
 
+static const char* ArithmeticOpcode (NodeType type)
+{
+    switch (type)
+    {
+        case NODE_ADD: return "ADD";
+        case NODE_SUB: return "SUB";
+        case NODE_MUL: return "MUL";
+        case NODE_DIV: return "DIV";
+        default:       return NULL;
+    }
+}
+
+//    ;   - InverseJump
+static const char* ConditionJump (NodeType type)
+{
+    switch (type)
+    {
+        case NODE_GT: return "JA";
+        case NODE_LT: return "JB";
+        case NODE_EQ: return "JE";
+        case NODE_NE: return "JNE";
+        default:      return NULL;
+    }
+}
+
+//        ExpressionType (node):
+//     ,     I*
 void GenExpression (CodeGenContext* ctx, Node* node)
 {
     if (!node) return;
@@ -168,113 +410,47 @@ void GenExpression (CodeGenContext* ctx, Node* node)
     switch (node->type)
     {
         case NODE_NUMBER:
-            fprintf (ctx->output, "PUSH %g\n", node->data.number_value);
+            GenPushConstant (ctx, node->data.number_value, ExpressionType (node));
             break;
 
         case NODE_VARIABLE:
-        {
-            int addr = GetVarAddress (ctx, node->data.string_value);
-            fprintf (ctx->output, "PUSH %d\n", addr);
-            fprintf (ctx->output, "POPR RAX\n");
-            fprintf (ctx->output, "PUSHM RAX\n");
+            GenLoadVariable (ctx, node->data.string_value, ExpressionType (node));
             break;
-        }
 
         case NODE_ADD:
-            GenExpression (ctx, node->left);
-            GenExpression (ctx, node->right);
-            fprintf (ctx->output, "ADD\n");
-            break;
-
         case NODE_SUB:
-            GenExpression (ctx, node->left);
-            GenExpression (ctx, node->right);
-            fprintf (ctx->output, "SUB\n");
-            break;
-
         case NODE_MUL:
-            GenExpression (ctx, node->left);
-            GenExpression (ctx, node->right);
-            fprintf (ctx->output, "MUL\n");
-            break;
-
         case NODE_DIV:
-            GenExpression (ctx, node->left);
-            GenExpression (ctx, node->right);
-            fprintf (ctx->output, "DIV\n");
-            break;
-
-        case NODE_EQ:
         {
-            GenExpression (ctx, node->left);
-            GenExpression (ctx, node->right);
-            fprintf (ctx->output, "SUB\n");
+            NodeType type = OperandType (node);
 
-            int true_label = NewLabel (ctx);
-            int end_label = NewLabel (ctx);
-
-            fprintf (ctx->output, "PUSH 0\n");
-            fprintf (ctx->output, "JE :label_%d\n", true_label);
-            fprintf (ctx->output, "PUSH 0\n");  // false
-            fprintf (ctx->output, "JMP :label_%d\n", end_label);
-            fprintf (ctx->output, ":label_%d\n", true_label);
-            fprintf (ctx->output, "PUSH 1\n");  // true
-            fprintf (ctx->output, ":label_%d\n", end_label);
+            GenTypedExpression (ctx, node->left, type);
+            GenTypedExpression (ctx, node->right, type);
+            fprintf (ctx->output, "%s%s\n", TypedOpcodePrefix (type), ArithmeticOpcode (node->type));
             break;
         }
 
+        //   int 0  1;   ,  ,
+        //   int   
+        case NODE_EQ:
         case NODE_NE:
-        {
-            GenExpression (ctx, node->left);
-            GenExpression (ctx, node->right);
-            fprintf (ctx->output, "SUB\n");
-
-            int true_label = NewLabel (ctx);
-            int end_label = NewLabel (ctx);
-
-            fprintf (ctx->output, "PUSH 0\n");
-            fprintf (ctx->output, "JNE :label_%d\n", true_label);
-            fprintf (ctx->output, "PUSH 0\n");
-            fprintf (ctx->output, "JMP :label_%d\n", end_label);
-            fprintf (ctx->output, ":label_%d\n", true_label);
-            fprintf (ctx->output, "PUSH 1\n");
-            fprintf (ctx->output, ":label_%d\n", end_label);
-            break;
-        }
         case NODE_GT:
-        {
-            GenExpression (ctx, node->left);
-            GenExpression (ctx, node->right);
-            fprintf (ctx->output, "SUB\n");
-
-            int true_label = NewLabel (ctx);
-            int end_label = NewLabel (ctx);
-
-            fprintf (ctx->output, "PUSH 0\n");
-            fprintf (ctx->output, "JA :label_%d\n", true_label);
-            fprintf (ctx->output, "PUSH 0\n");
-            fprintf (ctx->output, "JMP :label_%d\n", end_label);
-            fprintf (ctx->output, ":label_%d\n", true_label);
-            fprintf (ctx->output, "PUSH 1\n");
-            fprintf (ctx->output, ":label_%d\n", end_label);
-            break;
-        }
-
         case NODE_LT:
         {
-            GenExpression (ctx, node->left);
-            GenExpression (ctx, node->right);
-            fprintf (ctx->output, "SUB\n");
+            NodeType type = OperandType (node);
+
+            GenTypedExpression (ctx, node->left, type);
+            GenTypedExpression (ctx, node->right, type);
 
             int true_label = NewLabel (ctx);
             int end_label = NewLabel (ctx);
 
-            fprintf (ctx->output, "PUSH 0\n");
-            fprintf (ctx->output, "JB :label_%d\n", true_label);
-            fprintf (ctx->output, "PUSH 0\n");
+            fprintf (ctx->output, "%s%s :label_%d\n", TypedOpcodePrefix (type),
+                     ConditionJump (node->type), true_label);
+            fprintf (ctx->output, "IPUSH 0\n");  // false
             fprintf (ctx->output, "JMP :label_%d\n", end_label);
             fprintf (ctx->output, ":label_%d\n", true_label);
-            fprintf (ctx->output, "PUSH 1\n");
+            fprintf (ctx->output, "IPUSH 1\n");  // true
             fprintf (ctx->output, ":label_%d\n", end_label);
             break;
         }
@@ -293,17 +469,15 @@ void GenAssignment (CodeGenContext* ctx, Node* node)
 {
     if (!node || node->type != NODE_ASSIGNMENT) return;
 
-    GenExpression (ctx, node->right);
-
     if (node->left && node->left->type == NODE_VARIABLE)
     {
-        int addr = GetVarAddress (ctx, node->left->data.string_value);
+        NodeType type = ExpressionType (node->left);
 
-        fprintf (ctx->output, "POPR RBX\n");
-        fprintf (ctx->output, "PUSH %d\n", addr);
-        fprintf (ctx->output, "POPR RAX\n");
-        fprintf (ctx->output, "POPM RAX\n");
+        GenTypedExpression (ctx, node->right, type);
+        GenStoreVariable (ctx, node->left->data.string_value, type);
     }
+    else
+        GenExpression (ctx, node->right);
 }
 
 void GenSequence(CodeGenContext* ctx, Node* node)
@@ -314,25 +488,68 @@ void GenSequence(CodeGenContext* ctx, Node* node)
     GenerateCode (ctx, node->right);
 }
 
+//    : JBE/JAE/JNE/JE   0/1    
+static const char* InverseJump (NodeType type)
+{
+    switch (type)
+    {
+        case NODE_GT: return "JBE";
+        case NODE_LT: return "JAE";
+        case NODE_EQ: return "JNE";
+        case NODE_NE: return "JE";
+        default:      return NULL;
+    }
+}
+
+//  NaN   a > b,  a <= b:  double  JBE/JAE  ,
+//       ,    - 
+static int InverseIsExact (NodeType cond, NodeType type)
+{
+    return IsIntegerType (type) || cond == NODE_EQ || cond == NODE_NE;
+}
+
+void GenCondJump (CodeGenContext* ctx, Node* cond, int false_label)
+{
+    if (!cond) return;
+
+    const char* jump = InverseJump (cond->type);
+    NodeType type = OperandType (cond);
+
+    if (jump)
+    {
+        GenTypedExpression (ctx, cond->left, type);
+        GenTypedExpression (ctx, cond->right, type);
+
+        if (InverseIsExact (cond->type, type))
+        {
+            fprintf (ctx->output, "%s%s :label_%d\n", TypedOpcodePrefix (type), jump, false_label);
+            return;
+        }
+
+        int body_label = NewLabel (ctx);
+        fprintf (ctx->output, "%s :label_%d\n", ConditionJump (cond->type), body_label);
+        fprintf (ctx->output, "JMP :label_%d\n", false_label);
+        fprintf (ctx->output, ":label_%d\n", body_label);
+        return;
+    }
+
+    GenExpression (ctx, cond);
+
+    GenPushConstant (ctx, 0, type);
+    fprintf (ctx->output, "%sJE :label_%d\n", TypedOpcodePrefix (type), false_label);
+}
+
 void GenIf(CodeGenContext* ctx, Node* node)
 {
     if (!node || node->type != NODE_IF) return;
 
     int false_label = NewLabel (ctx);
-    int end_label = NewLabel (ctx);
-
-    GenExpression (ctx, node->left);
 
-    fprintf (ctx->output, "PUSH 0\n");
-    fprintf (ctx->output, "JE :label_%d\n", false_label);
+    GenCondJump (ctx, node->left, false_label);
 
     GenerateCode (ctx, node->right);
 
-    fprintf (ctx->output, "JMP :label_%d\n", end_label);
-
     fprintf (ctx->output, ":label_%d\n", false_label);
-
-    fprintf (ctx->output, ":label_%d\n", end_label);
 }
 
 void GenWhile (CodeGenContext* ctx, Node* node)
@@ -344,10 +561,7 @@ void GenWhile (CodeGenContext* ctx, Node* node)
 
     fprintf (ctx->output, ":label_%d\n", start_label);
 
-    GenExpression (ctx, node->left);
-
-    fprintf (ctx->output, "PUSH 0\n");
-    fprintf (ctx->output, "JE :label_%d\n", end_label);
+    GenCondJump (ctx, node->left, end_label);
 
     GenerateCode (ctx, node->right);
 
@@ -360,23 +574,73 @@ void GenVarDecl(CodeGenContext* ctx, Node* node)
     if (!node || node->type != NODE_VAR_DECL) return;
 
     int is_local = ctx->in_function ? 1 : 0;
-    int addr = AddVariable (ctx, node->data.string_value, is_local);
+    NodeType type = DeclaredType (node->data.type_value);
+    AddVariable (ctx, node->data.string_value, is_local, type);
+
+    if (is_local)
+        BindPlannedRegister (ctx, node->data.string_value);
 
     if (node->left)
     {
-        GenExpression (ctx, node->left);
+        GenTypedExpression (ctx, node->left, type);
+        GenStoreVariable (ctx, node->data.string_value, type);
+    }
+}
 
-        fprintf (ctx->output, "POPR RBX\n");
-        fprintf (ctx->output, "PUSH %d\n", addr);
-        fprintf (ctx->output, "POPR RAX\n");
-        fprintf (ctx->output, "POPM RAX\n");
+//       ,  
+static void GenStackParamPops (CodeGenContext* ctx, Node* func)
+{
+    int param_count = CountParameters (func);
+
+    for (int i = ARG_REG_COUNT; i < param_count; i++)
+    {
+        Node* param = NthParameter (func, i);
+        GenStoreVariable (ctx, param->data.string_value, DeclaredType (param->data.type_value));
     }
 }
 
-void GenFuncDecl (CodeGenContext* ctx, Node* node)
+// :        RBX/R12/R13,
+//    RDI/RSI/R8/R9     
+static void GenPrologue (CodeGenContext* ctx, Node* func)
 {
-    if (!node || node->type != NODE_FUNC_DECL) return;
+    int param_count = CountParameters (func);
+
+    for (int i = 0; i < param_count; i++)
+    {
+        Node* param = NthParameter (func, i);
+
+        AddVariable (ctx, param->data.string_value, 1, param->data.type_value);
+        BindPlannedRegister (ctx, param->data.string_value);
+    }
+
+    GenStackParamPops (ctx, func);
+    EmitCalleeSavedPrologue (ctx->output, ctx->callee_saved);
 
+    ctx->entry_label = NewLabel (ctx);
+    fprintf (ctx->output, ":label_%d\n", ctx->entry_label);
+
+    for (int i = 0; i < param_count && i < ARG_REG_COUNT; i++)
+    {
+        Node* param = NthParameter (func, i);
+        const char* name = param->data.string_value;
+        if (FindVariable (ctx, name)->reg == ARG_REG_FIRST + i) continue;
+
+        fprintf (ctx->output, "PUSHR %s\n", RegisterName (ARG_REG_FIRST + i));
+        GenStoreVariable (ctx, name, DeclaredType (param->data.type_value));
+    }
+
+    //  ,     ,   ,  
+    for (int i = 0; i < ctx->reg_plan_count; i++)
+    {
+        if (!ctx->reg_plan[i].zero_init || ctx->reg_plan[i].reg < 0) continue;
+
+        fprintf (ctx->output, "PUSH 0\n");
+        fprintf (ctx->output, "POPR %s\n", RegisterName (ctx->reg_plan[i].reg));
+    }
+}
+
+static void GenFunctionBody (CodeGenContext* ctx, Node* node)
+{
     char* func_name = node->data.string_value;
 
     int func_label = AddFunction (ctx, func_name);
@@ -385,58 +649,185 @@ void GenFuncDecl (CodeGenContext* ctx, Node* node)
     fprintf (ctx->output, ":func_%d\n", func_label);
 
     EnterFunction (ctx, func_name);
+    ctx->current_decl = node;
 
-    fprintf (ctx->output, ";  \n");
-
-    if (node->left)
+    if (ctx->opt_level >= 2)
     {
-        fprintf (ctx->output, "; :\n");
-        // TODO:  
+        GenFunctionFromIr (ctx, node, func_label);
+        ExitFunction (ctx);
+        return;
     }
 
+    if (ctx->opt_level >= 1)
+        AllocateRegisters (ctx, node);
+
+    fprintf (ctx->output, ";  \n");
+
+    GenPrologue (ctx, node);
+
     if (node->right)
         GenerateCode(ctx, node->right);
 
+    //   return  0:       OUT
+    GenPushConstant (ctx, 0, DeclaredType (node->data.type_value));
+    EmitCalleeSavedEpilogue (ctx->output, ctx->callee_saved);
     fprintf (ctx->output, "RET\n");
 
     ExitFunction (ctx);
 }
 
+void GenFuncDecl (CodeGenContext* ctx, Node* node)
+{
+    if (!node || node->type != NODE_FUNC_DECL) return;
+
+    TRACE_BEGIN ("", "function", node->data.string_value);
+    TraceCapture capture = {};
+    ctx->output = BeginTraceCapture (&capture, ctx->output);
+
+    if (ctx->cache)
+        GenCachedFunction (ctx->cache, ctx, node, GenFunctionBody);
+    else
+        GenFunctionBody (ctx, node);
+
+    ctx->output = EndTraceCapture (&capture);
+    TRACE_END ();
+}
+
+//  ,   (   ) 
+//     : ,    CALL, 
+//  .        
+static int CollectCallerSaved (CodeGenContext* ctx, CallSaveSlot* slots)
+{
+    if (!ctx->current_decl) return 0;
+
+    int count = 0;
+
+    for (int i = 0; i < ctx->var_count; i++)
+    {
+        VariableInfo* var = &ctx->var_table[i];
+
+        if (!IsOwnLocal (ctx, var) || IsCalleeSaved (var->reg) || !PlannedAcrossCall (ctx, var->name)) continue;
+
+        slots[count].reg = var->reg;
+        slots[count].address = var->address;
+        slots[count].type = var->type;
+        count++;
+    }
+
+    return count;
+}
+
+//         : 
+//  .   ,   .
+static void GenArguments (CodeGenContext* ctx, Node* call, FunctionInfo* func)
+{
+    for (int i = func->param_count - 1; i >= 0; i--)
+        GenTypedExpression (ctx, NthArgument (call, i), DeclaredType (NthParameter (func->decl, i)->data.type_value));
+
+    EmitArgumentPops (ctx->output, func->param_count);
+}
+
 void GenFuncCall (CodeGenContext* ctx, Node* node)
 {
     if (!node || node->type != NODE_FUNC_CALL) return;
 
     char* func_name = node->data.string_value;
 
-    int func_label = -1;
-    for (int i = 0; i < ctx->func_count; i++)
+    FunctionInfo* func = FindFunctionInfo (ctx, func_name);
+
+    if (!func)
     {
-        if (strcmp(ctx->func_table[i].name, func_name) == 0)
-        {
-            func_label = ctx->func_table[i].start_label;
-            break;
-        }
+        fprintf (ctx->output, "; :  '%s'  \n", func_name);
+        GenPushConstant (ctx, 0, ExpressionType (node));
+        return;
     }
 
-    if (func_label >= 0)
-        fprintf (ctx->output, "CALL :func_%d\n", func_label);
-    else
-        fprintf (ctx->output, "; :  '%s'  \n", func_name);
+    CallSaveSlot* saved = (CallSaveSlot*) MemAlloc (MEM_VARIABLES, ctx->var_count + 1, sizeof(CallSaveSlot));
+    if (!saved)
+    {
+        fprintf (ctx->output, "; :      '%s'\n", func_name);
+        GenPushConstant (ctx, 0, ExpressionType (node));
+        return;
+    }
+
+    int saved_count = CollectCallerSaved (ctx, saved);
+
+    EmitSaveSlots (ctx->output, saved, saved_count);
+    GenArguments (ctx, node, func);
+    fprintf (ctx->output, "CALL :func_%d\n", func->start_label);
+    EmitRestoreSlots (ctx->output, saved, saved_count);
+
+    MemFree (MEM_VARIABLES, saved);
+}
+
+// return f(...):     ,  CALL + RET   JMP -
+// RET       ,    .
+//      RBX/R12/R13,    .
+//         -  
+// ,    ,      .
+//           .
+static int GenTailCall (CodeGenContext* ctx, Node* call, NodeType return_type)
+{
+    if (!call || call->type != NODE_FUNC_CALL || ExpressionType (call) != return_type) return 0;
+
+    FunctionInfo* func = FindFunctionInfo (ctx, call->data.string_value);
+    if (!func) return 0;
+
+    int self = func->decl == ctx->current_decl && ctx->entry_label >= 0;
+    if (!self && func->param_count > ARG_REG_COUNT) return 0;
+
+    fprintf (ctx->output, ";   %s\n", call->data.string_value);
+    GenArguments (ctx, call, func);
+
+    if (self)
+    {
+        GenStackParamPops (ctx, func->decl);
+        fprintf (ctx->output, "JMP :label_%d\n", ctx->entry_label);
+        return 1;
+    }
+
+    EmitCalleeSavedRestore (ctx->output, ctx->callee_saved);
+    fprintf (ctx->output, "JMP :func_%d\n", func->start_label);
+    return 1;
 }
 
 void GenReturn(CodeGenContext* ctx, Node* node)
 {
     if (!node || node->type != NODE_RETURN) return;
 
-    if (node->left)
-        GenExpression (ctx, node->left);
-    else
-        fprintf (ctx->output, "PUSH 0\n");
+    NodeType return_type = ctx->current_decl ? DeclaredType (ctx->current_decl->data.type_value)
+                                             : ExpressionType (node->left);
 
-    fprintf (ctx->output, "OUT\n");
+    if (ctx->opt_level >= 1 && GenTailCall (ctx, node->left, return_type))
+        return;
+
+    GenTypedExpression (ctx, node->left, return_type);
+
+    //     ,   OUT   
+    EmitCalleeSavedEpilogue (ctx->output, ctx->callee_saved);
     fprintf (ctx->output, "RET\n");
 }
 
+//     :   .
+//     ,  -    HLT  .
+int GenEntryPoint (CodeGenContext* ctx, Node* root)
+{
+    Node* first = FirstFunction (root);
+    if (!first) return 0;
+
+    fprintf (ctx->output, ";   \n");
+
+    int param_count = CountParameters (first);
+    for (int i = param_count - 1; i >= 0; i--)
+        GenPushConstant (ctx, 0, DeclaredType (NthParameter (first, i)->data.type_value));
+
+    EmitArgumentPops (ctx->output, param_count);
+    fprintf (ctx->output, "CALL :func_0\n");
+    fprintf (ctx->output, "%sOUT\n", TypedOpcodePrefix (DeclaredType (first->data.type_value)));
+    fprintf (ctx->output, "HLT\n");
+    return 1;
+}
+
 void GenerateCode(CodeGenContext* ctx, Node* node)
 {
     if (!node || !ctx || !ctx->output) return;
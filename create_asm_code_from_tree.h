@@ -6,11 +6,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+struct CompileCache;
+
 typedef struct
 {
     char* name;
     int start_label;
     int local_var_count;
+    int param_count;
+    Node* decl;
 } FunctionInfo;
 
 typedef struct
@@ -18,13 +22,28 @@ typedef struct
     char* name;
     int address;
     int is_local;
+    char* owner;        //   ,   NULL
+    int reg;
+    NodeType type;      //      PUSHM/PUSHMI/PUSHMB
 } VariableInfo;
 
+typedef struct
+{
+    char* name;
+    int start;
+    int end;
+    int weight;
+    int crosses_call;
+    int fixed;          //    (  -)
+    int zero_init;      //    :    
+    int reg;
+} LiveInterval;
+
 typedef struct
 {
     FILE* output;
     int label_counter;
-    int var_counter;
+    int data_size;      //   VM  
     int temp_counter;
     VariableInfo* var_table;
     FunctionInfo* func_table;
@@ -33,24 +52,46 @@ typedef struct
     int var_count;
     int func_count;
     char* current_func;
+    Node* current_decl;
     int in_function;
+    LiveInterval* reg_plan;
+    int reg_plan_count;
+    int callee_saved;   //   RBX/R12/R13,    
+    int entry_label;    //   RBX/R12/R13:    
+    int opt_level;
+    int dump_ir;
+    CompileCache* cache;    // NULL -    
 } CodeGenContext;
 
 CodeGenContext* CtorCodeGen (FILE* output);
 void DtorCodeGen (CodeGenContext* ctx);
 
 void GenerateCode (CodeGenContext* ctx, Node* node);
+int GenEntryPoint (CodeGenContext* ctx, Node* root);
 
 int NewLabel (CodeGenContext* ctx);
 int GetVarAddress (CodeGenContext* ctx, const char* var_name);
-int AddVariable (CodeGenContext* ctx, const char* var_name, int is_local);
+int AddVariable (CodeGenContext* ctx, const char* var_name, int is_local, NodeType type);
 int AddFunction (CodeGenContext* ctx, const char* func_name);
+int FindFunctionLabel (CodeGenContext* ctx, const char* func_name);
+FunctionInfo* FindFunctionInfo (CodeGenContext* ctx, const char* func_name);
+void DeclareFunctions (CodeGenContext* ctx, Node* node);
 void EnterFunction (CodeGenContext* ctx, const char* func_name);
 void ExitFunction (CodeGenContext* ctx);
 
+VariableInfo* FindVariable (CodeGenContext* ctx, const char* var_name);
+void GenLoadVariable (CodeGenContext* ctx, const char* var_name, NodeType type);
+void GenStoreVariable (CodeGenContext* ctx, const char* var_name, NodeType type);
+
+const char* TypedOpcodePrefix (NodeType type);
+void GenConvert (CodeGenContext* ctx, NodeType from, NodeType to);
+void GenPushConstant (CodeGenContext* ctx, double value, NodeType type);
+void GenTypedExpression (CodeGenContext* ctx, Node* node, NodeType type);
+
 void GenExpression (CodeGenContext* ctx, Node* node);
 void GenAssignment (CodeGenContext* ctx, Node* node);
 void GenSequence (CodeGenContext* ctx, Node* node);
+void GenCondJump (CodeGenContext* ctx, Node* cond, int false_label);
 void GenIf (CodeGenContext* ctx, Node* node);
 void GenWhile (CodeGenContext* ctx, Node* node);
 void GenVarDecl (CodeGenContext* ctx, Node* node);
@@ -55,6 +55,13 @@ static void DumpNewFormat (Node* node, FILE* file, int depth)
             fprintf(file, "%s", node->data.string_value);
             break;
 
+        case NODE_PARAMETER:
+            fprintf(file, "%s", node->data.string_value);
+            break;
+
+        case NODE_ARGUMENT:      fprintf(file, "arg"); break;
+        case NODE_ERROR:         fprintf(file, "error"); break;
+
         //    
         //    enum NodeType   :
         // case NODE_IN:  fprintf(file, "in"); break;
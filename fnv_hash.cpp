@@ -0,0 +1,14 @@
+#include "fnv_hash.h"
+
+uint64_t HashBytes (uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*) data;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
@@ -0,0 +1,15 @@
+#ifndef FNV_HASH_H
+#define FNV_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// FNV-1a  64 :      ,   -
+//  .dot.     :    -
+//   
+const uint64_t FNV_OFFSET = 1469598103934665603ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+uint64_t HashBytes (uint64_t hash, const void* data, size_t size);
+
+#endif
@@ -0,0 +1,228 @@
+#include "graphviz_render.h"
+#include "fnv_hash.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+static const int DOT_READ_CHUNK = 4096;
+
+static int HashDotFile (const char* dot_filename, uint64_t* hash)
+{
+    FILE* dot_file = fopen (dot_filename, "rb");
+    if (!dot_file) return 0;
+
+    uint64_t value = FNV_OFFSET;
+    char chunk[DOT_READ_CHUNK] = "";
+    size_t size = 0;
+    while ((size = fread (chunk, 1, sizeof(chunk), dot_file)) > 0)
+        value = HashBytes (value, chunk, size);
+
+    fclose (dot_file);
+    *hash = value;
+    return 1;
+}
+
+// 0 -     size
+static int JoinPath (char* path, size_t size, const char* dir, const char* name)
+{
+    int length = snprintf (path, size, "%s%s%s", dir, *dir ? "/" : "", name);
+    return length >= 0 && (size_t) length < size;
+}
+
+GraphvizRenderer* CtorGraphvizRenderer (const char* output_dir, FILE* log)
+{
+    if (!output_dir) output_dir = "";
+    if (strlen (output_dir) >= (size_t) MAX_GRAPHVIZ_PATH)
+    {
+        fprintf (log, " %s:   %d \n", output_dir, MAX_GRAPHVIZ_PATH - 1);
+        return NULL;
+    }
+
+    GraphvizRenderer* renderer = (GraphvizRenderer*) calloc (1, sizeof(GraphvizRenderer));
+    if (!renderer) return NULL;
+
+    strcpy (renderer->output_dir, output_dir);
+    renderer->log = log;
+    renderer->image_counter = 1;
+
+    return renderer;
+}
+
+void DtorGraphvizRenderer (GraphvizRenderer* renderer)
+{
+    if (!renderer) return;
+
+    JoinGraphvizRenders (renderer, NULL);
+    free (renderer);
+}
+
+static int SpawnDot (GraphvizRenderer* renderer, GraphvizJob* job)
+{
+    char* argv_charset[] = {(char*) "dot", (char*) "-Tsvg", (char*) "-Gcharset=latin1",
+                            job->dot, (char*) "-o", job->svg, NULL};
+    char* argv_plain[] = {(char*) "dot", (char*) "-Tsvg", job->dot, (char*) "-o", job->svg, NULL};
+
+    int error = posix_spawnp (&job->pid, "dot", NULL, NULL, job->plain ? argv_plain : argv_charset, environ);
+    if (error == 0) return 1;
+
+    //  dot   :   
+    if (error == ENOENT)
+    {
+        if (!renderer->dot_missing)
+            fprintf (renderer->log, "Graphviz (dot)  ,   \n");
+        renderer->dot_missing = 1;
+    }
+    else
+        fprintf (renderer->log, "   dot  %s: %s\n", job->dot, strerror (error));
+
+    return 0;
+}
+
+//    dot;    charset   
+static void ReapOne (GraphvizRenderer* renderer, int block)
+{
+    int status = 0;
+    pid_t pid = 0;
+
+    for (int i = 0; i < renderer->running_count && pid <= 0; i++)
+        pid = waitpid (renderer->running[i].pid, &status, WNOHANG);
+
+    //   : waitpid (-1)     ,   --native
+    while (pid <= 0 && block && renderer->running_count > 0)
+    {
+        pid = waitpid (renderer->running[0].pid, &status, 0);
+        if (pid < 0 && errno != EINTR) return;
+    }
+
+    if (pid <= 0) return;
+
+    for (int i = 0; i < renderer->running_count; i++)
+    {
+        if (renderer->running[i].pid != pid) continue;
+
+        GraphvizJob job = renderer->running[i];
+        renderer->running[i] = renderer->running[--renderer->running_count];
+
+        int ok = WIFEXITED (status) && WEXITSTATUS (status) == 0;
+        if (!ok && !job.plain)
+        {
+            fprintf (renderer->log, "  SVG.   charset...\n");
+            job.plain = 1;
+            if (SpawnDot (renderer, &job))
+            {
+                renderer->running[renderer->running_count++] = job;
+                return;
+            }
+        }
+
+        if (!ok) renderer->failed_count++;
+        return;
+    }
+}
+
+void ReleaseDotFile (GraphvizRenderer* renderer, const char* dot_filename)
+{
+    for (int i = 0; renderer && i < renderer->running_count; i++)
+    {
+        if (strcmp (renderer->running[i].dot, dot_filename) != 0) continue;
+
+        ReapOne (renderer, 1);
+        i = -1;
+    }
+}
+
+int SubmitGraphvizRender (GraphvizRenderer* renderer, const char* dot_filename, char* svg_filename, size_t size)
+{
+    uint64_t hash = 0;
+    if (!HashDotFile (dot_filename, &hash)) return 0;
+
+    for (int i = 0; i < renderer->rendered_count; i++)
+    {
+        if (renderer->rendered[i].hash != hash) continue;
+
+        renderer->duplicate_count++;
+        snprintf (svg_filename, size, "%s", renderer->rendered[i].svg);
+        return 1;
+    }
+
+    if (renderer->rendered_count >= renderer->rendered_capacity)
+    {
+        int new_capacity = renderer->rendered_capacity ? renderer->rendered_capacity * 2 : 16;
+        RenderedGraph* new_rendered = (RenderedGraph*) realloc (renderer->rendered,
+                                                                new_capacity * sizeof(RenderedGraph));
+        if (!new_rendered) return 0;
+        renderer->rendered = new_rendered;
+        renderer->rendered_capacity = new_capacity;
+    }
+
+    if (!renderer->image_dir_ready)
+    {
+        char image_dir[MAX_GRAPHVIZ_PATH] = "";
+        if (JoinPath (image_dir, sizeof(image_dir), renderer->output_dir, GRAPHVIZ_IMAGE_DIR))
+            mkdir (image_dir, 0755);
+        renderer->image_dir_ready = 1;
+    }
+
+    RenderedGraph* graph = &renderer->rendered[renderer->rendered_count++];
+    graph->hash = hash;
+    snprintf (graph->svg, sizeof(graph->svg), "%s/ast_dump%d.svg", GRAPHVIZ_IMAGE_DIR, renderer->image_counter++);
+    snprintf (svg_filename, size, "%s", graph->svg);
+
+    if (renderer->dot_missing) return 1;
+
+    while (renderer->running_count >= MAX_GRAPHVIZ_RENDERERS)
+        ReapOne (renderer, 1);
+
+    GraphvizJob* job = &renderer->running[renderer->running_count];
+    memset (job, 0, sizeof(GraphvizJob));
+
+    //     dot   
+    char svg_path[MAX_GRAPHVIZ_PATH] = "";
+    if (strlen (dot_filename) >= sizeof(job->dot) ||
+        !JoinPath (svg_path, sizeof(svg_path), renderer->output_dir, graph->svg))
+    {
+        fprintf (renderer->log, "    %d , %s  \n", MAX_GRAPHVIZ_PATH - 1, dot_filename);
+        renderer->failed_count++;
+        return 1;
+    }
+
+    strcpy (job->dot, dot_filename);
+    strcpy (job->svg, svg_path);
+
+    if (SpawnDot (renderer, job))
+    {
+        renderer->running_count++;
+        renderer->render_count++;
+    }
+    else
+        renderer->failed_count++;
+
+    return 1;
+}
+
+void JoinGraphvizRenders (GraphvizRenderer* renderer, FILE* report)
+{
+    if (!renderer) return;
+
+    while (renderer->running_count > 0)
+        ReapOne (renderer, 1);
+
+    if (report && (renderer->render_count || renderer->duplicate_count || renderer->failed_count))
+        fprintf (report, " : %d,  : %d, : %d\n",
+                 renderer->render_count, renderer->duplicate_count, renderer->failed_count);
+
+    free (renderer->rendered);
+    renderer->rendered = NULL;
+    renderer->rendered_count = 0;
+    renderer->rendered_capacity = 0;
+    renderer->render_count = 0;
+    renderer->duplicate_count = 0;
+    renderer->failed_count = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef GRAPHVIZ_RENDER_H
+#define GRAPHVIZ_RENDER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+//  .dot  svg  :  dot -    posix_spawn,
+//    MAX_GRAPHVIZ_RENDERERS.    
+//     JoinGraphvizRenders.      .dot,  
+// ,   :     svg.
+//    GraphvizRenderer:    ,     .
+const int MAX_GRAPHVIZ_RENDERERS = 4;
+const int MAX_GRAPHVIZ_PATH = 200;
+const char GRAPHVIZ_IMAGE_DIR[] = "ast_images";
+
+typedef struct
+{
+    pid_t pid;
+    int plain;                          //   -Gcharset  
+    char dot[MAX_GRAPHVIZ_PATH];
+    char svg[MAX_GRAPHVIZ_PATH];
+} GraphvizJob;
+
+typedef struct
+{
+    uint64_t hash;
+    char svg[MAX_GRAPHVIZ_PATH];        //  output_dir
+} RenderedGraph;
+
+typedef struct
+{
+    char output_dir[MAX_GRAPHVIZ_PATH];
+    FILE* log;
+
+    GraphvizJob running[MAX_GRAPHVIZ_RENDERERS];
+    int running_count;
+
+    RenderedGraph* rendered;
+    int rendered_count;
+    int rendered_capacity;
+
+    int image_counter;
+    int image_dir_ready;
+    int dot_missing;
+
+    int render_count;
+    int duplicate_count;
+    int failed_count;
+} GraphvizRenderer;
+
+// svg   output_dir/ast_images; "" -  
+GraphvizRenderer* CtorGraphvizRenderer (const char* output_dir, FILE* log);
+void DtorGraphvizRenderer (GraphvizRenderer* renderer);
+
+//  svg_filename -   svg  output_dir (    <img>),
+//     JoinGraphvizRenders; 0 - .dot  
+int SubmitGraphvizRender (GraphvizRenderer* renderer, const char* dot_filename, char* svg_filename, size_t size);
+
+//  dot,   :     .dot
+void ReleaseDotFile (GraphvizRenderer* renderer, const char* dot_filename);
+
+//  ; report != NULL -  (,  , )
+void JoinGraphvizRenders (GraphvizRenderer* renderer, FILE* report);
+
+#endif
@@ -0,0 +1,1175 @@
+#include "incremental_parse.h"
+#include "syntactic_analysis.h"
+#include "memory_accounting.h"
+#include "monotonic_clock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+enum RelexResult
+{
+    RELEX_DONE,
+    RELEX_NEEDS_NEXT,       //    : ,   
+    RELEX_NO_MEMORY
+};
+
+static int ReserveUnitText (SourceUnit* unit, int length)
+{
+    if (length + 1 <= unit->text_capacity) return 1;
+
+    int new_capacity = unit->text_capacity ? unit->text_capacity : 64;
+    while (new_capacity < length + 1) new_capacity *= 2;
+
+    char* new_text = (char*) realloc (unit->text, new_capacity);
+    if (!new_text) return 0;
+
+    unit->text = new_text;
+    unit->text_capacity = new_capacity;
+    return 1;
+}
+
+static int ReserveUnitTokens (SourceUnit* unit, int count)
+{
+    if (count + 1 <= unit->token_capacity) return 1;
+
+    int new_capacity = unit->token_capacity ? unit->token_capacity : 16;
+    while (new_capacity < count + 1) new_capacity *= 2;
+
+    Token* new_tokens = (Token*) MemRealloc (MEM_TOKENS, unit->tokens, new_capacity * sizeof(Token));
+    if (!new_tokens) return 0;
+
+    unit->tokens = new_tokens;
+    unit->token_capacity = new_capacity;
+    return 1;
+}
+
+static int ReserveSpans (SyntaxSpans* spans, int count)
+{
+    if (count <= spans->capacity) return 1;
+
+    int new_capacity = spans->capacity ? spans->capacity : 16;
+    while (new_capacity < count) new_capacity *= 2;
+
+    SyntaxSpan* new_items = (SyntaxSpan*) realloc (spans->items, new_capacity * sizeof(SyntaxSpan));
+    if (!new_items) return 0;
+
+    spans->items = new_items;
+    spans->capacity = new_capacity;
+    return 1;
+}
+
+static void FreeTokenValues (Token* tokens, int count)
+{
+    for (int i = 0; i < count; i++)
+        if (tokens[i].type == TOK_IDENTIFIER && tokens[i].value.identifier)
+            MemFree (MEM_IDENTIFIERS, tokens[i].value.identifier);
+}
+
+static void ClearUnitTree (SourceUnit* unit)
+{
+    FreeTree (unit->function);
+    unit->function = NULL;
+    unit->spans.count = 0;
+    FreeParseDiagnostics (&unit->diagnostics);
+}
+
+static int CountNewlines (const char* text, int length)
+{
+    int count = 0;
+    if (!text) return 0;
+
+    for (const char* end = text + length; (text = (const char*) memchr (text, '\n', end - text)); text++)
+        count++;
+
+    return count;
+}
+
+static void DtorSourceUnit (SourceUnit* unit)
+{
+    ClearUnitTree (unit);
+    FreeTokenValues (unit->tokens, unit->token_count);
+    MemFree (MEM_TOKENS, unit->tokens);
+    FreeParseDiagnostics (&unit->diagnostics);
+    free (unit->spans.items);
+    free (unit->text);
+    memset (unit, 0, sizeof(SourceUnit));
+}
+
+//  ,    offset
+static int FindUnit (const IncrementalSource* source, int offset)
+{
+    int low = 0;
+    int high = source->unit_count - 1;
+
+    while (low < high)
+    {
+        int middle = (low + high + 1) / 2;
+        if (source->units[middle].start <= offset)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+
+    return low;
+}
+
+//  ,    offset
+static int FindToken (const SourceUnit* unit, int offset)
+{
+    int low = 0;
+    int high = unit->token_count;
+
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (unit->tokens[middle].offset < offset)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+// ----  SEQUENCE  ,   GetProgram ----
+
+static void DropProgramChain (IncrementalSource* source)
+{
+    Node* node = source->tree;
+
+    //   ,    
+    for (int i = source->chain_units - 1; i >= 1 && node; i--)
+    {
+        Node* left = node->left;
+        node->left = node->right = NULL;
+        FreeTree (node);
+        node = left;
+    }
+
+    source->tree = NULL;
+    source->chain_units = 0;
+
+    for (int i = 0; i < source->unit_count; i++)
+        source->units[i].slot = NULL;
+}
+
+static void BuildProgramChain (IncrementalSource* source)
+{
+    source->tree = source->units[0].function;
+    source->units[0].slot = &source->tree;
+    source->chain_units = 1;
+
+    for (int i = 1; i < source->unit_count; i++)
+    {
+        Node* sequence = CreateSequence (source->tree, source->units[i].function);
+        if (!sequence)
+        {
+            DropProgramChain (source);
+            return;
+        }
+
+        if (i == 1)
+            source->units[0].slot = &sequence->left;
+        source->units[i].slot = &sequence->right;
+        source->tree = sequence;
+        source->chain_units = i + 1;
+    }
+}
+
+// ----  ----
+
+static int InsertUnit (IncrementalSource* source, int index)
+{
+    if (source->unit_count >= source->unit_capacity)
+    {
+        int new_capacity = source->unit_capacity ? source->unit_capacity * 2 : 16;
+        SourceUnit* new_units = (SourceUnit*) realloc (source->units, new_capacity * sizeof(SourceUnit));
+        if (!new_units) return 0;
+
+        source->units = new_units;
+        source->unit_capacity = new_capacity;
+    }
+
+    memmove (&source->units[index + 1], &source->units[index], (source->unit_count - index) * sizeof(SourceUnit));
+    memset (&source->units[index], 0, sizeof(SourceUnit));
+    source->unit_count++;
+
+    return 1;
+}
+
+//   index + 1  index;     token_shift
+// (  ,        )
+static int MergeWithNext (IncrementalSource* source, int index, int token_shift)
+{
+    DropProgramChain (source);
+
+    SourceUnit* unit = &source->units[index];
+    SourceUnit* next = &source->units[index + 1];
+
+    if (!ReserveUnitText (unit, unit->length + next->length) ||
+        !ReserveUnitTokens (unit, unit->token_count + next->token_count))
+        return 0;
+
+    memcpy (unit->text + unit->length, next->text, next->length + 1);
+    unit->length += next->length;
+    unit->newlines += next->newlines;
+
+    for (int i = 0; i < next->token_count; i++)
+    {
+        unit->tokens[unit->token_count + i] = next->tokens[i];
+        unit->tokens[unit->token_count + i].offset += token_shift;
+    }
+    unit->token_count += next->token_count;
+    next->token_count = 0;             //    unit
+
+    ClearUnitTree (unit);
+    DtorSourceUnit (next);
+
+    memmove (next, next + 1, (source->unit_count - index - 2) * sizeof(SourceUnit));
+    source->unit_count--;
+
+    return 1;
+}
+
+//    TOK_DECLARE,  :     .
+// ,     , 0 -   
+static int SplitUnit (IncrementalSource* source, int index)
+{
+    int parts = 1;
+
+    while (1)
+    {
+        SourceUnit* unit = &source->units[index];
+
+        int cut = unit->token_count - 1;
+        while (cut > 0 && unit->tokens[cut].type != TOK_DECLARE)
+            cut--;
+        if (cut <= 0) return parts;
+
+        DropProgramChain (source);
+        if (!InsertUnit (source, index + 1)) return 0;
+
+        unit = &source->units[index];
+        SourceUnit* tail = &source->units[index + 1];
+        int cut_offset = unit->tokens[cut].offset;
+        int tail_tokens = unit->token_count - cut;
+
+        if (!ReserveUnitText (tail, unit->length - cut_offset) || !ReserveUnitTokens (tail, tail_tokens))
+            return 0;
+
+        tail->start = unit->start + cut_offset;
+        tail->length = unit->length - cut_offset;
+        memcpy (tail->text, unit->text + cut_offset, tail->length + 1);
+        tail->newlines = CountNewlines (tail->text, tail->length);
+        unit->newlines -= tail->newlines;
+
+        for (int i = 0; i < tail_tokens; i++)
+        {
+            tail->tokens[i] = unit->tokens[cut + i];
+            tail->tokens[i].offset -= cut_offset;
+        }
+        tail->token_count = tail_tokens;
+
+        unit->length = cut_offset;
+        unit->text[cut_offset] = '\0';
+        unit->token_count = cut;
+        ClearUnitTree (unit);
+
+        parts++;
+    }
+}
+
+// ----  ----
+
+//   [first, end) :   end     EOF,
+//      .    ,     
+static Node* ParseTokenRange (SourceUnit* unit, int first, int end, Node* (*parse) (Getter*), FILE* errors,
+                              StatementSpans* records, ParseDiagnostics* diagnostics, int* consumed, int* error_count)
+{
+    Token saved = {};
+    if (end < unit->token_count)
+        saved = unit->tokens[end];
+
+    unit->tokens[end].type = TOK_EOF;
+    unit->tokens[end].value.identifier = NULL;
+    unit->tokens[end].offset = end < unit->token_count ? saved.offset : unit->length;
+    unit->tokens[end].length = 0;
+
+    // source  :       ,   
+    Lexer view = {};
+    view.current = unit->text + unit->length;
+    view.tokens = unit->tokens + first;
+    view.count = end - first + 1;
+    view.errors = errors;
+
+    Node* node = NULL;
+    Getter* getter = CtorGetter (&view);
+    if (getter)
+    {
+        getter->spans = records;
+        getter->diagnostics = diagnostics;
+        node = parse (getter);
+        *consumed = getter->current_token;
+        *error_count = getter->error_count;
+        DtorGetter (getter);
+    }
+    else
+        *error_count = 1;
+
+    if (end < unit->token_count)
+        unit->tokens[end] = saved;
+
+    return node;
+}
+
+static int CompareRecords (const void* first, const void* second)
+{
+    const StatementSpan* a = (const StatementSpan*) first;
+    const StatementSpan* b = (const StatementSpan*) second;
+
+    if ((uintptr_t) a->node != (uintptr_t) b->node)
+        return (uintptr_t) a->node < (uintptr_t) b->node ? -1 : 1;
+
+    return a->first - b->first;
+}
+
+//  GetStatement  ,    slot;   
+// (        -    )
+static void AddNodeSpans (SyntaxSpans* spans, Node** slot, const StatementSpans* records, int shift)
+{
+    int low = 0;
+    int high = records->count;
+
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if ((uintptr_t) records->items[middle].node < (uintptr_t) *slot)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    for (int i = low; i < records->count && records->items[i].node == *slot; i++)
+    {
+        if (!ReserveSpans (spans, spans->count + 1)) return;
+
+        spans->items[spans->count++] = {records->items[i].first + shift, records->items[i].end + shift, slot};
+    }
+}
+
+//     .   SEQUENCE  :
+//        
+static void CollectSpans (SyntaxSpans* spans, Node** slot, const StatementSpans* records, int shift)
+{
+    Node*** spine = NULL;
+    int spine_count = 0;
+    int spine_capacity = 0;
+
+    while (*slot)
+    {
+        AddNodeSpans (spans, slot, records, shift);
+        Node* node = *slot;
+
+        if (node->type == NODE_SEQUENCE)
+        {
+            if (spine_count >= spine_capacity)
+            {
+                int new_capacity = spine_capacity ? spine_capacity * 2 : 16;
+                Node*** new_spine = (Node***) realloc (spine, new_capacity * sizeof(Node**));
+                if (!new_spine) break;
+                spine = new_spine;
+                spine_capacity = new_capacity;
+            }
+
+            spine[spine_count++] = slot;
+            slot = &node->left;
+            continue;
+        }
+
+        if (node->type == NODE_IF || node->type == NODE_WHILE)
+            CollectSpans (spans, &node->right, records, shift);
+        break;
+    }
+
+    for (int i = spine_count - 1; i >= 0; i--)
+        CollectSpans (spans, &(*spine[i])->right, records, shift);
+
+    free (spine);
+}
+
+//   ;  -  source->errors
+static int ParseUnit (IncrementalSource* source, SourceUnit* unit)
+{
+    ClearUnitTree (unit);
+
+    int end = unit->token_count;
+    if (end > 0 && unit->tokens[end - 1].type == TOK_EOF)
+        end--;
+
+    StatementSpans records = {};
+    int consumed = 0;
+    int error_count = 0;
+    Node* function = ParseTokenRange (unit, 0, end, GetFunction, source->errors, &records, &unit->diagnostics,
+                                      &consumed, &error_count);
+
+    if (function && error_count == 0 && consumed < end)
+    {
+        //   GetProgram,   
+        Lexer view = {};
+        view.tokens = unit->tokens;
+        view.count = unit->token_count;
+        view.errors = source->errors;
+
+        Getter* getter = CtorGetter (&view);
+        if (getter)
+        {
+            getter->current_token = consumed;
+            getter->diagnostics = &unit->diagnostics;
+            ReportParseError (getter, "   ");
+            DtorGetter (getter);
+        }
+        error_count++;
+    }
+
+    source->last.reparsed_tokens += end;
+
+    if (!function || error_count > 0)
+    {
+        FreeTree (function);
+        free (records.items);
+        return 0;
+    }
+
+    unit->function = function;
+    if (records.count > 0)
+        qsort (records.items, records.count, sizeof(StatementSpan), CompareRecords);
+
+    //   GetBlock,   GetStatement:   -   '{'  
+    int body = 0;
+    while (body < end && unit->tokens[body].type != TOK_LBRACE)
+        body++;
+
+    if (ReserveSpans (&unit->spans, 1))
+        unit->spans.items[unit->spans.count++] = {body, end, &function->right};
+    CollectSpans (&unit->spans, &function->right, &records, 0);
+
+    free (records.items);
+    return 1;
+}
+
+//     ,     
+//  [first, first + replaced),   [first, first + relexed).
+//      ,  ,   
+static int ReparseStatement (IncrementalSource* source, SourceUnit* unit, int first, int replaced, int relexed)
+{
+    int delta = relexed - replaced;
+    int damage_end = first + replaced;
+
+    for (int i = unit->spans.count - 1; i >= 0; i--)
+    {
+        SyntaxSpan span = unit->spans.items[i];
+        if (span.first > first || span.end < damage_end) continue;
+
+        int new_end = span.end + delta;
+        StatementSpans records = {};
+        int consumed = 0;
+        int error_count = 0;
+        Node* statement = ParseTokenRange (unit, span.first, new_end, GetStatement, source->discard,
+                                           &records, NULL, &consumed, &error_count);
+        source->last.reparsed_tokens += new_end - span.first;
+
+        if (!statement || error_count > 0 || consumed != new_end - span.first || statement->type == NODE_EMPTY)
+        {
+            FreeTree (statement);
+            free (records.items);
+            continue;
+        }
+
+        //          
+        int removed_end = i + 1;
+        while (removed_end < unit->spans.count && unit->spans.items[removed_end].end <= span.end)
+            removed_end++;
+
+        if (records.count > 0)
+            qsort (records.items, records.count, sizeof(StatementSpan), CompareRecords);
+
+        Node* old = *span.slot;
+        *span.slot = statement;
+        FreeTree (old);
+
+        SyntaxSpans fresh = {};
+        CollectSpans (&fresh, span.slot, &records, span.first);
+        free (records.items);
+
+        SyntaxSpans* spans = &unit->spans;
+        int new_count = spans->count - (removed_end - i) + fresh.count;
+        if (!ReserveSpans (spans, new_count))
+        {
+            free (fresh.items);
+            return 0;
+        }
+
+        memmove (&spans->items[i + fresh.count], &spans->items[removed_end],
+                 (spans->count - removed_end) * sizeof(SyntaxSpan));
+        memcpy (&spans->items[i], fresh.items, fresh.count * sizeof(SyntaxSpan));
+        spans->count = new_count;
+        free (fresh.items);
+
+        //   ,  
+        for (int k = 0; k < i; k++)
+            if (spans->items[k].end >= span.end)
+                spans->items[k].end += delta;
+
+        for (int k = i + fresh.count; k < spans->count; k++)
+        {
+            spans->items[k].first += delta;
+            spans->items[k].end += delta;
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+// ----  ----
+
+//    ,   .    
+//   ,       -    (  
+//   ),        ,
+//    ,  :   .
+//  *relexed -    ,    [*first, *first + *replaced)
+static RelexResult RelexUnit (IncrementalSource* source, SourceUnit* unit, int is_last, int offset,
+                              int removed, int inserted, Lexer** relexed, int* first, int* replaced)
+{
+    int delta = inserted - removed;
+    int edit_end = offset + inserted;
+
+    int start = FindToken (unit, offset) - 1;
+    int position = 0;
+
+    if (start < 0)
+        start = 0;
+    else if (unit->tokens[start].offset + unit->tokens[start].length < offset &&
+             unit->tokens[start].length < MAX_STR_SIZE - 2)   //    
+    {
+        position = unit->tokens[start].offset + unit->tokens[start].length;
+        start++;
+    }
+    else
+        position = unit->tokens[start].offset;
+
+    Lexer* lexer = CtorLexer (unit->text);
+    if (!lexer) return RELEX_NO_MEMORY;
+
+    lexer->errors = source->errors;
+    lexer->current = unit->text + position;
+
+    int old = start;
+
+    while (1)
+    {
+        int count = lexer->count;
+        if (!LexerScanNext (lexer))
+        {
+            DtorLexer (lexer);
+            return RELEX_NO_MEMORY;
+        }
+        if (lexer->count == count) break;
+
+        int token_start = lexer->tokens[count].offset;
+        if (token_start < edit_end) continue;
+
+        while (old < unit->token_count && (unit->tokens[old].offset < offset + removed ||
+                                           unit->tokens[old].offset + delta < token_start))
+            old++;
+
+        if (old < unit->token_count && unit->tokens[old].offset + delta == token_start)
+        {
+            FreeTokenValues (&lexer->tokens[count], 1);
+            lexer->count = count;
+
+            *relexed = lexer;
+            *first = start;
+            *replaced = old - start;
+            return RELEX_DONE;
+        }
+    }
+
+    //  :     EOF,    
+    //   -  ,      
+    int end = unit->token_count;
+    if (is_last)
+        end--;
+    else if (unit->length == 0 || unit->text[unit->length - 1] != '\n')
+    {
+        DtorLexer (lexer);
+        return RELEX_NEEDS_NEXT;
+    }
+
+    *relexed = lexer;
+    *first = start;
+    *replaced = end - start;
+    return RELEX_DONE;
+}
+
+static int SpliceTokens (SourceUnit* unit, int first, int replaced, Lexer* relexed, int delta)
+{
+    int inserted = relexed->count;
+    int tail = unit->token_count - first - replaced;
+
+    if (!ReserveUnitTokens (unit, unit->token_count - replaced + inserted))
+        return 0;
+
+    FreeTokenValues (unit->tokens + first, replaced);
+    memmove (unit->tokens + first + inserted, unit->tokens + first + replaced, tail * sizeof(Token));
+    memcpy (unit->tokens + first, relexed->tokens, inserted * sizeof(Token));
+    unit->token_count += inserted - replaced;
+
+    for (int i = first + inserted; i < unit->token_count; i++)
+        unit->tokens[i].offset += delta;
+
+    relexed->count = 0;                 //    
+    return 1;
+}
+
+static void FinishEdit (IncrementalSource* source)
+{
+    source->failed_units = 0;
+    for (int i = 0; i < source->unit_count; i++)
+        if (!source->units[i].function)
+            source->failed_units++;
+
+    if (source->failed_units > 0)
+        DropProgramChain (source);
+    else if (!source->chain_units)
+        BuildProgramChain (source);
+
+    source->last.units = source->unit_count;
+}
+
+IncrementalSource* CtorIncrementalSource (const char* text, FILE* errors)
+{
+    if (!text) return NULL;
+
+    IncrementalSource* source = (IncrementalSource*) calloc (1, sizeof(IncrementalSource));
+    if (!source) return NULL;
+
+    source->errors = errors ? errors : stderr;
+    source->discard = fopen ("/dev/null", "w");
+    source->length = (int) strlen (text);
+
+    Lexer* lexer = CtorLexer (text);
+    if (!source->discard || !lexer || !InsertUnit (source, 0))
+    {
+        DtorLexer (lexer);
+        DtorIncrementalSource (source);
+        return NULL;
+    }
+
+    lexer->errors = source->errors;
+    int scanned = LexerScanTokens (lexer);
+
+    //      , SplitUnit    
+    SourceUnit* unit = &source->units[0];
+    unit->tokens = lexer->tokens;
+    unit->token_count = lexer->count;
+    unit->token_capacity = lexer->capacity;
+    lexer->tokens = NULL;
+    lexer->count = 0;
+    DtorLexer (lexer);
+
+    if (!scanned || !ReserveUnitText (unit, source->length) || !ReserveUnitTokens (unit, unit->token_count))
+    {
+        DtorIncrementalSource (source);
+        return NULL;
+    }
+
+    memcpy (unit->text, text, source->length + 1);
+    unit->length = source->length;
+    unit->newlines = CountNewlines (text, source->length);
+
+    if (!SplitUnit (source, 0))
+    {
+        DtorIncrementalSource (source);
+        return NULL;
+    }
+
+    for (int i = 0; i < source->unit_count; i++)
+        ParseUnit (source, &source->units[i]);
+
+    FinishEdit (source);
+    source->last.scope = REPARSE_UNITS;
+    return source;
+}
+
+void DtorIncrementalSource (IncrementalSource* source)
+{
+    if (!source) return;
+
+    DropProgramChain (source);
+
+    for (int i = 0; i < source->unit_count; i++)
+        DtorSourceUnit (&source->units[i]);
+
+    free (source->units);
+    if (source->discard)
+        fclose (source->discard);
+    free (source);
+}
+
+int ApplySourceEdit (IncrementalSource* source, int offset, int removed, const char* inserted, int inserted_length)
+{
+    if (!source || offset < 0 || removed < 0 || inserted_length < 0 || offset + removed > source->length ||
+        (inserted_length > 0 && !inserted))
+        return 0;
+
+    memset (&source->last, 0, sizeof(source->last));
+    int delta = inserted_length - removed;
+    int structural = 0;
+
+    //   ,      :
+    //         
+    int first_unit = FindUnit (source, offset);
+    if (first_unit > 0 && source->units[first_unit].start == offset)
+        first_unit--;
+    int last_unit = FindUnit (source, offset + removed);
+
+    for (int i = first_unit; i < last_unit; i++)
+    {
+        if (!MergeWithNext (source, first_unit, source->units[first_unit].length))
+            return 0;
+        structural = 1;
+    }
+
+    SourceUnit* unit = &source->units[first_unit];
+    int local = offset - unit->start;
+
+    if (!ReserveUnitText (unit, unit->length + delta))
+        return 0;
+
+    unit->newlines += CountNewlines (inserted, inserted_length) - CountNewlines (unit->text + local, removed);
+    memmove (unit->text + local + inserted_length, unit->text + local + removed, unit->length - local - removed + 1);
+    if (inserted_length > 0)
+        memcpy (unit->text + local, inserted, inserted_length);
+    unit->length += delta;
+
+    Lexer* relexed = NULL;
+    int first = 0;
+    int replaced = 0;
+
+    while (1)
+    {
+        unit = &source->units[first_unit];
+        RelexResult result = RelexUnit (source, unit, first_unit == source->unit_count - 1, local, removed,
+                                        inserted_length, &relexed, &first, &replaced);
+        if (result == RELEX_NO_MEMORY)
+            return 0;
+        if (result == RELEX_DONE)
+            break;
+
+        if (!MergeWithNext (source, first_unit, unit->length - delta))
+            return 0;
+        structural = 1;
+    }
+
+    unit = &source->units[first_unit];
+    source->last.relexed_tokens = relexed->count;
+    source->last.replaced_tokens = replaced;
+
+    int relexed_count = relexed->count;
+    int spliced = SpliceTokens (unit, first, replaced, relexed, delta);
+    DtorLexer (relexed);
+    if (!spliced) return 0;
+
+    for (int i = first_unit + 1; i < source->unit_count; i++)
+        source->units[i].start += delta;
+    source->length += delta;
+
+    //      -   
+    if (first_unit > 0 && (unit->token_count == 0 || unit->tokens[0].type != TOK_DECLARE))
+    {
+        if (!MergeWithNext (source, first_unit - 1, source->units[first_unit - 1].length))
+            return 0;
+        first_unit--;
+        structural = 1;
+    }
+
+    int parts = SplitUnit (source, first_unit);
+    if (!parts) return 0;
+    if (parts > 1) structural = 1;
+
+    if (structural)
+    {
+        source->last.scope = REPARSE_UNITS;
+        for (int i = first_unit; i < first_unit + parts; i++)
+            ParseUnit (source, &source->units[i]);
+    }
+    else
+    {
+        unit = &source->units[first_unit];
+        source->last.scope = REPARSE_STATEMENT;
+
+        if (!unit->function || !ReparseStatement (source, unit, first, replaced, relexed_count))
+        {
+            source->last.scope = REPARSE_FUNCTION;
+            ParseUnit (source, unit);
+
+            if (unit->function && source->chain_units)
+                *unit->slot = unit->function;
+        }
+    }
+
+    FinishEdit (source);
+    return 1;
+}
+
+char* IncrementalSourceText (const IncrementalSource* source)
+{
+    char* text = (char*) malloc (source->length + 1);
+    if (!text) return NULL;
+
+    int length = 0;
+    for (int i = 0; i < source->unit_count; i++)
+    {
+        memcpy (text + length, source->units[i].text, source->units[i].length);
+        length += source->units[i].length;
+    }
+    text[length] = '\0';
+
+    return text;
+}
+
+char SourceCharAt (const IncrementalSource* source, int offset)
+{
+    if (offset < 0 || offset >= source->length) return '\0';
+
+    const SourceUnit* unit = &source->units[FindUnit (source, offset)];
+    return unit->text[offset - unit->start];
+}
+
+int SourceOffsetAt (const IncrementalSource* source, int line, int column)
+{
+    if (line < 0) return 0;
+
+    //     :   ,   
+    int unit_index = 0;
+    while (unit_index + 1 < source->unit_count && source->units[unit_index].newlines < line)
+        line -= source->units[unit_index++].newlines;
+
+    const SourceUnit* unit = &source->units[unit_index];
+    if (line > unit->newlines)
+        return source->length;
+
+    const char* text = unit->text;
+    for (int i = 0; i < line; i++)
+        text = strchr (text, '\n') + 1;
+
+    int offset = unit->start + (int) (text - unit->text);
+    for (int i = 0; i < column && offset < source->length && SourceCharAt (source, offset) != '\n'; i++)
+        offset++;
+
+    return offset;
+}
+
+void SourcePositionAt (const IncrementalSource* source, int offset, int* line, int* column)
+{
+    if (offset < 0) offset = 0;
+    if (offset > source->length) offset = source->length;
+
+    int unit_index = FindUnit (source, offset);
+    const SourceUnit* unit = &source->units[unit_index];
+
+    *line = 0;
+    for (int i = 0; i < unit_index; i++)
+        *line += source->units[i].newlines;
+    *line += CountNewlines (unit->text, offset - unit->start);
+
+    int line_start = offset;
+    while (line_start > 0 && SourceCharAt (source, line_start - 1) != '\n')
+        line_start--;
+
+    *column = offset - line_start;
+}
+
+const Token* SourceTokenAt (const IncrementalSource* source, int offset, int* unit_index, int* token_index)
+{
+    if (offset < 0 || offset > source->length) return NULL;
+
+    int index = FindUnit (source, offset);
+
+    //       -   
+    for (int u = index; u >= 0 && u >= index - 1; u--)
+    {
+        const SourceUnit* unit = &source->units[u];
+        int local = offset - unit->start;
+
+        int i = FindToken (unit, local + 1) - 1;
+        if (i < 0 || i >= unit->token_count) continue;
+
+        const Token* token = &unit->tokens[i];
+        if (token->type == TOK_EOF || local > token->offset + token->length) continue;
+
+        if (unit_index) *unit_index = u;
+        if (token_index) *token_index = i;
+        return token;
+    }
+
+    return NULL;
+}
+
+// ----     ----
+
+static int SameTree (const Node* a, const Node* b)
+{
+    //    :  SEQUENCE 
+    while (a && b)
+    {
+        if (a->type != b->type || a->data.number_value != b->data.number_value ||
+            a->data.type_value != b->data.type_value ||
+            (a->data.string_value == NULL) != (b->data.string_value == NULL) ||
+            (a->data.string_value && strcmp (a->data.string_value, b->data.string_value) != 0))
+            return 0;
+
+        if (!SameTree (a->right, b->right))
+            return 0;
+
+        a = a->left;
+        b = b->left;
+    }
+
+    return a == b;
+}
+
+static int SameTokens (const IncrementalSource* source, const Lexer* lexer)
+{
+    int index = 0;
+
+    for (int u = 0; u < source->unit_count; u++)
+    {
+        const SourceUnit* unit = &source->units[u];
+
+        for (int i = 0; i < unit->token_count; i++, index++)
+        {
+            if (index >= lexer->count) return 0;
+
+            const Token* a = &unit->tokens[i];
+            const Token* b = &lexer->tokens[index];
+
+            if (a->type != b->type || a->offset + unit->start != b->offset || a->length != b->length)
+                return 0;
+            if (a->type == TOK_NUMBER && a->value.number != b->value.number)
+                return 0;
+            if (a->type == TOK_IDENTIFIER && strcmp (a->value.identifier, b->value.identifier) != 0)
+                return 0;
+        }
+    }
+
+    return index == lexer->count;
+}
+
+static unsigned NextRandom (unsigned* state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 8) & 0xFFFFFF;
+}
+
+//        ; -1 -  
+static int PickToken (const IncrementalSource* source, unsigned* state, MyTokenType type, int* offset, int* length)
+{
+    const SourceUnit* unit = &source->units[NextRandom (state) % source->unit_count];
+    if (unit->token_count == 0) return -1;
+
+    int first = NextRandom (state) % unit->token_count;
+    for (int i = first; i < unit->token_count && i < first + 64; i++)
+    {
+        if (unit->tokens[i].type != type) continue;
+
+        *offset = unit->start + unit->tokens[i].offset;
+        *length = unit->tokens[i].length;
+        return i;
+    }
+
+    return -1;
+}
+
+typedef struct
+{
+    int offset;
+    int removed;
+    char inserted[64];
+    int inserted_length;
+} CheckEdit;
+
+// ,     :  ,  
+//  ';'.  -    ,    
+static void MakeCheckEdit (const IncrementalSource* source, const char* text, unsigned* state, CheckEdit* edit,
+                           CheckEdit* undo, int* has_undo)
+{
+    static const char* const junk[] = {"{", "}", ";", " ", "\n", "7", "x", "(", "__ ",
+                                       "__ ", " 0;", ""};
+
+    memset (edit, 0, sizeof(CheckEdit));
+    *has_undo = 0;
+    int kind = NextRandom (state) % 10;
+    int offset = 0;
+    int length = 0;
+
+    if (kind < 4 && PickToken (source, state, TOK_NUMBER, &offset, &length) >= 0)
+    {
+        edit->offset = offset;
+        edit->removed = length;
+        edit->inserted_length = snprintf (edit->inserted, sizeof(edit->inserted), "%u", NextRandom (state) % 1000);
+        return;
+    }
+
+    if (kind < 7 && PickToken (source, state, TOK_SEMICOLON, &offset, &length) >= 0)
+    {
+        edit->offset = offset + length;
+        edit->inserted_length = snprintf (edit->inserted, sizeof(edit->inserted),
+                                          "\n       __ %u;",
+                                          NextRandom (state) % 100);
+        return;
+    }
+
+    edit->offset = source->length ? NextRandom (state) % (source->length + 1) : 0;
+    *has_undo = 1;
+    undo->offset = edit->offset;
+
+    if (NextRandom (state) % 2 && edit->offset < source->length)
+    {
+        edit->removed = 1 + NextRandom (state) % 8;
+        if (edit->offset + edit->removed > source->length)
+            edit->removed = source->length - edit->offset;
+
+        undo->removed = 0;
+        memcpy (undo->inserted, text + edit->offset, edit->removed);
+        undo->inserted_length = edit->removed;
+    }
+    else
+    {
+        const char* piece = junk[NextRandom (state) % (sizeof(junk) / sizeof(junk[0]))];
+        edit->inserted_length = snprintf (edit->inserted, sizeof(edit->inserted), "%s", piece);
+
+        undo->removed = edit->inserted_length;
+        undo->inserted_length = 0;
+    }
+}
+
+int RunIncrementalCheck (const char* filename, int edit_count)
+{
+    if (edit_count <= 0)
+        edit_count = INCREMENTAL_DEFAULT_EDITS;
+
+    char* text = ReadFile (filename);
+    if (!text) return 1;
+
+    FILE* quiet = fopen ("/dev/null", "w");
+    double build_start = NowUs ();
+    IncrementalSource* source = quiet ? CtorIncrementalSource (text, quiet) : NULL;
+    double build_us = NowUs () - build_start;
+    free (text);
+
+    if (!source)
+    {
+        printf ("  \n");
+        if (quiet) fclose (quiet);
+        return 1;
+    }
+
+    int lines = 1;
+    for (int u = 0; u < source->unit_count; u++)
+        for (int i = 0; i < source->units[u].length; i++)
+            lines += source->units[u].text[i] == '\n';
+
+    printf (" %s: %d , %d , %d ,   %.1f %s\n", filename, source->length,
+            lines, source->unit_count, build_us / 1000, source->tree ? "" : " ( )");
+
+    unsigned state = 2024;
+    CheckEdit edit = {};
+    CheckEdit undo = {};
+    int has_undo = 0;
+
+    int mismatches = 0;
+    int scopes[REPARSE_UNITS + 1] = {};
+    long long relexed = 0;
+    long long reparsed = 0;
+    double incremental_total = 0;
+    double incremental_max = 0;
+    double full_total = 0;
+
+    for (int e = 0; e < edit_count; e++)
+    {
+        char* before = IncrementalSourceText (source);
+        if (!before) break;
+
+        if (has_undo)
+        {
+            edit = undo;
+            has_undo = 0;
+        }
+        else
+            MakeCheckEdit (source, before, &state, &edit, &undo, &has_undo);
+
+        double start = NowUs ();
+        int applied = ApplySourceEdit (source, edit.offset, edit.removed, edit.inserted, edit.inserted_length);
+        double incremental_us = NowUs () - start;
+        free (before);
+
+        if (!applied)
+        {
+            printf (" %d  \n", e + 1);
+            mismatches++;
+            break;
+        }
+
+        incremental_total += incremental_us;
+        if (incremental_us > incremental_max) incremental_max = incremental_us;
+        scopes[source->last.scope]++;
+        relexed += source->last.relexed_tokens;
+        reparsed += source->last.reparsed_tokens;
+
+        // :    ,   RunCompilation
+        char* current = IncrementalSourceText (source);
+        if (!current) break;
+
+        start = NowUs ();
+        Lexer* lexer = CtorLexer (current);
+        Getter* getter = NULL;
+        Node* tree = NULL;
+        if (lexer)
+        {
+            lexer->errors = quiet;
+            if (LexerScanTokens (lexer) && (getter = CtorGetter (lexer)))
+                tree = GetProgram (getter);
+        }
+        full_total += NowUs () - start;
+
+        int same = lexer && SameTokens (source, lexer) && SameTree (source->tree, tree);
+        if (!same)
+        {
+            mismatches++;
+            if (mismatches <= 5)
+                printf ("   %d:  %d,  %d,  \"%.*s\"\n",
+                        e + 1, edit.offset, edit.removed, edit.inserted_length, edit.inserted);
+        }
+
+        FreeTree (tree);
+        DtorGetter (getter);
+        DtorLexer (lexer);
+        free (current);
+    }
+
+    printf (": %d,    : %d\n", edit_count, mismatches);
+    printf (" :  %d,  %d,   %d\n",
+            scopes[REPARSE_STATEMENT], scopes[REPARSE_FUNCTION], scopes[REPARSE_UNITS]);
+    printf (":   %.1f ,  %.1f ;   : "
+            " %.1f,  %.1f\n",
+            incremental_total / edit_count, incremental_max,
+            (double) relexed / edit_count, (double) reparsed / edit_count);
+    printf (" LexerScanTokens + GetProgram:   %.2f \n", full_total / edit_count / 1000);
+
+    DtorIncrementalSource (source);
+    fclose (quiet);
+    return mismatches;
+}
@@ -0,0 +1,116 @@
+#ifndef INCREMENTAL_PARSE_H
+#define INCREMENTAL_PARSE_H
+
+#include "lexical_analysis.h"
+#include "tree_base.h"
+#include "syntactic_analysis.h"
+#include <stdio.h>
+
+//    :    , 
+// (,  ,  )   
+//         .
+//
+//      TOK_DECLARE:     ,
+//   (   )   .  
+//    ,     
+//    ,         .
+//     GetStatement     
+// ,      ,  ;  - 
+// ,   .      
+// "__"    .
+//    -    ,    .
+
+//   :  [first, end)      
+typedef struct
+{
+    int first;
+    int end;
+    Node** slot;
+} SyntaxSpan;
+
+typedef struct
+{
+    SyntaxSpan* items;          //   :    
+    int count;
+    int capacity;
+} SyntaxSpans;
+
+typedef struct
+{
+    int start;                  //   
+    char* text;
+    int length;
+    int text_capacity;
+    int newlines;               //    text
+
+    Token* tokens;              // offset -   ;      TOK_EOF
+    int token_count;
+    int token_capacity;         //   token_count:    EOF  
+
+    Node* function;             // NULL -   
+    Node** slot;                //     source->tree
+
+    SyntaxSpans spans;          //        
+    ParseDiagnostics diagnostics;   //   , token -   tokens
+} SourceUnit;
+
+enum ReparseScope
+{
+    REPARSE_STATEMENT,          //    
+    REPARSE_FUNCTION,           //    
+    REPARSE_UNITS               //   :  
+};
+
+typedef struct
+{
+    ReparseScope scope;
+    int relexed_tokens;         //     
+    int replaced_tokens;        //  ,   
+    int reparsed_tokens;        //    
+    int units;                  //   
+} IncrementalStats;
+
+typedef struct
+{
+    SourceUnit* units;
+    int unit_count;
+    int unit_capacity;
+    int length;
+
+    Node* tree;                 //   GetProgram: NULL,      
+    int chain_units;            //     SEQUENCE  , 0 -  
+    int failed_units;
+
+    FILE* errors;               //     
+    FILE* discard;              //   
+    IncrementalStats last;
+} IncrementalSource;
+
+IncrementalSource* CtorIncrementalSource (const char* text, FILE* errors);
+void DtorIncrementalSource (IncrementalSource* source);
+
+// inserted    '\0'. 0 -   ;   
+//  0,      
+int ApplySourceEdit (IncrementalSource* source, int offset, int removed, const char* inserted, int inserted_length);
+
+//   ,  free
+char* IncrementalSourceText (const IncrementalSource* source);
+
+//    :       .    
+//    ,     -   
+int SourceOffsetAt (const IncrementalSource* source, int line, int column);
+void SourcePositionAt (const IncrementalSource* source, int offset, int* line, int* column);
+char SourceCharAt (const IncrementalSource* source, int offset);
+
+// ,    offset       (  );
+// NULL -   .   -    
+const Token* SourceTokenAt (const IncrementalSource* source, int offset, int* unit_index, int* token_index);
+
+//   : edit_count  ,     
+//    LexerScanTokens + GetProgram,   .
+//   
+const int INCREMENTAL_DEFAULT_EDITS = 200;
+
+int RunIncrementalCheck (const char* filename, int edit_count);
+
+#endif
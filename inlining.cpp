@@ -0,0 +1,564 @@
+#include "inlining.h"
+#include "type_checking.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const int MAX_INLINE_NAME_LENGTH = 256;
+
+struct InlineRename
+{
+    char** from;
+    char** to;
+    int count;
+    int capacity;
+};
+
+static int CountTreeNodes (Node* node)
+{
+    if (!node) return 0;
+    return 1 + CountTreeNodes (node->left) + CountTreeNodes (node->right);
+}
+
+static int CountCalls (Node* node)
+{
+    if (!node) return 0;
+    return (node->type == NODE_FUNC_CALL) + CountCalls (node->left) + CountCalls (node->right);
+}
+
+static InlineCandidate* FindCandidate (InlineContext* ctx, const char* name)
+{
+    for (int i = 0; i < ctx->func_count; i++)
+    {
+        if (strcmp (ctx->funcs[i].name, name) == 0)
+            return &ctx->funcs[i];
+    }
+
+    return NULL;
+}
+
+static void CollectCandidates (InlineContext* ctx, Node* node)
+{
+    if (!node) return;
+
+    if (node->type == NODE_SEQUENCE)
+    {
+        CollectCandidates (ctx, node->left);
+        CollectCandidates (ctx, node->right);
+        return;
+    }
+
+    if (node->type != NODE_FUNC_DECL || FindCandidate (ctx, node->data.string_value))
+        return;
+
+    if (ctx->func_count >= ctx->func_capacity)
+    {
+        int new_capacity = ctx->func_capacity ? ctx->func_capacity * 2 : 8;
+        InlineCandidate* new_funcs = (InlineCandidate*) realloc (ctx->funcs,
+                                                                 new_capacity * sizeof(InlineCandidate));
+        if (!new_funcs) return;
+        ctx->funcs = new_funcs;
+        ctx->func_capacity = new_capacity;
+    }
+
+    InlineCandidate* candidate = &ctx->funcs[ctx->func_count++];
+    memset (candidate, 0, sizeof(*candidate));
+    candidate->name = node->data.string_value;
+    candidate->decl = node;
+}
+
+//    ,  SEQUENCE   
+static int FlattenStatements (Node* node, Node** statements, int count, int max_count)
+{
+    if (!node || node->type == NODE_EMPTY) return count;
+
+    if (node->type == NODE_SEQUENCE)
+    {
+        count = FlattenStatements (node->left, statements, count, max_count);
+        return FlattenStatements (node->right, statements, count, max_count);
+    }
+
+    if (count < max_count)
+        statements[count] = node;
+
+    return count + 1;
+}
+
+static int NameInList (char** names, int count, const char* name)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp (names[i], name) == 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+static int ParameterIndex (Node* func, const char* name)
+{
+    int index = 0;
+    for (Node* param = func->left; param; param = param->right, index++)
+    {
+        if (strcmp (param->data.string_value, name) == 0)
+            return index;
+    }
+
+    return -1;
+}
+
+static int NameDeclared (Node** statements, int count, const char* name)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (statements[i]->type == NODE_VAR_DECL && strcmp (statements[i]->data.string_value, name) == 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+//      :    
+//      ,      
+static int ReadsOnlyInitialized (Node* expr, Node** statements, int count, char** initialized, int initialized_count)
+{
+    if (!expr) return 1;
+
+    if (expr->type == NODE_VARIABLE &&
+        NameDeclared (statements, count, expr->data.string_value) &&
+        !NameInList (initialized, initialized_count, expr->data.string_value))
+        return 0;
+
+    return ReadsOnlyInitialized (expr->left, statements, count, initialized, initialized_count) &&
+           ReadsOnlyInitialized (expr->right, statements, count, initialized, initialized_count);
+}
+
+//   :  expr    target.
+// char  int   ;   - int 0.
+static int TypeFits (Node* expr, NodeType target)
+{
+    NodeType type = ExpressionType (expr);
+    target = DeclaredType (target);
+
+    if (type == target || (type == NODE_TYPE_CHAR && target == NODE_TYPE_INT))
+        return 1;
+
+    return type == NODE_TYPE_INT && target == NODE_TYPE_CHAR && expr && expr->type == NODE_NUMBER &&
+           ConvertValue (expr->data.number_value, NODE_TYPE_CHAR) == expr->data.number_value;
+}
+
+static void AnalyzeCandidate (InlineCandidate* candidate)
+{
+    Node* body = candidate->decl->right;
+
+    candidate->size = CountTreeNodes (body);
+    candidate->simple = 0;
+    candidate->inlinable = 0;
+
+    if (candidate->recursive || candidate->size > INLINE_MAX_CALLEE_SIZE) return;
+
+    Node* statements[INLINE_MAX_CALLEE_SIZE] = {};
+    int count = FlattenStatements (body, statements, 0, INLINE_MAX_CALLEE_SIZE);
+    if (count == 0 || count > INLINE_MAX_CALLEE_SIZE) return;
+
+    // return         
+    Node* last = statements[count - 1];
+    if (last->type != NODE_RETURN || !last->left || !TypeFits (last->left, candidate->decl->data.type_value))
+        return;
+
+    //   
+    char* initialized[INLINE_MAX_CALLEE_SIZE + MAX_FUNC_PARAMS] = {};
+    int initialized_count = 0;
+
+    for (Node* param = candidate->decl->left; param; param = param->right)
+        initialized[initialized_count++] = param->data.string_value;
+
+    for (int i = 0; i < count - 1; i++)
+    {
+        Node* statement = statements[i];
+        Node* value = NULL;
+        const char* target = NULL;
+
+        if (statement->type == NODE_VAR_DECL)
+        {
+            value = statement->left;
+            target = statement->data.string_value;
+        }
+        else if (statement->type == NODE_ASSIGNMENT && statement->left &&
+                 statement->left->type == NODE_VARIABLE)
+        {
+            value = statement->right;
+            target = statement->left->data.string_value;
+        }
+        else
+            return;
+
+        //        :
+        //         
+        if (!value || CountCalls (value) > 0 ||
+            (!NameDeclared (statements, i + 1, target) && ParameterIndex (candidate->decl, target) < 0))
+            return;
+
+        if (!ReadsOnlyInitialized (value, statements, count, initialized, initialized_count))
+            return;
+
+        if (!NameInList (initialized, initialized_count, target))
+            initialized[initialized_count++] = (char*) target;
+    }
+
+    if (!ReadsOnlyInitialized (last->left, statements, count, initialized, initialized_count))
+        return;
+
+    candidate->simple = count == 1;
+    candidate->inlinable = 1;
+}
+
+static int Reaches (InlineContext* ctx, Node* node, const char* target, char* seen)
+{
+    if (!node) return 0;
+
+    if (node->type == NODE_FUNC_CALL)
+    {
+        if (strcmp (node->data.string_value, target) == 0) return 1;
+
+        InlineCandidate* callee = FindCandidate (ctx, node->data.string_value);
+        if (callee)
+        {
+            int index = (int) (callee - ctx->funcs);
+            if (!seen[index])
+            {
+                seen[index] = 1;
+                if (Reaches (ctx, callee->decl->right, target, seen)) return 1;
+            }
+        }
+    }
+
+    return Reaches (ctx, node->left, target, seen) || Reaches (ctx, node->right, target, seen);
+}
+
+static void MarkRecursive (InlineContext* ctx)
+{
+    char* seen = (char*) calloc (ctx->func_count + 1, 1);
+    if (!seen) return;
+
+    for (int i = 0; i < ctx->func_count; i++)
+    {
+        memset (seen, 0, ctx->func_count);
+        ctx->funcs[i].recursive = Reaches (ctx, ctx->funcs[i].decl->right, ctx->funcs[i].name, seen);
+    }
+
+    free (seen);
+}
+
+static const char* RenamedTo (InlineRename* rename, const char* name)
+{
+    for (int i = 0; i < rename->count; i++)
+    {
+        if (strcmp (rename->from[i], name) == 0)
+            return rename->to[i];
+    }
+
+    return name;
+}
+
+static void AddRename (InlineContext* ctx, InlineRename* rename, const char* name)
+{
+    if (RenamedTo (rename, name) != name) return;
+
+    if (rename->count >= rename->capacity)
+    {
+        int new_capacity = rename->capacity ? rename->capacity * 2 : 8;
+        char** new_from = (char**) realloc (rename->from, new_capacity * sizeof(char*));
+        if (!new_from) return;
+        rename->from = new_from;
+
+        char** new_to = (char**) realloc (rename->to, new_capacity * sizeof(char*));
+        if (!new_to) return;
+        rename->to = new_to;
+
+        rename->capacity = new_capacity;
+    }
+
+    char fresh[MAX_INLINE_NAME_LENGTH] = "";
+    snprintf (fresh, sizeof(fresh), "%s_inl%d", name, ctx->inline_counter);
+
+    rename->from[rename->count] = strdup (name);
+    rename->to[rename->count] = strdup (fresh);
+    rename->count++;
+}
+
+static void FreeRename (InlineRename* rename)
+{
+    for (int i = 0; i < rename->count; i++)
+    {
+        free (rename->from[i]);
+        free (rename->to[i]);
+    }
+
+    free (rename->from);
+    free (rename->to);
+}
+
+static Node* CopyRenamed (Node* node, InlineRename* rename)
+{
+    if (!node) return NULL;
+
+    NodeData data = node->data;
+    if ((node->type == NODE_VARIABLE || node->type == NODE_VAR_DECL) && data.string_value)
+        data.string_value = (char*) RenamedTo (rename, data.string_value);
+
+    Node* copy = CreateNode (node->type, data, CopyRenamed (node->left, rename), CopyRenamed (node->right, rename));
+    if (copy)
+        copy->value_type = node->value_type;
+
+    return copy;
+}
+
+static Node* FindOnlyCall (Node* node)
+{
+    if (!node) return NULL;
+    if (node->type == NODE_FUNC_CALL) return node;
+
+    Node* call = FindOnlyCall (node->left);
+    return call ? call : FindOnlyCall (node->right);
+}
+
+static int BudgetAllows (InlineContext* ctx, InlineCandidate* callee)
+{
+    return ctx->growth + callee->size <= INLINE_MAX_GROWTH;
+}
+
+//          :  
+//      
+static int TrivialArguments (Node* call, Node* func)
+{
+    int param_count = CountParameters (func);
+
+    for (int i = 0; i < param_count; i++)
+    {
+        Node* arg = NthArgument (call, i);
+        if (arg && arg->type != NODE_NUMBER && arg->type != NODE_VARIABLE)
+            return 0;
+
+        if (!TypeFits (arg, NthParameter (func, i)->data.type_value))
+            return 0;
+    }
+
+    return 1;
+}
+
+static Node* CopySubstituted (Node* node, Node* func, Node* call)
+{
+    if (!node) return NULL;
+
+    if (node->type == NODE_VARIABLE)
+    {
+        int index = ParameterIndex (func, node->data.string_value);
+        if (index >= 0)
+        {
+            Node* arg = NthArgument (call, index);
+            if (arg)
+                return CopyTree (arg);
+
+            Node* zero = CreateNumber (0);
+            if (zero)
+                zero->value_type = NODE_TYPE_INT;
+            return zero;
+        }
+    }
+
+    Node* copy = CreateNode (node->type, node->data, CopySubstituted (node->left, func, call),
+                                                     CopySubstituted (node->right, func, call));
+    if (copy)
+        copy->value_type = node->value_type;
+
+    return copy;
+}
+
+// "return "      ,     .
+//   ,   -   .
+static void InlineSimpleCalls (InlineContext* ctx, Node** slot)
+{
+    Node* node = *slot;
+    if (!node) return;
+
+    if (node->type == NODE_FUNC_CALL)
+    {
+        InlineSimpleCalls (ctx, &node->left);
+
+        InlineCandidate* callee = FindCandidate (ctx, node->data.string_value);
+        if (callee && callee->inlinable && callee->simple && BudgetAllows (ctx, callee) &&
+            TrivialArguments (node, callee->decl))
+        {
+            Node* statements[1] = {};
+            FlattenStatements (callee->decl->right, statements, 0, 1);
+
+            *slot = CopySubstituted (statements[0]->left, callee->decl, node);
+            FreeTree (node);
+
+            ctx->growth += callee->size;
+            ctx->inlined_calls++;
+        }
+        return;
+    }
+
+    InlineSimpleCalls (ctx, &node->left);
+    InlineSimpleCalls (ctx, &node->right);
+}
+
+//       ,  
+//    return.      : 
+//        .
+//  ,     .
+static Node* InlineHoistedCall (InlineContext* ctx, Node** expr_slot)
+{
+    if (CountCalls (*expr_slot) != 1) return NULL;
+
+    Node* call = FindOnlyCall (*expr_slot);
+    InlineCandidate* callee = FindCandidate (ctx, call->data.string_value);
+    if (!callee || !callee->inlinable || !BudgetAllows (ctx, callee)) return NULL;
+
+    //       InlineSimpleCalls
+    if (callee->simple && !callee->decl->left) return NULL;
+
+    Node* statements[INLINE_MAX_CALLEE_SIZE] = {};
+    int count = FlattenStatements (callee->decl->right, statements, 0, INLINE_MAX_CALLEE_SIZE);
+
+    ctx->inline_counter++;
+
+    InlineRename rename = {};
+    for (Node* param = callee->decl->left; param; param = param->right)
+        AddRename (ctx, &rename, param->data.string_value);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (statements[i]->type == NODE_VAR_DECL)
+            AddRename (ctx, &rename, statements[i]->data.string_value);
+    }
+
+    //   :     
+    Node* prelude = NULL;
+    int index = 0;
+    for (Node* param = callee->decl->left; param; param = param->right, index++)
+    {
+        Node* arg = NthArgument (call, index);
+        Node* decl = CreateVarDeclaration (param->data.type_value,
+                                           RenamedTo (&rename, param->data.string_value),
+                                           arg ? CopyTree (arg) : CreateNumber (0));
+        prelude = prelude ? CreateSequence (prelude, decl) : decl;
+    }
+
+    for (int i = 0; i < count - 1; i++)
+    {
+        Node* copy = CopyRenamed (statements[i], &rename);
+        prelude = prelude ? CreateSequence (prelude, copy) : copy;
+    }
+
+    Node* value = CopyRenamed (statements[count - 1]->left, &rename);
+    FreeRename (&rename);
+
+    //    :      
+    Node** slot = expr_slot;
+    while (*slot != call)
+        slot = FindOnlyCall ((*slot)->left) ? &(*slot)->left : &(*slot)->right;
+
+    *slot = value;
+    FreeTree (call);
+
+    ctx->growth += callee->size;
+    ctx->inlined_calls++;
+
+    return prelude;
+}
+
+static void InlineIntoStatement (InlineContext* ctx, Node** slot)
+{
+    Node* node = *slot;
+    if (!node) return;
+
+    Node** expr_slot = NULL;
+
+    switch (node->type)
+    {
+        case NODE_SEQUENCE:
+            InlineIntoStatement (ctx, &node->left);
+            InlineIntoStatement (ctx, &node->right);
+            return;
+
+        case NODE_IF:
+        case NODE_WHILE:
+            InlineSimpleCalls (ctx, &node->left);
+            InlineIntoStatement (ctx, &node->right);
+            return;
+
+        case NODE_FUNC_DECL:
+        case NODE_EMPTY:
+            return;
+
+        case NODE_ASSIGNMENT:
+            expr_slot = &node->right;
+            break;
+
+        case NODE_VAR_DECL:
+        case NODE_RETURN:
+            expr_slot = &node->left;
+            break;
+
+        default:
+            expr_slot = slot;   // -
+            break;
+    }
+
+    InlineSimpleCalls (ctx, expr_slot);
+
+    Node* prelude = InlineHoistedCall (ctx, expr_slot);
+    if (prelude)
+        *slot = CreateSequence (prelude, *slot);
+}
+
+static void ProcessFunction (InlineContext* ctx, InlineCandidate* func);
+
+static void ProcessCallees (InlineContext* ctx, Node* node)
+{
+    if (!node) return;
+
+    if (node->type == NODE_FUNC_CALL)
+    {
+        InlineCandidate* callee = FindCandidate (ctx, node->data.string_value);
+        if (callee) ProcessFunction (ctx, callee);
+    }
+
+    ProcessCallees (ctx, node->left);
+    ProcessCallees (ctx, node->right);
+}
+
+//   :  ,       
+static void ProcessFunction (InlineContext* ctx, InlineCandidate* func)
+{
+    if (func->visited) return;
+    func->visited = 1;
+
+    ProcessCallees (ctx, func->decl->right);
+
+    ctx->growth = 0;
+    InlineIntoStatement (ctx, &func->decl->right);
+    AnalyzeCandidate (func);
+}
+
+int InlineFunctions (Node* root)
+{
+    InlineContext ctx = {};
+
+    CollectCandidates (&ctx, root);
+    MarkRecursive (&ctx);
+
+    for (int i = 0; i < ctx.func_count; i++)
+        AnalyzeCandidate (&ctx.funcs[i]);
+
+    for (int i = 0; i < ctx.func_count; i++)
+        ProcessFunction (&ctx, &ctx.funcs[i]);
+
+    free (ctx.funcs);
+
+    return ctx.inlined_calls;
+}
@@ -0,0 +1,33 @@
+#ifndef INLINING_H
+#define INLINING_H
+
+#include "tree_base.h"
+
+typedef struct
+{
+    char* name;
+    Node* decl;
+    int size;
+    int recursive;
+    int visited;
+    int simple;         //  -  "return "
+    int inlinable;      //      "return"  
+} InlineCandidate;
+
+typedef struct
+{
+    InlineCandidate* funcs;
+    int func_count;
+    int func_capacity;
+
+    int inline_counter;     //     
+    int inlined_calls;
+    int growth;             //     
+} InlineContext;
+
+const int INLINE_MAX_CALLEE_SIZE = 40;
+const int INLINE_MAX_GROWTH = 400;
+
+int InlineFunctions (Node* root);
+
+#endif
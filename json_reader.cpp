@@ -0,0 +1,297 @@
+#include "json_reader.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    const char* current;
+    const char* end;
+    int depth;
+} JsonParser;
+
+static void SkipJsonSpace (JsonParser* parser)
+{
+    while (parser->current < parser->end &&
+           (*parser->current == ' ' || *parser->current == '\t' || *parser->current == '\n' || *parser->current == '\r'))
+        parser->current++;
+}
+
+static int MatchJsonWord (JsonParser* parser, const char* word)
+{
+    size_t length = strlen (word);
+    if ((size_t) (parser->end - parser->current) < length || strncmp (parser->current, word, length) != 0)
+        return 0;
+
+    parser->current += length;
+    return 1;
+}
+
+//   UTF-16  cp1251: -,    -  ,  - '?'
+static char CodeUnitToCp1251 (unsigned code)
+{
+    if (code < 0x80) return (char) code;
+    if (code >= 0x410 && code <= 0x44F) return (char) (0xC0 + code - 0x410);
+    if (code == 0x401) return (char) 0xA8;
+    if (code == 0x451) return (char) 0xB8;
+
+    return '?';
+}
+
+static int HexDigit (char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+
+    return -1;
+}
+
+//     ;    
+static int ParseJsonString (JsonParser* parser, char** string, int* length)
+{
+    const char* start = parser->current;
+    const char* quote = start;
+    while (quote < parser->end && *quote != '"')
+        quote += *quote == '\\' ? 2 : 1;
+    if (quote >= parser->end) return 0;
+
+    char* out = (char*) malloc (quote - start + 1);
+    if (!out) return 0;
+
+    int size = 0;
+    const unsigned char* c = (const unsigned char*) start;
+    const unsigned char* end = (const unsigned char*) quote;
+
+    while (c < end)
+    {
+        if (*c == '\\')
+        {
+            c++;
+            switch (*c)
+            {
+                case 'n': out[size++] = '\n'; c++; break;
+                case 't': out[size++] = '\t'; c++; break;
+                case 'r': out[size++] = '\r'; c++; break;
+                case 'b': out[size++] = '\b'; c++; break;
+                case 'f': out[size++] = '\f'; c++; break;
+                case 'u':
+                {
+                    unsigned code = 0;
+                    for (int i = 1; i <= 4; i++)
+                    {
+                        int digit = c + i < end ? HexDigit ((char) c[i]) : -1;
+                        if (digit < 0)
+                        {
+                            free (out);
+                            return 0;
+                        }
+                        code = code * 16 + digit;
+                    }
+                    out[size++] = CodeUnitToCp1251 (code);     //    -  '?'
+                    c += 5;
+                    break;
+                }
+                default: out[size++] = (char) *c++; break;     // \" \\ \/
+            }
+        }
+        else if (*c < 0x80)
+            out[size++] = (char) *c++;
+        else if ((*c & 0xE0) == 0xC0 && c + 1 < end)
+        {
+            out[size++] = CodeUnitToCp1251 (((c[0] & 0x1F) << 6) | (c[1] & 0x3F));
+            c += 2;
+        }
+        else if ((*c & 0xF0) == 0xE0)
+        {
+            out[size++] = '?';
+            c += 3;
+        }
+        else if ((*c & 0xF8) == 0xF0)
+        {
+            out[size++] = '?';                              //  BMP -   UTF-16
+            out[size++] = '?';
+            c += 4;
+        }
+        else
+        {
+            out[size++] = '?';
+            c++;
+        }
+    }
+
+    out[size] = '\0';
+    parser->current = quote + 1;
+    *string = out;
+    *length = size;
+    return 1;
+}
+
+static void FreeJsonContents (JsonValue* value)
+{
+    for (int i = 0; i < value->count; i++)
+        FreeJsonContents (&value->items[i]);
+
+    free (value->items);
+    free (value->string);
+    free (value->key);
+}
+
+static int ParseJsonValue (JsonParser* parser, JsonValue* value);
+
+static int ParseJsonItems (JsonParser* parser, JsonValue* value, char close, int members)
+{
+    int capacity = 0;
+
+    SkipJsonSpace (parser);
+    if (parser->current < parser->end && *parser->current == close)
+    {
+        parser->current++;
+        return 1;
+    }
+
+    while (1)
+    {
+        if (value->count >= capacity)
+        {
+            int new_capacity = capacity ? capacity * 2 : 4;
+            JsonValue* new_items = (JsonValue*) realloc (value->items, new_capacity * sizeof(JsonValue));
+            if (!new_items) return 0;
+            value->items = new_items;
+            capacity = new_capacity;
+        }
+
+        JsonValue* item = &value->items[value->count];
+        memset (item, 0, sizeof(JsonValue));
+        value->count++;
+
+        SkipJsonSpace (parser);
+        if (members)
+        {
+            int key_length = 0;
+            if (parser->current >= parser->end || *parser->current != '"') return 0;
+            parser->current++;
+            if (!ParseJsonString (parser, &item->key, &key_length)) return 0;
+
+            SkipJsonSpace (parser);
+            if (parser->current >= parser->end || *parser->current != ':') return 0;
+            parser->current++;
+        }
+
+        if (!ParseJsonValue (parser, item)) return 0;
+
+        SkipJsonSpace (parser);
+        if (parser->current >= parser->end) return 0;
+
+        char c = *parser->current++;
+        if (c == close) return 1;
+        if (c != ',') return 0;
+    }
+}
+
+static int ParseJsonValue (JsonParser* parser, JsonValue* value)
+{
+    SkipJsonSpace (parser);
+    if (parser->current >= parser->end || parser->depth >= MAX_JSON_DEPTH) return 0;
+
+    char c = *parser->current;
+
+    if (c == '"')
+    {
+        parser->current++;
+        value->type = JSON_STRING;
+        return ParseJsonString (parser, &value->string, &value->length);
+    }
+
+    if (c == '{' || c == '[')
+    {
+        parser->current++;
+        parser->depth++;
+        value->type = c == '{' ? JSON_OBJECT : JSON_ARRAY;
+        int ok = ParseJsonItems (parser, value, c == '{' ? '}' : ']', c == '{');
+        parser->depth--;
+        return ok;
+    }
+
+    if (MatchJsonWord (parser, "true"))
+    {
+        value->type = JSON_BOOL;
+        value->number = 1;
+        return 1;
+    }
+    if (MatchJsonWord (parser, "false"))
+    {
+        value->type = JSON_BOOL;
+        return 1;
+    }
+    if (MatchJsonWord (parser, "null"))
+    {
+        value->type = JSON_NULL;
+        return 1;
+    }
+
+    // strtod  '\0'  ,     :  
+    char number[64] = "";
+    int length = 0;
+    while (parser->current + length < parser->end && length < (int) sizeof(number) - 1 &&
+           strchr ("+-0123456789.eE", parser->current[length]))
+    {
+        number[length] = parser->current[length];
+        length++;
+    }
+
+    char* number_end = NULL;
+    value->type = JSON_NUMBER;
+    value->number = strtod (number, &number_end);
+    if (length == 0 || number_end != number + length) return 0;
+
+    parser->current += length;
+    return 1;
+}
+
+JsonValue* ParseJson (const char* text, int length)
+{
+    JsonParser parser = {text, text + length, 0};
+
+    JsonValue* value = (JsonValue*) calloc (1, sizeof(JsonValue));
+    if (!value) return NULL;
+
+    int ok = ParseJsonValue (&parser, value);
+    SkipJsonSpace (&parser);
+
+    if (!ok || parser.current != parser.end)
+    {
+        FreeJson (value);
+        return NULL;
+    }
+
+    return value;
+}
+
+void FreeJson (JsonValue* value)
+{
+    if (!value) return;
+
+    FreeJsonContents (value);
+    free (value);
+}
+
+const JsonValue* JsonMember (const JsonValue* value, const char* key)
+{
+    if (!value || value->type != JSON_OBJECT) return NULL;
+
+    for (int i = 0; i < value->count; i++)
+        if (value->items[i].key && strcmp (value->items[i].key, key) == 0)
+            return &value->items[i];
+
+    return NULL;
+}
+
+const char* JsonString (const JsonValue* value)
+{
+    return value && value->type == JSON_STRING ? value->string : NULL;
+}
+
+double JsonNumber (const JsonValue* value, double fallback)
+{
+    return value && value->type == JSON_NUMBER ? value->number : fallback;
+}
@@ -0,0 +1,44 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+//  JSON   .     UTF-8  cp1251,
+//  :  -   ,   ASCII - '?'  
+//  UTF-16,         LSP
+enum JsonType
+{
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+};
+
+typedef struct JsonValue JsonValue;
+
+struct JsonValue
+{
+    JsonType type;
+    double number;              //  true/false  1/0
+    char* string;
+    int length;                 //  string
+    char* key;                  // ,    
+
+    JsonValue* items;           //     
+    int count;
+};
+
+const int MAX_JSON_DEPTH = 64;
+
+// NULL -  JSON    
+JsonValue* ParseJson (const char* text, int length);
+void FreeJson (JsonValue* value);
+
+// NULL,  value     
+const JsonValue* JsonMember (const JsonValue* value, const char* key);
+// NULL,   
+const char* JsonString (const JsonValue* value);
+// fallback,   
+double JsonNumber (const JsonValue* value, double fallback);
+
+#endif
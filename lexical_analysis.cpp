@@ -1,4 +1,6 @@
 #include "lexical_analysis.h"
+#include "pass_trace.h"
+#include "memory_accounting.h"
 
 /*
 
@@ -25,7 +27,10 @@
 20 while -- ___
 */
 
-static KeywordToken keyword_tokens[] =
+static bool IsAlphaRu (char c);
+static bool CanBeIdentifierCharRu (char c);
+
+static const KeywordToken keyword_tokens[] =
 {
     {TOK_DECLARE,       "__"},
     {TOK_TYPE_INT,      ""},
@@ -175,7 +180,7 @@ bool AddToken (Lexer* lexer, MyTokenType type, const char* value_start, int valu
     if (lexer->count >= lexer->capacity)
     {
         lexer->capacity *= 2;
-        Token* new_tokens = (Token*)realloc (lexer->tokens, lexer->capacity * sizeof(Token));
+        Token* new_tokens = (Token*) MemRealloc (MEM_TOKENS, lexer->tokens, lexer->capacity * sizeof(Token));
 
         if (!new_tokens)
             return false;
@@ -184,10 +189,12 @@ bool AddToken (Lexer* lexer, MyTokenType type, const char* value_start, int valu
     }
 
     lexer->tokens[lexer->count].type = type;
+    lexer->tokens[lexer->count].offset = (int) (value_start - lexer->source);
+    lexer->tokens[lexer->count].length = value_length;
 
     if (type == TOK_IDENTIFIER)
     {
-        lexer->tokens[lexer->count].value.identifier = (char*) calloc (1, value_length + 1);
+        lexer->tokens[lexer->count].value.identifier = (char*) MemAlloc (MEM_IDENTIFIERS, 1, value_length + 1);
 
         if (!lexer->tokens[lexer->count].value.identifier)
             return false;
@@ -207,6 +214,7 @@ bool AddToken (Lexer* lexer, MyTokenType type, const char* value_start, int valu
     }
 
     lexer->count++;
+    TRACE_COUNT (COUNTER_TOKENS, 1);
     return true;
 }
 
@@ -301,10 +309,11 @@ Lexer* CtorLexer (const char* source_code)
     lexer->current = source_code;
     lexer->line = 1;
     lexer->column = 1;
+    lexer->errors = stderr;
 
     lexer->capacity = 64;
     lexer->count = 0;
-    lexer->tokens = (Token*) calloc (lexer->capacity, sizeof(Token));
+    lexer->tokens = (Token*) MemAlloc (MEM_TOKENS, lexer->capacity, sizeof(Token));
 
     if (!lexer->tokens)
     {
@@ -323,11 +332,11 @@ void DtorLexer (Lexer* lexer)
     for (int i = 0; i < lexer->count; i++)
     {
         if (lexer->tokens[i].type == TOK_IDENTIFIER && lexer->tokens[i].value.identifier)
-            free (lexer->tokens[i].value.identifier);
+            MemFree (MEM_IDENTIFIERS, lexer->tokens[i].value.identifier);
     }
 
     if (lexer->tokens)
-        free(lexer->tokens);
+        MemFree (MEM_TOKENS, lexer->tokens);
 
     free(lexer);
 }
@@ -338,13 +347,24 @@ bool LexerScanTokens (Lexer* lexer)
 
     while (!IsAtEnd (lexer))
     {
+        if (!LexerScanNext (lexer))
+            return false;
+    }
+
+    return AddToken (lexer, TOK_EOF, lexer->current, 0);
+}
+
+bool LexerScanNext (Lexer* lexer)
+{
+    if (!lexer) return false;
+
+    int count = lexer->count;
+
+    while (!IsAtEnd (lexer) && lexer->count == count)
+    {
+        //     Advance
         if (isspace (Peek (lexer)))
         {
-            if (Peek (lexer) == '\n')
-            {
-                lexer->line++;
-                lexer->column = 1;
-            }
             Advance (lexer);
             continue;
         }
@@ -392,7 +412,7 @@ bool LexerScanTokens (Lexer* lexer)
             printf("DEBUG: : '%.10s'\n", lexer->current);
         #endif
 
-        fprintf (stderr, "   ( %d,  %d):   '%c' (: %d)\n",
+        fprintf (lexer->errors, "   ( %d,  %d):   '%c' (: %d)\n",
                  lexer->line, lexer->column, Peek(lexer), (unsigned char)Peek(lexer));
         Advance (lexer);
 
@@ -405,7 +425,7 @@ bool LexerScanTokens (Lexer* lexer)
                    (unsigned char)Peek(lexer),
                    lexer->line, lexer->column);
 
-            fprintf (stderr, "   ( %d,  %d):   '%c' (: %d)\n",
+            fprintf (lexer->errors, "   ( %d,  %d):   '%c' (: %d)\n",
                     lexer->line, lexer->column, Peek(lexer), (unsigned char)Peek(lexer));
             Advance (lexer);
             continue;
@@ -462,22 +482,21 @@ bool LexerScanTokens (Lexer* lexer)
         printf("'\n");
         printf("===  DEBUG ===\n");
 
-        fprintf (stderr, "   ( %d,  %d):   '%c' (: %d)\n",
+        fprintf (lexer->errors, "   ( %d,  %d):   '%c' (: %d)\n",
                  lexer->line, lexer->column, Peek(lexer), (unsigned char)Peek(lexer));
         Advance (lexer);
 
         #endif
     }
 
-    return AddToken (lexer, TOK_EOF, "", 0);
+    return true;
 }
 
 static bool IsRussianLetter (char c)
 {
     unsigned char uc = (unsigned char) c;
 
-    return (uc >= 192 && uc <= 223) ||    // -
-           (uc >= 224 && uc <= 255) ||    // -
+    return (uc >= 192) ||                 // -  192, -  224   
            (uc == 168) || (uc == 184);    // , 
 }
 
@@ -486,11 +505,6 @@ static bool IsAlphaRu (char c)
     return isalpha (c) || IsRussianLetter (c);
 }
 
-static bool IsAlnumRu (char c)
-{
-    return isalnum (c) || IsRussianLetter (c);
-}
-
 static bool CanBeIdentifierCharRu (char c)
 {
     return isalnum (c) || c == '_' || IsRussianLetter (c);
@@ -542,49 +556,49 @@ const char* TokenTypeToString (MyTokenType type)
     }
 }
 
-void LexerPrintTokens (const Lexer* lexer)
+void LexerPrintTokens (const Lexer* lexer, FILE* out)
 {
     if (!lexer)
     {
-        printf("  \n");
+        fprintf (out, "  \n");
         return;
     }
 
-    printf ("===  :  %d  ===\n", lexer->count);
-    printf ("%-5s %-30s %-20s %-10s\n", "", " ", "", "");
-    printf ("-------------------------------------------------------------\n");
+    fprintf (out, "===  :  %d  ===\n", lexer->count);
+    fprintf (out, "%-5s %-30s %-20s %-10s\n", "", " ", "", "");
+    fprintf (out, "-------------------------------------------------------------\n");
 
     for (int i = 0; i < lexer->count; i++)
     {
         const Token* token = &lexer->tokens[i];
 
-        printf("%-5d %-30s ", i, TokenTypeToString (token->type));
+        fprintf (out, "%-5d %-30s ", i, TokenTypeToString (token->type));
 
         switch (token->type)
         {
             case TOK_NUMBER:
-                printf("%-20g", token->value.number);
+                fprintf (out, "%-20g", token->value.number);
                 break;
 
             case TOK_IDENTIFIER:
                 if (token->value.identifier)
-                    printf ("%-20s", token->value.identifier);
+                    fprintf (out, "%-20s", token->value.identifier);
                 else
-                    printf ("%-20s", "(null)");
+                    fprintf (out, "%-20s", "(null)");
 
                 break;
 
             case TOK_EOF:
-                printf ("%-20s", "END OF FILE");
+                fprintf (out, "%-20s", "END OF FILE");
                 break;
 
             default:
-                printf("%-20s", "");
+                fprintf (out, "%-20s", "");
                 break;
         }
 
 
-        printf (" line:%d\n", lexer->line);
+        fprintf (out, " line:%d\n", lexer->line);
     }
 }
 
@@ -622,7 +636,7 @@ void FreeTokens (Token* tokens, int token_count)
     for (int i = 0; i < token_count; i++)
     {
         if (tokens[i].type == TOK_IDENTIFIER && tokens[i].value.identifier)
-            free(tokens[i].value.identifier);
+            MemFree (MEM_IDENTIFIERS, tokens[i].value.identifier);
     }
-    free (tokens);
+    MemFree (MEM_TOKENS, tokens);
 }
@@ -57,6 +57,8 @@ struct Token
         double number;
         char* identifier;
     } value;
+    int offset;         //   ,    lexer->source
+    int length;
 };
 
 struct KeyWordToken
@@ -76,6 +78,7 @@ struct Lexer
     int column;
     int capacity;
     int count;
+    FILE* errors;       //   ,   stderr
 };
 
 typedef struct Lexer Lexer;
@@ -94,20 +97,17 @@ long GetFileSize (FILE* file);
 Lexer* CtorLexer (const char* source_code);
 void DtorLexer (Lexer* lexer);
 bool LexerScanTokens (Lexer* lexer);
+//   LexerScanTokens:    , , 
+//      .      , EOF 
+bool LexerScanNext (Lexer* lexer);
 
 Token* LexerGetTokens (const Lexer* lexer);
 int LexerGetTokenCount (const Lexer* lexer);
 
 const char* TokenTypeToString (MyTokenType type);
-void LexerPrintTokens (const Lexer* lexer);
+void LexerPrintTokens (const Lexer* lexer, FILE* out);
 
 Token* LexerOld (const char* source_code, int* token_count);
 void FreeTokens (Token* tokens, int token_count);
 
-static bool IsRussianLetter(char c);
-static bool IsAlphaRu (char c);
-static bool IsAlnumRu (char c);
-static bool CanBeIdentifierCharRu (char c);
-
-
 #endif
@@ -0,0 +1,374 @@
+#include "lexxer_api.h"
+#include "lexical_analysis.h"
+#include "tree_base.h"
+#include "syntactic_analysis.h"
+#include "create_AST_dump.h"
+#include "create_tree_AST.h"
+#include "compile_pipeline.h"
+#include "x86_codegen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct LexxerCompiler
+{
+    int opt_level;
+
+    char* source;               //      :    '\0'
+    size_t source_capacity;
+
+    char* diagnostics;
+    size_t diagnostics_size;
+};
+
+int LexxerApiVersion (void)
+{
+    return LEXXER_API_VERSION;
+}
+
+LexxerCompiler* LexxerCreateCompiler (void)
+{
+    LexxerCompiler* compiler = (LexxerCompiler*) calloc (1, sizeof(LexxerCompiler));
+    if (!compiler) return NULL;
+
+    compiler->opt_level = 1;
+    return compiler;
+}
+
+void LexxerDestroyCompiler (LexxerCompiler* compiler)
+{
+    if (!compiler) return;
+
+    free (compiler->source);
+    free (compiler->diagnostics);
+    free (compiler);
+}
+
+LexxerStatus LexxerSetOption (LexxerCompiler* compiler, LexxerOption option, int value)
+{
+    if (!compiler) return LEXXER_ERROR_ARGUMENT;
+
+    switch (option)
+    {
+        case LEXXER_OPTION_OPT_LEVEL:
+            if (value < 0 || value > 2) return LEXXER_ERROR_ARGUMENT;
+            compiler->opt_level = value;
+            return LEXXER_OK;
+
+        default:
+            return LEXXER_ERROR_ARGUMENT;
+    }
+}
+
+const char* LexxerDiagnostics (const LexxerCompiler* compiler)
+{
+    return compiler && compiler->diagnostics ? compiler->diagnostics : "";
+}
+
+void LexxerFree (void* block)
+{
+    free (block);
+}
+
+const char* LexxerTokenTypeName (int type)
+{
+    return TokenTypeToString ((MyTokenType) type);
+}
+
+const char* LexxerNodeTypeName (int type)
+{
+    return NodeTypeToString ((NodeType) type);
+}
+
+//      ;   
+static FILE* BeginCall (LexxerCompiler* compiler, const char* source, size_t length)
+{
+    free (compiler->diagnostics);
+    compiler->diagnostics = NULL;
+    compiler->diagnostics_size = 0;
+
+    if (length + 1 > compiler->source_capacity)
+    {
+        char* new_source = (char*) realloc (compiler->source, length + 1);
+        if (!new_source) return NULL;
+        compiler->source = new_source;
+        compiler->source_capacity = length + 1;
+    }
+
+    memcpy (compiler->source, source, length);
+    compiler->source[length] = '\0';
+
+    return open_memstream (&compiler->diagnostics, &compiler->diagnostics_size);
+}
+
+//      :      
+static LexxerStatus EndCall (LexxerCompiler* compiler, FILE* diagnostics, LexxerStatus status)
+{
+    fclose (diagnostics);
+
+    if (status == LEXXER_OK && compiler->diagnostics_size > 0)
+        return LEXXER_ERROR_SOURCE;
+
+    return status;
+}
+
+static LexxerStatus ParseSource (LexxerCompiler* compiler, FILE* diagnostics,
+                                 Lexer** lexer, Getter** getter, Node** root)
+{
+    *lexer = CtorLexer (compiler->source);
+    if (!*lexer) return LEXXER_ERROR_MEMORY;
+
+    (*lexer)->errors = diagnostics;
+    if (!LexerScanTokens (*lexer)) return LEXXER_ERROR_SOURCE;
+
+    *getter = CtorGetter (*lexer);
+    if (!*getter) return LEXXER_ERROR_MEMORY;
+
+    *root = GetProgram (*getter);
+    if ((*getter)->error_count > 0) return LEXXER_ERROR_SOURCE;
+
+    if (!*root)
+    {
+        fprintf (diagnostics, "  NULL  \n");
+        return LEXXER_ERROR_SOURCE;
+    }
+
+    return LEXXER_OK;
+}
+
+LexxerStatus LexxerTokenize (LexxerCompiler* compiler, const char* source, size_t length,
+                             LexxerToken** tokens, size_t* count)
+{
+    if (!compiler || !source || !tokens || !count) return LEXXER_ERROR_ARGUMENT;
+
+    *tokens = NULL;
+    *count = 0;
+
+    FILE* diagnostics = BeginCall (compiler, source, length);
+    if (!diagnostics) return LEXXER_ERROR_MEMORY;
+
+    Lexer* lexer = CtorLexer (compiler->source);
+    if (!lexer) return EndCall (compiler, diagnostics, LEXXER_ERROR_MEMORY);
+
+    lexer->errors = diagnostics;
+    LexxerStatus status = LexerScanTokens (lexer) ? LEXXER_OK : LEXXER_ERROR_SOURCE;
+
+    //      :   LexxerFree
+    size_t text_bytes = 0;
+    for (int i = 0; i < lexer->count; i++)
+        if (lexer->tokens[i].type == TOK_IDENTIFIER && lexer->tokens[i].value.identifier)
+            text_bytes += strlen (lexer->tokens[i].value.identifier) + 1;
+
+    LexxerToken* result = status == LEXXER_OK ?
+                          (LexxerToken*) malloc (lexer->count * sizeof(LexxerToken) + text_bytes + 1) : NULL;
+    if (status == LEXXER_OK && !result)
+        status = LEXXER_ERROR_MEMORY;
+
+    if (result)
+    {
+        char* text = (char*) (result + lexer->count);
+
+        for (int i = 0; i < lexer->count; i++)
+        {
+            const Token* token = &lexer->tokens[i];
+
+            result[i].type = token->type;
+            result[i].number = token->type == TOK_NUMBER ? token->value.number : 0;
+            result[i].text = NULL;
+
+            if (token->type == TOK_IDENTIFIER && token->value.identifier)
+            {
+                size_t size = strlen (token->value.identifier) + 1;
+                memcpy (text, token->value.identifier, size);
+                result[i].text = text;
+                text += size;
+            }
+        }
+
+        *tokens = result;
+        *count = lexer->count;
+    }
+
+    DtorLexer (lexer);
+
+    status = EndCall (compiler, diagnostics, status);
+    if (status != LEXXER_OK)
+    {
+        free (*tokens);
+        *tokens = NULL;
+        *count = 0;
+    }
+
+    return status;
+}
+
+typedef struct
+{
+    LexxerNode* nodes;
+    char* text;
+    int count;
+} FlatTree;
+
+static void MeasureTree (const Node* node, int* count, size_t* text_bytes)
+{
+    if (!node) return;
+
+    (*count)++;
+    if (node->type != NODE_NUMBER && node->data.string_value)
+        *text_bytes += strlen (node->data.string_value) + 1;
+
+    MeasureTree (node->left, count, text_bytes);
+    MeasureTree (node->right, count, text_bytes);
+}
+
+//  :      
+static int FlattenTree (FlatTree* flat, const Node* node)
+{
+    if (!node) return -1;
+
+    int index = flat->count++;
+    LexxerNode* out = &flat->nodes[index];
+
+    out->type = node->type;
+    out->value_type = node->data.type_value;
+    out->number = node->type == NODE_NUMBER ? node->data.number_value : 0;
+    out->name = NULL;
+
+    if (node->type != NODE_NUMBER && node->data.string_value)
+    {
+        size_t size = strlen (node->data.string_value) + 1;
+        memcpy (flat->text, node->data.string_value, size);
+        out->name = flat->text;
+        flat->text += size;
+    }
+
+    int left = FlattenTree (flat, node->left);
+    int right = FlattenTree (flat, node->right);
+
+    // flat->nodes  , out  
+    out->left = left;
+    out->right = right;
+
+    return index;
+}
+
+LexxerStatus LexxerParse (LexxerCompiler* compiler, const char* source, size_t length,
+                          LexxerNode** nodes, size_t* count)
+{
+    if (!compiler || !source || !nodes || !count) return LEXXER_ERROR_ARGUMENT;
+
+    *nodes = NULL;
+    *count = 0;
+
+    FILE* diagnostics = BeginCall (compiler, source, length);
+    if (!diagnostics) return LEXXER_ERROR_MEMORY;
+
+    Lexer* lexer = NULL;
+    Getter* getter = NULL;
+    Node* root = NULL;
+    LexxerStatus status = ParseSource (compiler, diagnostics, &lexer, &getter, &root);
+
+    if (status == LEXXER_OK)
+    {
+        int node_count = 0;
+        size_t text_bytes = 0;
+        MeasureTree (root, &node_count, &text_bytes);
+
+        FlatTree flat = {};
+        flat.nodes = (LexxerNode*) malloc (node_count * sizeof(LexxerNode) + text_bytes + 1);
+
+        if (flat.nodes)
+        {
+            flat.text = (char*) (flat.nodes + node_count);
+            FlattenTree (&flat, root);
+
+            *nodes = flat.nodes;
+            *count = node_count;
+        }
+        else
+            status = LEXXER_ERROR_MEMORY;
+    }
+
+    FreeTree (root);
+    DtorGetter (getter);
+    DtorLexer (lexer);
+
+    status = EndCall (compiler, diagnostics, status);
+    if (status != LEXXER_OK)
+    {
+        free (*nodes);
+        *nodes = NULL;
+        *count = 0;
+    }
+
+    return status;
+}
+
+LexxerStatus LexxerCompile (LexxerCompiler* compiler, const char* source, size_t length,
+                            LexxerTarget target, char** code, size_t* size)
+{
+    if (!compiler || !source || !code || !size) return LEXXER_ERROR_ARGUMENT;
+    if (target != LEXXER_TARGET_VM_ASM && target != LEXXER_TARGET_X86_ASM && target != LEXXER_TARGET_AST)
+        return LEXXER_ERROR_ARGUMENT;
+
+    *code = NULL;
+    *size = 0;
+
+    FILE* diagnostics = BeginCall (compiler, source, length);
+    if (!diagnostics) return LEXXER_ERROR_MEMORY;
+
+    FILE* output = open_memstream (code, size);
+    if (!output) return EndCall (compiler, diagnostics, LEXXER_ERROR_MEMORY);
+
+    LexxerStatus status = LEXXER_OK;
+
+    if (target == LEXXER_TARGET_VM_ASM)
+    {
+        if (!CompileSourceToAsm (compiler->source, compiler->opt_level, NULL, output, diagnostics))
+            status = LEXXER_ERROR_SOURCE;
+    }
+    else
+    {
+        Lexer* lexer = NULL;
+        Getter* getter = NULL;
+        Node* root = NULL;
+        status = ParseSource (compiler, diagnostics, &lexer, &getter, &root);
+
+        if (status == LEXXER_OK && target == LEXXER_TARGET_AST)
+        {
+            DumpAST (root, output);
+        }
+        else if (status == LEXXER_OK)
+        {
+            OptimizeTree (&root, compiler->opt_level, 1);
+
+            X86Context* x86 = CtorX86CodeGen (output);
+            if (x86)
+            {
+                GenerateX86Program (x86, root);
+
+                //    , DtorX86CodeGen   
+                x86->output = NULL;
+                DtorX86CodeGen (x86);
+            }
+            else
+                status = LEXXER_ERROR_MEMORY;
+        }
+
+        FreeTree (root);
+        DtorGetter (getter);
+        DtorLexer (lexer);
+    }
+
+    fclose (output);
+
+    status = EndCall (compiler, diagnostics, status);
+    if (status != LEXXER_OK)
+    {
+        free (*code);
+        *code = NULL;
+        *size = 0;
+    }
+
+    return status;
+}
@@ -0,0 +1,99 @@
+#ifndef LEXXER_API_H
+#define LEXXER_API_H
+
+#include <stddef.h>
+
+//   :   , ,    -  
+// .  ,  stdout:    LexxerDiagnostics.
+//
+//    C      LEXXER_API_VERSION: 
+//     ,    .
+//  -  .cpp,  main.cpp:  - ar rcs liblexxer.a *.o,
+//  - g++ -shared -fPIC -fvisibility=hidden,    LEXXER_API.
+//
+//  LexxerCompiler -    ;   
+//    .
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+    #define LEXXER_API __attribute__ ((visibility ("default")))
+#else
+    #define LEXXER_API
+#endif
+
+#define LEXXER_API_VERSION 1
+
+typedef struct LexxerCompiler LexxerCompiler;
+
+typedef enum
+{
+    LEXXER_OK             = 0,
+    LEXXER_ERROR_ARGUMENT = 1,  // NULL ,   ,   
+    LEXXER_ERROR_MEMORY   = 2,
+    LEXXER_ERROR_SOURCE   = 3   //    ,   LexxerDiagnostics
+} LexxerStatus;
+
+typedef enum
+{
+    LEXXER_OPTION_OPT_LEVEL = 0     // 0..2,  -O;   1
+} LexxerOption;
+
+typedef enum
+{
+    LEXXER_TARGET_VM_ASM  = 0,      // asm  VM,  asm_code_gen.asm
+    LEXXER_TARGET_X86_ASM = 1,      // x86-64  cc,  native_code_gen.s
+    LEXXER_TARGET_AST     = 2       //     Lisp-,  ast_tree.txt
+} LexxerTarget;
+
+typedef struct
+{
+    int type;               // LexxerTokenTypeName
+    double number;          //  
+    const char* text;       //  ,  NULL;     
+} LexxerToken;
+
+//   : nodes[0] - ,  - , -1 -  
+typedef struct
+{
+    int type;               // LexxerNodeTypeName
+    int left;
+    int right;
+    int value_type;         //     (  ,  type)
+    double number;          //  
+    const char* name;       //  ,   ,  NULL
+} LexxerNode;
+
+LEXXER_API int LexxerApiVersion (void);
+
+LEXXER_API LexxerCompiler* LexxerCreateCompiler (void);
+LEXXER_API void LexxerDestroyCompiler (LexxerCompiler* compiler);
+LEXXER_API LexxerStatus LexxerSetOption (LexxerCompiler* compiler, LexxerOption option, int value);
+
+//        :
+//  LexxerFree.   *result == NULL, *count  *size == 0.
+// source    .
+LEXXER_API LexxerStatus LexxerTokenize (LexxerCompiler* compiler, const char* source, size_t length,
+                                        LexxerToken** tokens, size_t* count);
+LEXXER_API LexxerStatus LexxerParse (LexxerCompiler* compiler, const char* source, size_t length,
+                                     LexxerNode** nodes, size_t* count);
+//    ; size -  
+LEXXER_API LexxerStatus LexxerCompile (LexxerCompiler* compiler, const char* source, size_t length,
+                                       LexxerTarget target, char** code, size_t* size);
+
+//      ; "" -   .
+//     
+LEXXER_API const char* LexxerDiagnostics (const LexxerCompiler* compiler);
+
+LEXXER_API void LexxerFree (void* block);
+
+LEXXER_API const char* LexxerTokenTypeName (int type);
+LEXXER_API const char* LexxerNodeTypeName (int type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,318 @@
+#include "loop_optimization.h"
+#include "type_checking.h"
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  :       
+struct InductionVariable
+{
+    const char* name;
+    double step;            //  
+    Node** increment;       //    
+};
+
+static int CountTreeNodes (Node* node)
+{
+    if (!node) return 0;
+    return 1 + CountTreeNodes (node->left) + CountTreeNodes (node->right);
+}
+
+static int CountCalls (Node* node)
+{
+    if (!node) return 0;
+    return (node->type == NODE_FUNC_CALL) + CountCalls (node->left) + CountCalls (node->right);
+}
+
+static int IsVariable (Node* node, const char* name)
+{
+    return node && node->type == NODE_VARIABLE && strcmp (node->data.string_value, name) == 0;
+}
+
+static int Assigns (Node* node, const char* name)
+{
+    if (!node) return 0;
+
+    if (node->type == NODE_ASSIGNMENT && IsVariable (node->left, name)) return 1;
+    if (node->type == NODE_VAR_DECL && strcmp (node->data.string_value, name) == 0) return 1;
+
+    return Assigns (node->left, name) || Assigns (node->right, name);
+}
+
+//     :    ,    
+static int IsInvariant (Node* expr, Node* body)
+{
+    if (!expr) return 1;
+
+    switch (expr->type)
+    {
+        case NODE_NUMBER:
+            return 1;
+
+        case NODE_VARIABLE:
+            return !Assigns (body, expr->data.string_value);
+
+        case NODE_ADD:
+        case NODE_SUB:
+        case NODE_MUL:
+        case NODE_DIV:
+            return IsInvariant (expr->left, body) && IsInvariant (expr->right, body);
+
+        default:
+            return 0;
+    }
+}
+
+static Node** LastStatement (Node** slot)
+{
+    while (*slot && (*slot)->type == NODE_SEQUENCE)
+        slot = &(*slot)->right;
+
+    return slot;
+}
+
+// "i = i + c", "i = c + i"  "i = i - c"   i  c. double  :
+// i + 3c     c  -,    i * k -> t
+//    . char :     8 
+static int MatchIncrement (Node* statement, InductionVariable* iv)
+{
+    if (!statement || statement->type != NODE_ASSIGNMENT ||
+        !statement->left || statement->left->type != NODE_VARIABLE)
+        return 0;
+
+    const char* name = statement->left->data.string_value;
+    Node* value = statement->right;
+    if (!value || (value->type != NODE_ADD && value->type != NODE_SUB)) return 0;
+
+    Node* step = value->right;
+    if (value->type == NODE_ADD && IsVariable (step, name))
+        step = value->left;
+    else if (!IsVariable (value->left, name))
+        return 0;
+
+    if (!step || step->type != NODE_NUMBER || step->data.number_value == 0) return 0;
+
+    if (ExpressionType (statement->left) != NODE_TYPE_INT ||
+        step->data.number_value != floor (step->data.number_value))
+        return 0;
+
+    iv->name = name;
+    iv->step = value->type == NODE_ADD ? step->data.number_value : -step->data.number_value;
+    return 1;
+}
+
+static int MatchInductionVariable (Node* loop, InductionVariable* iv)
+{
+    //     :    
+    if (!loop->right || CountCalls (loop) > 0) return 0;
+
+    iv->increment = LastStatement (&loop->right);
+    if (!MatchIncrement (*iv->increment, iv)) return 0;
+
+    //      
+    Node* increment = *iv->increment;
+    *iv->increment = NULL;
+    int assigned = Assigns (loop->right, iv->name);
+    *iv->increment = increment;
+
+    return !assigned;
+}
+
+//   "i < B" / "B > i"   , "i > B" / "B < i"   
+static int MatchExitTest (Node* loop, const InductionVariable* iv)
+{
+    Node* condition = loop->left;
+    if (!condition || (condition->type != NODE_LT && condition->type != NODE_GT)) return 0;
+
+    int iv_left = IsVariable (condition->left, iv->name);
+    if (!iv_left && !IsVariable (condition->right, iv->name)) return 0;
+
+    Node* bound = iv_left ? condition->right : condition->left;
+    if (!IsInvariant (bound, loop->right)) return 0;
+
+    int increasing = (condition->type == NODE_LT) == iv_left;
+    return increasing == (iv->step > 0);
+}
+
+static Node* CreateStep (Node* base, double step)
+{
+    if (step < 0)
+        return CreateOperation (NODE_SUB, base, CreateNumber (-step));
+
+    return CreateOperation (NODE_ADD, base, CreateNumber (step));
+}
+
+static Node* AppendStatement (Node* list, Node* statement)
+{
+    return list ? CreateSequence (list, statement) : statement;
+}
+
+static void FreshName (LoopContext* ctx, const char* base, const char* suffix, char* name)
+{
+    snprintf (name, MAX_LOOP_NAME_LENGTH, "%s_%s%d", base, suffix, ctx->name_counter);
+}
+
+// i * k   k   t = i * k   , 
+//  ,     i   c * k:    
+static void ReduceMultiplications (LoopContext* ctx, Node** slot, Node* loop,
+                                   const InductionVariable* iv, Node** prelude, Node** updates)
+{
+    Node* node = *slot;
+    if (!node) return;
+
+    if (node->type == NODE_MUL)
+    {
+        Node* factor = IsVariable (node->left, iv->name)  ? node->right :
+                       IsVariable (node->right, iv->name) ? node->left  : NULL;
+
+        //       : i * i  .
+        //   : i * 0.1     t
+        if (factor && !IsVariable (factor, iv->name) &&
+            ExpressionType (node) == NODE_TYPE_INT && ExpressionType (factor) != NODE_TYPE_DOUBLE &&
+            ((factor->type == NODE_NUMBER && factor->data.number_value == floor (factor->data.number_value)) ||
+             (factor->type == NODE_VARIABLE && !Assigns (loop->right, factor->data.string_value))))
+        {
+            ctx->name_counter++;
+            NodeType type = ExpressionType (node);
+
+            char product[MAX_LOOP_NAME_LENGTH] = "";
+            FreshName (ctx, iv->name, "sr", product);
+            *prelude = AppendStatement (*prelude, CreateVarDeclaration (type, product, CopyTree (node)));
+
+            Node* update = NULL;
+            if (factor->type == NODE_NUMBER)
+                update = CreateStep (CreateVariable (product), iv->step * factor->data.number_value);
+            else
+            {
+                char delta[MAX_LOOP_NAME_LENGTH] = "";
+                FreshName (ctx, iv->name, "srd", delta);
+
+                Node* step = CreateOperation (NODE_MUL, CopyTree (factor), CreateNumber (iv->step));
+                *prelude = AppendStatement (*prelude, CreateVarDeclaration (type, delta, step));
+                update = CreateOperation (NODE_ADD, CreateVariable (product), CreateVariable (delta));
+            }
+
+            *updates = AppendStatement (*updates, CreateAssignment (CreateVariable (product), update));
+
+            *slot = CreateVariable (product);
+            FreeTree (node);
+
+            ctx->reduced_multiplications++;
+            return;
+        }
+    }
+
+    ReduceMultiplications (ctx, &node->left, loop, iv, prelude, updates);
+    ReduceMultiplications (ctx, &node->right, loop, iv, prelude, updates);
+}
+
+//  ,   (factor-1) : "i < B - (factor-1)*c" 
+// "i + (factor-1)*c < B",    i.    B,  
+//    int:   
+static int ShiftedBound (Node* loop, const InductionVariable* iv, int factor, double* shifted)
+{
+    Node* condition = loop->left;
+    Node* bound = IsVariable (condition->left, iv->name) ? condition->right : condition->left;
+
+    if (bound->type != NODE_NUMBER || ExpressionType (bound) != NODE_TYPE_INT ||
+        bound->data.number_value != floor (bound->data.number_value))
+        return 0;
+
+    *shifted = bound->data.number_value - iv->step * (factor - 1);
+    return *shifted >= INT_MIN && *shifted <= INT_MAX;
+}
+
+//       factor :  
+// ,          .
+//  ( factor )   .
+static Node* UnrollLoop (LoopContext* ctx, Node* loop, double shifted)
+{
+    Node* condition = CopyTree (loop->left);
+    Node** bound_slot = condition->left->type == NODE_NUMBER ? &condition->left : &condition->right;
+
+    FreeTree (*bound_slot);
+    *bound_slot = CreateNumber (shifted);
+
+    Node* body = NULL;
+    for (int i = 0; i < ctx->unroll_factor; i++)
+        body = AppendStatement (body, CopyTree (loop->right));
+
+    ctx->unrolled_loops++;
+
+    return CreateSequence (CreateOperation (NODE_WHILE, condition, body), loop);
+}
+
+static void OptimizeLoop (LoopContext* ctx, Node** slot)
+{
+    Node* loop = *slot;
+
+    InductionVariable iv = {};
+    if (!MatchInductionVariable (loop, &iv)) return;
+
+    Node* prelude = NULL;
+
+    if (ctx->strength_reduction)
+    {
+        Node* updates = NULL;
+        Node* increment = *iv.increment;
+
+        *iv.increment = NULL;
+        ReduceMultiplications (ctx, &loop->right, loop, &iv, &prelude, &updates);
+        *iv.increment = increment;
+
+        if (updates)
+        {
+            iv.increment = LastStatement (&loop->right);
+            *iv.increment = CreateSequence (updates, *iv.increment);
+        }
+    }
+
+    Node* result = loop;
+    double shifted = 0;
+
+    if (ctx->unroll_factor > 1 && MatchExitTest (loop, &iv) &&
+        ShiftedBound (loop, &iv, ctx->unroll_factor, &shifted) &&
+        CountTreeNodes (loop->right) * ctx->unroll_factor <= LOOP_UNROLL_MAX_SIZE)
+        result = UnrollLoop (ctx, loop, shifted);
+
+    *slot = prelude ? CreateSequence (prelude, result) : result;
+}
+
+static void OptimizeStatement (LoopContext* ctx, Node** slot)
+{
+    Node* node = *slot;
+    if (!node) return;
+
+    switch (node->type)
+    {
+        case NODE_SEQUENCE:
+            OptimizeStatement (ctx, &node->left);
+            OptimizeStatement (ctx, &node->right);
+            return;
+
+        case NODE_FUNC_DECL:
+        case NODE_IF:
+            OptimizeStatement (ctx, &node->right);
+            return;
+
+        case NODE_WHILE:
+            OptimizeStatement (ctx, &node->right);      //  
+            OptimizeLoop (ctx, slot);
+            return;
+
+        default:
+            return;
+    }
+}
+
+void OptimizeLoops (Node** root, LoopContext* ctx)
+{
+    if (!root || !ctx) return;
+
+    if (ctx->unroll_factor < 1)
+        ctx->unroll_factor = 1;
+
+    OptimizeStatement (ctx, root);
+}
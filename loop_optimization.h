@@ -0,0 +1,23 @@
+#ifndef LOOP_OPTIMIZATION_H
+#define LOOP_OPTIMIZATION_H
+
+#include "tree_base.h"
+
+typedef struct
+{
+    int unroll_factor;          // 1 -  
+    int strength_reduction;
+
+    int name_counter;           //    
+    int unrolled_loops;
+    int reduced_multiplications;
+} LoopContext;
+
+const int LOOP_UNROLL_DEFAULT_FACTOR = 4;
+const int LOOP_UNROLL_MAX_SIZE = 240;     //    
+const int MAX_LOOP_NAME_LENGTH = 256;
+
+//   "while (i < B) { ...; i = i + c; }"   i
+void OptimizeLoops (Node** root, LoopContext* ctx);
+
+#endif
@@ -0,0 +1,814 @@
+#include "lsp_server.h"
+#include "json_reader.h"
+#include "pass_trace.h"
+#include "monotonic_clock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// ----  ----
+
+static LspDocument* FindDocument (LspServer* server, const char* uri)
+{
+    for (int i = 0; uri && i < server->document_count; i++)
+        if (strcmp (server->documents[i].uri, uri) == 0)
+            return &server->documents[i];
+
+    return NULL;
+}
+
+static void CloseDocument (LspServer* server, const char* uri)
+{
+    LspDocument* document = FindDocument (server, uri);
+    if (!document) return;
+
+    free (document->uri);
+    DtorIncrementalSource (document->source);
+    *document = server->documents[--server->document_count];
+}
+
+static LspDocument* OpenDocument (LspServer* server, const char* uri, const char* text)
+{
+    CloseDocument (server, uri);
+
+    if (server->document_count >= server->document_capacity)
+    {
+        int new_capacity = server->document_capacity ? server->document_capacity * 2 : 4;
+        LspDocument* new_documents = (LspDocument*) realloc (server->documents, new_capacity * sizeof(LspDocument));
+        if (!new_documents) return NULL;
+        server->documents = new_documents;
+        server->document_capacity = new_capacity;
+    }
+
+    IncrementalSource* source = CtorIncrementalSource (text, server->discard);
+    char* uri_copy = strdup (uri);
+    if (!source || !uri_copy)
+    {
+        DtorIncrementalSource (source);
+        free (uri_copy);
+        return NULL;
+    }
+
+    LspDocument* document = &server->documents[server->document_count++];
+    document->uri = uri_copy;
+    document->source = source;
+    return document;
+}
+
+// ----  ----
+
+static void PrintJsonId (FILE* out, const JsonValue* id)
+{
+    if (id && id->type == JSON_STRING)
+        PrintJsonString (out, id->string);
+    else if (id && id->type == JSON_NUMBER)
+        fprintf (out, "%.17g", id->number);
+    else
+        fprintf (out, "null");
+}
+
+// text  size open_memstream    fclose
+static void SendMessage (LspServer* server, FILE* body, char** text, size_t* size)
+{
+    fclose (body);
+
+    fprintf (server->out, "Content-Length: %zu\r\n\r\n", *size);
+    fwrite (*text, 1, *size, server->out);
+    fflush (server->out);
+
+    free (*text);
+}
+
+//  :    result  SendResult
+static FILE* BeginResult (const JsonValue* id, char** text, size_t* size)
+{
+    FILE* body = open_memstream (text, size);
+    if (!body) return NULL;
+
+    fprintf (body, "{\"jsonrpc\":\"2.0\",\"id\":");
+    PrintJsonId (body, id);
+    fprintf (body, ",\"result\":");
+    return body;
+}
+
+static void SendResult (LspServer* server, FILE* body, char** text, size_t* size)
+{
+    fputc ('}', body);
+    SendMessage (server, body, text, size);
+}
+
+static void SendError (LspServer* server, const JsonValue* id, int code, const char* message)
+{
+    char* text = NULL;
+    size_t size = 0;
+    FILE* body = open_memstream (&text, &size);
+    if (!body) return;
+
+    fprintf (body, "{\"jsonrpc\":\"2.0\",\"id\":");
+    PrintJsonId (body, id);
+    fprintf (body, ",\"error\":{\"code\":%d,\"message\":", code);
+    PrintJsonString (body, message);
+    fprintf (body, "}}");
+    SendMessage (server, body, &text, &size);
+}
+
+static void SendNullResult (LspServer* server, const JsonValue* id)
+{
+    char* text = NULL;
+    size_t size = 0;
+    FILE* body = BeginResult (id, &text, &size);
+    if (!body) return;
+
+    fprintf (body, "null");
+    SendResult (server, body, &text, &size);
+}
+
+static void PrintPosition (FILE* out, const IncrementalSource* source, int offset)
+{
+    int line = 0, column = 0;
+    SourcePositionAt (source, offset, &line, &column);
+
+    fprintf (out, "{\"line\":%d,\"character\":%d}", line, column);
+}
+
+static void PrintRange (FILE* out, const IncrementalSource* source, int start, int end)
+{
+    fprintf (out, "{\"start\":");
+    PrintPosition (out, source, start);
+    fprintf (out, ",\"end\":");
+    PrintPosition (out, source, end);
+    fputc ('}', out);
+}
+
+static void PrintTokenRange (FILE* out, const IncrementalSource* source, int unit_index, int token_index)
+{
+    const SourceUnit* unit = &source->units[unit_index];
+    int start = unit->start + unit->length;
+    int end = start;
+
+    if (token_index < unit->token_count && unit->tokens[token_index].type != TOK_EOF)
+    {
+        start = unit->start + unit->tokens[token_index].offset;
+        end = start + unit->tokens[token_index].length;
+    }
+
+    PrintRange (out, source, start, end);
+}
+
+//     ;     -   
+static void PublishDiagnostics (LspServer* server, const LspDocument* document)
+{
+    char* text = NULL;
+    size_t size = 0;
+    FILE* body = open_memstream (&text, &size);
+    if (!body) return;
+
+    fprintf (body, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+    PrintJsonString (body, document->uri);
+    fprintf (body, ",\"diagnostics\":[");
+
+    const IncrementalSource* source = document->source;
+    int printed = 0;
+
+    for (int u = 0; u < source->unit_count; u++)
+    {
+        const ParseDiagnostics* diagnostics = &source->units[u].diagnostics;
+
+        for (int i = 0; i < diagnostics->count; i++)
+        {
+            fprintf (body, "%s{\"range\":", printed++ ? "," : "");
+            PrintTokenRange (body, source, u, diagnostics->items[i].token);
+            fprintf (body, ",\"severity\":1,\"source\":\"lexxer\",\"message\":");
+            PrintJsonString (body, diagnostics->items[i].message);
+            fputc ('}', body);
+        }
+    }
+
+    fprintf (body, "]}}");
+    SendMessage (server, body, &text, &size);
+}
+
+// ----    ----
+
+static int IsTypeToken (MyTokenType type)
+{
+    return type == TOK_TYPE_INT || type == TOK_TYPE_CHAR || type == TOK_TYPE_DOUBLE;
+}
+
+static int SameName (const Token* token, const char* name)
+{
+    return token->type == TOK_IDENTIFIER && strcmp (token->value.identifier, name) == 0;
+}
+
+// ,   name: __ <> <> (...)
+static int FindFunctionUnit (const IncrementalSource* source, const char* name)
+{
+    for (int u = 0; u < source->unit_count; u++)
+    {
+        const SourceUnit* unit = &source->units[u];
+        if (unit->token_count > 2 && unit->tokens[0].type == TOK_DECLARE && SameName (&unit->tokens[2], name))
+            return u;
+    }
+
+    return -1;
+}
+
+static int IsDeclarationAt (const SourceUnit* unit, int index, const char* name)
+{
+    return index > 0 && SameName (&unit->tokens[index], name) && IsTypeToken (unit->tokens[index - 1].type) &&
+           !(index + 1 < unit->token_count && unit->tokens[index + 1].type == TOK_LPAREN);
+}
+
+//  "<> <>"    :  ,   
+static int FindVariableDeclaration (const SourceUnit* unit, int index, const char* name)
+{
+    for (int i = index; i > 0; i--)
+        if (IsDeclarationAt (unit, i, name))
+            return i;
+
+    for (int i = index + 1; i < unit->token_count; i++)
+        if (IsDeclarationAt (unit, i, name))
+            return i;
+
+    return -1;
+}
+
+static int IsCall (const SourceUnit* unit, int index)
+{
+    return index + 1 < unit->token_count && unit->tokens[index + 1].type == TOK_LPAREN;
+}
+
+// ----  ----
+
+static const char* TokenMeaning (MyTokenType type)
+{
+    switch (type)
+    {
+        case TOK_DECLARE:       return " ";
+        case TOK_TYPE_INT:      return " int";
+        case TOK_TYPE_CHAR:     return " char";
+        case TOK_TYPE_DOUBLE:   return " double";
+        case TOK_IF:            return "if";
+        case TOK_WHILE:         return "while";
+        case TOK_RETURN:        return "return";
+        case TOK_PLUS:          return " (+)";
+        case TOK_MINUS:         return " (-)";
+        case TOK_MULTIPLY:      return " (*)";
+        case TOK_DIVIDE:        return " (/)";
+        case TOK_EQ:            return " (==)";
+        case TOK_NE:            return "  (!=)";
+        case TOK_GT:            return " (>)";
+        case TOK_LT:            return " (<)";
+        case TOK_ASSIGN:        return " (=)";
+        default:                return NULL;
+    }
+}
+
+static const char* CTypeName (MyTokenType type)
+{
+    switch (type)
+    {
+        case TOK_TYPE_INT:      return "int";
+        case TOK_TYPE_CHAR:     return "char";
+        case TOK_TYPE_DOUBLE:   return "double";
+        default:                return "?";
+    }
+}
+
+static void AppendHover (char* hover, int* used, const char* text, int length)
+{
+    int room = MAX_HOVER_SIZE - 1 - *used;
+    if (length > room) length = room;
+    if (length <= 0) return;
+
+    memcpy (hover + *used, text, length);
+    *used += length;
+    hover[*used] = '\0';
+}
+
+//        C: " f ( a)\nint f (int a)"
+static void FunctionSignature (const SourceUnit* unit, char* hover, int* used, int as_c)
+{
+    for (int k = 1; k < unit->token_count; k++)
+    {
+        const Token* token = &unit->tokens[k];
+        MyTokenType previous = unit->tokens[k - 1].type;
+
+        if (k > 1 && token->type != TOK_COMMA && token->type != TOK_RPAREN && previous != TOK_LPAREN)
+            AppendHover (hover, used, " ", 1);
+
+        if (as_c && IsTypeToken (token->type))
+        {
+            const char* name = CTypeName (token->type);
+            AppendHover (hover, used, name, (int) strlen (name));
+        }
+        else
+            AppendHover (hover, used, unit->text + token->offset, token->length);
+
+        if (token->type == TOK_RPAREN) break;
+    }
+}
+
+// 0 -  
+static int MakeHover (const IncrementalSource* source, int unit_index, int token_index, char* hover)
+{
+    const SourceUnit* unit = &source->units[unit_index];
+    const Token* token = &unit->tokens[token_index];
+    int used = 0;
+    hover[0] = '\0';
+
+    if (token->type == TOK_NUMBER)
+    {
+        snprintf (hover, MAX_HOVER_SIZE, " %g", token->value.number);
+        return 1;
+    }
+
+    if (token->type != TOK_IDENTIFIER)
+    {
+        const char* meaning = TokenMeaning (token->type);
+        if (!meaning) return 0;
+
+        AppendHover (hover, &used, unit->text + token->offset, token->length);
+        AppendHover (hover, &used, ": ", 2);
+        AppendHover (hover, &used, meaning, (int) strlen (meaning));
+        return 1;
+    }
+
+    const char* name = token->value.identifier;
+
+    if (IsCall (unit, token_index))
+    {
+        int function = FindFunctionUnit (source, name);
+        if (function < 0)
+        {
+            snprintf (hover, MAX_HOVER_SIZE, " %s  ", name);
+            return 1;
+        }
+
+        AppendHover (hover, &used, " ", 8);
+        FunctionSignature (&source->units[function], hover, &used, 0);
+        AppendHover (hover, &used, "\n", 1);
+        FunctionSignature (&source->units[function], hover, &used, 1);
+        return 1;
+    }
+
+    int declaration = FindVariableDeclaration (unit, token_index, name);
+    if (declaration < 0)
+    {
+        snprintf (hover, MAX_HOVER_SIZE, " %s  ", name);
+        return 1;
+    }
+
+    //    ,   '{' 
+    int is_parameter = unit->tokens[0].type == TOK_DECLARE;
+    for (int i = 0; i < declaration && is_parameter; i++)
+        if (unit->tokens[i].type == TOK_LBRACE)
+            is_parameter = 0;
+
+    const Token* type = &unit->tokens[declaration - 1];
+    snprintf (hover, MAX_HOVER_SIZE, "%s %s: %.*s (%s)", is_parameter ? "" : "", name,
+              type->length, unit->text + type->offset, CTypeName (type->type));
+    return 1;
+}
+
+// ----  ----
+
+static const LspDocument* DocumentAt (LspServer* server, const JsonValue* params, int* offset)
+{
+    const JsonValue* document = JsonMember (params, "textDocument");
+    const JsonValue* position = JsonMember (params, "position");
+
+    LspDocument* found = FindDocument (server, JsonString (JsonMember (document, "uri")));
+    if (!found || !position) return NULL;
+
+    *offset = SourceOffsetAt (found->source, (int) JsonNumber (JsonMember (position, "line"), 0),
+                              (int) JsonNumber (JsonMember (position, "character"), 0));
+    return found;
+}
+
+static void HandleInitialize (LspServer* server, const JsonValue* id)
+{
+    char* text = NULL;
+    size_t size = 0;
+    FILE* body = BeginResult (id, &text, &size);
+    if (!body) return;
+
+    // textDocumentSync 2 -   ,    ApplySourceEdit
+    fprintf (body, "{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2},"
+                   "\"definitionProvider\":true,\"hoverProvider\":true},"
+                   "\"serverInfo\":{\"name\":\"lexxer\"}}");
+    SendResult (server, body, &text, &size);
+}
+
+static void HandleDidOpen (LspServer* server, const JsonValue* params)
+{
+    const JsonValue* document = JsonMember (params, "textDocument");
+    const char* uri = JsonString (JsonMember (document, "uri"));
+    const char* text = JsonString (JsonMember (document, "text"));
+    if (!uri || !text) return;
+
+    LspDocument* opened = OpenDocument (server, uri, text);
+    if (opened) PublishDiagnostics (server, opened);
+}
+
+static void HandleDidChange (LspServer* server, const JsonValue* params)
+{
+    const char* uri = JsonString (JsonMember (JsonMember (params, "textDocument"), "uri"));
+    const JsonValue* changes = JsonMember (params, "contentChanges");
+    LspDocument* document = FindDocument (server, uri);
+    if (!document || !changes || changes->type != JSON_ARRAY) return;
+
+    for (int i = 0; i < changes->count && document; i++)
+    {
+        const JsonValue* change = &changes->items[i];
+        const JsonValue* range = JsonMember (change, "range");
+        const JsonValue* text = JsonMember (change, "text");
+        if (!text || text->type != JSON_STRING) continue;
+
+        //  range -   
+        if (!range)
+        {
+            document = OpenDocument (server, uri, text->string);
+            continue;
+        }
+
+        const JsonValue* start = JsonMember (range, "start");
+        const JsonValue* end = JsonMember (range, "end");
+        int from = SourceOffsetAt (document->source, (int) JsonNumber (JsonMember (start, "line"), 0),
+                                   (int) JsonNumber (JsonMember (start, "character"), 0));
+        int to = SourceOffsetAt (document->source, (int) JsonNumber (JsonMember (end, "line"), 0),
+                                 (int) JsonNumber (JsonMember (end, "character"), 0));
+        if (to < from) to = from;
+
+        if (!ApplySourceEdit (document->source, from, to - from, text->string, text->length))
+        {
+            //     :   ,  
+            char* whole = IncrementalSourceText (document->source);
+            document = whole ? OpenDocument (server, uri, whole) : NULL;
+            free (whole);
+        }
+    }
+
+    if (document) PublishDiagnostics (server, document);
+}
+
+static void HandleDefinition (LspServer* server, const JsonValue* id, const JsonValue* params)
+{
+    int offset = 0, unit_index = 0, token_index = 0;
+    const LspDocument* document = DocumentAt (server, params, &offset);
+    const Token* token = document ? SourceTokenAt (document->source, offset, &unit_index, &token_index) : NULL;
+
+    if (!token || token->type != TOK_IDENTIFIER)
+    {
+        SendNullResult (server, id);
+        return;
+    }
+
+    const IncrementalSource* source = document->source;
+    const SourceUnit* unit = &source->units[unit_index];
+    int target_unit = unit_index;
+    int target_token = -1;
+
+    if (IsCall (unit, token_index))
+    {
+        target_unit = FindFunctionUnit (source, token->value.identifier);
+        target_token = 2;
+    }
+    else
+        target_token = FindVariableDeclaration (unit, token_index, token->value.identifier);
+
+    if (target_unit < 0 || target_token < 0)
+    {
+        SendNullResult (server, id);
+        return;
+    }
+
+    char* text = NULL;
+    size_t size = 0;
+    FILE* body = BeginResult (id, &text, &size);
+    if (!body) return;
+
+    fprintf (body, "{\"uri\":");
+    PrintJsonString (body, document->uri);
+    fprintf (body, ",\"range\":");
+    PrintTokenRange (body, source, target_unit, target_token);
+    fputc ('}', body);
+    SendResult (server, body, &text, &size);
+}
+
+static void HandleHover (LspServer* server, const JsonValue* id, const JsonValue* params)
+{
+    int offset = 0, unit_index = 0, token_index = 0;
+    const LspDocument* document = DocumentAt (server, params, &offset);
+    const Token* token = document ? SourceTokenAt (document->source, offset, &unit_index, &token_index) : NULL;
+
+    char hover[MAX_HOVER_SIZE] = "";
+    if (!token || !MakeHover (document->source, unit_index, token_index, hover))
+    {
+        SendNullResult (server, id);
+        return;
+    }
+
+    char* text = NULL;
+    size_t size = 0;
+    FILE* body = BeginResult (id, &text, &size);
+    if (!body) return;
+
+    fprintf (body, "{\"contents\":{\"kind\":\"plaintext\",\"value\":");
+    PrintJsonString (body, hover);
+    fprintf (body, "},\"range\":");
+    PrintTokenRange (body, document->source, unit_index, token_index);
+    fputc ('}', body);
+    SendResult (server, body, &text, &size);
+}
+
+LspServer* CtorLspServer (FILE* out)
+{
+    LspServer* server = (LspServer*) calloc (1, sizeof(LspServer));
+    if (!server) return NULL;
+
+    server->out = out;
+    server->discard = fopen ("/dev/null", "w");
+    if (!server->discard)
+    {
+        free (server);
+        return NULL;
+    }
+
+    return server;
+}
+
+void DtorLspServer (LspServer* server)
+{
+    if (!server) return;
+
+    for (int i = 0; i < server->document_count; i++)
+    {
+        free (server->documents[i].uri);
+        DtorIncrementalSource (server->documents[i].source);
+    }
+
+    free (server->documents);
+    fclose (server->discard);
+    free (server);
+}
+
+int HandleLspMessage (LspServer* server, const char* body, int length)
+{
+    JsonValue* message = ParseJson (body, length);
+    server->method[0] = '\0';
+
+    if (!message)
+    {
+        SendError (server, NULL, -32700, "Parse error");
+        return 0;
+    }
+
+    const char* method = JsonString (JsonMember (message, "method"));
+    const JsonValue* id = JsonMember (message, "id");
+    const JsonValue* params = JsonMember (message, "params");
+
+    //     :     
+    if (!method)
+    {
+        FreeJson (message);
+        return 1;
+    }
+
+    snprintf (server->method, sizeof(server->method), "%s", method);
+
+    if (strcmp (method, "exit") == 0)
+        server->exit = 1;
+    else if (server->shutdown)
+    {
+        if (id) SendError (server, id, -32600, "Server is shutting down");
+    }
+    else if (strcmp (method, "initialize") == 0)
+        HandleInitialize (server, id);
+    else if (strcmp (method, "shutdown") == 0)
+    {
+        server->shutdown = 1;
+        SendNullResult (server, id);
+    }
+    else if (strcmp (method, "textDocument/didOpen") == 0)
+        HandleDidOpen (server, params);
+    else if (strcmp (method, "textDocument/didChange") == 0)
+        HandleDidChange (server, params);
+    else if (strcmp (method, "textDocument/didClose") == 0)
+        CloseDocument (server, JsonString (JsonMember (JsonMember (params, "textDocument"), "uri")));
+    else if (strcmp (method, "textDocument/definition") == 0)
+        HandleDefinition (server, id, params);
+    else if (strcmp (method, "textDocument/hover") == 0)
+        HandleHover (server, id, params);
+    else if (id)
+        SendError (server, id, -32601, "Method not found");
+
+    //   initialized  $/cancelRequest  
+    FreeJson (message);
+    return 1;
+}
+
+// ---- stdin/stdout ----
+
+//   ,  free; NULL -  
+static char* ReadLspMessage (FILE* in, int* length)
+{
+    char header[MAX_LSP_HEADER] = "";
+    long content_length = -1;
+
+    while (fgets (header, sizeof(header), in))
+    {
+        if (strcmp (header, "\r\n") == 0 || strcmp (header, "\n") == 0)
+        {
+            if (content_length < 0) continue;
+
+            char* body = (char*) malloc (content_length + 1);
+            if (!body) return NULL;
+
+            if (fread (body, 1, content_length, in) != (size_t) content_length)
+            {
+                free (body);
+                return NULL;
+            }
+
+            body[content_length] = '\0';
+            *length = (int) content_length;
+            return body;
+        }
+
+        if (strncasecmp (header, "Content-Length:", 15) == 0)
+            content_length = atol (header + 15);
+    }
+
+    return NULL;
+}
+
+int RunLanguageServer (const char* record_file)
+{
+    LspServer* server = CtorLspServer (stdout);
+    if (!server)
+    {
+        fprintf (stderr, "    \n");
+        return 1;
+    }
+
+    FILE* record = record_file ? fopen (record_file, "w") : NULL;
+    if (record_file && !record)
+        fprintf (stderr, "   %s   \n", record_file);
+
+    char* body = NULL;
+    int length = 0;
+
+    while (!server->exit && (body = ReadLspMessage (stdin, &length)))
+    {
+        //  -    :    JSON   -  
+        if (record)
+        {
+            for (int i = 0; i < length; i++)
+                fputc (body[i] == '\n' || body[i] == '\r' ? ' ' : body[i], record);
+            fputc ('\n', record);
+        }
+
+        HandleLspMessage (server, body, length);
+        free (body);
+    }
+
+    int code = server->exit && server->shutdown ? 0 : 1;
+
+    if (record) fclose (record);
+    DtorLspServer (server);
+    return code;
+}
+
+// ----    ----
+
+typedef struct
+{
+    char name[64];
+    double* times;
+    int count;
+    int capacity;
+} LspMethodTimes;
+
+static int CompareTimes (const void* first, const void* second)
+{
+    double a = *(const double*) first;
+    double b = *(const double*) second;
+
+    return (a > b) - (a < b);
+}
+
+static double TimePercentile (const double* sorted, int count, double fraction)
+{
+    int rank = (int) (fraction * count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+
+    return sorted[rank - 1];
+}
+
+static int AddMethodTime (LspMethodTimes** methods, int* method_count, const char* name, double ms)
+{
+    LspMethodTimes* method = NULL;
+    for (int i = 0; i < *method_count && !method; i++)
+        if (strcmp ((*methods)[i].name, name) == 0)
+            method = &(*methods)[i];
+
+    if (!method)
+    {
+        LspMethodTimes* new_methods = (LspMethodTimes*) realloc (*methods, (*method_count + 1) * sizeof(LspMethodTimes));
+        if (!new_methods) return 0;
+        *methods = new_methods;
+
+        method = &new_methods[(*method_count)++];
+        memset (method, 0, sizeof(LspMethodTimes));
+        snprintf (method->name, sizeof(method->name), "%s", name);
+    }
+
+    if (method->count >= method->capacity)
+    {
+        int new_capacity = method->capacity ? method->capacity * 2 : 64;
+        double* new_times = (double*) realloc (method->times, new_capacity * sizeof(double));
+        if (!new_times) return 0;
+        method->times = new_times;
+        method->capacity = new_capacity;
+    }
+
+    method->times[method->count++] = ms;
+    return 1;
+}
+
+int RunLspReplay (const char* filename)
+{
+    FILE* session = fopen (filename, "r");
+    if (!session)
+    {
+        printf ("     %s\n", filename);
+        return 1;
+    }
+
+    FILE* sink = fopen ("/dev/null", "w");
+    LspServer* server = sink ? CtorLspServer (sink) : NULL;
+    if (!server)
+    {
+        printf ("    \n");
+        if (sink) fclose (sink);
+        fclose (session);
+        return 1;
+    }
+
+    LspMethodTimes* methods = NULL;
+    int method_count = 0;
+    int message_count = 0;
+    int over_budget = 0;
+    int budgeted = 0;
+
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length = 0;
+
+    while ((length = getline (&line, &line_capacity, session)) > 0)
+    {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+            line[--length] = '\0';
+        if (length == 0) continue;
+
+        double start = NowMs ();
+        HandleLspMessage (server, line, (int) length);
+        double ms = NowMs () - start;
+
+        message_count++;
+        AddMethodTime (&methods, &method_count, server->method[0] ? server->method : "(  )", ms);
+
+        if (strcmp (server->method, "textDocument/didOpen") == 0) continue;
+        budgeted++;
+        if (ms > LSP_LATENCY_BUDGET_MS) over_budget++;
+    }
+
+    printf (" %s: %d \n", filename, message_count);
+    printf ("%-32s %8s %10s %10s %10s %10s\n", "", "", "., ", "p50, ", "p95, ", "., ");
+
+    for (int i = 0; i < method_count; i++)
+    {
+        LspMethodTimes* method = &methods[i];
+        qsort (method->times, method->count, sizeof(double), CompareTimes);
+
+        double total = 0;
+        for (int k = 0; k < method->count; k++)
+            total += method->times[k];
+
+        printf ("%-32s %8d %10.3f %10.3f %10.3f %10.3f\n", method->name, method->count, total / method->count,
+                TimePercentile (method->times, method->count, 0.50),
+                TimePercentile (method->times, method->count, 0.95), method->times[method->count - 1]);
+        free (method->times);
+    }
+
+    printf (" %.0f : %d  %d (didOpen  )\n", LSP_LATENCY_BUDGET_MS, over_budget, budgeted);
+
+    free (methods);
+    free (line);
+    fclose (session);
+    DtorLspServer (server);
+    fclose (sink);
+    return over_budget;
+}
@@ -0,0 +1,50 @@
+#ifndef LSP_SERVER_H
+#define LSP_SERVER_H
+
+#include "incremental_parse.h"
+#include <stdio.h>
+
+//   (LSP)  stdin/stdout:  ,  
+//     .     
+// IncrementalSource, didChange   ApplySourceEdit,   
+//       -       .
+//  LSP   :   cp1251,  -  .
+typedef struct
+{
+    char* uri;
+    IncrementalSource* source;
+} LspDocument;
+
+typedef struct
+{
+    LspDocument* documents;
+    int document_count;
+    int document_capacity;
+
+    FILE* out;                  //   ,   Content-Length
+    FILE* discard;              //    :    
+    char method[64];            //   ,  
+    int shutdown;
+    int exit;
+} LspServer;
+
+const int MAX_LSP_HEADER = 256;
+const int MAX_HOVER_SIZE = 1024;
+const double LSP_LATENCY_BUDGET_MS = 10;
+
+LspServer* CtorLspServer (FILE* out);
+void DtorLspServer (LspServer* server);
+
+//   JSON-RPC  . 0 -   JSON
+int HandleLspMessage (LspServer* server, const char* body, int length);
+
+//  stdin  exit. record_file != NULL -   
+//       --lsp-replay.    LSP: 0,   shutdown
+int RunLanguageServer (const char* record_file);
+
+//     :    /dev/null,  
+//     .    
+// LSP_LATENCY_BUDGET_MS,   didOpen -    
+int RunLspReplay (const char* filename);
+
+#endif
@@ -1,121 +1,196 @@
-#include "lexical_analysis.h"
-#include "tree_base.h"
-#include "syntactic_analysis.h"
-#include "create_AST_dump.h"
-#include "create_tree_AST.h"
-#include "read_AST_tree.h"
-#include "create_asm_code_from_tree.h"
+#include "compile_cache.h"
+#include "compile_server.h"
+#include "batch_driver.h"
+#include "compile_pipeline.h"
+#include "compiler_context.h"
+#include "incremental_parse.h"
+#include "lsp_server.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 int main (int argc, char* argv[])
 {
-    char* test_program = NULL;
-    char* Lisp_code = NULL;
-    if (argc  > 1)
+    char* filename = NULL;
+    CompileOptions options = {};
+    InitCompileOptions (&options);
+    int serve = 0;
+    const char* socket_path = NULL;
+    int batch = 0;
+    int jobs = 0;
+    const char* manifest = NULL;
+    int stress = 0;
+    int incremental = 0;
+    int lsp = 0;
+    const char* lsp_record = NULL;
+    const char* lsp_replay = NULL;
+    const char** inputs = (const char**) calloc (argc, sizeof(const char*));
+    int input_count = 0;
+
+    for (int i = 1; i < argc; i++)
     {
-        char* filename = argv[1];
-        printf ("Loading tree from file: %s\n", filename);
-
-        test_program = ReadFile (filename);
-        if (!test_program) printf ("ERORR: in ReadFile\n");
-
-        printf (" :\n");
-        printf ("-------------------------------------------------\n");
-        printf ("%s\n", test_program);
-        printf ("-------------------------------------------------\n\n");
-    }
-    else
-    {
-        printf ("No input file specified. Creating default tree...\n");
-        return 0;
+        if (argv[i][0] == '-' && argv[i][1] == 'O' && argv[i][2] >= '0' && argv[i][2] <= '9' && argv[i][3] == '\0')
+            options.opt_level = argv[i][2] - '0';
+        else if (strcmp (argv[i], "--dump-ir") == 0)
+            options.dump_ir = 1;
+        else if (strcmp (argv[i], "--native") == 0)
+            options.native = 1;
+        else if (strcmp (argv[i], "--run") == 0)
+            options.run = 1;
+        else if (strcmp (argv[i], "--eval") == 0)
+            options.eval = 1;
+        else if (strcmp (argv[i], "--time-passes") == 0)
+            options.time_passes = 1;
+        else if (strcmp (argv[i], "--time-passes=json") == 0)
+            options.time_passes = 2;
+        else if (strncmp (argv[i], "--trace=", 8) == 0)
+            options.trace_file = argv[i] + 8;
+        else if (strcmp (argv[i], "--mem-report") == 0)
+            options.mem_report = 1;
+        else if (strncmp (argv[i], "--dot-depth=", 12) == 0)
+        {
+            options.dump_detail.max_depth = atoi (argv[i] + 12);
+            options.detail_dump = 1;
+        }
+        else if (strncmp (argv[i], "--dot-nodes=", 12) == 0)
+        {
+            options.dump_detail.max_nodes = atoi (argv[i] + 12);
+            options.detail_dump = 1;
+        }
+        else if (strncmp (argv[i], "--dot-chain=", 12) == 0)
+        {
+            options.dump_detail.max_chain = atoi (argv[i] + 12);
+            options.detail_dump = 1;
+        }
+        else if (strcmp (argv[i], "--ast-json") == 0)
+            options.json_file = "ast_tree.json";
+        else if (strncmp (argv[i], "--ast-json=", 11) == 0)
+            options.json_file = argv[i] + 11;
+        else if (strcmp (argv[i], "--object") == 0)
+            options.object = 1;
+        else if (strcmp (argv[i], "--disasm") == 0)
+            options.object = options.disasm = 1;
+        else if (strncmp (argv[i], "--unroll=", 9) == 0)
+            options.unroll_factor = atoi (argv[i] + 9);
+        else if (strcmp (argv[i], "--cache") == 0)
+            options.cache_dir = COMPILE_CACHE_DEFAULT_DIR;
+        else if (strncmp (argv[i], "--cache=", 8) == 0)
+            options.cache_dir = argv[i] + 8;
+        else if (strcmp (argv[i], "--serve") == 0)
+            serve = 1;
+        else if (strncmp (argv[i], "--serve=", 8) == 0)
+            serve = 1, socket_path = argv[i] + 8;
+        else if (strcmp (argv[i], "--batch") == 0)
+            batch = 1;
+        else if (strncmp (argv[i], "--manifest=", 11) == 0)
+            batch = 1, manifest = argv[i] + 11;
+        else if (strncmp (argv[i], "--jobs=", 7) == 0)
+            jobs = atoi (argv[i] + 7);
+        else if (strcmp (argv[i], "--stress") == 0)
+            stress = STRESS_DEFAULT_COUNT;
+        else if (strncmp (argv[i], "--stress=", 9) == 0)
+            stress = atoi (argv[i] + 9);
+        else if (strcmp (argv[i], "--incremental") == 0)
+            incremental = INCREMENTAL_DEFAULT_EDITS;
+        else if (strncmp (argv[i], "--incremental=", 14) == 0)
+            incremental = atoi (argv[i] + 14);
+        else if (strcmp (argv[i], "--lsp") == 0)
+            lsp = 1;
+        else if (strncmp (argv[i], "--lsp-record=", 13) == 0)
+            lsp = 1, lsp_record = argv[i] + 13;
+        else if (strncmp (argv[i], "--lsp-replay=", 13) == 0)
+            lsp_replay = argv[i] + 13;
+        else if (strncmp (argv[i], "--emit=", 7) == 0)
+        {
+            options.stages = ParseStages (argv[i] + 7);
+            if (options.stages < 0)
+            {
+                printf ("   %s\n", argv[i]);
+                free (inputs);
+                return 1;
+            }
+        }
+        else if (strncmp (argv[i], "--cache-size=", 13) == 0)
+            options.cache_limit = atoll (argv[i] + 13) << 10;     //  
+        else
+        {
+            if (!filename) filename = argv[i];
+            if (inputs) inputs[input_count++] = argv[i];
+        }
     }
 
-    Lexer* lexer = CtorLexer (test_program);
-    if (lexer && LexerScanTokens (lexer))
+    //     ,    argv
+    if (serve)
     {
-        LexerPrintTokens (lexer);
+        CompileCache* cache = options.cache_dir ? OpenCompileCache (options.cache_dir, options.cache_limit) : NULL;
+        int served = RunCompileServer (socket_path, cache);
+        CloseCompileCache (cache, socket_path ? stdout : stderr);
+        free (inputs);
+        return served ? 0 : 1;
     }
 
-    Getter* Getter = CtorGetter (lexer);
-    if (!Getter)
+    //  : stdout  ,    
+    if (lsp)
     {
-        printf ("  \n");
-        DtorLexer (lexer);
-        return 1;
+        free (inputs);
+        return RunLanguageServer (lsp_record);
     }
 
-    Node* Ast_root = GetProgram (Getter);
-
-    if (Getter->error_count > 0)
+    if (lsp_replay)
     {
-        printf("\n   %d \n", Getter->error_count);
+        free (inputs);
+        return RunLspReplay (lsp_replay) ? 1 : 0;
     }
-    else if (Ast_root)
-    {
-        printf("\n===    ===\n");
-        PrintTree(Ast_root, 0);
 
-        CreateGraphvizDump (Ast_root, "ast_graph.dot");
-    }
-    else
+    // :    ,   ,    
+    if (batch)
     {
-        printf ("\n  NULL  \n");
+        int manifest_count = 0;
+        char** manifest_paths = manifest ? ReadManifest (manifest, &manifest_count) : NULL;
+
+        const char** all_inputs = (const char**) calloc (input_count + manifest_count + 1, sizeof(const char*));
+        int all_count = 0;
+        for (int i = 0; all_inputs && i < input_count; i++)
+            all_inputs[all_count++] = inputs[i];
+        for (int i = 0; all_inputs && i < manifest_count; i++)
+            all_inputs[all_count++] = manifest_paths[i];
+
+        int failed = RunBatchCompile (all_inputs, all_count, jobs, options.opt_level,
+                                      options.cache_dir, options.cache_limit);
+
+        free (all_inputs);
+        FreeManifest (manifest_paths, manifest_count);
+        free (inputs);
+        return failed ? 1 : 0;
     }
 
-    if (Ast_root)
+    free (inputs);
+
+    if (!filename)
     {
-        DumpAST (Ast_root, stdout);
-        FILE* Dump = fopen ("ast_tree.txt", "w");
-        if (Dump)
-        {
-            DumpAST (Ast_root, Dump);
-            fclose (Dump);
-        }
-        else
-            printf ("\n ast_tree.txt  \n");
+        printf ("No input file specified. Creating default tree...\n");
+        return 0;
     }
 
-    printf ("Parsing LISP Ast_tree_after_reading...\n");
+    if (stress)
+        return RunStressCompile (filename, stress, &options) ? 1 : 0;
 
-    Lisp_code = ReadFile ("ast_tree.txt");
-    Node* Ast_tree_after_reading = ParseLispAST (Lisp_code);
+    if (incremental)
+        return RunIncrementalCheck (filename, incremental) ? 1 : 0;
 
-    if (Ast_tree_after_reading)
-    {
-        printf ("\nAST Structure after reading:\n");
-        PrintTree (Ast_tree_after_reading, 0);
-    } else
-        printf("Parsing failed\n");
-
-    FILE* Asm_code = fopen ("asm_code_gen.asm", "w");
-    CodeGenContext* codegen = CtorCodeGen (Asm_code);
-    if (codegen && Ast_root)
+    //     ,   stdout,  
+    CompilerContext* ctx = CtorCompilerContext ("", stdout, stderr);
+    if (!ctx)
     {
-        int has_function = 0;
-        Node* current = Ast_root;
-
-        if (Ast_root->type == NODE_FUNC_DECL)
-        {
-            has_function = 1;
-            fprintf (Asm_code, ";   \n");
-            fprintf (Asm_code, "CALL :func_0\n");
-            fprintf (Asm_code, "OUT\n");
-            fprintf (Asm_code, "HLT\n");
-        }
-        GenerateCode (codegen, Ast_root);
-
-        if (!has_function)
-            fprintf (Asm_code, "HLT\n");
+        printf ("   \n");
+        return 1;
     }
 
-    DtorCodeGen (codegen);
-    FreeTree (Ast_tree_after_reading);
-    FreeTree (Ast_root);
-    CloseHtmlFile ();
-    DtorGetter (Getter);
-    DtorLexer (lexer);
-    printf ("\n \n");
+    ctx->options = options;
+    RunCompilation (ctx, filename);
+    DtorCompilerContext (ctx);
+
+    return 0;
 }
 
 /*
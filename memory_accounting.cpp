@@ -0,0 +1,196 @@
+#include "memory_accounting.h"
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+static void* SystemAllocate (void* state, size_t size)
+{
+    (void) state;
+    return calloc (1, size);
+}
+
+static void* SystemReallocate (void* state, void* block, size_t size)
+{
+    (void) state;
+    return realloc (block, size);
+}
+
+static void SystemRelease (void* state, void* block)
+{
+    (void) state;
+    free (block);
+}
+
+static size_t SystemBlockSize (void* state, const void* block)
+{
+    (void) state;
+    return malloc_usable_size ((void*) block);
+}
+
+const Allocator system_allocator = {SystemAllocate, SystemReallocate, SystemRelease, SystemBlockSize, NULL};
+const Allocator* active_allocator = &system_allocator;
+thread_local MemoryAccounting* memory_accounting = NULL;
+
+static const char* kind_names[MEM_KIND_COUNT] =
+{
+    "", "", " AST", " ", "", "", "Lisp-"
+};
+
+static const char* phase_names[MEM_PHASE_COUNT] =
+{
+    "", "", "", "", "", "", ""
+};
+
+static void CountAllocation (MemoryUsage* usage, long long bytes)
+{
+    usage->allocations++;
+    usage->allocated_bytes += bytes;
+    usage->live_bytes += bytes;
+
+    if (usage->live_bytes > usage->peak_bytes) usage->peak_bytes = usage->live_bytes;
+}
+
+static void CountFree (MemoryUsage* usage, long long bytes)
+{
+    usage->frees++;
+    usage->freed_bytes += bytes;
+    usage->live_bytes -= bytes;
+}
+
+static void RecordAllocation (MemoryKind kind, long long bytes)
+{
+    MemoryAccounting* accounting = memory_accounting;
+
+    CountAllocation (&accounting->kinds[kind], bytes);
+    CountAllocation (&accounting->total, bytes);
+    CountAllocation (&accounting->phases[accounting->phase], bytes);
+
+    //      ,     
+    MemoryUsage* phase = &accounting->phases[accounting->phase];
+    if (accounting->total.live_bytes > phase->peak_bytes)
+        phase->peak_bytes = accounting->total.live_bytes;
+}
+
+static void RecordFree (MemoryKind kind, long long bytes)
+{
+    MemoryAccounting* accounting = memory_accounting;
+
+    CountFree (&accounting->kinds[kind], bytes);
+    CountFree (&accounting->total, bytes);
+    CountFree (&accounting->phases[accounting->phase], bytes);
+}
+
+void* MemAlloc (MemoryKind kind, size_t count, size_t size)
+{
+    if (size && count > (size_t) -1 / size) return NULL;
+
+    void* block = active_allocator->allocate (active_allocator->state, count * size);
+
+    if (block && memory_accounting)
+        RecordAllocation (kind, (long long) active_allocator->block_size (active_allocator->state, block));
+
+    return block;
+}
+
+//          
+void* MemRealloc (MemoryKind kind, void* block, size_t size)
+{
+    long long old_size = block && memory_accounting ?
+                         (long long) active_allocator->block_size (active_allocator->state, block) : 0;
+
+    void* new_block = active_allocator->reallocate (active_allocator->state, block, size);
+    if (!new_block || !memory_accounting) return new_block;
+
+    if (block)
+        RecordFree (kind, old_size);
+    RecordAllocation (kind, (long long) active_allocator->block_size (active_allocator->state, new_block));
+
+    return new_block;
+}
+
+char* MemStrdup (MemoryKind kind, const char* text)
+{
+    if (!text) return NULL;
+
+    size_t length = strlen (text);
+    char* copy = (char*) MemAlloc (kind, length + 1, 1);
+    if (copy) memcpy (copy, text, length + 1);
+
+    return copy;
+}
+
+void MemFree (MemoryKind kind, void* block)
+{
+    if (!block) return;
+
+    if (memory_accounting)
+        RecordFree (kind, (long long) active_allocator->block_size (active_allocator->state, block));
+
+    active_allocator->release (active_allocator->state, block);
+}
+
+MemoryAccounting* CtorMemoryAccounting ()
+{
+    return (MemoryAccounting*) calloc (1, sizeof(MemoryAccounting));
+}
+
+void DtorMemoryAccounting (MemoryAccounting* accounting)
+{
+    if (memory_accounting == accounting)
+        memory_accounting = NULL;
+
+    free (accounting);
+}
+
+void SetMemoryPhase (MemoryPhase phase)
+{
+    if (memory_accounting)
+        memory_accounting->phase = phase;
+}
+
+static void PrintUsage (FILE* out, const char* name, const MemoryUsage* usage)
+{
+    fprintf (out, "%-18s %10lld %10lld %11.1f %11.1f %11.1f\n", name, usage->allocations, usage->frees,
+             usage->allocated_bytes / 1024.0, usage->live_bytes / 1024.0, usage->peak_bytes / 1024.0);
+}
+
+void PrintMemoryReport (const MemoryAccounting* accounting, FILE* out)
+{
+    if (!accounting) return;
+
+    fprintf (out, "\n===    ===\n");
+    fprintf (out, "%-18s %10s %10s %11s %11s %11s\n", "", "", ".",
+             ", ", ", ", ", ");
+    for (int k = 0; k < MEM_KIND_COUNT; k++)
+        PrintUsage (out, kind_names[k], &accounting->kinds[k]);
+    PrintUsage (out, "", &accounting->total);
+
+    //    -        
+    fprintf (out, "\n===    ===\n");
+    fprintf (out, "%-18s %10s %10s %11s %11s %11s\n", "", "", ".",
+             ", ", ", ", ", ");
+    for (int p = 0; p < MEM_PHASE_COUNT; p++)
+        if (accounting->phases[p].allocations || accounting->phases[p].frees)
+            PrintUsage (out, phase_names[p], &accounting->phases[p]);
+}
+
+int ReportMemoryLeaks (const MemoryAccounting* accounting, FILE* out)
+{
+    if (!accounting) return 0;
+
+    int leaks = 0;
+    for (int k = 0; k < MEM_KIND_COUNT; k++)
+    {
+        const MemoryUsage* usage = &accounting->kinds[k];
+        if (usage->allocations == usage->frees && usage->live_bytes == 0) continue;
+
+        fprintf (out, ": %s - %lld , %lld   \n", kind_names[k],
+                 usage->allocations - usage->frees, usage->live_bytes);
+        leaks++;
+    }
+
+    if (!leaks)
+        fprintf (out, " \n");
+
+    return leaks;
+}
@@ -0,0 +1,82 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+//    , ,      
+// active_allocator.    calloc/realloc/free;   
+//         .
+//    :       .
+typedef struct
+{
+    void* (*allocate) (void* state, size_t size);                   //  
+    void* (*reallocate) (void* state, void* block, size_t size);
+    void (*release) (void* state, void* block);
+    size_t (*block_size) (void* state, const void* block);          //     
+    void* state;
+} Allocator;
+
+enum MemoryKind
+{
+    MEM_TOKENS,         //   
+    MEM_IDENTIFIERS,    //    
+    MEM_NODES,          //  AST
+    MEM_NODE_NAMES,     //   
+    MEM_VARIABLES,      //       
+    MEM_FUNCTIONS,      //       
+    MEM_LISP,           //   ParseLispAST
+    MEM_KIND_COUNT
+};
+
+enum MemoryPhase
+{
+    MEM_PHASE_OTHER,
+    MEM_PHASE_LEXING,
+    MEM_PHASE_PARSING,
+    MEM_PHASE_OPTIMIZATION,
+    MEM_PHASE_SERIALIZATION,
+    MEM_PHASE_CODEGEN,
+    MEM_PHASE_SHUTDOWN,
+    MEM_PHASE_COUNT
+};
+
+typedef struct
+{
+    long long allocations;
+    long long frees;
+    long long allocated_bytes;  //  ,     realloc
+    long long freed_bytes;
+    long long live_bytes;
+    long long peak_bytes;       //   -   ,   
+} MemoryUsage;
+
+//     :  memory_accounting == NULL,
+//    .     :
+// CompilerContext     ,   .
+typedef struct
+{
+    MemoryUsage kinds[MEM_KIND_COUNT];
+    MemoryUsage phases[MEM_PHASE_COUNT];
+    MemoryUsage total;
+    MemoryPhase phase;
+} MemoryAccounting;
+
+extern const Allocator system_allocator;
+extern const Allocator* active_allocator;
+extern thread_local MemoryAccounting* memory_accounting;
+
+void* MemAlloc (MemoryKind kind, size_t count, size_t size);
+void* MemRealloc (MemoryKind kind, void* block, size_t size);
+char* MemStrdup (MemoryKind kind, const char* text);
+void MemFree (MemoryKind kind, void* block);
+
+MemoryAccounting* CtorMemoryAccounting ();
+void DtorMemoryAccounting (MemoryAccounting* accounting);
+void SetMemoryPhase (MemoryPhase phase);
+
+void PrintMemoryReport (const MemoryAccounting* accounting, FILE* out);
+//       ;     
+int ReportMemoryLeaks (const MemoryAccounting* accounting, FILE* out);
+
+#endif
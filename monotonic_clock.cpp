@@ -0,0 +1,18 @@
+#include "monotonic_clock.h"
+#include <time.h>
+
+double NowMs ()
+{
+    timespec now = {};
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+double NowUs ()
+{
+    timespec now = {};
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
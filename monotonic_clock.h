@@ -0,0 +1,9 @@
+#ifndef MONOTONIC_CLOCK_H
+#define MONOTONIC_CLOCK_H
+
+//    : CLOCK_MONOTONIC     
+// .   ,    
+double NowMs ();
+double NowUs ();
+
+#endif
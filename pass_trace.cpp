@@ -0,0 +1,280 @@
+#include "pass_trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+#include <unistd.h>
+
+thread_local PassTrace* active_trace = NULL;
+
+static const char* counter_names[COUNTER_COUNT] = {"tokens", "nodes", "labels", "instructions"};
+
+static double ClockUs (clockid_t clock)
+{
+    timespec now = {};
+    clock_gettime (clock, &now);
+
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+static long long HeapInUse ()
+{
+    struct mallinfo2 info = mallinfo2 ();
+
+    return (long long) (info.uordblks + info.hblkhd);
+}
+
+PassTrace* CtorPassTrace ()
+{
+    PassTrace* trace = (PassTrace*) calloc (1, sizeof(PassTrace));
+    if (!trace) return NULL;
+
+    trace->origin_us = ClockUs (CLOCK_MONOTONIC);
+    return trace;
+}
+
+void DtorPassTrace (PassTrace* trace)
+{
+    if (!trace) return;
+
+    if (active_trace == trace)
+        active_trace = NULL;
+
+    for (int i = 0; i < trace->span_count; i++)
+        free (trace->spans[i].detail);
+
+    free (trace->spans);
+    free (trace);
+}
+
+void BeginTraceSpan (PassTrace* trace, const char* name, const char* category, const char* detail)
+{
+    if (!trace || trace->depth >= MAX_TRACE_DEPTH) return;
+
+    if (trace->span_count >= trace->span_capacity)
+    {
+        int new_capacity = trace->span_capacity ? trace->span_capacity * 2 : 32;
+        TraceSpan* new_spans = (TraceSpan*) realloc (trace->spans, new_capacity * sizeof(TraceSpan));
+        if (!new_spans) return;
+        trace->spans = new_spans;
+        trace->span_capacity = new_capacity;
+    }
+
+    TraceSpan* span = &trace->spans[trace->span_count];
+    memset (span, 0, sizeof(TraceSpan));
+
+    span->name = name;
+    span->category = category;
+    span->detail = detail ? strdup (detail) : NULL;
+    span->depth = trace->depth;
+
+    memcpy (span->counters_start, trace->counters, sizeof(trace->counters));
+    span->heap_start = HeapInUse ();
+    span->cpu_start_us = ClockUs (CLOCK_THREAD_CPUTIME_ID);
+    span->start_us = ClockUs (CLOCK_MONOTONIC) - trace->origin_us;
+
+    trace->open[trace->depth++] = trace->span_count++;
+}
+
+void EndTraceSpan (PassTrace* trace)
+{
+    if (!trace || trace->depth <= 0) return;
+
+    double now_us = ClockUs (CLOCK_MONOTONIC) - trace->origin_us;
+    double cpu_us = ClockUs (CLOCK_THREAD_CPUTIME_ID);
+
+    TraceSpan* span = &trace->spans[trace->open[--trace->depth]];
+
+    span->wall_us = now_us - span->start_us;
+    span->cpu_us = cpu_us - span->cpu_start_us;
+    span->heap_bytes = HeapInUse () - span->heap_start;
+
+    for (int c = 0; c < COUNTER_COUNT; c++)
+        span->counters[c] = trace->counters[c] - span->counters_start[c];
+}
+
+long long CountAsmInstructions (const char* asm_text)
+{
+    long long count = 0;
+
+    for (const char* line = asm_text; line && *line; )
+    {
+        const char* end = strchr (line, '\n');
+        if (!end) end = line + strlen (line);
+
+        const char* first = line;
+        while (first < end && (*first == ' ' || *first == '\t')) first++;
+
+        // x86-64     : "glob_0:    # k"
+        const char* last = first;
+        while (last < end && *last != '#') last++;
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) last--;
+
+        // VM: ":", "; "; x86-64: ":", "# ", "."
+        if (first < last && *first != ':' && *first != ';' && *first != '.' && last[-1] != ':')
+            count++;
+
+        line = *end ? end + 1 : end;
+    }
+
+    return count;
+}
+
+FILE* BeginTraceCapture (TraceCapture* capture, FILE* target)
+{
+    capture->target = target;
+    capture->stream = NULL;
+    capture->text = NULL;
+    capture->size = 0;
+
+#ifndef NO_PASS_TRACE
+    if (active_trace)
+        capture->stream = open_memstream (&capture->text, &capture->size);
+#endif
+
+    return capture->stream ? capture->stream : target;
+}
+
+FILE* EndTraceCapture (TraceCapture* capture)
+{
+    if (!capture->stream) return capture->target;
+
+    fclose (capture->stream);
+    capture->stream = NULL;
+
+    TRACE_COUNT (COUNTER_INSTRUCTIONS, CountAsmInstructions (capture->text));
+    fputs (capture->text, capture->target);
+
+    free (capture->text);
+    capture->text = NULL;
+    return capture->target;
+}
+
+void PrintTraceTable (const PassTrace* trace, FILE* out)
+{
+    if (!trace) return;
+
+    fprintf (out, "\n===   ===\n");
+    fprintf (out, "%-32s %10s %10s %11s %8s %8s %8s %11s\n", "", ", ", ", ",
+             ", ", "", "", "", "");
+
+    for (int i = 0; i < trace->span_count; i++)
+    {
+        const TraceSpan* span = &trace->spans[i];
+        char title[64] = "";
+
+        snprintf (title, sizeof(title), "%*s%s%s%s", span->depth * 2, "", span->name,
+                  span->detail ? " " : "", span->detail ? span->detail : "");
+
+        fprintf (out, "%-32s %10.3f %10.3f %11.1f %8lld %8lld %8lld %11lld\n", title,
+                 span->wall_us / 1000, span->cpu_us / 1000, span->heap_bytes / 1024.0,
+                 span->counters[COUNTER_TOKENS], span->counters[COUNTER_NODES],
+                 span->counters[COUNTER_LABELS], span->counters[COUNTER_INSTRUCTIONS]);
+    }
+}
+
+//     cp1251,  JSON    UTF-8: 
+//   \u,    0x7f   '?'.
+// '<'   \u,       <script>.
+void PrintJsonString (FILE* out, const char* text)
+{
+    fputc ('"', out);
+
+    for (const unsigned char* c = (const unsigned char*) text; c && *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            fprintf (out, "\\%c", *c);
+        else if (*c == '<')
+            fprintf (out, "\\u003c");
+        else if (*c == '\n')
+            fprintf (out, "\\n");
+        else if (*c >= 0xC0)
+            fprintf (out, "\\u%04x", 0x0410 + (*c - 0xC0));
+        else if (*c == 0xA8)
+            fprintf (out, "\\u0401");
+        else if (*c == 0xB8)
+            fprintf (out, "\\u0451");
+        else if (*c < 0x20 || *c >= 0x80)
+            fputc ('?', out);
+        else
+            fputc (*c, out);
+    }
+
+    fputc ('"', out);
+}
+
+static void PrintJsonCounters (FILE* out, const long long* counters)
+{
+    for (int c = 0; c < COUNTER_COUNT; c++)
+        fprintf (out, "%s\"%s\": %lld", c ? ", " : "", counter_names[c], counters[c]);
+}
+
+void PrintTraceJson (const PassTrace* trace, FILE* out)
+{
+    if (!trace) return;
+
+    fprintf (out, "{\n  \"passes\": [\n");
+
+    for (int i = 0; i < trace->span_count; i++)
+    {
+        const TraceSpan* span = &trace->spans[i];
+
+        fprintf (out, "    {\"name\": ");
+        PrintJsonString (out, span->name);
+        if (span->detail)
+        {
+            fprintf (out, ", \"function\": ");
+            PrintJsonString (out, span->detail);
+        }
+        fprintf (out, ", \"depth\": %d, \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"heap_bytes\": %lld, ",
+                 span->depth, span->wall_us / 1000, span->cpu_us / 1000, span->heap_bytes);
+        PrintJsonCounters (out, span->counters);
+        fprintf (out, "}%s\n", i + 1 < trace->span_count ? "," : "");
+    }
+
+    fprintf (out, "  ],\n  \"totals\": {");
+    PrintJsonCounters (out, trace->counters);
+    fprintf (out, "}\n}\n");
+}
+
+int WriteChromeTrace (const PassTrace* trace, const char* filename)
+{
+    if (!trace) return 0;
+
+    FILE* out = fopen (filename, "w");
+    if (!out)
+    {
+        printf ("\n %s  \n", filename);
+        return 0;
+    }
+
+    int pid = (int) getpid ();
+    fprintf (out, "{\"traceEvents\": [\n");
+
+    for (int i = 0; i < trace->span_count; i++)
+    {
+        const TraceSpan* span = &trace->spans[i];
+
+        fprintf (out, "  {\"name\": ");
+        PrintJsonString (out, span->detail ? span->detail : span->name);
+        fprintf (out, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": 1, "
+                      "\"args\": {\"cpu_ms\": %.3f, \"heap_bytes\": %lld, ",
+                 span->category, span->start_us, span->wall_us, pid, span->cpu_us / 1000, span->heap_bytes);
+        PrintJsonCounters (out, span->counters);
+        fprintf (out, "}},\n");
+    }
+
+    //     -   "C"   
+    double end_us = trace->span_count ? trace->spans[0].start_us : 0;
+    for (int i = 0; i < trace->span_count; i++)
+        if (trace->spans[i].start_us + trace->spans[i].wall_us > end_us)
+            end_us = trace->spans[i].start_us + trace->spans[i].wall_us;
+
+    fprintf (out, "  {\"name\": \"totals\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": %d, \"tid\": 1, \"args\": {",
+             end_us, pid);
+    PrintJsonCounters (out, trace->counters);
+    fprintf (out, "}}\n], \"displayTimeUnit\": \"ms\"}\n");
+
+    fclose (out);
+    return 1;
+}
@@ -0,0 +1,101 @@
+#ifndef PASS_TRACE_H
+#define PASS_TRACE_H
+
+#include <stdio.h>
+
+//   :    ,  ,
+//        .  :
+//  -> .  ,   active_trace != NULL;
+// active_trace    ,   BindCompilerContext;
+//    -DNO_PASS_TRACE         .
+enum TraceCounter
+{
+    COUNTER_TOKENS,
+    COUNTER_NODES,
+    COUNTER_LABELS,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_COUNT
+};
+
+typedef struct
+{
+    const char* name;
+    const char* category;           // "pass"  "function"
+    char* detail;                   //     
+
+    int depth;
+    double start_us;                //   
+    double wall_us;
+    double cpu_us;                  //   
+    long long heap_bytes;           //        ,   
+    long long counters[COUNTER_COUNT];
+
+    //   ,   
+    double cpu_start_us;
+    long long heap_start;
+    long long counters_start[COUNTER_COUNT];
+} TraceSpan;
+
+const int MAX_TRACE_DEPTH = 16;
+
+typedef struct
+{
+    TraceSpan* spans;
+    int span_count;
+    int span_capacity;
+
+    int open[MAX_TRACE_DEPTH];
+    int depth;
+
+    long long counters[COUNTER_COUNT];
+    double origin_us;
+} PassTrace;
+
+extern thread_local PassTrace* active_trace;
+
+PassTrace* CtorPassTrace ();
+void DtorPassTrace (PassTrace* trace);
+
+void BeginTraceSpan (PassTrace* trace, const char* name, const char* category, const char* detail);
+void EndTraceSpan (PassTrace* trace);
+
+//  asm VM  x86-64,   , ,   
+long long CountAsmInstructions (const char* asm_text);
+
+//   asm   :     
+//  ,     COUNTER_INSTRUCTIONS,  
+//   .    Begin   target
+typedef struct
+{
+    FILE* target;
+    FILE* stream;
+    char* text;
+    size_t size;
+} TraceCapture;
+
+FILE* BeginTraceCapture (TraceCapture* capture, FILE* target);
+//  target
+FILE* EndTraceCapture (TraceCapture* capture);
+
+//  cp1251  JSON-  ,  ASCII  
+void PrintJsonString (FILE* out, const char* text);
+
+void PrintTraceTable (const PassTrace* trace, FILE* out);
+void PrintTraceJson (const PassTrace* trace, FILE* out);
+//  trace_event:   chrome://tracing  Perfetto
+int WriteChromeTrace (const PassTrace* trace, const char* filename);
+
+#ifdef NO_PASS_TRACE
+    #define TRACE_COUNT(counter, amount)            ((void) 0)
+    #define TRACE_BEGIN(name, category, detail)     ((void) 0)
+    #define TRACE_END()                             ((void) 0)
+#else
+    #define TRACE_COUNT(counter, amount) \
+        do { if (active_trace) active_trace->counters[counter] += (amount); } while (0)
+    #define TRACE_BEGIN(name, category, detail) \
+        do { if (active_trace) BeginTraceSpan (active_trace, name, category, detail); } while (0)
+    #define TRACE_END() \
+        do { if (active_trace) EndTraceSpan (active_trace); } while (0)
+#endif
+
+#endif
@@ -4,6 +4,7 @@
 #include <ctype.h>
 #include <math.h>
 #include "read_AST_tree.h"
+#include "memory_accounting.h"
 
 void CtorParser (ParserState* state, const char* str)
 {
@@ -49,7 +50,7 @@ char* ReadToken (ParserState* str)
 
     if (str->input[str->pos] == '(' || str->input[str->pos] == ')')
     {
-        char* token = (char*) calloc (2, sizeof (char));
+        char* token = (char*) MemAlloc (MEM_LISP, 2, sizeof (char));
         token[0] = str->input[str->pos];
         token[1] = '\0';
         str->pos++;
@@ -69,7 +70,7 @@ char* ReadToken (ParserState* str)
     if (len == 0)
         return NULL;
 
-    char* token = (char*) calloc(len + 1, sizeof (char));
+    char* token = (char*) MemAlloc (MEM_LISP, len + 1, sizeof (char));
     strncpy (token, start, len);
     token[len] = '\0';
 
@@ -124,7 +125,7 @@ Node* ParseExpression (ParserState* str)
     {
         char* token = ReadToken (str);
         Node* node = CreateNodeFromToken (token);
-        free (token);
+        MemFree (MEM_LISP, token);
         return node;
     }
 
@@ -140,7 +141,7 @@ Node* ParseExpression (ParserState* str)
     }
 
     Node* node = CreateNodeFromToken (token);
-    free (token);
+    MemFree (MEM_LISP, token);
 
     if (!node)
     {
@@ -0,0 +1,478 @@
+#include "register_allocation.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const alloc_reg_names[] = {"RCX", "RDX", "RBX", "R12", "R13", "RDI", "RSI", "R8", "R9"};
+
+struct LoopRange
+{
+    int start;
+    int end;
+};
+
+struct LiveScan
+{
+    LiveInterval* intervals;
+    int count;
+    int capacity;
+
+    LoopRange* loops;
+    int loop_count;
+    int loop_capacity;
+
+    int* calls;
+    int call_count;
+    int call_capacity;
+
+    int position;
+    int loop_depth;
+    int branch_depth;   //   if/while:     
+};
+
+const char* RegisterName (int reg)
+{
+    if (reg < 0 || reg >= ARG_REG_FIRST + ARG_REG_COUNT) return "RAX";
+    return alloc_reg_names[reg];
+}
+
+int IsCalleeSaved (int reg)
+{
+    return reg >= ALLOC_CALLER_SAVED_COUNT && reg < ALLOC_REG_COUNT;
+}
+
+// ,      
+int CalleeSavedMask (const LiveInterval* intervals, int count)
+{
+    int mask = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (IsCalleeSaved (intervals[i].reg))
+            mask |= 1 << intervals[i].reg;
+    }
+
+    return mask;
+}
+
+static LiveInterval* FindInterval (LiveScan* scan, const char* name)
+{
+    for (int i = 0; i < scan->count; i++)
+    {
+        if (strcmp (scan->intervals[i].name, name) == 0)
+            return &scan->intervals[i];
+    }
+
+    return NULL;
+}
+
+static int LoopWeight (int depth)
+{
+    if (depth > MAX_LOOP_WEIGHT_DEPTH) depth = MAX_LOOP_WEIGHT_DEPTH;
+
+    int weight = 1;
+    for (int i = 0; i < depth; i++)
+        weight *= 10;
+
+    return weight;
+}
+
+//     x86    0,  -  . 
+//     if/while      : 
+//      ,     
+static void AddDeclaration (LiveScan* scan, const char* name, int initialized)
+{
+    int may_skip = scan->branch_depth > 0 || !initialized;
+
+    LiveInterval* interval = FindInterval (scan, name);
+    if (interval)
+    {
+        interval->weight += LoopWeight (scan->loop_depth);
+        if (scan->position > interval->end) interval->end = scan->position;
+        if (may_skip) interval->zero_init = 1;
+        return;
+    }
+
+    if (scan->count >= scan->capacity)
+    {
+        scan->capacity = scan->capacity ? scan->capacity * 2 : 8;
+        LiveInterval* new_intervals = (LiveInterval*) realloc (scan->intervals,
+                                                               scan->capacity * sizeof(LiveInterval));
+        if (!new_intervals) return;
+        scan->intervals = new_intervals;
+    }
+
+    LiveInterval* fresh = &scan->intervals[scan->count++];
+    fresh->name = strdup (name);
+    fresh->start = scan->position;
+    fresh->end = scan->position;
+    fresh->weight = LoopWeight (scan->loop_depth);
+    fresh->crosses_call = 0;
+    fresh->fixed = 0;
+    fresh->zero_init = may_skip;
+    fresh->reg = -1;
+}
+
+static void AddUse (LiveScan* scan, const char* name)
+{
+    //       
+    LiveInterval* interval = FindInterval (scan, name);
+    if (!interval) return;
+
+    interval->end = scan->position;
+    interval->weight += LoopWeight (scan->loop_depth);
+}
+
+static void AddCall (LiveScan* scan)
+{
+    if (scan->call_count >= scan->call_capacity)
+    {
+        scan->call_capacity = scan->call_capacity ? scan->call_capacity * 2 : 8;
+        int* new_calls = (int*) realloc (scan->calls, scan->call_capacity * sizeof(int));
+        if (!new_calls) return;
+        scan->calls = new_calls;
+    }
+
+    scan->calls[scan->call_count++] = scan->position;
+}
+
+static void AddLoop (LiveScan* scan, int start, int end)
+{
+    if (scan->loop_count >= scan->loop_capacity)
+    {
+        scan->loop_capacity = scan->loop_capacity ? scan->loop_capacity * 2 : 4;
+        LoopRange* new_loops = (LoopRange*) realloc (scan->loops,
+                                                     scan->loop_capacity * sizeof(LoopRange));
+        if (!new_loops) return;
+        scan->loops = new_loops;
+    }
+
+    scan->loops[scan->loop_count].start = start;
+    scan->loops[scan->loop_count].end = end;
+    scan->loop_count++;
+}
+
+static void ScanNode (LiveScan* scan, Node* node);
+
+//    ,   GenFuncCall
+static void ScanArguments (LiveScan* scan, Node* arg)
+{
+    if (!arg) return;
+
+    ScanArguments (scan, arg->right);
+    ScanNode (scan, arg->left);
+}
+
+//       (  GenerateCode)
+static void ScanNode (LiveScan* scan, Node* node)
+{
+    if (!node) return;
+
+    switch (node->type)
+    {
+        case NODE_VARIABLE:
+            scan->position++;
+            AddUse (scan, node->data.string_value);
+            break;
+
+        case NODE_ASSIGNMENT:
+            ScanNode (scan, node->right);
+            scan->position++;
+            if (node->left && node->left->type == NODE_VARIABLE)
+                AddUse (scan, node->left->data.string_value);
+            break;
+
+        case NODE_VAR_DECL:
+            scan->position++;
+            AddDeclaration (scan, node->data.string_value, node->left != NULL);
+            ScanNode (scan, node->left);
+            break;
+
+        case NODE_IF:
+            ScanNode (scan, node->left);
+            scan->branch_depth++;
+            ScanNode (scan, node->right);
+            scan->branch_depth--;
+            scan->position++;
+            break;
+
+        case NODE_FUNC_CALL:
+            ScanArguments (scan, node->left);
+            scan->position++;
+            AddCall (scan);
+            break;
+
+        case NODE_WHILE:
+        {
+            int start = ++scan->position;
+            scan->loop_depth++;
+            ScanNode (scan, node->left);
+            scan->branch_depth++;
+            ScanNode (scan, node->right);
+            scan->branch_depth--;
+            scan->loop_depth--;
+            int end = ++scan->position;
+            AddLoop (scan, start, end);
+            break;
+        }
+
+        default:
+            ScanNode (scan, node->left);
+            ScanNode (scan, node->right);
+            scan->position++;
+            break;
+    }
+}
+
+// ,   ,     ( )
+static void ExtendOverLoops (LiveScan* scan)
+{
+    int changed = 1;
+    while (changed)
+    {
+        changed = 0;
+        for (int i = 0; i < scan->count; i++)
+        {
+            LiveInterval* interval = &scan->intervals[i];
+            for (int j = 0; j < scan->loop_count; j++)
+            {
+                LoopRange* loop = &scan->loops[j];
+                if (interval->end < loop->start || interval->start > loop->end)
+                    continue;
+
+                if (loop->start < interval->start)
+                {
+                    interval->start = loop->start;
+                    changed = 1;
+                }
+                if (loop->end > interval->end)
+                {
+                    interval->end = loop->end;
+                    changed = 1;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < scan->count; i++)
+    {
+        for (int j = 0; j < scan->call_count; j++)
+        {
+            if (scan->calls[j] > scan->intervals[i].start &&
+                scan->calls[j] < scan->intervals[i].end)
+                scan->intervals[i].crosses_call = 1;
+        }
+    }
+}
+
+static int CompareByStart (const void* a, const void* b)
+{
+    const LiveInterval* left = *(const LiveInterval* const*) a;
+    const LiveInterval* right = *(const LiveInterval* const*) b;
+
+    if (left->start != right->start) return left->start - right->start;
+    return right->weight - left->weight;
+}
+
+int LinearScan (LiveInterval* intervals, int count, int reg_count)
+{
+    if (count <= 0) return 0;
+
+    LiveInterval** order = (LiveInterval**) calloc (count, sizeof(LiveInterval*));
+    LiveInterval** active = (LiveInterval**) calloc (count, sizeof(LiveInterval*));
+    if (!order || !active)
+    {
+        free (order);
+        free (active);
+        return 0;
+    }
+
+    int order_count = 0;
+    for (int i = 0; i < count; i++)
+    {
+        //  -    ,   
+        if (intervals[i].fixed) continue;
+
+        intervals[i].reg = -1;
+        order[order_count++] = &intervals[i];
+    }
+
+    qsort (order, order_count, sizeof(LiveInterval*), CompareByStart);
+
+    int active_count = 0;
+    int assigned = 0;
+
+    for (int i = 0; i < order_count; i++)
+    {
+        LiveInterval* current = order[i];
+
+        //  CALL   ,   ;
+        //      -    
+        int first_reg = current->crosses_call ? ALLOC_CALLER_SAVED_COUNT : 0;
+
+        for (int j = 0; j < active_count; )
+        {
+            if (active[j]->end < current->start)
+                active[j] = active[--active_count];
+            else
+                j++;
+        }
+
+        int free_reg = -1;
+        for (int reg = first_reg; reg < reg_count && free_reg < 0; reg++)
+        {
+            int busy = 0;
+            for (int j = 0; j < active_count; j++)
+                if (active[j]->reg == reg) busy = 1;
+
+            if (!busy) free_reg = reg;
+        }
+
+        if (free_reg >= 0)
+        {
+            current->reg = free_reg;
+            active[active_count++] = current;
+            assigned++;
+            continue;
+        }
+
+        //     
+        int victim = -1;
+        for (int j = 0; j < active_count; j++)
+        {
+            if (active[j]->reg < first_reg) continue;
+
+            if (victim < 0 || active[j]->weight < active[victim]->weight)
+                victim = j;
+        }
+
+        if (victim >= 0 && active[victim]->weight < current->weight)
+        {
+            current->reg = active[victim]->reg;
+            active[victim]->reg = -1;
+            active[victim] = current;
+        }
+    }
+
+    free (order);
+    free (active);
+
+    return assigned;
+}
+
+//   -,   ,   ;
+//      .   
+//   RBX/R12/R13  ,     .
+static void FixParameterRegisters (LiveScan* scan, Node* func)
+{
+    int param_count = CountParameters (func);
+
+    for (int i = 0; i < param_count; i++)
+    {
+        LiveInterval* interval = FindInterval (scan, NthParameter (func, i)->data.string_value);
+        if (!interval) continue;
+
+        if (i >= ARG_REG_COUNT)
+        {
+            interval->fixed = 1;
+            interval->reg = -1;
+        }
+        else if (!interval->crosses_call)
+        {
+            interval->fixed = 1;
+            interval->reg = ARG_REG_FIRST + i;
+        }
+    }
+}
+
+void AllocateRegisters (CodeGenContext* ctx, Node* func)
+{
+    FreeRegisterPlan (ctx);
+
+    if (!ctx || !func) return;
+
+    LiveScan scan = {};
+
+    //      
+    int param_count = CountParameters (func);
+    for (int i = 0; i < param_count; i++)
+    {
+        scan.position++;
+        AddDeclaration (&scan, NthParameter (func, i)->data.string_value, 1);
+    }
+
+    ScanNode (&scan, func->right);
+
+    // ,  ,    
+    for (int i = 0; i < param_count; i++)
+    {
+        LiveInterval* param = FindInterval (&scan, NthParameter (func, i)->data.string_value);
+        if (param) param->zero_init = 0;
+    }
+
+    for (int i = 0; i < scan.count; i++)
+    {
+        if (scan.intervals[i].zero_init)
+            scan.intervals[i].start = 0;
+    }
+
+    ExtendOverLoops (&scan);
+
+    FixParameterRegisters (&scan, func);
+
+    LinearScan (scan.intervals, scan.count, ALLOC_REG_COUNT);
+
+    ctx->reg_plan = scan.intervals;
+    ctx->reg_plan_count = scan.count;
+    ctx->callee_saved = CalleeSavedMask (scan.intervals, scan.count);
+
+    for (int i = 0; i < scan.count; i++)
+    {
+        if (scan.intervals[i].reg >= 0)
+            fprintf (ctx->output, "; %s -> %s\n", scan.intervals[i].name,
+                     RegisterName (scan.intervals[i].reg));
+    }
+
+    free (scan.loops);
+    free (scan.calls);
+}
+
+void BindPlannedRegister (CodeGenContext* ctx, const char* var_name)
+{
+    VariableInfo* var = FindVariable (ctx, var_name);
+    if (!var || !var->is_local) return;
+
+    for (int i = 0; i < ctx->reg_plan_count; i++)
+    {
+        if (strcmp (ctx->reg_plan[i].name, var_name) == 0)
+        {
+            var->reg = ctx->reg_plan[i].reg;
+            return;
+        }
+    }
+}
+
+//       (  - ,  )
+int PlannedAcrossCall (CodeGenContext* ctx, const char* var_name)
+{
+    if (!ctx->reg_plan) return 1;
+
+    for (int i = 0; i < ctx->reg_plan_count; i++)
+    {
+        if (strcmp (ctx->reg_plan[i].name, var_name) == 0)
+            return ctx->reg_plan[i].crosses_call;
+    }
+
+    return 0;
+}
+
+void FreeRegisterPlan (CodeGenContext* ctx)
+{
+    if (!ctx) return;
+
+    for (int i = 0; i < ctx->reg_plan_count; i++)
+        free (ctx->reg_plan[i].name);
+
+    free (ctx->reg_plan);
+    ctx->reg_plan = NULL;
+    ctx->reg_plan_count = 0;
+}
@@ -0,0 +1,29 @@
+#ifndef REGISTER_ALLOCATION_H
+#define REGISTER_ALLOCATION_H
+
+#include "create_asm_code_from_tree.h"
+
+//     :
+//   RAX               -   ,  
+//   RCX, RDX          -  :  CALL     
+//   RBX, R12, R13     -  ,   
+//   RDI, RSI, R8, R9  -  ,  
+//      ,     .
+const int ALLOC_CALLER_SAVED_COUNT = 2;
+const int ALLOC_REG_COUNT = 5;
+const int ARG_REG_FIRST = ALLOC_REG_COUNT;      //  -  RegisterName
+const int ARG_REG_COUNT = 4;
+const int MAX_LOOP_WEIGHT_DEPTH = 4;
+
+const char* RegisterName (int reg);
+int IsCalleeSaved (int reg);
+int CalleeSavedMask (const LiveInterval* intervals, int count);
+
+int LinearScan (LiveInterval* intervals, int count, int reg_count);
+
+void AllocateRegisters (CodeGenContext* ctx, Node* func);
+void BindPlannedRegister (CodeGenContext* ctx, const char* var_name);
+int PlannedAcrossCall (CodeGenContext* ctx, const char* var_name);
+void FreeRegisterPlan (CodeGenContext* ctx);
+
+#endif
@@ -0,0 +1,1034 @@
+#include "ssa_ir.h"
+#include "type_checking.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+struct IrBuilder
+{
+    IrFunction* fn;
+    CodeGenContext* ctx;        //    
+    int current;
+    int loop_depth;
+    int* declared;
+};
+
+static void PushInt (int** array, int* count, int* capacity, int value)
+{
+    if (*count >= *capacity)
+    {
+        int new_capacity = *capacity ? *capacity * 2 : 4;
+        int* new_array = (int*) realloc (*array, new_capacity * sizeof(int));
+        if (!new_array) return;
+        *array = new_array;
+        *capacity = new_capacity;
+    }
+
+    (*array)[(*count)++] = value;
+}
+
+int IrNewBlock (IrFunction* fn, int loop_depth)
+{
+    if (fn->block_count >= fn->block_capacity)
+    {
+        int new_capacity = fn->block_capacity ? fn->block_capacity * 2 : 8;
+        IrBlock* new_blocks = (IrBlock*) realloc (fn->blocks, new_capacity * sizeof(IrBlock));
+        if (!new_blocks) return -1;
+        fn->blocks = new_blocks;
+        fn->block_capacity = new_capacity;
+    }
+
+    IrBlock* block = &fn->blocks[fn->block_count];
+    memset (block, 0, sizeof(IrBlock));
+
+    block->term = IR_TERM_NONE;
+    block->term_value = -1;
+    block->succ[0] = -1;
+    block->succ[1] = -1;
+    block->loop_depth = loop_depth;
+
+    if (fn->var_count > 0)
+    {
+        block->defs = (int*) calloc (fn->var_count, sizeof(int));
+        for (int i = 0; block->defs && i < fn->var_count; i++)
+            block->defs[i] = -1;
+    }
+
+    return fn->block_count++;
+}
+
+static int AllocValue (IrFunction* fn, int block, IrOpcode op)
+{
+    if (fn->value_count >= fn->value_capacity)
+    {
+        int new_capacity = fn->value_capacity ? fn->value_capacity * 2 : 32;
+        IrValue* new_values = (IrValue*) realloc (fn->values, new_capacity * sizeof(IrValue));
+        if (!new_values) return -1;
+        fn->values = new_values;
+        fn->value_capacity = new_capacity;
+    }
+
+    IrValue* value = &fn->values[fn->value_count];
+    memset (value, 0, sizeof(IrValue));
+
+    value->op = op;
+    value->type = NODE_TYPE_DOUBLE;
+    value->block = block;
+    value->replaced_by = -1;
+
+    return fn->value_count++;
+}
+
+int IrNewValue (IrFunction* fn, int block, IrOpcode op)
+{
+    int id = AllocValue (fn, block, op);
+    if (id < 0) return -1;
+
+    IrBlock* b = &fn->blocks[block];
+    PushInt (&b->values, &b->value_count, &b->value_capacity, id);
+
+    return id;
+}
+
+// phi       
+static int InsertValueFront (IrFunction* fn, int block, IrOpcode op)
+{
+    int id = AllocValue (fn, block, op);
+    if (id < 0) return -1;
+
+    IrBlock* b = &fn->blocks[block];
+    PushInt (&b->values, &b->value_count, &b->value_capacity, id);
+
+    int pos = 0;
+    while (pos < b->value_count - 1 && fn->values[b->values[pos]].op == IR_PHI)
+        pos++;
+
+    memmove (&b->values[pos + 1], &b->values[pos], (b->value_count - 1 - pos) * sizeof(int));
+    b->values[pos] = id;
+
+    return id;
+}
+
+void IrAddArg (IrFunction* fn, int value, int arg)
+{
+    IrValue* v = &fn->values[value];
+    PushInt (&v->args, &v->arg_count, &v->arg_capacity, arg);
+}
+
+void IrAddPred (IrFunction* fn, int block, int pred)
+{
+    IrBlock* b = &fn->blocks[block];
+    PushInt (&b->preds, &b->pred_count, &b->pred_capacity, pred);
+}
+
+void IrRemovePred (IrFunction* fn, int block, int pred)
+{
+    IrBlock* b = &fn->blocks[block];
+
+    int index = -1;
+    for (int i = 0; i < b->pred_count; i++)
+        if (b->preds[i] == pred) index = i;
+
+    if (index < 0) return;
+
+    memmove (&b->preds[index], &b->preds[index + 1], (b->pred_count - index - 1) * sizeof(int));
+    b->pred_count--;
+
+    for (int i = 0; i < b->value_count; i++)
+    {
+        IrValue* v = &fn->values[b->values[i]];
+        if (v->op != IR_PHI || v->removed || index >= v->arg_count) continue;
+
+        memmove (&v->args[index], &v->args[index + 1], (v->arg_count - index - 1) * sizeof(int));
+        v->arg_count--;
+    }
+}
+
+int IrResolve (const IrFunction* fn, int value)
+{
+    while (value >= 0 && fn->values[value].replaced_by >= 0)
+        value = fn->values[value].replaced_by;
+
+    return value;
+}
+
+int IrIsPure (IrOpcode op)
+{
+    return op == IR_CONST || op == IR_CONVERT || (op >= IR_ADD && op <= IR_LT);
+}
+
+int IrIsCommutative (IrOpcode op)
+{
+    return op == IR_ADD || op == IR_MUL || op == IR_EQ || op == IR_NE;
+}
+
+int IrSuccCount (const IrBlock* block)
+{
+    switch (block->term)
+    {
+        case IR_TERM_JUMP:   return 1;
+        case IR_TERM_BRANCH: return 2;
+        default:             return 0;
+    }
+}
+
+static void ReplaceValue (IrFunction* fn, int value, int by)
+{
+    fn->values[value].replaced_by = by;
+    fn->values[value].removed = 1;
+}
+
+// =====================  SSA (Braun et al.) =====================
+
+static int FindVar (IrFunction* fn, const char* name)
+{
+    for (int i = 0; i < fn->var_count; i++)
+        if (strcmp (fn->vars[i], name) == 0) return i;
+
+    return -1;
+}
+
+static void CollectLocals (IrFunction* fn, Node* node)
+{
+    if (!node) return;
+
+    if ((node->type == NODE_VAR_DECL || node->type == NODE_PARAMETER) && node->data.string_value &&
+        FindVar (fn, node->data.string_value) < 0)
+    {
+        char** new_vars = (char**) realloc (fn->vars, (fn->var_count + 1) * sizeof(char*));
+        if (!new_vars) return;
+        fn->vars = new_vars;
+
+        NodeType* new_types = (NodeType*) realloc (fn->var_types, (fn->var_count + 1) * sizeof(NodeType));
+        if (!new_types) return;
+        fn->var_types = new_types;
+
+        fn->vars[fn->var_count] = strdup (node->data.string_value);
+        fn->var_types[fn->var_count] = DeclaredType (node->data.type_value);
+        fn->var_count++;
+    }
+
+    CollectLocals (fn, node->left);
+    CollectLocals (fn, node->right);
+}
+
+static int ReadVariable (IrBuilder* builder, int var, int block);
+
+static int NewConst (IrFunction* fn, int block, double number, NodeType type)
+{
+    int id = InsertValueFront (fn, block, IR_CONST);
+    fn->values[id].number = ConvertValue (number, type);
+    fn->values[id].type = DeclaredType (type);
+    return id;
+}
+
+static int TryRemoveTrivialPhi (IrFunction* fn, int phi)
+{
+    int same = -1;
+    IrValue* v = &fn->values[phi];
+
+    for (int i = 0; i < v->arg_count; i++)
+    {
+        int arg = IrResolve (fn, v->args[i]);
+        if (arg == same || arg == phi) continue;
+        if (same >= 0) return phi;
+        same = arg;
+    }
+
+    if (same < 0)
+        same = NewConst (fn, v->block, 0, v->type);
+
+    ReplaceValue (fn, phi, same);
+    return same;
+}
+
+static int AddPhiOperands (IrBuilder* builder, int var, int phi)
+{
+    IrFunction* fn = builder->fn;
+    int block = fn->values[phi].block;
+
+    for (int i = 0; i < fn->blocks[block].pred_count; i++)
+    {
+        int arg = ReadVariable (builder, var, fn->blocks[block].preds[i]);
+        IrAddArg (fn, phi, arg);
+    }
+
+    return TryRemoveTrivialPhi (fn, phi);
+}
+
+static void WriteVariable (IrBuilder* builder, int var, int block, int value)
+{
+    IrBlock* b = &builder->fn->blocks[block];
+    if (b->defs) b->defs[var] = value;
+}
+
+static int ReadVariable (IrBuilder* builder, int var, int block)
+{
+    IrFunction* fn = builder->fn;
+    IrBlock* b = &fn->blocks[block];
+
+    if (b->defs && b->defs[var] >= 0)
+        return IrResolve (fn, b->defs[var]);
+
+    int value = -1;
+
+    if (!b->sealed)
+    {
+        value = InsertValueFront (fn, block, IR_PHI);
+        fn->values[value].type = fn->var_types[var];
+        b = &fn->blocks[block];
+        PushInt (&b->incomplete, &b->incomplete_count, &b->incomplete_capacity, var);
+        PushInt (&b->incomplete, &b->incomplete_count, &b->incomplete_capacity, value);
+    }
+    else if (b->pred_count == 0)
+    {
+        //  :   
+        value = NewConst (fn, block, 0, fn->var_types[var]);
+    }
+    else if (b->pred_count == 1)
+    {
+        value = ReadVariable (builder, var, b->preds[0]);
+    }
+    else
+    {
+        int phi = InsertValueFront (fn, block, IR_PHI);
+        fn->values[phi].type = fn->var_types[var];
+        WriteVariable (builder, var, block, phi);
+        value = AddPhiOperands (builder, var, phi);
+    }
+
+    WriteVariable (builder, var, block, value);
+    return value;
+}
+
+static void SealBlock (IrBuilder* builder, int block)
+{
+    IrFunction* fn = builder->fn;
+
+    for (int i = 0; i < fn->blocks[block].incomplete_count; i += 2)
+    {
+        int var = fn->blocks[block].incomplete[i];
+        int phi = fn->blocks[block].incomplete[i + 1];
+        AddPhiOperands (builder, var, phi);
+    }
+
+    IrBlock* b = &fn->blocks[block];
+    free (b->incomplete);
+    b->incomplete = NULL;
+    b->incomplete_count = 0;
+    b->incomplete_capacity = 0;
+    b->sealed = 1;
+}
+
+static int LocalIndex (IrBuilder* builder, const char* name)
+{
+    if (!name) return -1;
+
+    int var = FindVar (builder->fn, name);
+    if (var < 0 || !builder->declared[var]) return -1;
+
+    return var;
+}
+
+static IrOpcode OpcodeForNode (NodeType type)
+{
+    switch (type)
+    {
+        case NODE_ADD: return IR_ADD;
+        case NODE_SUB: return IR_SUB;
+        case NODE_MUL: return IR_MUL;
+        case NODE_DIV: return IR_DIV;
+        case NODE_EQ:  return IR_EQ;
+        case NODE_NE:  return IR_NE;
+        case NODE_GT:  return IR_GT;
+        default:       return IR_LT;
+    }
+}
+
+//        ;  - double
+static NodeType GlobalType (IrBuilder* builder, const char* name)
+{
+    VariableInfo* var = FindVariable (builder->ctx, name);
+    return var ? var->type : NODE_TYPE_DOUBLE;
+}
+
+// char -> int   :     
+static int BuildConvert (IrBuilder* builder, int value, NodeType type)
+{
+    IrFunction* fn = builder->fn;
+    NodeType from = fn->values[value].type;
+    type = DeclaredType (type);
+
+    if (from == type || (from == NODE_TYPE_CHAR && type == NODE_TYPE_INT))
+        return value;
+
+    if (fn->values[value].op == IR_CONST)
+    {
+        int id = IrNewValue (fn, builder->current, IR_CONST);
+        fn->values[id].number = ConvertValue (fn->values[value].number, type);
+        fn->values[id].type = type;
+        return id;
+    }
+
+    int id = IrNewValue (fn, builder->current, IR_CONVERT);
+    fn->values[id].type = type;
+    IrAddArg (fn, id, value);
+    return id;
+}
+
+static int BuildExpression (IrBuilder* builder, Node* node);
+
+static int BuildTyped (IrBuilder* builder, Node* node, NodeType type)
+{
+    return BuildConvert (builder, BuildExpression (builder, node), type);
+}
+
+//    ExpressionType (node);     
+static int BuildExpression (IrBuilder* builder, Node* node)
+{
+    IrFunction* fn = builder->fn;
+    int block = builder->current;
+
+    if (!node)
+        return NewConst (fn, block, 0, NODE_TYPE_INT);
+
+    switch (node->type)
+    {
+        case NODE_NUMBER:
+        {
+            int id = IrNewValue (fn, block, IR_CONST);
+            fn->values[id].type = ExpressionType (node);
+            fn->values[id].number = ConvertValue (node->data.number_value, fn->values[id].type);
+            return id;
+        }
+
+        case NODE_VARIABLE:
+        {
+            int var = LocalIndex (builder, node->data.string_value);
+            if (var >= 0)
+                return BuildConvert (builder, ReadVariable (builder, var, block), ExpressionType (node));
+
+            int id = IrNewValue (fn, block, IR_LOAD_GLOBAL);
+            fn->values[id].name = strdup (node->data.string_value);
+            fn->values[id].type = GlobalType (builder, node->data.string_value);
+            return BuildConvert (builder, id, ExpressionType (node));
+        }
+
+        case NODE_ADD:
+        case NODE_SUB:
+        case NODE_MUL:
+        case NODE_DIV:
+        case NODE_EQ:
+        case NODE_NE:
+        case NODE_GT:
+        case NODE_LT:
+        {
+            NodeType type = OperandType (node);
+            int left = BuildTyped (builder, node->left, type);
+            int right = BuildTyped (builder, node->right, type);
+
+            int id = IrNewValue (fn, block, OpcodeForNode (node->type));
+            fn->values[id].type = ExpressionType (node);
+            IrAddArg (fn, id, left);
+            IrAddArg (fn, id, right);
+            return id;
+        }
+
+        case NODE_FUNC_CALL:
+        {
+            //         ,
+            //  - ,   
+            FunctionInfo* callee = FindFunctionInfo (builder->ctx, node->data.string_value);
+            int param_count = callee ? callee->param_count : 0;
+
+            int args[MAX_FUNC_PARAMS] = {};
+            for (int i = param_count - 1; i >= 0; i--)
+            {
+                NodeType type = DeclaredType (NthParameter (callee->decl, i)->data.type_value);
+                Node* arg = NthArgument (node, i);
+
+                args[i] = arg ? BuildTyped (builder, arg, type) : NewConst (fn, builder->current, 0, type);
+            }
+
+            int id = IrNewValue (fn, block, IR_CALL);
+            fn->values[id].name = strdup (node->data.string_value);
+            fn->values[id].type = ExpressionType (node);
+
+            for (int i = 0; i < param_count; i++)
+                IrAddArg (fn, id, args[i]);
+
+            return id;
+        }
+
+        default:
+            return NewConst (fn, block, 0, NODE_TYPE_INT);
+    }
+}
+
+//    ,     -  
+static void MarkDeclarations (IrBuilder* builder, Node* node)
+{
+    if (!node) return;
+
+    if (node->type == NODE_VAR_DECL)
+    {
+        int var = FindVar (builder->fn, node->data.string_value);
+        if (var >= 0) builder->declared[var] = 1;
+    }
+
+    MarkDeclarations (builder, node->left);
+    MarkDeclarations (builder, node->right);
+}
+
+//       
+static void StoreName (IrBuilder* builder, const char* name, int value)
+{
+    int var = LocalIndex (builder, name);
+    if (var >= 0)
+    {
+        value = BuildConvert (builder, value, builder->fn->var_types[var]);
+        WriteVariable (builder, var, builder->current, value);
+        return;
+    }
+
+    NodeType type = GlobalType (builder, name);
+    value = BuildConvert (builder, value, type);
+
+    IrFunction* fn = builder->fn;
+    int id = IrNewValue (fn, builder->current, IR_STORE_GLOBAL);
+    fn->values[id].name = strdup (name);
+    fn->values[id].type = type;
+    IrAddArg (fn, id, value);
+}
+
+static void SetJump (IrFunction* fn, int from, int to)
+{
+    fn->blocks[from].term = IR_TERM_JUMP;
+    fn->blocks[from].succ[0] = to;
+    IrAddPred (fn, to, from);
+}
+
+static void BuildStatement (IrBuilder* builder, Node* node)
+{
+    if (!node) return;
+
+    if (builder->current < 0)
+    {
+        MarkDeclarations (builder, node);
+        return;
+    }
+
+    IrFunction* fn = builder->fn;
+
+    switch (node->type)
+    {
+        case NODE_SEQUENCE:
+            BuildStatement (builder, node->left);
+            BuildStatement (builder, node->right);
+            break;
+
+        case NODE_ASSIGNMENT:
+        {
+            int value = BuildExpression (builder, node->right);
+            if (node->left && node->left->type == NODE_VARIABLE)
+                StoreName (builder, node->left->data.string_value, value);
+            break;
+        }
+
+        case NODE_VAR_DECL:
+        {
+            int var = FindVar (fn, node->data.string_value);
+            if (var >= 0) builder->declared[var] = 1;
+
+            if (node->left)
+            {
+                int value = BuildExpression (builder, node->left);
+                StoreName (builder, node->data.string_value, value);
+            }
+            break;
+        }
+
+        case NODE_IF:
+        {
+            int cond_block = builder->current;
+            int cond = BuildExpression (builder, node->left);
+
+            int then_block = IrNewBlock (fn, builder->loop_depth);
+            fn->blocks[cond_block].term = IR_TERM_BRANCH;
+            fn->blocks[cond_block].term_value = cond;
+            fn->blocks[cond_block].succ[0] = then_block;
+            IrAddPred (fn, then_block, cond_block);
+            SealBlock (builder, then_block);
+
+            builder->current = then_block;
+            BuildStatement (builder, node->right);
+            int then_end = builder->current;
+
+            int join_block = IrNewBlock (fn, builder->loop_depth);
+            fn->blocks[cond_block].succ[1] = join_block;
+            IrAddPred (fn, join_block, cond_block);
+            if (then_end >= 0)
+                SetJump (fn, then_end, join_block);
+            SealBlock (builder, join_block);
+
+            builder->current = join_block;
+            break;
+        }
+
+        case NODE_WHILE:
+        {
+            builder->loop_depth++;
+
+            int header = IrNewBlock (fn, builder->loop_depth);
+            SetJump (fn, builder->current, header);
+
+            builder->current = header;
+            int cond = BuildExpression (builder, node->left);
+
+            int body = IrNewBlock (fn, builder->loop_depth);
+            IrAddPred (fn, body, header);
+            SealBlock (builder, body);
+
+            builder->current = body;
+            BuildStatement (builder, node->right);
+            int body_end = builder->current;
+
+            if (body_end >= 0)
+                SetJump (fn, body_end, header);
+
+            builder->loop_depth--;
+
+            int exit_block = IrNewBlock (fn, builder->loop_depth);
+            fn->blocks[header].term = IR_TERM_BRANCH;
+            fn->blocks[header].term_value = cond;
+            fn->blocks[header].succ[0] = body;
+            fn->blocks[header].succ[1] = exit_block;
+            IrAddPred (fn, exit_block, header);
+
+            SealBlock (builder, exit_block);
+            SealBlock (builder, header);
+
+            builder->current = exit_block;
+            break;
+        }
+
+        case NODE_RETURN:
+        {
+            int value = node->left ? BuildTyped (builder, node->left, fn->return_type) : -1;
+            fn->blocks[builder->current].term = IR_TERM_RETURN;
+            fn->blocks[builder->current].term_value = value;
+            builder->current = -1;
+            break;
+        }
+
+        case NODE_EMPTY:
+            break;
+
+        default:
+            BuildExpression (builder, node);
+            break;
+    }
+}
+
+IrFunction* BuildIr (Node* func, CodeGenContext* ctx)
+{
+    if (!func || func->type != NODE_FUNC_DECL) return NULL;
+
+    IrFunction* fn = (IrFunction*) calloc (1, sizeof(IrFunction));
+    if (!fn) return NULL;
+
+    fn->name = strdup (func->data.string_value ? func->data.string_value : "");
+    CollectLocals (fn, func->left);
+    CollectLocals (fn, func->right);
+
+    IrBuilder builder = {};
+    builder.fn = fn;
+    builder.ctx = ctx;
+    builder.declared = (int*) calloc (fn->var_count + 1, sizeof(int));
+
+    int entry = IrNewBlock (fn, 0);
+    SealBlock (&builder, entry);
+    builder.current = entry;
+
+    fn->param_count = CountParameters (func);
+    fn->return_type = DeclaredType (func->data.type_value);
+
+    int index = 0;
+    for (Node* param = func->left; param; param = param->right, index++)
+    {
+        int id = IrNewValue (fn, entry, IR_PARAM);
+        fn->values[id].number = index;
+        fn->values[id].name = strdup (param->data.string_value);
+        fn->values[id].type = DeclaredType (param->data.type_value);
+
+        int var = FindVar (fn, param->data.string_value);
+        builder.declared[var] = 1;
+        WriteVariable (&builder, var, entry, id);
+    }
+
+    BuildStatement (&builder, func->right);
+
+    if (builder.current >= 0)
+    {
+        fn->blocks[builder.current].term = IR_TERM_RETURN;
+        fn->blocks[builder.current].term_value = -1;
+    }
+
+    free (builder.declared);
+
+    for (int i = 0; i < fn->block_count; i++)
+    {
+        free (fn->blocks[i].defs);
+        fn->blocks[i].defs = NULL;
+    }
+
+    IrRemoveUnreachable (fn);
+    IrRemoveTrivialPhis (fn);
+
+    return fn;
+}
+
+void FreeIr (IrFunction* fn)
+{
+    if (!fn) return;
+
+    for (int i = 0; i < fn->value_count; i++)
+    {
+        free (fn->values[i].args);
+        free (fn->values[i].name);
+    }
+
+    for (int i = 0; i < fn->block_count; i++)
+    {
+        free (fn->blocks[i].values);
+        free (fn->blocks[i].preds);
+        free (fn->blocks[i].defs);
+        free (fn->blocks[i].incomplete);
+    }
+
+    for (int i = 0; i < fn->var_count; i++)
+        free (fn->vars[i]);
+
+    free (fn->vars);
+    free (fn->var_types);
+    free (fn->values);
+    free (fn->blocks);
+    free (fn->name);
+    free (fn);
+}
+
+// =====================   =====================
+
+void IrCompact (IrFunction* fn)
+{
+    for (int b = 0; b < fn->block_count; b++)
+    {
+        IrBlock* block = &fn->blocks[b];
+        if (block->removed) continue;
+
+        int kept = 0;
+        for (int i = 0; i < block->value_count; i++)
+        {
+            int id = block->values[i];
+            IrValue* v = &fn->values[id];
+            if (v->removed) continue;
+
+            for (int a = 0; a < v->arg_count; a++)
+                v->args[a] = IrResolve (fn, v->args[a]);
+
+            block->values[kept++] = id;
+        }
+        block->value_count = kept;
+
+        if (block->term_value >= 0)
+            block->term_value = IrResolve (fn, block->term_value);
+    }
+}
+
+void IrRemoveTrivialPhis (IrFunction* fn)
+{
+    int changed = 1;
+    while (changed)
+    {
+        changed = 0;
+        for (int id = 0; id < fn->value_count; id++)
+        {
+            IrValue* v = &fn->values[id];
+            if (v->op != IR_PHI || v->removed || fn->blocks[v->block].removed) continue;
+
+            if (TryRemoveTrivialPhi (fn, id) != id)
+                changed = 1;
+        }
+    }
+
+    IrCompact (fn);
+}
+
+void IrRemoveUnreachable (IrFunction* fn)
+{
+    if (fn->block_count == 0) return;
+
+    char* reachable = (char*) calloc (fn->block_count, 1);
+    int* stack = (int*) calloc (fn->block_count + 1, sizeof(int));
+    if (!reachable || !stack)
+    {
+        free (reachable);
+        free (stack);
+        return;
+    }
+
+    int top = 0;
+    stack[top++] = 0;
+    reachable[0] = 1;
+
+    while (top > 0)
+    {
+        IrBlock* block = &fn->blocks[stack[--top]];
+        for (int s = 0; s < IrSuccCount (block); s++)
+        {
+            int succ = block->succ[s];
+            if (succ >= 0 && !reachable[succ])
+            {
+                reachable[succ] = 1;
+                stack[top++] = succ;
+            }
+        }
+    }
+
+    for (int b = 0; b < fn->block_count; b++)
+    {
+        IrBlock* block = &fn->blocks[b];
+        if (reachable[b] || block->removed) continue;
+
+        for (int s = 0; s < IrSuccCount (block); s++)
+        {
+            if (block->succ[s] >= 0 && reachable[block->succ[s]])
+                IrRemovePred (fn, block->succ[s], b);
+        }
+
+        for (int i = 0; i < block->value_count; i++)
+            fn->values[block->values[i]].removed = 1;
+
+        block->removed = 1;
+        block->value_count = 0;
+        block->term = IR_TERM_NONE;
+    }
+
+    free (reachable);
+    free (stack);
+}
+
+// =====================  (Cooper, Harvey, Kennedy) =====================
+
+static void PostorderVisit (const IrFunction* fn, int block, char* visited, int* order, int* count)
+{
+    visited[block] = 1;
+
+    const IrBlock* b = &fn->blocks[block];
+    for (int s = IrSuccCount (b) - 1; s >= 0; s--)
+    {
+        int succ = b->succ[s];
+        if (succ >= 0 && !visited[succ] && !fn->blocks[succ].removed)
+            PostorderVisit (fn, succ, visited, order, count);
+    }
+
+    order[(*count)++] = block;
+}
+
+int* IrReversePostorder (const IrFunction* fn, int* count)
+{
+    *count = 0;
+
+    char* visited = (char*) calloc (fn->block_count + 1, 1);
+    int* order = (int*) calloc (fn->block_count + 1, sizeof(int));
+    if (!visited || !order)
+    {
+        free (visited);
+        free (order);
+        return NULL;
+    }
+
+    if (fn->block_count > 0)
+        PostorderVisit (fn, 0, visited, order, count);
+
+    for (int i = 0; i < *count / 2; i++)
+    {
+        int tmp = order[i];
+        order[i] = order[*count - 1 - i];
+        order[*count - 1 - i] = tmp;
+    }
+
+    free (visited);
+    return order;
+}
+
+int* IrComputeDominators (const IrFunction* fn)
+{
+    int count = 0;
+    int* rpo = IrReversePostorder (fn, &count);
+    int* idom = (int*) calloc (fn->block_count + 1, sizeof(int));
+    int* rpo_index = (int*) calloc (fn->block_count + 1, sizeof(int));
+
+    if (!rpo || !idom || !rpo_index)
+    {
+        free (rpo);
+        free (idom);
+        free (rpo_index);
+        return NULL;
+    }
+
+    for (int b = 0; b < fn->block_count; b++)
+    {
+        idom[b] = -1;
+        rpo_index[b] = -1;
+    }
+
+    for (int i = 0; i < count; i++)
+        rpo_index[rpo[i]] = i;
+
+    if (count > 0) idom[rpo[0]] = rpo[0];
+
+    int changed = 1;
+    while (changed)
+    {
+        changed = 0;
+        for (int i = 1; i < count; i++)
+        {
+            int b = rpo[i];
+            int new_idom = -1;
+
+            const IrBlock* block = &fn->blocks[b];
+            for (int p = 0; p < block->pred_count; p++)
+            {
+                int pred = block->preds[p];
+                if (rpo_index[pred] < 0 || idom[pred] < 0) continue;
+
+                if (new_idom < 0)
+                {
+                    new_idom = pred;
+                    continue;
+                }
+
+                int x = pred;
+                int y = new_idom;
+                while (x != y)
+                {
+                    while (rpo_index[x] > rpo_index[y]) x = idom[x];
+                    while (rpo_index[y] > rpo_index[x]) y = idom[y];
+                }
+                new_idom = x;
+            }
+
+            if (new_idom >= 0 && idom[b] != new_idom)
+            {
+                idom[b] = new_idom;
+                changed = 1;
+            }
+        }
+    }
+
+    free (rpo);
+    free (rpo_index);
+    return idom;
+}
+
+int IrDominates (const int* idom, int a, int b)
+{
+    while (b >= 0)
+    {
+        if (a == b) return 1;
+        if (idom[b] == b) return 0;
+        b = idom[b];
+    }
+
+    return 0;
+}
+
+// =====================  =====================
+
+static const char* IrOpcodeName (IrOpcode op)
+{
+    switch (op)
+    {
+        case IR_CONST:        return "const";
+        case IR_PHI:          return "phi";
+        case IR_ADD:          return "add";
+        case IR_SUB:          return "sub";
+        case IR_MUL:          return "mul";
+        case IR_DIV:          return "div";
+        case IR_EQ:           return "eq";
+        case IR_NE:           return "ne";
+        case IR_GT:           return "gt";
+        case IR_LT:           return "lt";
+        case IR_LOAD_GLOBAL:  return "load";
+        case IR_STORE_GLOBAL: return "store";
+        case IR_CALL:         return "call";
+        case IR_PARAM:        return "param";
+        case IR_CONVERT:      return "convert";
+        default:              return "?";
+    }
+}
+
+static const char* IrTypeName (NodeType type)
+{
+    switch (type)
+    {
+        case NODE_TYPE_INT:  return "int";
+        case NODE_TYPE_CHAR: return "char";
+        default:             return "double";
+    }
+}
+
+void DumpIr (const IrFunction* fn, FILE* file)
+{
+    if (!fn || !file) return;
+
+    fprintf (file, "; IR  %s\n", fn->name);
+
+    for (int b = 0; b < fn->block_count; b++)
+    {
+        const IrBlock* block = &fn->blocks[b];
+        if (block->removed) continue;
+
+        fprintf (file, ";   b%d ( %d, :", b, block->loop_depth);
+        for (int p = 0; p < block->pred_count; p++)
+            fprintf (file, " b%d", block->preds[p]);
+        fprintf (file, ")\n");
+
+        for (int i = 0; i < block->value_count; i++)
+        {
+            int id = block->values[i];
+            const IrValue* v = &fn->values[id];
+
+            fprintf (file, ";     v%d:%s = %s", id, IrTypeName (v->type), IrOpcodeName (v->op));
+            if (v->op == IR_CONST || v->op == IR_PARAM) fprintf (file, " %g", v->number);
+            if (v->name) fprintf (file, " %s", v->name);
+
+            for (int a = 0; a < v->arg_count; a++)
+            {
+                if (v->op == IR_PHI && a < block->pred_count)
+                    fprintf (file, " [v%d, b%d]", v->args[a], block->preds[a]);
+                else
+                    fprintf (file, " v%d", v->args[a]);
+            }
+            fprintf (file, "\n");
+        }
+
+        switch (block->term)
+        {
+            case IR_TERM_JUMP:
+                fprintf (file, ";     jump b%d\n", block->succ[0]);
+                break;
+            case IR_TERM_BRANCH:
+                fprintf (file, ";     branch v%d b%d b%d\n", block->term_value, block->succ[0], block->succ[1]);
+                break;
+            case IR_TERM_RETURN:
+                fprintf (file, ";     return v%d\n", block->term_value);
+                break;
+            default:
+                fprintf (file, ";     < >\n");
+                break;
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef SSA_IR_H
+#define SSA_IR_H
+
+#include "tree_base.h"
+#include "create_asm_code_from_tree.h"
+#include <stdio.h>
+
+enum IrOpcode
+{
+    IR_CONST,
+    IR_PHI,
+    IR_ADD,
+    IR_SUB,
+    IR_MUL,
+    IR_DIV,
+    IR_EQ,
+    IR_NE,
+    IR_GT,
+    IR_LT,
+    IR_LOAD_GLOBAL,
+    IR_STORE_GLOBAL,
+    IR_CALL,            // args -   ,    
+    IR_PARAM,           // number -  ,     
+    IR_CONVERT          // args[0],   type
+};
+
+enum IrTerminator
+{
+    IR_TERM_NONE,
+    IR_TERM_JUMP,       // succ[0]
+    IR_TERM_BRANCH,     // term_value != 0 ? succ[0] : succ[1]
+    IR_TERM_RETURN      // term_value  -1
+};
+
+struct IrValue
+{
+    IrOpcode op;
+    NodeType type;      //  : NODE_TYPE_INT, _CHAR  _DOUBLE
+    int block;
+    double number;
+    char* name;         //     
+    int* args;          //  phi -      
+    int arg_count;
+    int arg_capacity;
+    int replaced_by;
+    int removed;
+};
+
+struct IrBlock
+{
+    int* values;        // phi  
+    int value_count;
+    int value_capacity;
+
+    int* preds;
+    int pred_count;
+    int pred_capacity;
+
+    IrTerminator term;
+    int term_value;
+    int succ[2];
+
+    int* defs;          //    
+    int* incomplete;    //  (, phi)   
+    int incomplete_count;
+    int incomplete_capacity;
+    int sealed;
+
+    int loop_depth;
+    int removed;
+};
+
+struct IrFunction
+{
+    char* name;
+
+    IrValue* values;
+    int value_count;
+    int value_capacity;
+
+    IrBlock* blocks;
+    int block_count;
+    int block_capacity;
+
+    char** vars;
+    NodeType* var_types;
+    int var_count;
+
+    int param_count;
+    NodeType return_type;
+};
+
+const int IR_MAX_OPT_LEVEL = 2;
+
+IrFunction* BuildIr (Node* func, CodeGenContext* ctx);
+void FreeIr (IrFunction* fn);
+void DumpIr (const IrFunction* fn, FILE* file);
+
+int IrNewBlock (IrFunction* fn, int loop_depth);
+int IrNewValue (IrFunction* fn, int block, IrOpcode op);
+void IrAddArg (IrFunction* fn, int value, int arg);
+void IrAddPred (IrFunction* fn, int block, int pred);
+void IrRemovePred (IrFunction* fn, int block, int pred);
+int IrResolve (const IrFunction* fn, int value);
+int IrIsPure (IrOpcode op);
+int IrIsCommutative (IrOpcode op);
+int IrSuccCount (const IrBlock* block);
+void IrCompact (IrFunction* fn);
+void IrRemoveUnreachable (IrFunction* fn);
+void IrRemoveTrivialPhis (IrFunction* fn);
+
+int* IrReversePostorder (const IrFunction* fn, int* count);
+int* IrComputeDominators (const IrFunction* fn);
+int IrDominates (const int* idom, int a, int b);
+
+void IrSparseConditionalConstants (IrFunction* fn);
+void IrDeadCodeElimination (IrFunction* fn);
+void IrGlobalValueNumbering (IrFunction* fn);
+void IrLoopInvariantCodeMotion (IrFunction* fn);
+void OptimizeIr (IrFunction* fn, int opt_level);
+
+void LowerIr (CodeGenContext* ctx, IrFunction* fn, int func_label);
+void GenFunctionFromIr (CodeGenContext* ctx, Node* func, int func_label);
+
+#endif
@@ -0,0 +1,1073 @@
+#include "ssa_ir.h"
+#include "register_allocation.h"
+#include "calling_convention.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const int MAX_TEMP_NAME = 64;
+const int MAX_SAVED_SLOTS = 256;
+
+struct LowerState
+{
+    CodeGenContext* ctx;
+    IrFunction* fn;
+    int func_label;
+
+    int* layout;
+    int layout_count;
+
+    int* use_count;
+    int* user;          //   ()  -1
+    int* user_block;    // ,    
+    char* inlined;      //       
+    char* materialized; //      
+
+    int* position;
+    int* block_start;
+    int* block_end;
+    int* block_label;
+    char* label_needed;
+
+    int* slot_reg;
+    int* slot_addr;
+    int* live_start;
+    int* live_end;
+    int* params;        // IR_PARAM     -1,    
+    int callee_saved;
+    int entry_label;    //   RBX/R12/R13:    
+};
+
+static void PushIndex (int** array, int* count, int value)
+{
+    int* new_array = (int*) realloc (*array, (*count + 1) * sizeof(int));
+    if (!new_array) return;
+    *array = new_array;
+    (*array)[(*count)++] = value;
+}
+
+static int IsImpure (IrOpcode op)
+{
+    return op == IR_CALL || op == IR_LOAD_GLOBAL || op == IR_STORE_GLOBAL;
+}
+
+//      ,  
+//       
+static int IsImpureTree (const LowerState* state, int id)
+{
+    const IrValue* v = &state->fn->values[id];
+    if (IsImpure (v->op)) return 1;
+
+    for (int a = 0; a < v->arg_count; a++)
+        if (state->inlined[v->args[a]] && IsImpureTree (state, v->args[a])) return 1;
+
+    return 0;
+}
+
+static int IsCompare (IrOpcode op)
+{
+    return op == IR_EQ || op == IR_NE || op == IR_GT || op == IR_LT;
+}
+
+//      phi :  phi    
+static void SplitCriticalEdges (LowerState* state)
+{
+    IrFunction* fn = state->fn;
+    int original_count = fn->block_count;
+
+    for (int s = 0; s < original_count; s++)
+    {
+        if (fn->blocks[s].removed || fn->blocks[s].pred_count < 2) continue;
+
+        int has_phi = 0;
+        for (int i = 0; i < fn->blocks[s].value_count; i++)
+            if (fn->values[fn->blocks[s].values[i]].op == IR_PHI) has_phi = 1;
+
+        if (!has_phi) continue;
+
+        for (int p = 0; p < fn->blocks[s].pred_count; p++)
+        {
+            int pred = fn->blocks[s].preds[p];
+            if (IrSuccCount (&fn->blocks[pred]) < 2) continue;
+
+            int edge = IrNewBlock (fn, fn->blocks[s].loop_depth);
+            if (edge < 0) continue;
+
+            IrBlock* edge_block = &fn->blocks[edge];
+            edge_block->term = IR_TERM_JUMP;
+            edge_block->succ[0] = s;
+            edge_block->sealed = 1;
+            IrAddPred (fn, edge, pred);
+
+            IrBlock* pred_block = &fn->blocks[pred];
+            for (int k = 0; k < 2; k++)
+                if (pred_block->succ[k] == s) pred_block->succ[k] = edge;
+
+            fn->blocks[s].preds[p] = edge;
+        }
+    }
+
+    //      -
+    for (int b = 0; b < original_count; b++)
+    {
+        if (fn->blocks[b].removed) continue;
+
+        for (int e = original_count; e < fn->block_count; e++)
+            if (fn->blocks[e].succ[0] == b)
+                PushIndex (&state->layout, &state->layout_count, e);
+
+        PushIndex (&state->layout, &state->layout_count, b);
+    }
+}
+
+static int ValueIndexInBlock (const IrBlock* block, int id)
+{
+    for (int i = 0; i < block->value_count; i++)
+        if (block->values[i] == id) return i;
+
+    return block->value_count;
+}
+
+static void FindParams (LowerState* state)
+{
+    IrFunction* fn = state->fn;
+
+    for (int index = 0; index < fn->param_count; index++)
+        state->params[index] = -1;
+
+    for (int id = 0; id < fn->value_count; id++)
+    {
+        IrValue* v = &fn->values[id];
+        if (!v->removed && v->op == IR_PARAM && !fn->blocks[v->block].removed)
+            state->params[(int) v->number] = id;
+    }
+}
+
+static void CountUses (LowerState* state)
+{
+    IrFunction* fn = state->fn;
+
+    for (int b = 0; b < fn->block_count; b++)
+    {
+        IrBlock* block = &fn->blocks[b];
+        if (block->removed) continue;
+
+        for (int i = 0; i < block->value_count; i++)
+        {
+            int id = block->values[i];
+            IrValue* v = &fn->values[id];
+
+            for (int a = 0; a < v->arg_count; a++)
+            {
+                int arg = v->args[a];
+                state->use_count[arg]++;
+
+                if (v->op == IR_PHI)
+                {
+                    //  phi    
+                    state->user[arg] = -1;
+                    state->user_block[arg] = block->preds[a];
+                }
+                else
+                {
+                    state->user[arg] = id;
+                    state->user_block[arg] = b;
+                }
+            }
+        }
+
+        if (block->term_value >= 0)
+        {
+            state->use_count[block->term_value]++;
+            state->user[block->term_value] = -1;
+            state->user_block[block->term_value] = b;
+        }
+    }
+}
+
+//            
+static void ChooseInlined (LowerState* state)
+{
+    IrFunction* fn = state->fn;
+
+    for (int b = 0; b < fn->block_count; b++)
+    {
+        IrBlock* block = &fn->blocks[b];
+        if (block->removed) continue;
+
+        for (int i = 0; i < block->value_count; i++)
+        {
+            int id = block->values[i];
+            IrValue* v = &fn->values[id];
+
+            if (v->op == IR_CONST || v->op == IR_PHI || v->op == IR_STORE_GLOBAL) continue;
+
+            if (state->use_count[id] == 0)
+                continue;
+
+            //      
+            if (v->op == IR_PARAM)
+            {
+                state->materialized[id] = 1;
+                continue;
+            }
+
+            if (state->use_count[id] == 1 && state->user_block[id] == b)
+            {
+                int use_index = state->user[id] >= 0 ? ValueIndexInBlock (block, state->user[id])
+                                                     : block->value_count;
+                int safe = use_index > i;
+
+                if (safe && IsImpureTree (state, id))
+                {
+                    for (int k = i + 1; k < use_index; k++)
+                        if (IsImpure (fn->values[block->values[k]].op)) safe = 0;
+                }
+
+                if (safe)
+                {
+                    state->inlined[id] = 1;
+                    continue;
+                }
+            }
+
+            state->materialized[id] = 1;
+        }
+    }
+
+    for (int id = 0; id < fn->value_count; id++)
+    {
+        IrValue* v = &fn->values[id];
+        if (!v->removed && v->op == IR_PHI && !fn->blocks[v->block].removed)
+            state->materialized[id] = 1;
+    }
+}
+
+static void NumberEmitted (LowerState* state, int id, int* pos);
+
+static void NumberOperand (LowerState* state, int id, int* pos)
+{
+    if (state->inlined[id])
+        NumberEmitted (state, id, pos);
+}
+
+//       ,   ,
+//     EmitValue:      
+static void NumberEmitted (LowerState* state, int id, int* pos)
+{
+    IrValue* v = &state->fn->values[id];
+
+    if (v->op == IR_CALL)
+    {
+        for (int a = v->arg_count - 1; a >= 0; a--)
+            NumberOperand (state, v->args[a], pos);
+    }
+    else
+    {
+        for (int a = 0; a < v->arg_count; a++)
+            NumberOperand (state, v->args[a], pos);
+    }
+
+    state->position[id] = (*pos)++;
+}
+
+//      ,   -  
+// : CALL         ,
+//       
+static void NumberPositions (LowerState* state)
+{
+    IrFunction* fn = state->fn;
+    int pos = 0;
+
+    for (int id = 0; id < fn->value_count; id++)
+        state->position[id] = -1;
+
+    for (int l = 0; l < state->layout_count; l++)
+    {
+        int b = state->layout[l];
+        IrBlock* block = &fn->blocks[b];
+
+        state->block_start[b] = pos++;
+        for (int i = 0; i < block->value_count; i++)
+        {
+            int id = block->values[i];
+            IrValue* v = &fn->values[id];
+
+            if (v->op == IR_PHI)
+                state->position[id] = state->block_start[b];
+            else if (!state->inlined[id])
+                NumberEmitted (state, id, &pos);
+        }
+
+        //  phi      ,   EmitBlocks
+        if (block->term == IR_TERM_JUMP)
+        {
+            IrBlock* succ = &fn->blocks[block->succ[0]];
+            int pred_index = -1;
+            for (int p = 0; p < succ->pred_count; p++)
+                if (succ->preds[p] == b) pred_index = p;
+
+            for (int i = 0; pred_index >= 0 && i < succ->value_count; i++)
+            {
+                IrValue* phi = &fn->values[succ->values[i]];
+                if (phi->op == IR_PHI && pred_index < phi->arg_count)
+                    NumberOperand (state, phi->args[pred_index], &pos);
+            }
+        }
+        else if (block->term_value >= 0)
+            NumberOperand (state, block->term_value, &pos);
+
+        state->block_end[b] = pos++;
+
+        //    ( ) -    
+        for (int i = 0; i < block->value_count; i++)
+            if (state->position[block->values[i]] < 0)
+                state->position[block->values[i]] = state->block_end[b];
+    }
+}
+
+// ,    
+static int EmitPosition (LowerState* state, int id)
+{
+    return state->position[id];
+}
+
+static int UsePosition (LowerState* state, int user)
+{
+    return EmitPosition (state, user);
+}
+
+static void ExtendInterval (LiveInterval* interval, int pos)
+{
+    if (pos < interval->start) interval->start = pos;
+    if (pos > interval->end) interval->end = pos;
+}
+
+static int LoopWeight (int depth)
+{
+    int weight = 1;
+    for (int i = 0; i < depth && i < MAX_LOOP_WEIGHT_DEPTH; i++)
+        weight *= 10;
+
+    return weight;
+}
+
+static void AllocateSlots (LowerState* state)
+{
+    IrFunction* fn = state->fn;
+    int value_count = fn->value_count;
+
+    int* interval_of = (int*) calloc (value_count + 1, sizeof(int));
+    LiveInterval* intervals = (LiveInterval*) calloc (value_count + 1, sizeof(LiveInterval));
+    char* live_in = (char*) calloc ((size_t) fn->block_count * value_count + 1, 1);
+    char* live_out = (char*) calloc ((size_t) fn->block_count * value_count + 1, 1);
+
+    if (!interval_of || !intervals || !live_in || !live_out)
+    {
+        free (interval_of);
+        free (intervals);
+        free (live_in);
+        free (live_out);
+        return;
+    }
+
+    int interval_count = 0;
+    for (int id = 0; id < value_count; id++)
+    {
+        interval_of[id] = -1;
+        if (!state->materialized[id]) continue;
+
+        LiveInterval* interval = &intervals[interval_count];
+        interval->start = state->position[id];
+        interval->end = state->position[id];
+        interval->weight = LoopWeight (fn->blocks[fn->values[id].block].loop_depth);
+        interval->reg = -1;
+        interval_of[id] = interval_count++;
+    }
+
+    //   phi:        
+    for (int b = 0; b < fn->block_count; b++)
+    {
+        IrBlock* block = &fn->blocks[b];
+        if (block->removed) continue;
+
+        char* in = &live_in[(size_t) b * value_count];
+
+        for (int i = 0; i < block->value_count; i++)
+        {
+            IrValue* v = &fn->values[block->values[i]];
+            if (v->op == IR_PHI) continue;
+
+            for (int a = 0; a < v->arg_count; a++)
+            {
+                int arg = v->args[a];
+                if (state->materialized[arg] && fn->values[arg].block != b)
+                    in[arg] = 1;
+            }
+        }
+
+        int term = block->term_value;
+        if (term >= 0 && state->materialized[term] && fn->values[term].block != b)
+            in[term] = 1;
+    }
+
+    //     
+    int changed = 1;
+    while (changed)
+    {
+        changed = 0;
+        for (int l = state->layout_count - 1; l >= 0; l--)
+        {
+            int b = state->layout[l];
+            IrBlock* block = &fn->blocks[b];
+            char* out = &live_out[(size_t) b * value_count];
+            char* in = &live_in[(size_t) b * value_count];
+
+            for (int s = 0; s < IrSuccCount (block); s++)
+            {
+                int succ = block->succ[s];
+                IrBlock* succ_block = &fn->blocks[succ];
+                char* succ_in = &live_in[(size_t) succ * value_count];
+
+                for (int id = 0; id < value_count; id++)
+                {
+                    if (succ_in[id] && !out[id])
+                    {
+                        out[id] = 1;
+                        changed = 1;
+                    }
+                }
+
+                int pred_index = -1;
+                for (int p = 0; p < succ_block->pred_count; p++)
+                    if (succ_block->preds[p] == b) pred_index = p;
+
+                for (int i = 0; pred_index >= 0 && i < succ_block->value_count; i++)
+                {
+                    IrValue* phi = &fn->values[succ_block->values[i]];
+                    if (phi->op != IR_PHI || pred_index >= phi->arg_count) continue;
+
+                    int arg = phi->args[pred_index];
+                    if (state->materialized[arg] && !out[arg])
+                    {
+                        out[arg] = 1;
+                        changed = 1;
+                    }
+                }
+            }
+
+            for (int id = 0; id < value_count; id++)
+            {
+                if (out[id] && !in[id] && fn->values[id].block != b)
+                {
+                    in[id] = 1;
+                    changed = 1;
+                }
+            }
+        }
+    }
+
+    for (int l = 0; l < state->layout_count; l++)
+    {
+        int b = state->layout[l];
+        IrBlock* block = &fn->blocks[b];
+
+        for (int id = 0; id < value_count; id++)
+        {
+            if (interval_of[id] < 0) continue;
+            LiveInterval* interval = &intervals[interval_of[id]];
+
+            if (live_in[(size_t) b * value_count + id])
+                ExtendInterval (interval, state->block_start[b]);
+            if (live_out[(size_t) b * value_count + id])
+                ExtendInterval (interval, state->block_end[b]);
+        }
+
+        for (int i = 0; i < block->value_count; i++)
+        {
+            int id = block->values[i];
+            IrValue* v = &fn->values[id];
+
+            for (int a = 0; a < v->arg_count; a++)
+            {
+                int arg = v->args[a];
+                if (interval_of[arg] < 0) continue;
+
+                LiveInterval* interval = &intervals[interval_of[arg]];
+                int pos = v->op == IR_PHI ? state->block_end[block->preds[a]] : UsePosition (state, id);
+                ExtendInterval (interval, pos);
+                interval->weight += LoopWeight (block->loop_depth);
+            }
+
+            // phi      
+            if (v->op == IR_PHI && interval_of[id] >= 0)
+            {
+                for (int p = 0; p < block->pred_count; p++)
+                    ExtendInterval (&intervals[interval_of[id]], state->block_end[block->preds[p]]);
+            }
+        }
+
+        if (block->term_value >= 0 && interval_of[block->term_value] >= 0)
+        {
+            LiveInterval* interval = &intervals[interval_of[block->term_value]];
+            ExtendInterval (interval, state->block_end[b]);
+            interval->weight += LoopWeight (block->loop_depth);
+        }
+    }
+
+    //  CALL   RBX/R12/R13 -   LinearScan
+    for (int id = 0; id < value_count; id++)
+    {
+        if (fn->values[id].removed || fn->values[id].op != IR_CALL) continue;
+
+        int call_pos = EmitPosition (state, id);
+        for (int i = 0; i < interval_count; i++)
+            if (call_pos > intervals[i].start && call_pos < intervals[i].end)
+                intervals[i].crosses_call = 1;
+    }
+
+    //   AllocateRegisters:   -  ,  
+    //       -
+    for (int index = 0; index < fn->param_count; index++)
+    {
+        int id = state->params[index];
+        if (id < 0 || interval_of[id] < 0) continue;
+
+        LiveInterval* interval = &intervals[interval_of[id]];
+        if (index >= ARG_REG_COUNT)
+        {
+            interval->fixed = 1;
+            interval->reg = -1;
+        }
+        else if (!interval->crosses_call)
+        {
+            interval->fixed = 1;
+            interval->reg = ARG_REG_FIRST + index;
+        }
+    }
+
+    LinearScan (intervals, interval_count, ALLOC_REG_COUNT);
+    state->callee_saved = CalleeSavedMask (intervals, interval_count);
+
+    for (int id = 0; id < value_count; id++)
+    {
+        state->slot_reg[id] = -1;
+        state->slot_addr[id] = -1;
+
+        if (interval_of[id] < 0) continue;
+
+        state->live_start[id] = intervals[interval_of[id]].start;
+        state->live_end[id] = intervals[interval_of[id]].end;
+        state->slot_reg[id] = intervals[interval_of[id]].reg;
+        if (state->slot_reg[id] < 0)
+        {
+            char name[MAX_TEMP_NAME] = "";
+            snprintf (name, sizeof(name), "%%t%d_%d", state->func_label, id);
+            state->slot_addr[id] = AddVariable (state->ctx, name, 1, NODE_TYPE_DOUBLE);
+        }
+    }
+
+    free (interval_of);
+    free (intervals);
+    free (live_in);
+    free (live_out);
+}
+
+static void EmitLoadSlot (LowerState* state, int id)
+{
+    FILE* out = state->ctx->output;
+
+    if (state->slot_reg[id] >= 0)
+    {
+        fprintf (out, "PUSHR %s\n", RegisterName (state->slot_reg[id]));
+        return;
+    }
+
+    fprintf (out, "PUSH %d\n", state->slot_addr[id]);
+    fprintf (out, "POPR RAX\n");
+    fprintf (out, "PUSHM RAX\n");
+}
+
+static void EmitStoreSlot (LowerState* state, int id)
+{
+    FILE* out = state->ctx->output;
+
+    if (state->slot_reg[id] >= 0)
+    {
+        fprintf (out, "POPR %s\n", RegisterName (state->slot_reg[id]));
+        return;
+    }
+
+    fprintf (out, "PUSH %d\n", state->slot_addr[id]);
+    fprintf (out, "POPR RAX\n");
+    fprintf (out, "POPM RAX\n");
+}
+
+static int SameSlot (LowerState* state, int a, int b)
+{
+    if (!state->materialized[a] || !state->materialized[b]) return 0;
+    if (state->slot_reg[a] >= 0) return state->slot_reg[a] == state->slot_reg[b];
+
+    return state->slot_reg[b] < 0 && state->slot_addr[a] == state->slot_addr[b];
+}
+
+static void EmitValue (LowerState* state, int id);
+
+static void EmitOperand (LowerState* state, int id)
+{
+    IrValue* v = &state->fn->values[id];
+
+    if (v->op == IR_CONST)
+        GenPushConstant (state->ctx, v->number, v->type);
+    else if (state->inlined[id])
+        EmitValue (state, id);
+    else
+        EmitLoadSlot (state, id);
+}
+
+static const char* JumpForCompare (IrOpcode op, int when_true)
+{
+    switch (op)
+    {
+        case IR_GT: return when_true ? "JA"  : "JBE";
+        case IR_LT: return when_true ? "JB"  : "JAE";
+        case IR_EQ: return when_true ? "JE"  : "JNE";
+        case IR_NE: return when_true ? "JNE" : "JE";
+        default:    return "JMP";
+    }
+}
+
+//   :   ,   , 
+// .       .
+static int CollectCallerSaved (LowerState* state, int call, CallSaveSlot* slots)
+{
+    int call_pos = EmitPosition (state, call);
+    int count = 0;
+
+    for (int id = 0; id < state->fn->value_count && count < MAX_SAVED_SLOTS; id++)
+    {
+        if (!state->materialized[id] || state->slot_reg[id] >= 0 || state->slot_addr[id] < 0) continue;
+        if (call_pos <= state->live_start[id] || call_pos >= state->live_end[id]) continue;
+
+        slots[count].reg = -1;
+        slots[count].address = state->slot_addr[id];
+        count++;
+    }
+
+    return count;
+}
+
+static void EmitArguments (LowerState* state, IrValue* call)
+{
+    for (int a = call->arg_count - 1; a >= 0; a--)
+        EmitOperand (state, call->args[a]);
+
+    EmitArgumentPops (state->ctx->output, call->arg_count);
+}
+
+static void EmitValue (LowerState* state, int id)
+{
+    CodeGenContext* ctx = state->ctx;
+    FILE* out = ctx->output;
+    IrValue* v = &state->fn->values[id];
+
+    switch (v->op)
+    {
+        case IR_CONST:
+            GenPushConstant (ctx, v->number, v->type);
+            break;
+
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+            EmitOperand (state, v->args[0]);
+            EmitOperand (state, v->args[1]);
+            fprintf (out, "%s%s\n", TypedOpcodePrefix (v->type),
+                     v->op == IR_ADD ? "ADD" : v->op == IR_SUB ? "SUB" : v->op == IR_MUL ? "MUL" : "DIV");
+            break;
+
+        case IR_CONVERT:
+            EmitOperand (state, v->args[0]);
+            GenConvert (ctx, state->fn->values[v->args[0]].type, v->type);
+            break;
+
+        case IR_EQ:
+        case IR_NE:
+        case IR_GT:
+        case IR_LT:
+        {
+            EmitOperand (state, v->args[0]);
+            EmitOperand (state, v->args[1]);
+
+            int true_label = NewLabel (ctx);
+            int end_label = NewLabel (ctx);
+
+            fprintf (out, "%s%s :label_%d\n", TypedOpcodePrefix (state->fn->values[v->args[0]].type),
+                     JumpForCompare (v->op, 1), true_label);
+            fprintf (out, "IPUSH 0\n");
+            fprintf (out, "JMP :label_%d\n", end_label);
+            fprintf (out, ":label_%d\n", true_label);
+            fprintf (out, "IPUSH 1\n");
+            fprintf (out, ":label_%d\n", end_label);
+            break;
+        }
+
+        case IR_LOAD_GLOBAL:
+        {
+            int addr = GetVarAddress (ctx, v->name);
+            fprintf (out, "PUSH %d\n", addr);
+            fprintf (out, "POPR RAX\n");
+            fprintf (out, "%s RAX\n", LoadOpcode (v->type));
+            break;
+        }
+
+        case IR_STORE_GLOBAL:
+        {
+            EmitOperand (state, v->args[0]);
+            int addr = GetVarAddress (ctx, v->name);
+            fprintf (out, "PUSH %d\n", addr);
+            fprintf (out, "POPR RAX\n");
+            fprintf (out, "%s RAX\n", StoreOpcode (v->type));
+            break;
+        }
+
+        case IR_CALL:
+        {
+            int func_label = FindFunctionLabel (ctx, v->name);
+            if (func_label < 0)
+            {
+                fprintf (out, "; :  '%s'  \n", v->name);
+                GenPushConstant (ctx, 0, v->type);
+                break;
+            }
+
+            CallSaveSlot saved[MAX_SAVED_SLOTS] = {};
+            int saved_count = CollectCallerSaved (state, id, saved);
+
+            EmitSaveSlots (out, saved, saved_count);
+            EmitArguments (state, v);
+            fprintf (out, "CALL :func_%d\n", func_label);
+            EmitRestoreSlots (out, saved, saved_count);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+//      ,  
+static void EmitStackParamPops (LowerState* state)
+{
+    for (int index = ARG_REG_COUNT; index < state->fn->param_count; index++)
+    {
+        int id = state->params[index];
+        if (id >= 0 && state->materialized[id])
+            EmitStoreSlot (state, id);
+        else
+            fprintf (state->ctx->output, "POPR RAX\n");
+    }
+}
+
+// ,     return,     : 
+// CALL + RET - ,       .
+//      RBX/R12/R13,  
+//  .   -       :
+//      -   .
+//         IR_CONVERT    .
+static int EmitTailCall (LowerState* state, int value)
+{
+    if (value < 0 || !state->inlined[value]) return 0;
+
+    IrValue* v = &state->fn->values[value];
+    if (v->op != IR_CALL) return 0;
+
+    int func_label = FindFunctionLabel (state->ctx, v->name);
+    if (func_label < 0) return 0;
+
+    int self = func_label == state->func_label;
+    if (!self && v->arg_count > ARG_REG_COUNT) return 0;
+
+    fprintf (state->ctx->output, ";   %s\n", v->name);
+    EmitArguments (state, v);
+
+    if (self)
+    {
+        EmitStackParamPops (state);
+        fprintf (state->ctx->output, "JMP :label_%d\n", state->entry_label);
+        return 1;
+    }
+
+    EmitCalleeSavedRestore (state->ctx->output, state->callee_saved);
+    fprintf (state->ctx->output, "JMP :func_%d\n", func_label);
+    return 1;
+}
+
+//      RBX/R12/R13,   
+static void EmitPrologue (LowerState* state)
+{
+    FILE* out = state->ctx->output;
+
+    EmitStackParamPops (state);
+    EmitCalleeSavedPrologue (out, state->callee_saved);
+
+    state->entry_label = NewLabel (state->ctx);
+    fprintf (out, ":label_%d\n", state->entry_label);
+
+    for (int index = 0; index < state->fn->param_count && index < ARG_REG_COUNT; index++)
+    {
+        int id = state->params[index];
+        if (id < 0 || !state->materialized[id] || state->slot_reg[id] == ARG_REG_FIRST + index) continue;
+
+        fprintf (out, "PUSHR %s\n", RegisterName (ARG_REG_FIRST + index));
+        EmitStoreSlot (state, id);
+    }
+}
+
+//     :   ,  
+static void EmitPhiCopies (LowerState* state, int from, int to)
+{
+    IrFunction* fn = state->fn;
+    IrBlock* succ = &fn->blocks[to];
+
+    int pred_index = -1;
+    for (int p = 0; p < succ->pred_count; p++)
+        if (succ->preds[p] == from) pred_index = p;
+
+    if (pred_index < 0) return;
+
+    int* dests = NULL;
+    int dest_count = 0;
+
+    for (int i = 0; i < succ->value_count; i++)
+    {
+        int phi = succ->values[i];
+        IrValue* v = &fn->values[phi];
+        if (v->op != IR_PHI || pred_index >= v->arg_count) continue;
+
+        int arg = v->args[pred_index];
+        if (arg == phi || SameSlot (state, arg, phi)) continue;
+
+        EmitOperand (state, arg);
+        PushIndex (&dests, &dest_count, phi);
+    }
+
+    for (int i = dest_count - 1; i >= 0; i--)
+        EmitStoreSlot (state, dests[i]);
+
+    free (dests);
+}
+
+static void EmitBranch (LowerState* state, int b, int next)
+{
+    CodeGenContext* ctx = state->ctx;
+    FILE* out = ctx->output;
+    IrBlock* block = &state->fn->blocks[b];
+
+    int cond = block->term_value;
+    int on_true = block->succ[0];
+    int on_false = block->succ[1];
+    IrValue* c = &state->fn->values[cond];
+
+    const char* true_jump = "JNE";
+    const char* false_jump = "JE";
+    const char* prefix = TypedOpcodePrefix (c->type);
+    int inverse_exact = 1;
+
+    if (IsCompare (c->op) && state->inlined[cond])
+    {
+        EmitOperand (state, c->args[0]);
+        EmitOperand (state, c->args[1]);
+        true_jump = JumpForCompare (c->op, 1);
+        false_jump = JumpForCompare (c->op, 0);
+        prefix = TypedOpcodePrefix (state->fn->values[c->args[0]].type);
+
+        //  NaN  JBE/JAE  ,   :  double
+        //       
+        inverse_exact = prefix[0] == 'I' || c->op == IR_EQ || c->op == IR_NE;
+    }
+    else
+    {
+        EmitOperand (state, cond);
+        GenPushConstant (ctx, 0, c->type);
+    }
+
+    if (on_true == next && !inverse_exact)
+    {
+        fprintf (out, "%s%s :label_%d\n", prefix, true_jump, state->block_label[on_true]);
+        fprintf (out, "JMP :label_%d\n", state->block_label[on_false]);
+    }
+    else if (on_true == next)
+    {
+        fprintf (out, "%s%s :label_%d\n", prefix, false_jump, state->block_label[on_false]);
+    }
+    else if (on_false == next)
+    {
+        fprintf (out, "%s%s :label_%d\n", prefix, true_jump, state->block_label[on_true]);
+    }
+    else
+    {
+        fprintf (out, "%s%s :label_%d\n", prefix, true_jump, state->block_label[on_true]);
+        fprintf (out, "JMP :label_%d\n", state->block_label[on_false]);
+    }
+}
+
+static void EmitBlocks (LowerState* state)
+{
+    CodeGenContext* ctx = state->ctx;
+    FILE* out = ctx->output;
+    IrFunction* fn = state->fn;
+
+    for (int l = 0; l < state->layout_count; l++)
+    {
+        int b = state->layout[l];
+        IrBlock* block = &fn->blocks[b];
+        int next = l + 1 < state->layout_count ? state->layout[l + 1] : -1;
+
+        if (block->term == IR_TERM_JUMP && block->succ[0] != next)
+            state->label_needed[block->succ[0]] = 1;
+
+        if (block->term == IR_TERM_BRANCH)
+        {
+            state->label_needed[block->succ[0]] = 1;
+            state->label_needed[block->succ[1]] = 1;
+        }
+    }
+
+    for (int b = 0; b < fn->block_count; b++)
+        state->block_label[b] = state->label_needed[b] ? NewLabel (ctx) : -1;
+
+    EmitPrologue (state);
+
+    for (int l = 0; l < state->layout_count; l++)
+    {
+        int b = state->layout[l];
+        IrBlock* block = &fn->blocks[b];
+        int next = l + 1 < state->layout_count ? state->layout[l + 1] : -1;
+
+        if (state->label_needed[b])
+            fprintf (out, ":label_%d\n", state->block_label[b]);
+
+        for (int i = 0; i < block->value_count; i++)
+        {
+            int id = block->values[i];
+            IrValue* v = &fn->values[id];
+
+            if (v->op == IR_PHI || v->op == IR_CONST || v->op == IR_PARAM || state->inlined[id]) continue;
+
+            if (state->use_count[id] == 0 && v->op != IR_CALL && v->op != IR_STORE_GLOBAL)
+                continue;
+
+            EmitValue (state, id);
+
+            if (state->materialized[id])
+                EmitStoreSlot (state, id);
+            else if (v->op == IR_CALL)
+                fprintf (out, "POPR RAX\n");   //    
+        }
+
+        switch (block->term)
+        {
+            case IR_TERM_JUMP:
+                EmitPhiCopies (state, b, block->succ[0]);
+                if (block->succ[0] != next)
+                    fprintf (out, "JMP :label_%d\n", state->block_label[block->succ[0]]);
+                break;
+
+            case IR_TERM_BRANCH:
+                EmitBranch (state, b, next);
+                break;
+
+            case IR_TERM_RETURN:
+                if (EmitTailCall (state, block->term_value))
+                    break;
+
+                if (block->term_value >= 0)
+                    EmitOperand (state, block->term_value);
+                else
+                    GenPushConstant (ctx, 0, fn->return_type);
+                EmitCalleeSavedEpilogue (out, state->callee_saved);
+                fprintf (out, "RET\n");
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+void LowerIr (CodeGenContext* ctx, IrFunction* fn, int func_label)
+{
+    if (!ctx || !fn) return;
+
+    LowerState state = {};
+    state.ctx = ctx;
+    state.fn = fn;
+    state.func_label = func_label;
+
+    SplitCriticalEdges (&state);
+
+    int value_count = fn->value_count + 1;
+    int block_count = fn->block_count + 1;
+
+    state.use_count = (int*) calloc (value_count, sizeof(int));
+    state.user = (int*) calloc (value_count, sizeof(int));
+    state.user_block = (int*) calloc (value_count, sizeof(int));
+    state.inlined = (char*) calloc (value_count, 1);
+    state.materialized = (char*) calloc (value_count, 1);
+    state.position = (int*) calloc (value_count, sizeof(int));
+    state.slot_reg = (int*) calloc (value_count, sizeof(int));
+    state.slot_addr = (int*) calloc (value_count, sizeof(int));
+    state.live_start = (int*) calloc (value_count, sizeof(int));
+    state.live_end = (int*) calloc (value_count, sizeof(int));
+    state.params = (int*) calloc (fn->param_count + 1, sizeof(int));
+    state.block_start = (int*) calloc (block_count, sizeof(int));
+    state.block_end = (int*) calloc (block_count, sizeof(int));
+    state.block_label = (int*) calloc (block_count, sizeof(int));
+    state.label_needed = (char*) calloc (block_count, 1);
+
+    if (state.use_count && state.user && state.user_block && state.inlined &&
+        state.materialized && state.position && state.slot_reg && state.slot_addr &&
+        state.live_start && state.live_end && state.params &&
+        state.block_start && state.block_end && state.block_label && state.label_needed)
+    {
+        FindParams (&state);
+        CountUses (&state);
+        ChooseInlined (&state);
+        NumberPositions (&state);
+        AllocateSlots (&state);
+        EmitBlocks (&state);
+    }
+
+    free (state.layout);
+    free (state.use_count);
+    free (state.user);
+    free (state.user_block);
+    free (state.inlined);
+    free (state.materialized);
+    free (state.position);
+    free (state.slot_reg);
+    free (state.slot_addr);
+    free (state.live_start);
+    free (state.live_end);
+    free (state.params);
+    free (state.block_start);
+    free (state.block_end);
+    free (state.block_label);
+    free (state.label_needed);
+}
+
+void GenFunctionFromIr (CodeGenContext* ctx, Node* func, int func_label)
+{
+    IrFunction* fn = BuildIr (func, ctx);
+    if (!fn) return;
+
+    OptimizeIr (fn, ctx->opt_level);
+
+    if (ctx->dump_ir)
+        DumpIr (fn, ctx->output);
+
+    LowerIr (ctx, fn, func_label);
+    FreeIr (fn);
+}
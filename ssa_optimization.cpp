@@ -0,0 +1,810 @@
+#include "ssa_ir.h"
+#include "type_checking.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum LatticeState
+{
+    LATTICE_TOP,
+    LATTICE_CONST,
+    LATTICE_BOTTOM
+};
+
+struct UseList
+{
+    int* users;         // -
+    int count;
+    int capacity;
+    int* term_users;    // ,    
+    int term_count;
+    int term_capacity;
+};
+
+static void PushUse (int** array, int* count, int* capacity, int value)
+{
+    if (*count >= *capacity)
+    {
+        int new_capacity = *capacity ? *capacity * 2 : 4;
+        int* new_array = (int*) realloc (*array, new_capacity * sizeof(int));
+        if (!new_array) return;
+        *array = new_array;
+        *capacity = new_capacity;
+    }
+
+    (*array)[(*count)++] = value;
+}
+
+static UseList* BuildUseLists (const IrFunction* fn)
+{
+    UseList* uses = (UseList*) calloc (fn->value_count + 1, sizeof(UseList));
+    if (!uses) return NULL;
+
+    for (int b = 0; b < fn->block_count; b++)
+    {
+        const IrBlock* block = &fn->blocks[b];
+        if (block->removed) continue;
+
+        for (int i = 0; i < block->value_count; i++)
+        {
+            const IrValue* v = &fn->values[block->values[i]];
+            for (int a = 0; a < v->arg_count; a++)
+            {
+                UseList* list = &uses[v->args[a]];
+                PushUse (&list->users, &list->count, &list->capacity, block->values[i]);
+            }
+        }
+
+        if (block->term_value >= 0)
+        {
+            UseList* list = &uses[block->term_value];
+            PushUse (&list->term_users, &list->term_count, &list->term_capacity, b);
+        }
+    }
+
+    return uses;
+}
+
+static void FreeUseLists (UseList* uses, int count)
+{
+    if (!uses) return;
+
+    for (int i = 0; i < count; i++)
+    {
+        free (uses[i].users);
+        free (uses[i].term_users);
+    }
+
+    free (uses);
+}
+
+static NodeType ArithmeticNode (IrOpcode op)
+{
+    switch (op)
+    {
+        case IR_ADD: return NODE_ADD;
+        case IR_SUB: return NODE_SUB;
+        case IR_MUL: return NODE_MUL;
+        default:     return NODE_DIV;
+    }
+}
+
+//      IADD/IDIV:     
+static int FoldBinary (IrOpcode op, NodeType type, double left, double right, double* result)
+{
+    if (IsIntegerType (type) && op >= IR_ADD && op <= IR_DIV)
+    {
+        if (op == IR_DIV && right == 0) return 0;
+        *result = IntegerArithmetic (ArithmeticNode (op), left, right);
+        return 1;
+    }
+
+    switch (op)
+    {
+        case IR_ADD: *result = left + right; return 1;
+        case IR_SUB: *result = left - right; return 1;
+        case IR_MUL: *result = left * right; return 1;
+        case IR_DIV:
+            if (right == 0) return 0;   //      
+            *result = left / right;
+            return 1;
+        case IR_EQ:  *result = (left == right); return 1;
+        case IR_NE:  *result = (left != right); return 1;
+        case IR_GT:  *result = (left > right);  return 1;
+        case IR_LT:  *result = (left < right);  return 1;
+        default:     return 0;
+    }
+}
+
+// ===================== SCCP (Wegman, Zadeck) =====================
+
+struct SccpState
+{
+    IrFunction* fn;
+    UseList* uses;
+
+    LatticeState* state;
+    double* constant;
+
+    char* block_exec;
+    char** edge_exec;   // [][ ]
+
+    int* flow;          //  (, )
+    int flow_count;
+    int flow_capacity;
+
+    int* ssa;
+    int ssa_count;
+    int ssa_capacity;
+};
+
+static int PredIndex (const IrBlock* block, int pred)
+{
+    for (int i = 0; i < block->pred_count; i++)
+        if (block->preds[i] == pred) return i;
+
+    return -1;
+}
+
+static void SetLattice (SccpState* sccp, int value, LatticeState state, double constant)
+{
+    if (sccp->state[value] == state &&
+        (state != LATTICE_CONST || sccp->constant[value] == constant))
+        return;
+
+    if (sccp->state[value] == LATTICE_BOTTOM) return;
+
+    sccp->state[value] = state;
+    sccp->constant[value] = constant;
+    PushUse (&sccp->ssa, &sccp->ssa_count, &sccp->ssa_capacity, value);
+}
+
+static void EvaluateValue (SccpState* sccp, int id)
+{
+    IrFunction* fn = sccp->fn;
+    IrValue* v = &fn->values[id];
+    if (v->removed || !sccp->block_exec[v->block]) return;
+
+    switch (v->op)
+    {
+        case IR_CONST:
+            SetLattice (sccp, id, LATTICE_CONST, v->number);
+            return;
+
+        case IR_PHI:
+        {
+            IrBlock* block = &fn->blocks[v->block];
+            LatticeState result = LATTICE_TOP;
+            double constant = 0;
+
+            for (int a = 0; a < v->arg_count && a < block->pred_count; a++)
+            {
+                if (!sccp->edge_exec[v->block][a]) continue;
+
+                int arg = v->args[a];
+                if (sccp->state[arg] == LATTICE_TOP) continue;
+
+                if (sccp->state[arg] == LATTICE_BOTTOM ||
+                    (result == LATTICE_CONST && constant != sccp->constant[arg]))
+                {
+                    result = LATTICE_BOTTOM;
+                    break;
+                }
+
+                result = LATTICE_CONST;
+                constant = sccp->constant[arg];
+            }
+
+            SetLattice (sccp, id, result, constant);
+            return;
+        }
+
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_EQ:
+        case IR_NE:
+        case IR_GT:
+        case IR_LT:
+        {
+            int left = v->args[0];
+            int right = v->args[1];
+
+            if (sccp->state[left] == LATTICE_BOTTOM || sccp->state[right] == LATTICE_BOTTOM)
+            {
+                SetLattice (sccp, id, LATTICE_BOTTOM, 0);
+                return;
+            }
+
+            if (sccp->state[left] == LATTICE_TOP || sccp->state[right] == LATTICE_TOP)
+                return;
+
+            double result = 0;
+            if (FoldBinary (v->op, v->type, sccp->constant[left], sccp->constant[right], &result))
+                SetLattice (sccp, id, LATTICE_CONST, result);
+            else
+                SetLattice (sccp, id, LATTICE_BOTTOM, 0);
+            return;
+        }
+
+        case IR_CONVERT:
+        {
+            int arg = v->args[0];
+            if (sccp->state[arg] == LATTICE_TOP) return;
+
+            if (sccp->state[arg] == LATTICE_BOTTOM)
+                SetLattice (sccp, id, LATTICE_BOTTOM, 0);
+            else
+                SetLattice (sccp, id, LATTICE_CONST, ConvertValue (sccp->constant[arg], v->type));
+            return;
+        }
+
+        default:
+            SetLattice (sccp, id, LATTICE_BOTTOM, 0);
+            return;
+    }
+}
+
+static void MarkEdge (SccpState* sccp, int from, int to)
+{
+    PushUse (&sccp->flow, &sccp->flow_count, &sccp->flow_capacity, from);
+    PushUse (&sccp->flow, &sccp->flow_count, &sccp->flow_capacity, to);
+}
+
+static void EvaluateTerminator (SccpState* sccp, int b)
+{
+    IrBlock* block = &sccp->fn->blocks[b];
+
+    if (block->term == IR_TERM_JUMP)
+    {
+        MarkEdge (sccp, b, block->succ[0]);
+    }
+    else if (block->term == IR_TERM_BRANCH)
+    {
+        int cond = block->term_value;
+        if (sccp->state[cond] == LATTICE_CONST)
+        {
+            MarkEdge (sccp, b, sccp->constant[cond] != 0 ? block->succ[0] : block->succ[1]);
+        }
+        else if (sccp->state[cond] == LATTICE_BOTTOM)
+        {
+            MarkEdge (sccp, b, block->succ[0]);
+            MarkEdge (sccp, b, block->succ[1]);
+        }
+    }
+}
+
+void IrSparseConditionalConstants (IrFunction* fn)
+{
+    if (!fn || fn->block_count == 0) return;
+
+    SccpState sccp = {};
+    sccp.fn = fn;
+    sccp.uses = BuildUseLists (fn);
+    sccp.state = (LatticeState*) calloc (fn->value_count + 1, sizeof(LatticeState));
+    sccp.constant = (double*) calloc (fn->value_count + 1, sizeof(double));
+    sccp.block_exec = (char*) calloc (fn->block_count + 1, 1);
+    sccp.edge_exec = (char**) calloc (fn->block_count + 1, sizeof(char*));
+
+    if (!sccp.uses || !sccp.state || !sccp.constant || !sccp.block_exec || !sccp.edge_exec)
+    {
+        FreeUseLists (sccp.uses, fn->value_count);
+        free (sccp.state);
+        free (sccp.constant);
+        free (sccp.block_exec);
+        free (sccp.edge_exec);
+        return;
+    }
+
+    for (int b = 0; b < fn->block_count; b++)
+        sccp.edge_exec[b] = (char*) calloc (fn->blocks[b].pred_count + 1, 1);
+
+    sccp.block_exec[0] = 1;
+    for (int i = 0; i < fn->blocks[0].value_count; i++)
+        EvaluateValue (&sccp, fn->blocks[0].values[i]);
+    EvaluateTerminator (&sccp, 0);
+
+    while (sccp.flow_count > 0 || sccp.ssa_count > 0)
+    {
+        while (sccp.flow_count > 0)
+        {
+            int to = sccp.flow[--sccp.flow_count];
+            int from = sccp.flow[--sccp.flow_count];
+
+            IrBlock* block = &fn->blocks[to];
+            int index = PredIndex (block, from);
+            if (index < 0 || sccp.edge_exec[to][index]) continue;
+
+            sccp.edge_exec[to][index] = 1;
+
+            if (!sccp.block_exec[to])
+            {
+                sccp.block_exec[to] = 1;
+                for (int i = 0; i < block->value_count; i++)
+                    EvaluateValue (&sccp, block->values[i]);
+                EvaluateTerminator (&sccp, to);
+            }
+            else
+            {
+                for (int i = 0; i < block->value_count; i++)
+                    if (fn->values[block->values[i]].op == IR_PHI)
+                        EvaluateValue (&sccp, block->values[i]);
+            }
+        }
+
+        while (sccp.ssa_count > 0)
+        {
+            int id = sccp.ssa[--sccp.ssa_count];
+            UseList* list = &sccp.uses[id];
+
+            for (int u = 0; u < list->count; u++)
+                EvaluateValue (&sccp, list->users[u]);
+
+            for (int t = 0; t < list->term_count; t++)
+                if (sccp.block_exec[list->term_users[t]])
+                    EvaluateTerminator (&sccp, list->term_users[t]);
+        }
+    }
+
+    // -   IR_CONST
+    for (int id = 0; id < fn->value_count; id++)
+    {
+        IrValue* v = &fn->values[id];
+        if (v->removed || sccp.state[id] != LATTICE_CONST || (!IrIsPure (v->op) && v->op != IR_PHI))
+            continue;
+
+        v->op = IR_CONST;
+        v->number = sccp.constant[id];
+        v->arg_count = 0;
+    }
+
+    //     
+    for (int b = 0; b < fn->block_count; b++)
+    {
+        IrBlock* block = &fn->blocks[b];
+        if (block->removed || !sccp.block_exec[b] || block->term != IR_TERM_BRANCH) continue;
+
+        int cond = block->term_value;
+        if (sccp.state[cond] != LATTICE_CONST) continue;
+
+        int taken = sccp.constant[cond] != 0 ? block->succ[0] : block->succ[1];
+        int dropped = sccp.constant[cond] != 0 ? block->succ[1] : block->succ[0];
+
+        block->term = IR_TERM_JUMP;
+        block->term_value = -1;
+        block->succ[0] = taken;
+        block->succ[1] = -1;
+
+        if (dropped != taken)
+            IrRemovePred (fn, dropped, b);
+    }
+
+    for (int b = 0; b < fn->block_count; b++)
+        free (sccp.edge_exec[b]);
+
+    FreeUseLists (sccp.uses, fn->value_count);
+    free (sccp.state);
+    free (sccp.constant);
+    free (sccp.block_exec);
+    free (sccp.edge_exec);
+    free (sccp.flow);
+    free (sccp.ssa);
+
+    IrRemoveUnreachable (fn);
+    IrRemoveTrivialPhis (fn);
+}
+
+// ===================== DCE =====================
+
+void IrDeadCodeElimination (IrFunction* fn)
+{
+    if (!fn) return;
+
+    char* live = (char*) calloc (fn->value_count + 1, 1);
+    int* worklist = (int*) calloc (fn->value_count + 1, sizeof(int));
+    if (!live || !worklist)
+    {
+        free (live);
+        free (worklist);
+        return;
+    }
+
+    int top = 0;
+
+    for (int b = 0; b < fn->block_count; b++)
+    {
+        IrBlock* block = &fn->blocks[b];
+        if (block->removed) continue;
+
+        for (int i = 0; i < block->value_count; i++)
+        {
+            int id = block->values[i];
+            IrOpcode op = fn->values[id].op;
+            if ((op == IR_STORE_GLOBAL || op == IR_CALL) && !live[id])
+            {
+                live[id] = 1;
+                worklist[top++] = id;
+            }
+        }
+
+        int term = block->term_value;
+        if (term >= 0 && !live[term])
+        {
+            live[term] = 1;
+            worklist[top++] = term;
+        }
+    }
+
+    while (top > 0)
+    {
+        IrValue* v = &fn->values[worklist[--top]];
+        for (int a = 0; a < v->arg_count; a++)
+        {
+            int arg = v->args[a];
+            if (!live[arg])
+            {
+                live[arg] = 1;
+                worklist[top++] = arg;
+            }
+        }
+    }
+
+    for (int id = 0; id < fn->value_count; id++)
+        if (!live[id]) fn->values[id].removed = 1;
+
+    free (live);
+    free (worklist);
+
+    IrCompact (fn);
+}
+
+// ===================== GVN    =====================
+
+struct GvnEntry
+{
+    unsigned hash;
+    int value;
+    int next;
+};
+
+struct GvnTable
+{
+    int* buckets;
+    int bucket_count;
+    GvnEntry* entries;
+    int entry_count;
+    int entry_capacity;
+};
+
+static unsigned HashValue (const IrValue* v)
+{
+    unsigned hash = (2166136261u ^ (unsigned) v->op) * 16777619u ^ (unsigned) v->type;
+
+    if (v->op == IR_CONST)
+    {
+        unsigned char bytes[sizeof(double)] = {};
+        memcpy (bytes, &v->number, sizeof(double));
+        for (size_t i = 0; i < sizeof(double); i++)
+            hash = (hash ^ bytes[i]) * 16777619u;
+    }
+
+    for (int a = 0; a < v->arg_count; a++)
+        hash = (hash ^ (unsigned) v->args[a]) * 16777619u;
+
+    return hash;
+}
+
+static int SameValue (const IrValue* a, const IrValue* b)
+{
+    if (a->op != b->op || a->type != b->type || a->arg_count != b->arg_count) return 0;
+    if (a->op == IR_CONST && memcmp (&a->number, &b->number, sizeof(double)) != 0) return 0;
+
+    for (int i = 0; i < a->arg_count; i++)
+        if (a->args[i] != b->args[i]) return 0;
+
+    return 1;
+}
+
+static void NumberBlock (IrFunction* fn, GvnTable* table, int** children, int* child_count, int b)
+{
+    int saved_count = table->entry_count;
+    IrBlock* block = &fn->blocks[b];
+
+    for (int i = 0; i < block->value_count; i++)
+    {
+        int id = block->values[i];
+        IrValue* v = &fn->values[id];
+        if (v->removed || !IrIsPure (v->op)) continue;
+
+        for (int a = 0; a < v->arg_count; a++)
+            v->args[a] = IrResolve (fn, v->args[a]);
+
+        if (IrIsCommutative (v->op) && v->arg_count == 2 && v->args[0] > v->args[1])
+        {
+            int tmp = v->args[0];
+            v->args[0] = v->args[1];
+            v->args[1] = tmp;
+        }
+
+        unsigned hash = HashValue (v);
+        int bucket = (int) (hash % (unsigned) table->bucket_count);
+
+        int found = -1;
+        for (int e = table->buckets[bucket]; e >= 0; e = table->entries[e].next)
+        {
+            if (table->entries[e].hash == hash && SameValue (&fn->values[table->entries[e].value], v))
+            {
+                found = table->entries[e].value;
+                break;
+            }
+        }
+
+        if (found >= 0)
+        {
+            v->replaced_by = found;
+            v->removed = 1;
+            continue;
+        }
+
+        if (table->entry_count >= table->entry_capacity)
+        {
+            int new_capacity = table->entry_capacity ? table->entry_capacity * 2 : 64;
+            GvnEntry* new_entries = (GvnEntry*) realloc (table->entries, new_capacity * sizeof(GvnEntry));
+            if (!new_entries) continue;
+            table->entries = new_entries;
+            table->entry_capacity = new_capacity;
+        }
+
+        GvnEntry* entry = &table->entries[table->entry_count];
+        entry->hash = hash;
+        entry->value = id;
+        entry->next = table->buckets[bucket];
+        table->buckets[bucket] = table->entry_count++;
+    }
+
+    for (int c = 0; c < child_count[b]; c++)
+        NumberBlock (fn, table, children, child_count, children[b][c]);
+
+    //     
+    while (table->entry_count > saved_count)
+    {
+        GvnEntry* entry = &table->entries[--table->entry_count];
+        int bucket = (int) (entry->hash % (unsigned) table->bucket_count);
+        table->buckets[bucket] = entry->next;
+    }
+}
+
+void IrGlobalValueNumbering (IrFunction* fn)
+{
+    if (!fn || fn->block_count == 0) return;
+
+    int* idom = IrComputeDominators (fn);
+    if (!idom) return;
+
+    int** children = (int**) calloc (fn->block_count, sizeof(int*));
+    int* child_count = (int*) calloc (fn->block_count, sizeof(int));
+    int* child_capacity = (int*) calloc (fn->block_count, sizeof(int));
+
+    GvnTable table = {};
+    table.bucket_count = 1021;
+    table.buckets = (int*) calloc (table.bucket_count, sizeof(int));
+
+    if (children && child_count && child_capacity && table.buckets)
+    {
+        for (int i = 0; i < table.bucket_count; i++)
+            table.buckets[i] = -1;
+
+        for (int b = 1; b < fn->block_count; b++)
+        {
+            if (fn->blocks[b].removed || idom[b] < 0 || idom[b] == b) continue;
+            PushUse (&children[idom[b]], &child_count[idom[b]], &child_capacity[idom[b]], b);
+        }
+
+        NumberBlock (fn, &table, children, child_count, 0);
+    }
+
+    for (int b = 0; children && b < fn->block_count; b++)
+        free (children[b]);
+
+    free (children);
+    free (child_count);
+    free (child_capacity);
+    free (table.buckets);
+    free (table.entries);
+    free (idom);
+
+    IrCompact (fn);
+    IrRemoveTrivialPhis (fn);
+}
+
+// ===================== LICM =====================
+
+struct NaturalLoop
+{
+    int header;
+    int preheader;
+    char* body;
+    int size;
+};
+
+static int CompareLoopSize (const void* a, const void* b)
+{
+    return ((const NaturalLoop*) a)->size - ((const NaturalLoop*) b)->size;
+}
+
+static void CollectLoopBody (const IrFunction* fn, NaturalLoop* loop, int latch)
+{
+    int* stack = (int*) calloc (fn->block_count + 1, sizeof(int));
+    if (!stack) return;
+
+    int top = 0;
+    if (!loop->body[latch])
+    {
+        loop->body[latch] = 1;
+        loop->size++;
+        stack[top++] = latch;
+    }
+
+    while (top > 0)
+    {
+        const IrBlock* block = &fn->blocks[stack[--top]];
+        for (int p = 0; p < block->pred_count; p++)
+        {
+            int pred = block->preds[p];
+            if (!loop->body[pred])
+            {
+                loop->body[pred] = 1;
+                loop->size++;
+                stack[top++] = pred;
+            }
+        }
+    }
+
+    free (stack);
+}
+
+//  : IDIV     VM ,   
+//    
+static int MayTrap (const IrFunction* fn, const IrValue* v)
+{
+    if (v->op != IR_DIV || !IsIntegerType (v->type)) return 0;
+
+    const IrValue* divisor = &fn->values[v->args[1]];
+    return divisor->op != IR_CONST || divisor->number == 0;
+}
+
+static void HoistLoop (IrFunction* fn, const NaturalLoop* loop, const int* rpo, int rpo_count)
+{
+    int changed = 1;
+    while (changed)
+    {
+        changed = 0;
+
+        for (int r = 0; r < rpo_count; r++)
+        {
+            int b = rpo[r];
+            if (!loop->body[b]) continue;
+
+            IrBlock* block = &fn->blocks[b];
+            for (int i = 0; i < block->value_count; i++)
+            {
+                int id = block->values[i];
+                IrValue* v = &fn->values[id];
+
+                //     
+                if (v->removed || v->op == IR_CONST || !IrIsPure (v->op) || MayTrap (fn, v)) continue;
+
+                int invariant = 1;
+                for (int a = 0; a < v->arg_count && invariant; a++)
+                    if (loop->body[fn->values[v->args[a]].block]) invariant = 0;
+
+                if (!invariant) continue;
+
+                memmove (&block->values[i], &block->values[i + 1],
+                         (block->value_count - i - 1) * sizeof(int));
+                block->value_count--;
+                i--;
+
+                IrBlock* pre = &fn->blocks[loop->preheader];
+                PushUse (&pre->values, &pre->value_count, &pre->value_capacity, id);
+                v->block = loop->preheader;
+                changed = 1;
+            }
+        }
+    }
+}
+
+void IrLoopInvariantCodeMotion (IrFunction* fn)
+{
+    if (!fn || fn->block_count == 0) return;
+
+    int* idom = IrComputeDominators (fn);
+    int rpo_count = 0;
+    int* rpo = IrReversePostorder (fn, &rpo_count);
+    if (!idom || !rpo)
+    {
+        free (idom);
+        free (rpo);
+        return;
+    }
+
+    NaturalLoop* loops = NULL;
+    int loop_count = 0;
+
+    for (int h = 0; h < fn->block_count; h++)
+    {
+        IrBlock* header = &fn->blocks[h];
+        if (header->removed || idom[h] < 0) continue;
+
+        NaturalLoop loop = {};
+        loop.header = h;
+        loop.preheader = -1;
+
+        for (int p = 0; p < header->pred_count; p++)
+        {
+            int pred = header->preds[p];
+            if (!IrDominates (idom, h, pred)) continue;
+
+            if (!loop.body)
+            {
+                loop.body = (char*) calloc (fn->block_count + 1, 1);
+                if (!loop.body) break;
+                loop.body[h] = 1;
+                loop.size = 1;
+            }
+            CollectLoopBody (fn, &loop, pred);
+        }
+
+        if (!loop.body) continue;
+
+        //      
+        int outside = 0;
+        for (int p = 0; p < header->pred_count; p++)
+        {
+            int pred = header->preds[p];
+            if (loop.body[pred]) continue;
+            outside++;
+            loop.preheader = pred;
+        }
+
+        if (outside != 1 || IrSuccCount (&fn->blocks[loop.preheader]) != 1)
+        {
+            free (loop.body);
+            continue;
+        }
+
+        NaturalLoop* new_loops = (NaturalLoop*) realloc (loops, (loop_count + 1) * sizeof(NaturalLoop));
+        if (!new_loops)
+        {
+            free (loop.body);
+            continue;
+        }
+        loops = new_loops;
+        loops[loop_count++] = loop;
+    }
+
+    //   :       
+    if (loop_count > 0)
+        qsort (loops, loop_count, sizeof(NaturalLoop), CompareLoopSize);
+
+    for (int l = 0; l < loop_count; l++)
+        HoistLoop (fn, &loops[l], rpo, rpo_count);
+
+    for (int l = 0; l < loop_count; l++)
+        free (loops[l].body);
+
+    free (loops);
+    free (idom);
+    free (rpo);
+}
+
+void OptimizeIr (IrFunction* fn, int opt_level)
+{
+    if (!fn || opt_level < 2) return;
+
+    IrSparseConditionalConstants (fn);
+    IrGlobalValueNumbering (fn);
+    IrLoopInvariantCodeMotion (fn);
+    IrDeadCodeElimination (fn);
+}
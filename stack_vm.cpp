@@ -0,0 +1,685 @@
+#include "stack_vm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const int MAX_VM_LINE_LENGTH = 256;
+static const int MAX_VM_WORD_LENGTH = 64;
+
+static const char* const vm_opcode_names[VM_OPCODE_COUNT] =
+{
+    "PUSH", "IPUSH", "PUSHR", "POPR", "PUSHM", "POPM",
+    "PUSHMI", "POPMI", "PUSHMB", "POPMB",
+    "ADD", "SUB", "MUL", "DIV", "IADD", "ISUB", "IMUL", "IDIV",
+    "ITOF", "FTOI", "ITOB",
+    "JE", "JNE", "JA", "JB", "JAE", "JBE",
+    "IJE", "IJNE", "IJA", "IJB", "IJAE", "IJBE", "JMP",
+    "CALL", "RET", "OUT", "IOUT", "HLT"
+};
+
+static const char* const vm_register_names[VM_REG_COUNT] =
+{
+    "RAX", "RBX", "RCX", "RDX",
+    "RSI", "RDI", "R8", "R9", "R12", "R13"
+};
+
+struct VmLabel
+{
+    char* name;
+    int index;
+};
+
+struct VmFixup
+{
+    char* name;
+    int instruction;
+};
+
+struct VmAssembler
+{
+    VmProgram* program;
+
+    VmLabel* labels;
+    int label_count;
+    int label_capacity;
+
+    VmFixup* fixups;
+    int fixup_count;
+    int fixup_capacity;
+
+    int line;
+};
+
+const char* VmOpcodeName (VmOpcode opcode)
+{
+    if (opcode < 0 || opcode >= VM_OPCODE_COUNT) return "???";
+    return vm_opcode_names[opcode];
+}
+
+int VmRegisterIndex (const char* name)
+{
+    for (int i = 0; i < VM_REG_COUNT; i++)
+    {
+        if (strcmp (vm_register_names[i], name) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+const char* VmRegisterName (int reg)
+{
+    if (reg < 0 || reg >= VM_REG_COUNT) return "???";
+    return vm_register_names[reg];
+}
+
+int VmOpcodeHasRegister (VmOpcode opcode)
+{
+    return opcode >= VM_PUSHR && opcode <= VM_POPMB;
+}
+
+int VmOpcodeHasTarget (VmOpcode opcode)
+{
+    return opcode >= VM_JE && opcode <= VM_CALL;
+}
+
+int VmOpcodeHasImmediate (VmOpcode opcode)
+{
+    return opcode == VM_PUSH || opcode == VM_IPUSH;
+}
+
+static int FindOpcode (const char* mnemonic)
+{
+    for (int i = 0; i < VM_OPCODE_COUNT; i++)
+    {
+        if (strcmp (vm_opcode_names[i], mnemonic) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+static VmInstruction* AppendInstruction (VmProgram* program, VmOpcode opcode)
+{
+    if (program->count >= program->capacity)
+    {
+        int new_capacity = program->capacity ? program->capacity * 2 : 256;
+        VmInstruction* new_code = (VmInstruction*) realloc (program->code,
+                                                            new_capacity * sizeof(VmInstruction));
+        if (!new_code) return NULL;
+        program->code = new_code;
+        program->capacity = new_capacity;
+    }
+
+    VmInstruction* instruction = &program->code[program->count++];
+    instruction->handler = NULL;
+    instruction->opcode = opcode;
+    instruction->operand = 0;
+    instruction->immediate = 0;
+
+    return instruction;
+}
+
+static int AddLabel (VmAssembler* as, const char* name)
+{
+    for (int i = 0; i < as->label_count; i++)
+    {
+        if (strcmp (as->labels[i].name, name) == 0)
+        {
+            fprintf (stderr, "VM:  %d:  %s  \n", as->line, name);
+            return 0;
+        }
+    }
+
+    if (as->label_count >= as->label_capacity)
+    {
+        int new_capacity = as->label_capacity ? as->label_capacity * 2 : 32;
+        VmLabel* new_labels = (VmLabel*) realloc (as->labels, new_capacity * sizeof(VmLabel));
+        if (!new_labels) return 0;
+        as->labels = new_labels;
+        as->label_capacity = new_capacity;
+    }
+
+    as->labels[as->label_count].name = strdup (name);
+    as->labels[as->label_count].index = as->program->count;
+    as->label_count++;
+
+    if (strncmp (name, ":func_", strlen (":func_")) == 0)
+        return AddVmSymbol (as->program, name, as->program->count);
+
+    return 1;
+}
+
+int AddVmSymbol (VmProgram* program, const char* name, int index)
+{
+    if (program->symbol_count >= program->symbol_capacity)
+    {
+        int new_capacity = program->symbol_capacity ? program->symbol_capacity * 2 : 8;
+        VmSymbol* new_symbols = (VmSymbol*) realloc (program->symbols, new_capacity * sizeof(VmSymbol));
+        if (!new_symbols) return 0;
+        program->symbols = new_symbols;
+        program->symbol_capacity = new_capacity;
+    }
+
+    program->symbols[program->symbol_count].name = strdup (name);
+    program->symbols[program->symbol_count].index = index;
+    program->symbol_count++;
+
+    return 1;
+}
+
+static int AddFixup (VmAssembler* as, const char* name)
+{
+    if (as->fixup_count >= as->fixup_capacity)
+    {
+        int new_capacity = as->fixup_capacity ? as->fixup_capacity * 2 : 32;
+        VmFixup* new_fixups = (VmFixup*) realloc (as->fixups, new_capacity * sizeof(VmFixup));
+        if (!new_fixups) return 0;
+        as->fixups = new_fixups;
+        as->fixup_capacity = new_capacity;
+    }
+
+    as->fixups[as->fixup_count].name = strdup (name);
+    as->fixups[as->fixup_count].instruction = as->program->count - 1;
+    as->fixup_count++;
+
+    return 1;
+}
+
+//         
+static int ResolveFixups (VmAssembler* as)
+{
+    int ok = 1;
+
+    for (int i = 0; i < as->fixup_count; i++)
+    {
+        int found = -1;
+        for (int j = 0; j < as->label_count; j++)
+        {
+            if (strcmp (as->labels[j].name, as->fixups[i].name) == 0)
+            {
+                found = as->labels[j].index;
+                break;
+            }
+        }
+
+        if (found < 0)
+        {
+            fprintf (stderr, "VM:  %s  \n", as->fixups[i].name);
+            ok = 0;
+            continue;
+        }
+
+        as->program->code[as->fixups[i].instruction].operand = found;
+    }
+
+    return ok;
+}
+
+static void FreeAssembler (VmAssembler* as)
+{
+    for (int i = 0; i < as->label_count; i++)
+        free (as->labels[i].name);
+
+    for (int i = 0; i < as->fixup_count; i++)
+        free (as->fixups[i].name);
+
+    free (as->labels);
+    free (as->fixups);
+}
+
+static int AssembleLine (VmAssembler* as, char* line)
+{
+    char* comment = strchr (line, ';');
+    if (comment) *comment = '\0';
+
+    char mnemonic[MAX_VM_WORD_LENGTH] = "";
+    char operand[MAX_VM_WORD_LENGTH] = "";
+
+    int words = sscanf (line, "%63s %63s", mnemonic, operand);
+    if (words <= 0) return 1;
+
+    if (mnemonic[0] == ':')
+        return AddLabel (as, mnemonic);
+
+    int opcode = FindOpcode (mnemonic);
+    if (opcode < 0)
+    {
+        fprintf (stderr, "VM:  %d:   %s\n", as->line, mnemonic);
+        return 0;
+    }
+
+    VmInstruction* instruction = AppendInstruction (as->program, (VmOpcode) opcode);
+    if (!instruction) return 0;
+
+    if (VmOpcodeHasImmediate ((VmOpcode) opcode))
+    {
+        if (words < 2 || sscanf (operand, "%lf", &instruction->immediate) != 1)
+        {
+            fprintf (stderr, "VM:  %d: %s  \n", as->line, mnemonic);
+            return 0;
+        }
+        return 1;
+    }
+
+    if (VmOpcodeHasRegister ((VmOpcode) opcode))
+    {
+        instruction->operand = VmRegisterIndex (operand);
+        if (instruction->operand < 0)
+        {
+            fprintf (stderr, "VM:  %d:   %s\n", as->line, operand);
+            return 0;
+        }
+        return 1;
+    }
+
+    if (VmOpcodeHasTarget ((VmOpcode) opcode))
+    {
+        if (words < 2 || operand[0] != ':')
+        {
+            fprintf (stderr, "VM:  %d: %s  \n", as->line, mnemonic);
+            return 0;
+        }
+        return AddFixup (as, operand);
+    }
+
+    return 1;
+}
+
+VmProgram* AssembleVmProgram (const char* text)
+{
+    if (!text) return NULL;
+
+    VmProgram* program = (VmProgram*) calloc (1, sizeof(VmProgram));
+    if (!program) return NULL;
+
+    VmAssembler as = {};
+    as.program = program;
+
+    int ok = 1;
+    const char* current = text;
+
+    while (*current && ok)
+    {
+        const char* end = strchr (current, '\n');
+        size_t length = end ? (size_t) (end - current) : strlen (current);
+
+        char line[MAX_VM_LINE_LENGTH] = "";
+        if (length >= sizeof(line)) length = sizeof(line) - 1;
+        memcpy (line, current, length);
+
+        as.line++;
+        ok = AssembleLine (&as, line);
+
+        current = end ? end + 1 : current + length;
+    }
+
+    if (ok)
+        ok = ResolveFixups (&as);
+
+    //      :     
+    if (ok)
+        ok = AppendInstruction (program, VM_HLT) != NULL;
+
+    FreeAssembler (&as);
+
+    if (!ok)
+    {
+        FreeVmProgram (program);
+        return NULL;
+    }
+
+    return program;
+}
+
+void FreeVmProgram (VmProgram* program)
+{
+    if (!program) return;
+
+    for (int i = 0; i < program->symbol_count; i++)
+        free (program->symbols[i].name);
+
+    free (program->symbols);
+    free (program->code);
+    free (program);
+}
+
+//   :      ,  -
+//       .  GNU- - switch.
+#ifdef __GNUC__
+    #define VM_HANDLER(op)  handler_##op
+    #define VM_DISPATCH()   do { executed++; goto *ip->handler; } while (0)
+#else
+    #define VM_HANDLER(op)  case op
+    #define VM_DISPATCH()   do { executed++; continue; } while (0)
+#endif
+
+#define VM_PUSH_VALUE(value)                    \
+    do {                                        \
+        if (sp >= stack_end) goto stack_error;  \
+        *sp++ = (value);                        \
+    } while (0)
+
+#define VM_POP_VALUE(target)                    \
+    do {                                        \
+        if (sp <= stack) goto stack_error;      \
+        (target) = *--sp;                       \
+    } while (0)
+
+// field -  VmValue: f    double, i  
+#define VM_BINARY(field, op)                    \
+    do {                                        \
+        VmValue b = {}, a = {};                 \
+        VM_POP_VALUE (b);                       \
+        VM_POP_VALUE (a);                       \
+        (sp++)->field = a.field op b.field;     \
+        ip++;                                   \
+    } while (0)
+
+// int - 32 :  ,   
+#define VM_INT_BINARY(op)                       \
+    do {                                        \
+        VmValue b = {}, a = {};                 \
+        VM_POP_VALUE (b);                       \
+        VM_POP_VALUE (a);                       \
+        (sp++)->i = VmWrapInt (a.i op b.i);     \
+        ip++;                                   \
+    } while (0)
+
+#define VM_JUMP_IF(field, op)                   \
+    do {                                        \
+        VmValue b = {}, a = {};                 \
+        VM_POP_VALUE (b);                       \
+        VM_POP_VALUE (a);                       \
+        ip = (a.field op b.field) ? code + ip->operand : ip + 1; \
+    } while (0)
+
+#define VM_ADDRESS(target, size)                                \
+    do {                                                        \
+        (target) = (int) regs[ip->operand].f;                   \
+        if ((unsigned) (target) > (unsigned) (VM_RAM_SIZE - (size))) \
+            goto memory_error;                                  \
+    } while (0)
+
+static inline long long VmWrapInt (long long value)
+{
+    return (int) (unsigned) value;
+}
+
+static inline long long VmWrapChar (long long value)
+{
+    return (signed char) (unsigned char) value;
+}
+
+int RunVmProgram (VmProgram* program, FILE* out, VmStats* stats)
+{
+    if (!program || program->count == 0) return 0;
+
+    VmInstruction* code = program->code;
+
+#ifdef __GNUC__
+    static const void* const handlers[VM_OPCODE_COUNT] =
+    {
+        &&handler_VM_PUSH, &&handler_VM_IPUSH, &&handler_VM_PUSHR, &&handler_VM_POPR,
+        &&handler_VM_PUSHM, &&handler_VM_POPM, &&handler_VM_PUSHMI, &&handler_VM_POPMI,
+        &&handler_VM_PUSHMB, &&handler_VM_POPMB,
+        &&handler_VM_ADD, &&handler_VM_SUB, &&handler_VM_MUL, &&handler_VM_DIV,
+        &&handler_VM_IADD, &&handler_VM_ISUB, &&handler_VM_IMUL, &&handler_VM_IDIV,
+        &&handler_VM_ITOF, &&handler_VM_FTOI, &&handler_VM_ITOB,
+        &&handler_VM_JE, &&handler_VM_JNE, &&handler_VM_JA, &&handler_VM_JB,
+        &&handler_VM_JAE, &&handler_VM_JBE,
+        &&handler_VM_IJE, &&handler_VM_IJNE, &&handler_VM_IJA, &&handler_VM_IJB,
+        &&handler_VM_IJAE, &&handler_VM_IJBE, &&handler_VM_JMP,
+        &&handler_VM_CALL, &&handler_VM_RET, &&handler_VM_OUT, &&handler_VM_IOUT, &&handler_VM_HLT
+    };
+
+    for (int i = 0; i < program->count; i++)
+        code[i].handler = handlers[code[i].opcode];
+#endif
+
+    VmValue* stack = (VmValue*) calloc (VM_STACK_SIZE, sizeof(VmValue));
+    unsigned char* ram = (unsigned char*) calloc (VM_RAM_SIZE, 1);
+    VmInstruction** calls = (VmInstruction**) calloc (VM_CALL_DEPTH, sizeof(VmInstruction*));
+
+    if (!stack || !ram || !calls)
+    {
+        free (stack);
+        free (ram);
+        free (calls);
+        return 0;
+    }
+
+    VmValue* sp = stack;
+    VmValue* stack_end = stack + VM_STACK_SIZE;
+    VmInstruction** call_sp = calls;
+    VmInstruction** calls_end = calls + VM_CALL_DEPTH;
+    VmValue regs[VM_REG_COUNT] = {};
+
+    VmInstruction* ip = code;
+    long long executed = 0;
+    int outputs = 0;
+    int ok = 1;
+
+    clock_t start = clock ();
+
+#ifdef __GNUC__
+    VM_DISPATCH();
+#else
+    for (;;)
+    {
+        switch (ip->opcode)
+        {
+#endif
+
+    VM_HANDLER(VM_PUSH):
+        if (sp >= stack_end) goto stack_error;
+        (sp++)->f = ip->immediate;
+        ip++;
+        VM_DISPATCH();
+
+    VM_HANDLER(VM_IPUSH):
+        if (sp >= stack_end) goto stack_error;
+        (sp++)->i = (long long) ip->immediate;
+        ip++;
+        VM_DISPATCH();
+
+    VM_HANDLER(VM_PUSHR):
+        VM_PUSH_VALUE (regs[ip->operand]);
+        ip++;
+        VM_DISPATCH();
+
+    VM_HANDLER(VM_POPR):
+        VM_POP_VALUE (regs[ip->operand]);
+        ip++;
+        VM_DISPATCH();
+
+    VM_HANDLER(VM_PUSHM):
+    {
+        int address = 0;
+        VM_ADDRESS (address, 8);
+        if (sp >= stack_end) goto stack_error;
+        memcpy (sp++, ram + address, 8);
+        ip++;
+        VM_DISPATCH();
+    }
+
+    VM_HANDLER(VM_POPM):
+    {
+        int address = 0;
+        VM_ADDRESS (address, 8);
+        if (sp <= stack) goto stack_error;
+        memcpy (ram + address, --sp, 8);
+        ip++;
+        VM_DISPATCH();
+    }
+
+    VM_HANDLER(VM_PUSHMI):
+    {
+        int address = 0, value = 0;
+        VM_ADDRESS (address, 4);
+        if (sp >= stack_end) goto stack_error;
+        memcpy (&value, ram + address, 4);
+        (sp++)->i = value;
+        ip++;
+        VM_DISPATCH();
+    }
+
+    VM_HANDLER(VM_POPMI):
+    {
+        int address = 0;
+        VM_ADDRESS (address, 4);
+        if (sp <= stack) goto stack_error;
+        int value = (int) VmWrapInt ((--sp)->i);
+        memcpy (ram + address, &value, 4);
+        ip++;
+        VM_DISPATCH();
+    }
+
+    VM_HANDLER(VM_PUSHMB):
+    {
+        int address = 0;
+        VM_ADDRESS (address, 1);
+        if (sp >= stack_end) goto stack_error;
+        (sp++)->i = (signed char) ram[address];
+        ip++;
+        VM_DISPATCH();
+    }
+
+    VM_HANDLER(VM_POPMB):
+    {
+        int address = 0;
+        VM_ADDRESS (address, 1);
+        if (sp <= stack) goto stack_error;
+        ram[address] = (unsigned char) (--sp)->i;
+        ip++;
+        VM_DISPATCH();
+    }
+
+    VM_HANDLER(VM_ADD): VM_BINARY (f, +); VM_DISPATCH();
+    VM_HANDLER(VM_SUB): VM_BINARY (f, -); VM_DISPATCH();
+    VM_HANDLER(VM_MUL): VM_BINARY (f, *); VM_DISPATCH();
+    VM_HANDLER(VM_DIV): VM_BINARY (f, /); VM_DISPATCH();
+
+    VM_HANDLER(VM_IADD): VM_INT_BINARY (+); VM_DISPATCH();
+    VM_HANDLER(VM_ISUB): VM_INT_BINARY (-); VM_DISPATCH();
+    VM_HANDLER(VM_IMUL): VM_INT_BINARY (*); VM_DISPATCH();
+
+    VM_HANDLER(VM_IDIV):
+    {
+        VmValue b = {}, a = {};
+        VM_POP_VALUE (b);
+        VM_POP_VALUE (a);
+        if (b.i == 0) goto divide_error;
+        (sp++)->i = VmWrapInt (a.i / b.i);
+        ip++;
+        VM_DISPATCH();
+    }
+
+    VM_HANDLER(VM_ITOF):
+        if (sp <= stack) goto stack_error;
+        sp[-1].f = (double) sp[-1].i;
+        ip++;
+        VM_DISPATCH();
+
+    VM_HANDLER(VM_FTOI):
+        if (sp <= stack) goto stack_error;
+        sp[-1].i = VmWrapInt ((long long) sp[-1].f);
+        ip++;
+        VM_DISPATCH();
+
+    VM_HANDLER(VM_ITOB):
+        if (sp <= stack) goto stack_error;
+        sp[-1].i = VmWrapChar (sp[-1].i);
+        ip++;
+        VM_DISPATCH();
+
+    VM_HANDLER(VM_JE):  VM_JUMP_IF (f, ==); VM_DISPATCH();
+    VM_HANDLER(VM_JNE): VM_JUMP_IF (f, !=); VM_DISPATCH();
+    VM_HANDLER(VM_JA):  VM_JUMP_IF (f, >);  VM_DISPATCH();
+    VM_HANDLER(VM_JB):  VM_JUMP_IF (f, <);  VM_DISPATCH();
+    VM_HANDLER(VM_JAE): VM_JUMP_IF (f, >=); VM_DISPATCH();
+    VM_HANDLER(VM_JBE): VM_JUMP_IF (f, <=); VM_DISPATCH();
+
+    VM_HANDLER(VM_IJE):  VM_JUMP_IF (i, ==); VM_DISPATCH();
+    VM_HANDLER(VM_IJNE): VM_JUMP_IF (i, !=); VM_DISPATCH();
+    VM_HANDLER(VM_IJA):  VM_JUMP_IF (i, >);  VM_DISPATCH();
+    VM_HANDLER(VM_IJB):  VM_JUMP_IF (i, <);  VM_DISPATCH();
+    VM_HANDLER(VM_IJAE): VM_JUMP_IF (i, >=); VM_DISPATCH();
+    VM_HANDLER(VM_IJBE): VM_JUMP_IF (i, <=); VM_DISPATCH();
+
+    VM_HANDLER(VM_JMP):
+        ip = code + ip->operand;
+        VM_DISPATCH();
+
+    VM_HANDLER(VM_CALL):
+        if (call_sp >= calls_end) goto stack_error;
+        *call_sp++ = ip + 1;
+        ip = code + ip->operand;
+        VM_DISPATCH();
+
+    VM_HANDLER(VM_RET):
+        if (call_sp == calls) goto finish;
+        ip = *--call_sp;
+        VM_DISPATCH();
+
+    VM_HANDLER(VM_OUT):
+    {
+        VmValue value = {};
+        VM_POP_VALUE (value);
+        if (out) fprintf (out, "%g\n", value.f);
+        outputs++;
+        ip++;
+        VM_DISPATCH();
+    }
+
+    VM_HANDLER(VM_IOUT):
+    {
+        VmValue value = {};
+        VM_POP_VALUE (value);
+        if (out) fprintf (out, "%lld\n", value.i);
+        outputs++;
+        ip++;
+        VM_DISPATCH();
+    }
+
+    VM_HANDLER(VM_HLT):
+        goto finish;
+
+#ifndef __GNUC__
+            default:
+                goto finish;
+        }
+    }
+#endif
+
+stack_error:
+    fprintf (stderr, "VM:     %d (%s)\n",
+             (int) (ip - code), VmOpcodeName (ip->opcode));
+    ok = 0;
+    goto finish;
+
+memory_error:
+    fprintf (stderr, "VM:  %g     %d\n",
+             regs[ip->operand].f, (int) (ip - code));
+    ok = 0;
+    goto finish;
+
+divide_error:
+    fprintf (stderr, "VM:       %d\n", (int) (ip - code));
+    ok = 0;
+
+finish:
+    if (stats)
+    {
+        stats->executed = executed;
+        stats->seconds = (double) (clock () - start) / CLOCKS_PER_SEC;
+        stats->outputs = outputs;
+    }
+
+    free (stack);
+    free (ram);
+    free (calls);
+
+    return ok;
+}
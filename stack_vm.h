@@ -0,0 +1,108 @@
+#ifndef STACK_VM_H
+#define STACK_VM_H
+
+#include <stdio.h>
+
+enum VmOpcode
+{
+    VM_PUSH,
+    VM_IPUSH,
+    VM_PUSHR,
+    VM_POPR,
+    VM_PUSHM,           // 8 : double     
+    VM_POPM,
+    VM_PUSHMI,          // 4 : int
+    VM_POPMI,
+    VM_PUSHMB,          // 1 : char
+    VM_POPMB,
+    VM_ADD,
+    VM_SUB,
+    VM_MUL,
+    VM_DIV,
+    VM_IADD,
+    VM_ISUB,
+    VM_IMUL,
+    VM_IDIV,
+    VM_ITOF,
+    VM_FTOI,
+    VM_ITOB,
+    VM_JE,
+    VM_JNE,
+    VM_JA,
+    VM_JB,
+    VM_JAE,
+    VM_JBE,
+    VM_IJE,
+    VM_IJNE,
+    VM_IJA,
+    VM_IJB,
+    VM_IJAE,
+    VM_IJBE,
+    VM_JMP,
+    VM_CALL,
+    VM_RET,
+    VM_OUT,
+    VM_IOUT,
+    VM_HLT,
+    VM_OPCODE_COUNT
+};
+
+//    : double  F-,   I-.
+//   int  char    64 .
+union VmValue
+{
+    double f;
+    long long i;
+};
+
+struct VmInstruction
+{
+    const void* handler;    //   ,    
+    VmOpcode opcode;
+    int operand;            //     
+    double immediate;
+};
+
+struct VmSymbol
+{
+    char* name;
+    int index;
+};
+
+struct VmProgram
+{
+    VmInstruction* code;
+    int count;
+    int capacity;
+
+    VmSymbol* symbols;      //  ,     
+    int symbol_count;
+    int symbol_capacity;
+};
+
+struct VmStats
+{
+    long long executed;
+    double seconds;
+    int outputs;
+};
+
+const int VM_REG_COUNT = 10;            // RAX-RDX,  RDI/RSI/R8/R9, R12/R13
+const int VM_STACK_SIZE = 1 << 16;
+const int VM_CALL_DEPTH = 1 << 16;
+const int VM_RAM_SIZE = 1 << 16;            // 
+
+const char* VmOpcodeName (VmOpcode opcode);
+int VmRegisterIndex (const char* name);
+const char* VmRegisterName (int reg);
+int VmOpcodeHasRegister (VmOpcode opcode);
+int VmOpcodeHasTarget (VmOpcode opcode);
+int VmOpcodeHasImmediate (VmOpcode opcode);
+
+VmProgram* AssembleVmProgram (const char* text);
+int AddVmSymbol (VmProgram* program, const char* name, int index);
+void FreeVmProgram (VmProgram* program);
+
+int RunVmProgram (VmProgram* program, FILE* out, VmStats* stats);
+
+#endif
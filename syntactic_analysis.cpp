@@ -1,6 +1,7 @@
 #include "lexical_analysis.h"
 #include "tree_base.h"
 #include "syntactic_analysis.h"
+#include <stdarg.h>
 
 Getter* CtorGetter (Lexer* lexer)
 {
@@ -10,6 +11,7 @@ Getter* CtorGetter (Lexer* lexer)
     getter->lexer = lexer;
     getter->current_token = 0;
     getter->error_count = 0;
+    getter->errors = lexer ? lexer->errors : stderr;
 
     return getter;
 }
@@ -28,7 +30,7 @@ Token* CurrentToken (Getter* getter)
     return &getter->lexer->tokens[getter->current_token];
 }
 
-void Advance (Getter* getter)
+void AdvanceToken (Getter* getter)
 {
     if (getter && getter->current_token < getter->lexer->count)
         getter->current_token++;
@@ -40,6 +42,83 @@ bool Match (Getter* getter, MyTokenType type)
     return token && token->type == type;
 }
 
+//       ,   . 0 -  :
+//         
+static int TokenPosition (Getter* getter, int* line, int* column)
+{
+    const Lexer* lexer = getter->lexer;
+    if (!lexer || !lexer->source || lexer->count == 0) return 0;
+
+    int index = getter->current_token < lexer->count ? getter->current_token : lexer->count - 1;
+    int offset = lexer->tokens[index].offset;
+
+    SourcePosition* position = &getter->position;
+    if (offset < position->offset)
+        memset (position, 0, sizeof(SourcePosition));
+
+    for (int i = position->offset; i < offset; i++)
+    {
+        if (lexer->source[i] == '\n')
+        {
+            position->line++;
+            position->line_start = i + 1;
+        }
+    }
+    position->offset = offset;
+
+    *line = position->line + 1;
+    *column = offset - position->line_start + 1;
+    return 1;
+}
+
+//    :    -  getter->errors,  
+// getter->diagnostics != NULL         .
+//   (panic)   -  ,   
+void ReportParseError (Getter* getter, const char* format, ...)
+{
+    if (getter->panic) return;
+    getter->panic = 1;
+
+    va_list args;
+    va_start (args, format);
+    char message[MAX_DIAGNOSTIC_SIZE] = "";
+    vsnprintf (message, sizeof(message), format, args);
+    va_end (args);
+
+    int line = 0, column = 0;
+    if (TokenPosition (getter, &line, &column))
+        fprintf (getter->errors, "  ( %d,  %d): %s\n", line, column, message);
+    else
+        fprintf (getter->errors, " : %s\n", message);
+    getter->error_count++;
+
+    ParseDiagnostics* diagnostics = getter->diagnostics;
+    if (!diagnostics) return;
+
+    if (diagnostics->count >= diagnostics->capacity)
+    {
+        int new_capacity = diagnostics->capacity ? diagnostics->capacity * 2 : 8;
+        ParseDiagnostic* new_items = (ParseDiagnostic*) realloc (diagnostics->items,
+                                                                new_capacity * sizeof(ParseDiagnostic));
+        if (!new_items) return;
+        diagnostics->items = new_items;
+        diagnostics->capacity = new_capacity;
+    }
+
+    diagnostics->items[diagnostics->count].token = getter->current_token;
+    diagnostics->items[diagnostics->count].message = strdup (message);
+    diagnostics->count++;
+}
+
+void FreeParseDiagnostics (ParseDiagnostics* diagnostics)
+{
+    for (int i = 0; i < diagnostics->count; i++)
+        free (diagnostics->items[i].message);
+
+    free (diagnostics->items);
+    memset (diagnostics, 0, sizeof(ParseDiagnostics));
+}
+
 bool Expect (Getter* getter, MyTokenType type, const char* error_msg)
 {
     Token* token = CurrentToken (getter);
@@ -48,21 +127,20 @@ bool Expect (Getter* getter, MyTokenType type, const char* error_msg)
     {
         if (token)
         {
-            fprintf (stderr, " : %s.  %s,  %s\n",
+            ReportParseError (getter, "%s:  %s,  %s",
                     error_msg,
                     TokenTypeToString (type),
                     TokenTypeToString (token->type));
         }
         else
         {
-            fprintf (stderr, " : %s.  %s,   \n",
+            ReportParseError (getter, "%s:  %s,   ",
                     error_msg, TokenTypeToString (type));
         }
-        getter->error_count++;
         return false;
     }
 
-    Advance (getter);
+    AdvanceToken (getter);
     return true;
 }
 
@@ -74,7 +152,7 @@ Node* GetPrimary (Getter* getter)
     if (token->type == TOK_NUMBER)
     {
         Node* node = CreateNumber (token->value.number);
-        Advance (getter);
+        AdvanceToken (getter);
         return node;
     }
 
@@ -87,10 +165,10 @@ Node* GetPrimary (Getter* getter)
         if (next && next->type == TOK_LPAREN)
         {
             char* func_name = strdup (token->value.identifier);
-            Advance(getter); //   
+            AdvanceToken (getter); //   
 
-            Advance(getter); //  '('
-            Node* args = GetExpression (getter);
+            AdvanceToken (getter); //  '('
+            Node* args = GetArguments (getter);
             Expect (getter, TOK_RPAREN, " ')'   ");
 
             Node* node = CreateFunctionCall (func_name, args);
@@ -100,37 +178,72 @@ Node* GetPrimary (Getter* getter)
         else
         {
             Node* node = CreateVariable (token->value.identifier);
-            Advance (getter);
+            AdvanceToken (getter);
             return node;
         }
     }
 
     if (token->type == TOK_LPAREN)
     {
-        Advance (getter); //  '('
+        AdvanceToken (getter); //  '('
         Node* expr = GetExpression (getter);
         Expect (getter, TOK_RPAREN, " ')'  ");
         return expr;
     }
 
-    fprintf (stderr, ":  ,   '('\n");
-    getter->error_count++;
+    ReportParseError (getter, " ,   '(',  %s", TokenTypeToString (token->type));
     return NULL;
 }
 
+Node* GetArguments (Getter* getter) //   ,   
+{
+    if (Match (getter, TOK_RPAREN))
+        return NULL;
+
+    Node* first = NULL;
+    Node* last = NULL;
+    int count = 0;
+
+    while (1)
+    {
+        Node* expr = GetExpression (getter);
+        if (!expr) break;
+
+        Node* arg = CreateArgument (expr);
+        if (last)
+            last->right = arg;
+        else
+            first = arg;
+        last = arg;
+
+        if (++count > MAX_FUNC_PARAMS)
+        {
+            ReportParseError (getter, " %d   ", MAX_FUNC_PARAMS);
+            break;
+        }
+
+        if (!Match (getter, TOK_COMMA))
+            break;
+
+        AdvanceToken (getter); //  ','
+    }
+
+    return first;
+}
+
 Node* GetUnary (Getter* getter)  //  +-   
 {
     Token* token = CurrentToken (getter);
 
     if (token->type == TOK_PLUS)
     {
-        Advance (getter); //    
+        AdvanceToken (getter); //    
         return GetUnary (getter);
     }
 
     if (token->type == TOK_MINUS)
     {
-        Advance (getter); //  '-'
+        AdvanceToken (getter); //  '-'
         Node* operand = GetUnary (getter);
         return CreateOperation (NODE_SUB, CreateNumber(0), operand);
     }
@@ -155,7 +268,7 @@ Node* GetFactor (Getter* getter) // */
         else
             break;
 
-        Advance (getter);
+        AdvanceToken (getter);
         Node* right = GetUnary (getter);
         node = CreateOperation (op_type, node, right);
     }
@@ -181,7 +294,7 @@ Node* GetTerm (Getter* getter) // +-
         else
             break;
 
-        Advance (getter);
+        AdvanceToken (getter);
         Node* right = GetFactor (getter);
         node = CreateOperation (op_type, node, right);
     }
@@ -210,7 +323,7 @@ Node* GetComparison (Getter* getter)//  
         else
             break;
 
-        Advance (getter);
+        AdvanceToken (getter);
         Node* right = GetTerm (getter);
         node = CreateOperation (op_type, node, right);
     }
@@ -234,7 +347,7 @@ Node* GetAssignment (Getter* getter)
     Node* variable = CreateVariable (var_name);
     free (var_name);
 
-    Advance (getter); //  
+    AdvanceToken (getter); //  
 
     Expect (getter, TOK_ASSIGN, " '='  ");
 
@@ -255,12 +368,11 @@ Node* GetVarDecl (Getter* getter)
         case TOK_TYPE_CHAR: var_type = NODE_TYPE_CHAR; break;
         case TOK_TYPE_DOUBLE: var_type = NODE_TYPE_DOUBLE; break;
         default:
-            fprintf (stderr, ":   \n");
-            getter->error_count++;
+            ReportParseError (getter, "  ");
             return NULL;
     }
 
-    Advance(getter); //  
+    AdvanceToken (getter); //  
 
     Token* id_token = CurrentToken (getter);
     if (!Expect (getter, TOK_IDENTIFIER, "  "))
@@ -271,7 +383,7 @@ Node* GetVarDecl (Getter* getter)
     Node* init_value = NULL;
     if (Match(getter, TOK_ASSIGN))
     {
-        Advance (getter); //  '='
+        AdvanceToken (getter); //  '='
         init_value = GetExpression (getter);
         if (!init_value)
         {
@@ -332,7 +444,9 @@ Node* GetIf (Getter* getter)
 
 Node* GetBlock (Getter* getter) //  { }
 {
-    Expect (getter, TOK_LBRACE, " '{'");
+    // '{' -   :       
+    if (Expect (getter, TOK_LBRACE, " '{'"))
+        getter->panic = 0;
 
     Node* body = GetStatements (getter);
 
@@ -347,7 +461,21 @@ Node* GetBlock (Getter* getter) // 
     return body;
 }
 
-Node* GetStatement (Getter* getter) //  
+static void RecordStatementSpan (StatementSpans* spans, Node* node, int first, int end)
+{
+    if (spans->count >= spans->capacity)
+    {
+        int new_capacity = spans->capacity ? spans->capacity * 2 : 16;
+        StatementSpan* new_items = (StatementSpan*) realloc (spans->items, new_capacity * sizeof(StatementSpan));
+        if (!new_items) return;
+        spans->items = new_items;
+        spans->capacity = new_capacity;
+    }
+
+    spans->items[spans->count++] = {node, first, end};
+}
+
+static Node* ParseStatement (Getter* getter)
 {
     Token* token = CurrentToken (getter);
     if (!token) return CreateEmpty();
@@ -392,7 +520,6 @@ Node* GetStatement (Getter* getter) // 
             else
             {
                 Expect (getter, TOK_ASSIGN, " ");
-                getter->error_count++;
                 return NULL;
             }
         }
@@ -401,28 +528,103 @@ Node* GetStatement (Getter* getter) // 
             return CreateEmpty ();
 
         default:
-            fprintf (stderr, ":    : %s\n",
+            ReportParseError (getter, "   : %s",
                     TokenTypeToString(token->type));
-            getter->error_count++;
             return NULL;
     }
 }
 
+Node* GetStatement (Getter* getter) //  
+{
+    int first = getter->current_token;
+    Node* statement = ParseStatement (getter);
+
+    if (getter->spans && statement && statement->type != NODE_EMPTY)
+        RecordStatementSpan (getter->spans, statement, first, getter->current_token);
+
+    return statement;
+}
+
+//  :   ,    , -  ';',
+//  '}',      . , 
+//  start,    ';'  '}' -  
+static void Synchronize (Getter* getter, int start)
+{
+    getter->panic = 0;
+
+    if (getter->current_token > start)
+    {
+        MyTokenType previous = getter->lexer->tokens[getter->current_token - 1].type;
+        if (previous == TOK_SEMICOLON || previous == TOK_RBRACE)
+            return;
+    }
+
+    for (Token* token = CurrentToken (getter); token; token = CurrentToken (getter))
+    {
+        switch (token->type)
+        {
+            case TOK_SEMICOLON:
+                AdvanceToken (getter);
+                return;
+
+            case TOK_RBRACE:
+            case TOK_DECLARE:
+            case TOK_EOF:
+                return;
+
+            //       :  ,   
+            case TOK_TYPE_INT:
+            case TOK_TYPE_CHAR:
+            case TOK_TYPE_DOUBLE:
+            case TOK_IF:
+            case TOK_WHILE:
+            case TOK_RETURN:
+            case TOK_LBRACE:
+                if (getter->current_token > start)
+                    return;
+                break;
+
+            default:
+                break;
+        }
+
+        AdvanceToken (getter);
+    }
+}
+
+//    :      
+// ,        
+static void SkipBrokenFunction (Getter* getter)
+{
+    Token* token = CurrentToken (getter);
+    while (token && token->type != TOK_LBRACE && token->type != TOK_DECLARE && token->type != TOK_EOF)
+    {
+        AdvanceToken (getter);
+        token = CurrentToken (getter);
+    }
+
+    if (token && token->type == TOK_LBRACE)
+        FreeTree (GetBlock (getter));
+}
+
 Node* GetStatements (Getter* getter)  //   
 {
     Node* first = NULL;
 
     while (1)
     {
+        //     - ,  '}':    
         Token* token = CurrentToken (getter);
-        if (!token || token->type == TOK_RBRACE)
+        if (!token || token->type == TOK_RBRACE || token->type == TOK_EOF || token->type == TOK_DECLARE)
             break;
 
+        //     ,   
+        int start = getter->current_token;
         Node* stmt = GetStatement (getter);
-        if (!stmt)
+        if (!stmt || getter->panic)
         {
-            if (first) FreeTree (first);
-            return NULL;
+            Synchronize (getter, start);
+            if (!stmt) stmt = CreateError ();
         }
 
         if (stmt->type == NODE_EMPTY)
@@ -443,6 +645,55 @@ Node* GetStatements (Getter* getter)  // 
     return first;
 }
 
+Node* GetParameters (Getter* getter) // " "  
+{
+    Node* first = NULL;
+    Node* last = NULL;
+    int count = 0;
+
+    while (!Match (getter, TOK_RPAREN))
+    {
+        Token* type_token = CurrentToken (getter);
+        NodeType param_type = NODE_TYPE_INT;
+
+        switch (type_token ? type_token->type : TOK_EOF)
+        {
+            case TOK_TYPE_INT: param_type = NODE_TYPE_INT; break;
+            case TOK_TYPE_CHAR: param_type = NODE_TYPE_CHAR; break;
+            case TOK_TYPE_DOUBLE: param_type = NODE_TYPE_DOUBLE; break;
+            default:
+                ReportParseError (getter, "  ");
+                return first;
+        }
+
+        AdvanceToken (getter); //  
+
+        Token* id_token = CurrentToken (getter);
+        if (!Expect (getter, TOK_IDENTIFIER, "  "))
+            return first;
+
+        Node* param = CreateParameter (param_type, id_token->value.identifier);
+        if (last)
+            last->right = param;
+        else
+            first = param;
+        last = param;
+
+        if (++count > MAX_FUNC_PARAMS)
+        {
+            ReportParseError (getter, " %d   ", MAX_FUNC_PARAMS);
+            return first;
+        }
+
+        if (!Match (getter, TOK_COMMA))
+            break;
+
+        AdvanceToken (getter); //  ','
+    }
+
+    return first;
+}
+
 Node* GetFunction (Getter* getter)
 {
     if (!Expect(getter, TOK_DECLARE, "  "))
@@ -457,30 +708,36 @@ Node* GetFunction (Getter* getter)
         case TOK_TYPE_CHAR: return_type = NODE_TYPE_CHAR; break;
         case TOK_TYPE_DOUBLE: return_type = NODE_TYPE_DOUBLE; break;
         default:
-            fprintf (stderr, ":    \n");
-            getter->error_count++;
+            ReportParseError (getter, "   ");
+            SkipBrokenFunction (getter);
             return NULL;
     }
 
-    Advance(getter);
+    AdvanceToken (getter);
 
     Token* id_token = CurrentToken(getter);
     if (!Expect(getter, TOK_IDENTIFIER, "  "))
+    {
+        SkipBrokenFunction (getter);
         return NULL;
+    }
 
     char* func_name = strdup(id_token->value.identifier);
 
     if (!Expect(getter, TOK_LPAREN, " '('   "))
     {
         free(func_name);
+        SkipBrokenFunction (getter);
         return NULL;
     }
 
-    Node* params = NULL;  // TODO: 
+    Node* params = GetParameters (getter);
 
     if (!Expect(getter, TOK_RPAREN, " ')'  "))
     {
         free(func_name);
+        FreeTree (params);
+        SkipBrokenFunction (getter);
         return NULL;
     }
 
@@ -488,35 +745,65 @@ Node* GetFunction (Getter* getter)
     if (!body)
     {
         free(func_name);
+        FreeTree (params);
         return NULL;
     }
 
-    Node* func_decl = CreateFunctionDeclaration(return_type, func_name, NULL, body);
+    Node* func_decl = CreateFunctionDeclaration(return_type, func_name, params, body);
     free (func_name);
 
     return func_decl;
 }
 
+//   :       
+static void SkipToFunction (Getter* getter)
+{
+    Token* token = CurrentToken (getter);
+    while (token && token->type != TOK_DECLARE && token->type != TOK_EOF)
+    {
+        AdvanceToken (getter);
+        token = CurrentToken (getter);
+    }
+}
+
 Node* GetProgram (Getter* getter)
 {
-    Node* func = GetFunction (getter);
-    // TODO     
-    if (getter->error_count == 0)
+    Node* program = NULL;
+
+    //      SEQUENCE,  -  .
+    //     ,    :
+    //        
+    for (int index = 0; ; index++)
     {
         Token* token = CurrentToken (getter);
-        if (token && token->type != TOK_EOF)
+        if (index > 0 && (!token || token->type == TOK_EOF))
+            break;
+
+        getter->panic = 0;
+
+        if (index > 0 && token->type != TOK_DECLARE)
         {
-            fprintf (stderr, ":    \n");
-            getter->error_count++;
+            ReportParseError (getter, "   ");
+            SkipToFunction (getter);
+            continue;
         }
+
+        Node* func = GetFunction (getter);
+        if (!func)
+        {
+            SkipToFunction (getter);
+            continue;
+        }
+
+        program = program ? CreateSequence (program, func) : func;
     }
 
     if (getter->error_count > 0)
     {
-        if (func) FreeTree (func);
+        if (program) FreeTree (program);
         return NULL;
     }
 
-    return func;
+    return program;
 }
 
@@ -1,22 +1,70 @@
 #ifndef SYNTACTIC_ANALYSIS_H
 #define SYNTACTIC_ANALYSIS_H
 
+//     : [first, end)
+typedef struct
+{
+    Node* node;
+    int first;
+    int end;
+} StatementSpan;
+
+typedef struct
+{
+    StatementSpan* items;
+    int count;
+    int capacity;
+} StatementSpans;
+
+const int MAX_DIAGNOSTIC_SIZE = 256;
+
+//  : ,    ,     
+typedef struct
+{
+    int token;
+    char* message;
+} ParseDiagnostic;
+
+typedef struct
+{
+    ParseDiagnostic* items;
+    int count;
+    int capacity;
+} ParseDiagnostics;
+
+//     :     ,
+//      ,    
+typedef struct
+{
+    int offset;
+    int line;           //  
+    int line_start;
+} SourcePosition;
+
 struct Getter
 {
     Lexer* lexer;
     int current_token;
     int error_count;
+    FILE* errors;       //   :     
+    StatementSpans* spans;  //  NULL - GetStatement     
+    ParseDiagnostics* diagnostics;  //  NULL -    
+    int panic;          //       
+    SourcePosition position;
 };
 
 Getter* CtorGetter (Lexer* lexer);
 void DtorGetter (Getter* getter);
 Token* CurrentToken (Getter* getter);
-void Advance (Getter* getter);
+void AdvanceToken (Getter* getter);
 bool Match (Getter* getter, MyTokenType type);
 bool Expect (Getter* getter, MyTokenType type, const char* error_msg);
+void ReportParseError (Getter* getter, const char* format, ...);
+void FreeParseDiagnostics (ParseDiagnostics* diagnostics);
 
 Node* GetProgram (Getter* getter);
 Node* GetFunction (Getter* getter);
+Node* GetParameters (Getter* getter);
 Node* GetBlock (Getter* getter);
 Node* GetStatements (Getter* getter);
 Node* GetStatement (Getter* getter);
@@ -31,5 +79,6 @@ Node* GetTerm (Getter* getter);
 Node* GetFactor (Getter* getter);
 Node* GetUnary (Getter* getter);
 Node* GetPrimary (Getter* getter);
+Node* GetArguments (Getter* getter);
 
 #endif
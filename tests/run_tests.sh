@@ -0,0 +1,55 @@
+#!/bin/bash
+#    tests/   : eval, VM  x86-64  -O0, -O1, -O2.
+#   main      :
+#     __ : 30
+# : tests/run_tests.sh //lexxer [.txt ...]
+#  cp1251,      .
+
+export LC_ALL=C
+
+if [ $# -lt 1 ]; then
+    echo ": $0 lexxer [.txt ...]" >&2
+    exit 2
+fi
+
+lexxer=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+shift
+
+tests_dir=$(cd "$(dirname "$0")" && pwd)
+if [ $# -eq 0 ]; then
+    set -- "$tests_dir"/*.txt
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+failed=0
+total=0
+
+for program in "$@"; do
+    program=$(cd "$(dirname "$program")" && pwd)/$(basename "$program")
+    expected=$(head -n 1 "$program" | sed -n 's/.*: *\([-0-9.e]*\).*/\1/p')
+
+    if [ -z "$expected" ]; then
+        echo "$(basename "$program"):     "
+        failed=$((failed + 1))
+        continue
+    fi
+
+    for level in -O0 -O1 -O2; do
+        output=$(cd "$work" && timeout 60 "$lexxer" $level --run --eval --native "$program" 2>&1 | tr -d '\r')
+
+        for backend in eval VM x86-64; do
+            total=$((total + 1))
+            result=$(echo "$output" | grep -A1 -F "===  ($backend) ===" | sed -n 2p)
+
+            if [ "$result" != "$expected" ]; then
+                echo "$(basename "$program") $level $backend:  $expected,  ${result:-}"
+                failed=$((failed + 1))
+            fi
+        done
+    done
+done
+
+echo ": $total, : $failed"
+[ $failed -eq 0 ]
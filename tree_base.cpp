@@ -1,13 +1,17 @@
 #include "tree_base.h"
+#include "pass_trace.h"
+#include "memory_accounting.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 Node* CreateNode (NodeType type, NodeData data, Node* left, Node* right)
 {
-    Node* node = (Node*) calloc (1, sizeof(Node));
+    Node* node = (Node*) MemAlloc (MEM_NODES, 1, sizeof(Node));
     if (!node) return NULL;
 
+    TRACE_COUNT (COUNTER_NODES, 1);
+
     node->type = type;
     node->left = left;
     node->right = right;
@@ -16,7 +20,7 @@ Node* CreateNode (NodeType type, NodeData data, Node* left, Node* right)
     node->data.type_value = data.type_value;
 
     if (data.string_value)
-        node->data.string_value = strdup(data.string_value);
+        node->data.string_value = MemStrdup (MEM_NODE_NAMES, data.string_value);
     else
         node->data.string_value = NULL;
 
@@ -103,6 +107,12 @@ Node* CreateEmpty()
     return CreateNode(NODE_EMPTY, data, NULL, NULL);
 }
 
+Node* CreateError ()
+{
+    NodeData data = {};
+    return CreateNode (NODE_ERROR, data, NULL, NULL);
+}
+
 void FreeTree (Node* root)
 {
     if (!root) return;
@@ -111,9 +121,32 @@ void FreeTree (Node* root)
     FreeTree(root->right);
 
     if (root->data.string_value)
-        free(root->data.string_value);
+        MemFree (MEM_NODE_NAMES, root->data.string_value);
+
+    MemFree (MEM_NODES, root);
+}
 
-    free (root);
+Node* CopyTree (Node* root)
+{
+    if (!root) return NULL;
+
+    Node* copy = CreateNode (root->type, root->data, CopyTree (root->left), CopyTree (root->right));
+    if (copy)
+        copy->value_type = root->value_type;
+
+    return copy;
+}
+
+//  -     SEQUENCE  
+Node* FirstFunction (Node* root)
+{
+    while (root && root->type == NODE_SEQUENCE)
+        root = root->left;
+
+    if (root && root->type == NODE_FUNC_DECL)
+        return root;
+
+    return NULL;
 }
 
 Node* CreateFunctionDeclaration (NodeType return_type, const char* name, Node* params, Node* body)
@@ -131,48 +164,125 @@ Node* CreateFunctionCall (const char* func_name, Node* arguments)
     return CreateNode (NODE_FUNC_CALL, data, arguments, NULL);
 }
 
-void PrintTree(Node* node, int depth)
+Node* CreateParameter (NodeType param_type, const char* name)
+{
+    NodeData data = {};
+    data.string_value = (char*) name;
+    data.type_value = param_type;
+    return CreateNode (NODE_PARAMETER, data, NULL, NULL);
+}
+
+Node* CreateArgument (Node* expr)
+{
+    NodeData data = {};
+    return CreateNode (NODE_ARGUMENT, data, expr, NULL);
+}
+
+// char  int - ,    double
+int IsIntegerType (NodeType type)
+{
+    return type == NODE_TYPE_INT || type == NODE_TYPE_CHAR;
+}
+
+//     VM, 
+int TypeSize (NodeType type)
+{
+    switch (type)
+    {
+        case NODE_TYPE_CHAR: return 1;
+        case NODE_TYPE_INT:  return 4;
+        default:             return 8;
+    }
+}
+
+//    -   right
+int CountParameters (Node* func)
+{
+    int count = 0;
+    for (Node* param = func ? func->left : NULL; param; param = param->right)
+        count++;
+
+    return count;
+}
+
+int CountArguments (Node* call)
+{
+    int count = 0;
+    for (Node* arg = call ? call->left : NULL; arg; arg = arg->right)
+        count++;
+
+    return count;
+}
+
+Node* NthParameter (Node* func, int index)
+{
+    Node* param = func ? func->left : NULL;
+    for (int i = 0; param && i < index; i++)
+        param = param->right;
+
+    return param;
+}
+
+//    NULL,   
+Node* NthArgument (Node* call, int index)
+{
+    Node* arg = call ? call->left : NULL;
+    for (int i = 0; arg && i < index; i++)
+        arg = arg->right;
+
+    return arg ? arg->left : NULL;
+}
+
+void PrintTree (FILE* out, Node* node, int depth)
 {
     if (!node) return;
 
     for (int i = 0; i < depth; i++)
-        printf ("  ");
+        fprintf (out, "  ");
 
     switch (node->type)
     {
         case NODE_NUMBER:
-            printf ("NUMBER: %g\n", node->data.number_value);
+            fprintf (out, "NUMBER: %g\n", node->data.number_value);
             break;
 
         case NODE_VARIABLE:
-            printf ("VAR: %s\n", node->data.string_value);
+            fprintf (out, "VAR: %s\n", node->data.string_value);
             break;
 
-        case NODE_ADD: printf ("ADD\n"); break;
-        case NODE_SUB: printf ("SUB\n"); break;
-        case NODE_MUL: printf ("MUL\n"); break;
-        case NODE_DIV: printf ("DIV\n"); break;
-        case NODE_ASSIGNMENT: printf ("ASSIGN\n"); break;
-        case NODE_EQ: printf ("EQ\n"); break;
-        case NODE_NE: printf ("NE\n"); break;
-        case NODE_GT: printf ("GT\n"); break;
-        case NODE_LT: printf ("LT\n"); break;
+        case NODE_ADD: fprintf (out, "ADD\n"); break;
+        case NODE_SUB: fprintf (out, "SUB\n"); break;
+        case NODE_MUL: fprintf (out, "MUL\n"); break;
+        case NODE_DIV: fprintf (out, "DIV\n"); break;
+        case NODE_ASSIGNMENT: fprintf (out, "ASSIGN\n"); break;
+        case NODE_EQ: fprintf (out, "EQ\n"); break;
+        case NODE_NE: fprintf (out, "NE\n"); break;
+        case NODE_GT: fprintf (out, "GT\n"); break;
+        case NODE_LT: fprintf (out, "LT\n"); break;
 
         case NODE_VAR_DECL:
-            printf ("VAR_DECL: %s (type: %d)\n",
+            fprintf (out, "VAR_DECL: %s (type: %d)\n",
+                   node->data.string_value, node->data.type_value);
+            break;
+
+        case NODE_SEQUENCE: fprintf (out, "SEQUENCE\n"); break;
+        case NODE_IF: fprintf (out, "IF\n"); break;
+        case NODE_RETURN: fprintf (out, "RETURN\n"); break;
+        case NODE_EMPTY: fprintf (out, "EMPTY\n"); break;
+
+        case NODE_PARAMETER:
+            fprintf (out, "PARAM: %s (type: %d)\n",
                    node->data.string_value, node->data.type_value);
             break;
 
-        case NODE_SEQUENCE: printf ("SEQUENCE\n"); break;
-        case NODE_IF: printf ("IF\n"); break;
-        case NODE_RETURN: printf ("RETURN\n"); break;
-        case NODE_EMPTY: printf ("EMPTY\n"); break;
+        case NODE_ARGUMENT: fprintf (out, "ARG\n"); break;
+        case NODE_ERROR: fprintf (out, "ERROR\n"); break;
 
         default:
-            printf ("UNKNOWN: %d\n", node->type);
+            fprintf (out, "UNKNOWN: %d\n", node->type);
             break;
     }
 
-    PrintTree (node->left, depth + 1);
-    PrintTree (node->right, depth + 1);
+    PrintTree (out, node->left, depth + 1);
+    PrintTree (out, node->right, depth + 1);
 }
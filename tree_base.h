@@ -2,6 +2,7 @@
 #define TREE_BASE_H
 
 #include <stddef.h>
+#include <stdio.h>
 #include <stdbool.h>
 
 enum NodeType
@@ -27,9 +28,14 @@ enum NodeType
     NODE_RETURN,        // return
     NODE_TYPE_INT,      // int
     NODE_TYPE_CHAR,     // char
-    NODE_TYPE_DOUBLE    // double
+    NODE_TYPE_DOUBLE,   // double
+    NODE_PARAMETER,     //  :   , right - 
+    NODE_ARGUMENT,      //  : left - , right - 
+    NODE_ERROR          //  ;       
 };
 
+const int MAX_FUNC_PARAMS = 16;
+
 struct NodeData
 {
     double number_value;
@@ -44,6 +50,7 @@ struct Node
     struct Node* left;      //  
     struct Node* right;     //  
     int priority;           //  
+    NodeType value_type;    //   ,  CheckTypes
 };
 
 Node* CreateNumber (double value);
@@ -54,11 +61,24 @@ Node* CreateVarDeclaration (NodeType var_type, const char* name, Node* init_valu
 Node* CreateReturn (Node* expr);
 Node* CreateIf (Node* condition, Node* body);
 Node* CreateEmpty ();
+Node* CreateError ();
 Node* CreateSequence (Node* first, Node* second);
 Node* CreateNode (NodeType type, NodeData data, Node* left, Node* right);
 void FreeTree (Node* root);
-void PrintTree (Node* node, int depth);
+Node* CopyTree (Node* root);
+Node* FirstFunction (Node* root);
+void PrintTree (FILE* out, Node* node, int depth);
 Node* CreateFunctionDeclaration (NodeType return_type, const char* name, Node* params, Node* body);
 Node* CreateFunctionCall (const char* func_name, Node* arguments);
+Node* CreateParameter (NodeType param_type, const char* name);
+Node* CreateArgument (Node* expr);
+
+int IsIntegerType (NodeType type);
+int TypeSize (NodeType type);
+
+int CountParameters (Node* func);
+int CountArguments (Node* call);
+Node* NthParameter (Node* func, int index);
+Node* NthArgument (Node* call, int index);
 
 #endif
@@ -0,0 +1,313 @@
+#include "type_checking.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static const double INT_TYPE_MIN = -2147483648.0;
+static const double INT_TYPE_MAX = 2147483647.0;
+
+// ,   int   char (   ,      ), - double
+NodeType DeclaredType (NodeType type)
+{
+    if (type == NODE_TYPE_INT || type == NODE_TYPE_CHAR)
+        return type;
+
+    return NODE_TYPE_DOUBLE;
+}
+
+NodeType ExpressionType (const Node* node)
+{
+    return node ? DeclaredType (node->value_type) : NODE_TYPE_INT;
+}
+
+//    C: char   int,  double - double
+NodeType CommonType (NodeType a, NodeType b)
+{
+    if (DeclaredType (a) == NODE_TYPE_DOUBLE || DeclaredType (b) == NODE_TYPE_DOUBLE)
+        return NODE_TYPE_DOUBLE;
+
+    return NODE_TYPE_INT;
+}
+
+// ,    :    int,   -  
+NodeType OperandType (const Node* node)
+{
+    if (!node) return NODE_TYPE_INT;
+
+    switch (node->type)
+    {
+        case NODE_EQ:
+        case NODE_NE:
+        case NODE_GT:
+        case NODE_LT:
+            return CommonType (ExpressionType (node->left), ExpressionType (node->right));
+
+        default:
+            return ExpressionType (node);
+    }
+}
+
+// ,     type:  FTOI/ITOB  VM, 
+//       32  (int)  8 (char)
+double ConvertValue (double value, NodeType type)
+{
+    switch (DeclaredType (type))
+    {
+        case NODE_TYPE_INT:  return (int) (unsigned) (long long) value;
+        case NODE_TYPE_CHAR: return (signed char) (unsigned char) (long long) value;
+        default:             return value;
+    }
+}
+
+// IADD/ISUB/IMUL/IDIV  ,   double;    -  
+double IntegerArithmetic (NodeType op, double a, double b)
+{
+    long long x = (long long) a;
+    long long y = (long long) b;
+    long long result = 0;
+
+    switch (op)
+    {
+        case NODE_ADD: result = x + y; break;
+        case NODE_SUB: result = x - y; break;
+        case NODE_MUL: result = x * y; break;
+        case NODE_DIV: result = y ? x / y : 0; break;
+        default:       break;
+    }
+
+    return (int) (unsigned) result;
+}
+
+static TypedName* FindName (TypedName* names, int count, const char* name)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp (names[i].name, name) == 0)
+            return &names[i];
+    }
+
+    return NULL;
+}
+
+//        :  
+static void AddName (TypedName** names, int* count, int* capacity, const char* name, NodeType type)
+{
+    if (!name || FindName (*names, *count, name)) return;
+
+    if (*count >= *capacity)
+    {
+        int new_capacity = *capacity ? *capacity * 2 : 16;
+        TypedName* new_names = (TypedName*) realloc (*names, new_capacity * sizeof(TypedName));
+        if (!new_names) return;
+        *names = new_names;
+        *capacity = new_capacity;
+    }
+
+    (*names)[*count].name = (char*) name;
+    (*names)[*count].type = DeclaredType (type);
+    (*count)++;
+}
+
+static void AddFunc (TypeContext* ctx, Node* func)
+{
+    if (ctx->func_count >= ctx->func_capacity)
+    {
+        int new_capacity = ctx->func_capacity ? ctx->func_capacity * 2 : 8;
+        Node** new_funcs = (Node**) realloc (ctx->funcs, new_capacity * sizeof(Node*));
+        if (!new_funcs) return;
+        ctx->funcs = new_funcs;
+        ctx->func_capacity = new_capacity;
+    }
+
+    ctx->funcs[ctx->func_count++] = func;
+}
+
+static Node* FindFunc (TypeContext* ctx, const char* name)
+{
+    for (int i = 0; i < ctx->func_count; i++)
+    {
+        if (strcmp (ctx->funcs[i]->data.string_value, name) == 0)
+            return ctx->funcs[i];
+    }
+
+    return NULL;
+}
+
+//    ;    
+static void CollectGlobals (TypeContext* ctx, Node* node)
+{
+    if (!node) return;
+
+    if (node->type == NODE_FUNC_DECL)
+    {
+        AddFunc (ctx, node);
+        return;
+    }
+
+    if (node->type == NODE_VAR_DECL)
+        AddName (&ctx->globals, &ctx->global_count, &ctx->global_capacity,
+                 node->data.string_value, node->data.type_value);
+
+    CollectGlobals (ctx, node->left);
+    CollectGlobals (ctx, node->right);
+}
+
+//      :      
+static void CollectLocals (TypeContext* ctx, Node* node)
+{
+    if (!node) return;
+
+    if (node->type == NODE_VAR_DECL)
+        AddName (&ctx->locals, &ctx->local_count, &ctx->local_capacity,
+                 node->data.string_value, node->data.type_value);
+
+    CollectLocals (ctx, node->left);
+    CollectLocals (ctx, node->right);
+}
+
+static NodeType VariableType (TypeContext* ctx, const char* name)
+{
+    TypedName* var = NULL;
+
+    if (ctx->current_func)
+        var = FindName (ctx->locals, ctx->local_count, name);
+
+    if (!var)
+        var = FindName (ctx->globals, ctx->global_count, name);
+
+    return var ? var->type : NODE_TYPE_DOUBLE;
+}
+
+static NodeType NumberType (double value)
+{
+    if (value == floor (value) && value >= INT_TYPE_MIN && value <= INT_TYPE_MAX)
+        return NODE_TYPE_INT;
+
+    return NODE_TYPE_DOUBLE;
+}
+
+static void CheckNode (TypeContext* ctx, Node* node);
+
+//    :      
+static void CheckCall (TypeContext* ctx, Node* node)
+{
+    Node* callee = FindFunc (ctx, node->data.string_value);
+    int index = 0;
+
+    for (Node* arg = node->left; arg; arg = arg->right, index++)
+    {
+        CheckNode (ctx, arg->left);
+
+        Node* param = callee ? NthParameter (callee, index) : NULL;
+        arg->value_type = param ? DeclaredType (param->data.type_value) : ExpressionType (arg->left);
+    }
+
+    //     0
+    node->value_type = callee ? DeclaredType (callee->data.type_value) : NODE_TYPE_INT;
+}
+
+static void CheckFunction (TypeContext* ctx, Node* node)
+{
+    ctx->current_func = node;
+    ctx->local_count = 0;
+
+    for (Node* param = node->left; param; param = param->right)
+    {
+        AddName (&ctx->locals, &ctx->local_count, &ctx->local_capacity,
+                 param->data.string_value, param->data.type_value);
+        param->value_type = DeclaredType (param->data.type_value);
+    }
+
+    CollectLocals (ctx, node->right);
+
+    node->value_type = DeclaredType (node->data.type_value);
+    CheckNode (ctx, node->right);
+
+    ctx->current_func = NULL;
+    ctx->local_count = 0;
+}
+
+static void CheckNode (TypeContext* ctx, Node* node)
+{
+    if (!node) return;
+
+    switch (node->type)
+    {
+        case NODE_NUMBER:
+            node->value_type = NumberType (node->data.number_value);
+            break;
+
+        case NODE_VARIABLE:
+            node->value_type = VariableType (ctx, node->data.string_value);
+            break;
+
+        case NODE_ADD:
+        case NODE_SUB:
+        case NODE_MUL:
+        case NODE_DIV:
+            CheckNode (ctx, node->left);
+            CheckNode (ctx, node->right);
+            node->value_type = CommonType (ExpressionType (node->left), ExpressionType (node->right));
+            break;
+
+        case NODE_EQ:
+        case NODE_NE:
+        case NODE_GT:
+        case NODE_LT:
+            CheckNode (ctx, node->left);
+            CheckNode (ctx, node->right);
+            node->value_type = NODE_TYPE_INT;
+            break;
+
+        case NODE_ASSIGNMENT:
+            CheckNode (ctx, node->left);
+            CheckNode (ctx, node->right);
+            node->value_type = ExpressionType (node->left);
+            break;
+
+        case NODE_VAR_DECL:
+            CheckNode (ctx, node->left);
+            node->value_type = DeclaredType (node->data.type_value);
+            break;
+
+        case NODE_FUNC_CALL:
+            CheckCall (ctx, node);
+            break;
+
+        case NODE_FUNC_DECL:
+            CheckFunction (ctx, node);
+            return;
+
+        // return     
+        case NODE_RETURN:
+            CheckNode (ctx, node->left);
+            node->value_type = ctx->current_func ? DeclaredType (ctx->current_func->data.type_value)
+                                                 : ExpressionType (node->left);
+            break;
+
+        default:
+            CheckNode (ctx, node->left);
+            CheckNode (ctx, node->right);
+            return;
+    }
+
+    if (IsIntegerType (node->value_type))
+        ctx->integer_exprs++;
+}
+
+int CheckTypes (Node* root)
+{
+    if (!root) return 0;
+
+    TypeContext ctx = {};
+
+    CollectGlobals (&ctx, root);
+    CheckNode (&ctx, root);
+
+    free (ctx.globals);
+    free (ctx.locals);
+    free (ctx.funcs);
+
+    return ctx.integer_exprs;
+}
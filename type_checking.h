@@ -0,0 +1,43 @@
+#ifndef TYPE_CHECKING_H
+#define TYPE_CHECKING_H
+
+#include "tree_base.h"
+
+typedef struct
+{
+    char* name;
+    NodeType type;
+} TypedName;
+
+typedef struct
+{
+    TypedName* globals;
+    int global_count;
+    int global_capacity;
+
+    TypedName* locals;          //     
+    int local_count;
+    int local_capacity;
+
+    Node** funcs;
+    int func_count;
+    int func_capacity;
+
+    Node* current_func;
+    int integer_exprs;
+} TypeContext;
+
+//  value_type :   , 
+//     .   - double.
+//        .
+int CheckTypes (Node* root);
+
+NodeType DeclaredType (NodeType type);
+NodeType ExpressionType (const Node* node);
+NodeType CommonType (NodeType a, NodeType b);
+NodeType OperandType (const Node* node);
+
+double ConvertValue (double value, NodeType type);
+double IntegerArithmetic (NodeType op, double a, double b);
+
+#endif
@@ -0,0 +1,367 @@
+#include "vm_object.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+static const size_t VM_OBJECT_ALIGN = 8;
+
+static size_t AlignUp (size_t value)
+{
+    return (value + VM_OBJECT_ALIGN - 1) / VM_OBJECT_ALIGN * VM_OBJECT_ALIGN;
+}
+
+static int AddConstant (double* constants, int* count, double value)
+{
+    for (int i = 0; i < *count; i++)
+    {
+        if (memcmp (&constants[i], &value, sizeof(double)) == 0)
+            return i;
+    }
+
+    constants[*count] = value;
+    return (*count)++;
+}
+
+static uint32_t EncodeInstruction (VmOpcode opcode, uint32_t operand)
+{
+    return (uint32_t) opcode | (operand << VM_OPCODE_BITS);
+}
+
+static VmOpcode DecodeOpcode (uint32_t word)
+{
+    return (VmOpcode) (word & ((1u << VM_OPCODE_BITS) - 1));
+}
+
+static uint32_t DecodeOperand (uint32_t word)
+{
+    return word >> VM_OPCODE_BITS;
+}
+
+//         fwrite
+int WriteVmObject (const VmProgram* program, const char* filename)
+{
+    if (!program || !filename) return 0;
+
+    if ((uint32_t) program->count > VM_MAX_OPERAND)
+    {
+        fprintf (stderr, "VM:      \n");
+        return 0;
+    }
+
+    double* constants = (double*) calloc (program->count + 1, sizeof(double));
+    uint32_t* code = (uint32_t*) calloc (program->count + 1, sizeof(uint32_t));
+    if (!constants || !code)
+    {
+        free (constants);
+        free (code);
+        return 0;
+    }
+
+    int constant_count = 0;
+    for (int i = 0; i < program->count; i++)
+    {
+        const VmInstruction* instruction = &program->code[i];
+        uint32_t operand = (uint32_t) instruction->operand;
+
+        if (VmOpcodeHasImmediate (instruction->opcode))
+            operand = (uint32_t) AddConstant (constants, &constant_count, instruction->immediate);
+
+        code[i] = EncodeInstruction (instruction->opcode, operand);
+    }
+
+    size_t strings_size = 0;
+    for (int i = 0; i < program->symbol_count; i++)
+        strings_size += strlen (program->symbols[i].name) + 1;
+
+    VmObjectHeader header = {};
+    memcpy (header.magic, VM_OBJECT_MAGIC, sizeof(header.magic));
+    header.version = VM_OBJECT_VERSION;
+    header.code_count = (uint32_t) program->count;
+    header.constant_count = (uint32_t) constant_count;
+    header.symbol_count = (uint32_t) program->symbol_count;
+    header.strings_size = (uint32_t) strings_size;
+    header.code_offset = (uint32_t) AlignUp (sizeof(header));
+    header.constant_offset = (uint32_t) AlignUp (header.code_offset + program->count * sizeof(uint32_t));
+    header.symbol_offset = (uint32_t) AlignUp (header.constant_offset + constant_count * sizeof(double));
+    header.strings_offset = (uint32_t) AlignUp (header.symbol_offset +
+                                                program->symbol_count * sizeof(VmObjectSymbol));
+
+    size_t size = header.strings_offset + strings_size;
+    char* image = (char*) calloc (size, 1);
+    if (!image)
+    {
+        free (constants);
+        free (code);
+        return 0;
+    }
+
+    memcpy (image, &header, sizeof(header));
+    memcpy (image + header.code_offset, code, program->count * sizeof(uint32_t));
+    memcpy (image + header.constant_offset, constants, constant_count * sizeof(double));
+
+    VmObjectSymbol* symbols = (VmObjectSymbol*) (image + header.symbol_offset);
+    char* strings = image + header.strings_offset;
+    size_t name_offset = 0;
+
+    for (int i = 0; i < program->symbol_count; i++)
+    {
+        symbols[i].name = (uint32_t) name_offset;
+        symbols[i].instruction = (uint32_t) program->symbols[i].index;
+
+        size_t length = strlen (program->symbols[i].name) + 1;
+        memcpy (strings + name_offset, program->symbols[i].name, length);
+        name_offset += length;
+    }
+
+    int ok = 0;
+    FILE* file = fopen (filename, "wb");
+    if (file)
+    {
+        ok = fwrite (image, 1, size, file) == size;
+        fclose (file);
+    }
+
+    if (!ok)
+        fprintf (stderr, "VM:    %s\n", filename);
+
+    free (image);
+    free (constants);
+    free (code);
+
+    return ok;
+}
+
+static int CheckSection (const VmObject* object, uint32_t offset, size_t length)
+{
+    return offset % VM_OBJECT_ALIGN == 0 && offset <= object->size && length <= object->size - offset;
+}
+
+static int BindSections (VmObject* object)
+{
+    if (object->size < sizeof(VmObjectHeader)) return 0;
+
+    const VmObjectHeader* header = (const VmObjectHeader*) object->base;
+    if (memcmp (header->magic, VM_OBJECT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != VM_OBJECT_VERSION)
+        return 0;
+
+    if (!CheckSection (object, header->code_offset, header->code_count * sizeof(uint32_t)) ||
+        !CheckSection (object, header->constant_offset, header->constant_count * sizeof(double)) ||
+        !CheckSection (object, header->symbol_offset, header->symbol_count * sizeof(VmObjectSymbol)) ||
+        header->strings_offset > object->size || header->strings_size > object->size - header->strings_offset)
+        return 0;
+
+    const char* base = (const char*) object->base;
+
+    object->header = header;
+    object->code = (const uint32_t*) (base + header->code_offset);
+    object->constants = (const double*) (base + header->constant_offset);
+    object->symbols = (const VmObjectSymbol*) (base + header->symbol_offset);
+    object->strings = base + header->strings_offset;
+
+    return 1;
+}
+
+VmObject* LoadVmObject (const char* filename)
+{
+    VmObject* object = (VmObject*) calloc (1, sizeof(VmObject));
+    if (!object) return NULL;
+
+#ifndef _WIN32
+    int fd = open (filename, O_RDONLY);
+    struct stat info = {};
+
+    if (fd >= 0 && fstat (fd, &info) == 0 && info.st_size > 0)
+    {
+        void* base = mmap (NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base != MAP_FAILED)
+        {
+            object->base = base;
+            object->size = (size_t) info.st_size;
+            object->mapped = 1;
+        }
+    }
+
+    if (fd >= 0) close (fd);
+#else
+    FILE* file = fopen (filename, "rb");
+    if (file)
+    {
+        fseek (file, 0, SEEK_END);
+        long size = ftell (file);
+        fseek (file, 0, SEEK_SET);
+
+        object->base = size > 0 ? malloc (size) : NULL;
+        if (object->base && fread (object->base, 1, size, file) == (size_t) size)
+            object->size = (size_t) size;
+
+        fclose (file);
+    }
+#endif
+
+    if (!object->base || !BindSections (object))
+    {
+        fprintf (stderr, "VM: %s     VM\n", filename);
+        FreeVmObject (object);
+        return NULL;
+    }
+
+    return object;
+}
+
+void FreeVmObject (VmObject* object)
+{
+    if (!object) return;
+
+#ifndef _WIN32
+    if (object->mapped)
+        munmap (object->base, object->size);
+    else
+        free (object->base);
+#else
+    free (object->base);
+#endif
+
+    free (object);
+}
+
+static int ValidOperand (const VmObject* object, VmOpcode opcode, uint32_t operand)
+{
+    if (VmOpcodeHasImmediate (opcode))
+        return operand < object->header->constant_count;
+
+    if (VmOpcodeHasRegister (opcode))
+        return operand < (uint32_t) VM_REG_COUNT;
+
+    if (VmOpcodeHasTarget (opcode))
+        return operand <= object->header->code_count;
+
+    return 1;
+}
+
+//     VM:      
+VmProgram* VmProgramFromObject (const VmObject* object)
+{
+    if (!object) return NULL;
+
+    VmProgram* program = (VmProgram*) calloc (1, sizeof(VmProgram));
+    if (!program) return NULL;
+
+    int count = (int) object->header->code_count;
+
+    //  HLT        
+    program->code = (VmInstruction*) calloc (count + 1, sizeof(VmInstruction));
+    program->capacity = count + 1;
+
+    if (!program->code)
+    {
+        FreeVmProgram (program);
+        return NULL;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        VmOpcode opcode = DecodeOpcode (object->code[i]);
+        uint32_t operand = DecodeOperand (object->code[i]);
+
+        if (opcode >= VM_OPCODE_COUNT || !ValidOperand (object, opcode, operand))
+        {
+            fprintf (stderr, "VM:   %d   \n", i);
+            FreeVmProgram (program);
+            return NULL;
+        }
+
+        program->code[i].opcode = opcode;
+
+        if (VmOpcodeHasImmediate (opcode))
+            program->code[i].immediate = object->constants[operand];
+        else
+            program->code[i].operand = (int) operand;
+    }
+
+    program->code[count].opcode = VM_HLT;
+    program->count = count + 1;
+
+    for (uint32_t i = 0; i < object->header->symbol_count; i++)
+    {
+        if (object->symbols[i].name >= object->header->strings_size) continue;
+        AddVmSymbol (program, object->strings + object->symbols[i].name, (int) object->symbols[i].instruction);
+    }
+
+    return program;
+}
+
+static const char* SymbolAt (const VmObject* object, uint32_t instruction)
+{
+    for (uint32_t i = 0; i < object->header->symbol_count; i++)
+    {
+        if (object->symbols[i].instruction == instruction && object->symbols[i].name < object->header->strings_size)
+            return object->strings + object->symbols[i].name;
+    }
+
+    return NULL;
+}
+
+//    :     :label_<>
+void DisassembleVmObject (const VmObject* object, FILE* out)
+{
+    if (!object || !out) return;
+
+    const VmObjectHeader* header = object->header;
+    uint32_t count = header->code_count;
+
+    char* is_target = (char*) calloc (count + 1, 1);
+    if (!is_target) return;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        VmOpcode opcode = DecodeOpcode (object->code[i]);
+        uint32_t operand = DecodeOperand (object->code[i]);
+
+        if (VmOpcodeHasTarget (opcode) && operand <= count)
+            is_target[operand] = 1;
+    }
+
+    fprintf (out, ";  VM v%u: %u , %u , %u \n",
+             header->version, count, header->constant_count, header->symbol_count);
+
+    for (uint32_t i = 0; i <= count; i++)
+    {
+        const char* symbol = SymbolAt (object, i);
+        if (symbol)
+            fprintf (out, "%s\n", symbol);
+        else if (is_target[i])
+            fprintf (out, ":label_%u\n", i);
+
+        if (i == count) break;
+
+        VmOpcode opcode = DecodeOpcode (object->code[i]);
+        uint32_t operand = DecodeOperand (object->code[i]);
+
+        fprintf (out, "%-6s", VmOpcodeName (opcode));
+
+        if (VmOpcodeHasImmediate (opcode) && operand < header->constant_count)
+            fprintf (out, "%g", object->constants[operand]);
+        else if (VmOpcodeHasRegister (opcode))
+            fprintf (out, "%s", VmRegisterName ((int) operand));
+        else if (VmOpcodeHasTarget (opcode))
+        {
+            const char* target = SymbolAt (object, operand);
+            if (target)
+                fprintf (out, "%s", target);
+            else
+                fprintf (out, ":label_%u", operand);
+        }
+
+        fprintf (out, "    ; %u\n", i);
+    }
+
+    free (is_target);
+}
@@ -0,0 +1,58 @@
+#ifndef VM_OBJECT_H
+#define VM_OBJECT_H
+
+#include "stack_vm.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//   VM: ,  ,   PUSH  IPUSH,
+//      .     ,
+//    8,    mmap     .
+struct VmObjectHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t code_count;
+    uint32_t constant_count;
+    uint32_t symbol_count;
+    uint32_t strings_size;
+    uint32_t code_offset;
+    uint32_t constant_offset;
+    uint32_t symbol_offset;
+    uint32_t strings_offset;
+};
+
+struct VmObjectSymbol
+{
+    uint32_t name;          //   
+    uint32_t instruction;
+};
+
+struct VmObject
+{
+    void* base;
+    size_t size;
+    int mapped;
+
+    const VmObjectHeader* header;
+    const uint32_t* code;           //    8 ,    24
+    const double* constants;
+    const VmObjectSymbol* symbols;
+    const char* strings;
+};
+
+const char VM_OBJECT_MAGIC[4] = {'S', 'V', 'M', 'O'};
+const uint32_t VM_OBJECT_VERSION = 2;            // 2:     
+const int VM_OPCODE_BITS = 8;
+const uint32_t VM_MAX_OPERAND = (1u << (32 - VM_OPCODE_BITS)) - 1;
+
+int WriteVmObject (const VmProgram* program, const char* filename);
+
+VmObject* LoadVmObject (const char* filename);
+void FreeVmObject (VmObject* object);
+
+VmProgram* VmProgramFromObject (const VmObject* object);
+void DisassembleVmObject (const VmObject* object, FILE* out);
+
+#endif
@@ -0,0 +1,1119 @@
+#include "x86_codegen.h"
+#include "type_checking.h"
+#include "pass_trace.h"
+#include "monotonic_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// GNU as  intel-:    cc,   printf
+static const int MAX_OPERAND_LENGTH = 64;
+static const int MAX_COMMAND_LENGTH = 512;
+
+static const char* const X86_ARG_GPR64[] = {"rdi", "rsi", "rdx", "rcx", "r8", "r9"};
+static const char* const X86_ARG_GPR32[] = {"edi", "esi", "edx", "ecx", "r8d", "r9d"};
+
+X86Context* CtorX86CodeGen (FILE* output)
+{
+    X86Context* ctx = (X86Context*) calloc (1, sizeof(X86Context));
+    if (!ctx) return NULL;
+
+    ctx->output = output;
+    ctx->return_label = -1;
+    ctx->entry_label = -1;
+    ctx->current_func = -1;
+
+    return ctx;
+}
+
+static void FreeNames (char** names, int count)
+{
+    for (int i = 0; i < count; i++)
+        free (names[i]);
+
+    free (names);
+}
+
+void DtorX86CodeGen (X86Context* ctx)
+{
+    if (!ctx) return;
+
+    for (int i = 0; i < ctx->local_count; i++)
+        free (ctx->locals[i].name);
+
+    free (ctx->locals);
+    FreeNames (ctx->globals, ctx->global_count);
+    free (ctx->global_types);
+    FreeNames (ctx->funcs, ctx->func_count);
+    free (ctx->func_params);
+    free (ctx->func_decls);
+    free (ctx->constants);
+
+    if (ctx->output && ctx->output != stdout && ctx->output != stderr)
+        fclose (ctx->output);
+
+    free (ctx);
+}
+
+static int NewX86Label (X86Context* ctx)
+{
+    TRACE_COUNT (COUNTER_LABELS, 1);
+    return ctx->label_counter++;
+}
+
+static int AppendName (char*** names, int* count, int* capacity, const char* name)
+{
+    for (int i = 0; i < *count; i++)
+    {
+        if (strcmp ((*names)[i], name) == 0)
+            return i;
+    }
+
+    if (*count >= *capacity)
+    {
+        int new_capacity = *capacity ? *capacity * 2 : 8;
+        char** new_names = (char**) realloc (*names, new_capacity * sizeof(char*));
+        if (!new_names) return -1;
+        *names = new_names;
+        *capacity = new_capacity;
+    }
+
+    (*names)[*count] = strdup (name);
+    return (*count)++;
+}
+
+static int FindX86Function (X86Context* ctx, const char* name)
+{
+    for (int i = 0; i < ctx->func_count; i++)
+    {
+        if (strcmp (ctx->funcs[i], name) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+static int AddConstant (X86Context* ctx, double value)
+{
+    for (int i = 0; i < ctx->constant_count; i++)
+    {
+        if (memcmp (&ctx->constants[i], &value, sizeof(double)) == 0)
+            return i;
+    }
+
+    if (ctx->constant_count >= ctx->constant_capacity)
+    {
+        int new_capacity = ctx->constant_capacity ? ctx->constant_capacity * 2 : 16;
+        double* new_constants = (double*) realloc (ctx->constants, new_capacity * sizeof(double));
+        if (!new_constants) return -1;
+        ctx->constants = new_constants;
+        ctx->constant_capacity = new_capacity;
+    }
+
+    ctx->constants[ctx->constant_count] = value;
+    return ctx->constant_count++;
+}
+
+static X86Local* FindLocal (X86Context* ctx, const char* name)
+{
+    for (int i = 0; i < ctx->local_count; i++)
+    {
+        if (strcmp (ctx->locals[i].name, name) == 0)
+            return &ctx->locals[i];
+    }
+
+    return NULL;
+}
+
+static void AddLocal (X86Context* ctx, const char* name, NodeType type)
+{
+    if (FindLocal (ctx, name)) return;
+
+    if (ctx->local_count >= ctx->local_capacity)
+    {
+        int new_capacity = ctx->local_capacity ? ctx->local_capacity * 2 : 8;
+        X86Local* new_locals = (X86Local*) realloc (ctx->locals, new_capacity * sizeof(X86Local));
+        if (!new_locals) return;
+        ctx->locals = new_locals;
+        ctx->local_capacity = new_capacity;
+    }
+
+    ctx->locals[ctx->local_count].name = strdup (name);
+    ctx->locals[ctx->local_count].offset = -(ctx->local_count + 1) * X86_SLOT_SIZE;
+    ctx->locals[ctx->local_count].type = DeclaredType (type);
+    ctx->local_count++;
+}
+
+static void ResetLocals (X86Context* ctx)
+{
+    for (int i = 0; i < ctx->local_count; i++)
+        free (ctx->locals[i].name);
+
+    ctx->local_count = 0;
+}
+
+static void CollectLocals (X86Context* ctx, Node* node)
+{
+    if (!node) return;
+
+    if (node->type == NODE_VAR_DECL)
+        AddLocal (ctx, node->data.string_value, node->data.type_value);
+
+    if (node->type == NODE_FUNC_DECL) return;
+
+    CollectLocals (ctx, node->left);
+    CollectLocals (ctx, node->right);
+}
+
+//  ;    ,   - double
+static int AddGlobal (X86Context* ctx, const char* name, NodeType type)
+{
+    int count = ctx->global_count;
+    int index = AppendName (&ctx->globals, &ctx->global_count, &ctx->global_capacity, name);
+    if (index < 0 || ctx->global_count == count) return index;
+
+    NodeType* new_types = (NodeType*) realloc (ctx->global_types, ctx->global_capacity * sizeof(NodeType));
+    if (!new_types) return index;
+    ctx->global_types = new_types;
+    ctx->global_types[index] = DeclaredType (type);
+
+    return index;
+}
+
+static void CollectGlobals (X86Context* ctx, Node* node)
+{
+    if (!node || node->type == NODE_FUNC_DECL) return;
+
+    if (node->type == NODE_VAR_DECL)
+        AddGlobal (ctx, node->data.string_value, node->data.type_value);
+
+    CollectGlobals (ctx, node->left);
+    CollectGlobals (ctx, node->right);
+}
+
+static NodeType StorageType (X86Context* ctx, const char* name)
+{
+    X86Local* local = FindLocal (ctx, name);
+    if (local) return local->type;
+
+    for (int i = 0; i < ctx->global_count; i++)
+    {
+        if (strcmp (ctx->globals[i], name) == 0)
+            return ctx->global_types[i];
+    }
+
+    return NODE_TYPE_DOUBLE;
+}
+
+static void CollectFunctions (X86Context* ctx, Node* node)
+{
+    if (!node) return;
+
+    if (node->type == NODE_FUNC_DECL)
+    {
+        int func = AppendName (&ctx->funcs, &ctx->func_count, &ctx->func_capacity, node->data.string_value);
+        if (func < 0) return;
+
+        int* new_params = (int*) realloc (ctx->func_params, ctx->func_capacity * sizeof(int));
+        if (!new_params) return;
+        ctx->func_params = new_params;
+        ctx->func_params[func] = CountParameters (node);
+
+        Node** new_decls = (Node**) realloc (ctx->func_decls, ctx->func_capacity * sizeof(Node*));
+        if (!new_decls) return;
+        ctx->func_decls = new_decls;
+        ctx->func_decls[func] = node;
+        return;
+    }
+
+    if (node->type == NODE_SEQUENCE)
+    {
+        CollectFunctions (ctx, node->left);
+        CollectFunctions (ctx, node->right);
+    }
+}
+
+//  GenX86Expression  :   char -  eax (char 
+//  int), double -  xmm0.   int 0/1
+static NodeType X86ValueType (X86Context* ctx, Node* node)
+{
+    if (!node) return NODE_TYPE_INT;
+
+    switch (node->type)
+    {
+        case NODE_VARIABLE:
+            return StorageType (ctx, node->data.string_value);
+
+        case NODE_NUMBER:
+        case NODE_ADD:
+        case NODE_SUB:
+        case NODE_MUL:
+        case NODE_DIV:
+            return ExpressionType (node);
+
+        case NODE_FUNC_CALL:
+        {
+            int func = FindX86Function (ctx, node->data.string_value);
+            return func >= 0 && ctx->func_decls[func] ? DeclaredType (ctx->func_decls[func]->data.type_value) : NODE_TYPE_INT;
+        }
+
+        default:
+            return NODE_TYPE_INT;
+    }
+}
+
+//      type:   /.bss,   -
+//  , double -  .rodata. 0 -    
+static int LeafOperand (X86Context* ctx, Node* node, NodeType type, char* operand, size_t size)
+{
+    int integer = IsIntegerType (DeclaredType (type));
+
+    if (node->type == NODE_NUMBER)
+    {
+        if (!integer)
+        {
+            int index = AddConstant (ctx, node->data.number_value);
+            snprintf (operand, size, "qword ptr [rip + .LC%d]", index);
+            return 1;
+        }
+
+        if (!IsIntegerType (ExpressionType (node))) return 0;
+
+        snprintf (operand, size, "%d", (int) ConvertValue (node->data.number_value, NODE_TYPE_INT));
+        return 1;
+    }
+
+    if (node->type == NODE_VARIABLE)
+    {
+        if (integer != IsIntegerType (StorageType (ctx, node->data.string_value))) return 0;
+
+        //   char    4  
+        const char* width = integer ? "dword ptr" : "qword ptr";
+
+        X86Local* local = FindLocal (ctx, node->data.string_value);
+        if (local)
+        {
+            snprintf (operand, size, "%s [rbp - %d]", width, -local->offset);
+            return 1;
+        }
+
+        int index = AddGlobal (ctx, node->data.string_value, NODE_TYPE_DOUBLE);
+        snprintf (operand, size, "%s [rip + glob_%d]", width, index);
+        return 1;
+    }
+
+    return 0;
+}
+
+static void GenX86Load (X86Context* ctx, NodeType type, const char* operand)
+{
+    if (IsIntegerType (type))
+        fprintf (ctx->output, "    mov eax, %s\n", operand);
+    else
+        fprintf (ctx->output, "    movsd xmm0, %s\n", operand);
+}
+
+static void GenX86Zero (X86Context* ctx, NodeType type)
+{
+    if (IsIntegerType (type))
+        fprintf (ctx->output, "    xor eax, eax\n");
+    else
+        fprintf (ctx->output, "    xorpd xmm0, xmm0\n");
+}
+
+static void PushValue (X86Context* ctx, NodeType type)
+{
+    if (IsIntegerType (type))
+        fprintf (ctx->output, "    push rax\n");
+    else
+    {
+        fprintf (ctx->output, "    sub rsp, %d\n", X86_SLOT_SIZE);
+        fprintf (ctx->output, "    movsd qword ptr [rsp], xmm0\n");
+    }
+
+    ctx->stack_depth++;
+}
+
+static void PopValue (X86Context* ctx, NodeType type)
+{
+    if (IsIntegerType (type))
+        fprintf (ctx->output, "    pop rax\n");
+    else
+    {
+        fprintf (ctx->output, "    movsd xmm0, qword ptr [rsp]\n");
+        fprintf (ctx->output, "    add rsp, %d\n", X86_SLOT_SIZE);
+    }
+
+    ctx->stack_depth--;
+}
+
+//  eax  xmm0      .  
+//    ,  FTOI/ITOB  
+static void GenX86Convert (X86Context* ctx, NodeType from, NodeType to)
+{
+    from = DeclaredType (from);
+    to = DeclaredType (to);
+
+    if (from == to || (from == NODE_TYPE_CHAR && to == NODE_TYPE_INT))
+        return;
+
+    if (to == NODE_TYPE_DOUBLE)
+    {
+        fprintf (ctx->output, "    cvtsi2sd xmm0, eax\n");
+        return;
+    }
+
+    if (from == NODE_TYPE_DOUBLE)
+        fprintf (ctx->output, "    cvttsd2si rax, xmm0\n");
+    if (to == NODE_TYPE_CHAR)
+        fprintf (ctx->output, "    movsx eax, al\n");
+}
+
+static void GenX86Expression (X86Context* ctx, Node* node);
+
+static void GenX86Typed (X86Context* ctx, Node* node, NodeType type)
+{
+    char operand[MAX_OPERAND_LENGTH] = "";
+
+    if (LeafOperand (ctx, node, type, operand, sizeof(operand)))
+    {
+        GenX86Load (ctx, type, operand);
+        return;
+    }
+
+    GenX86Expression (ctx, node);
+    GenX86Convert (ctx, X86ValueType (ctx, node), type);
+}
+
+//  left  type  eax/xmm0, right -  ecx/xmm1    ;
+//     rhs
+static void GenX86Operands (X86Context* ctx, Node* node, NodeType type, char* rhs, size_t size)
+{
+    if (LeafOperand (ctx, node->right, type, rhs, size))
+    {
+        GenX86Typed (ctx, node->left, type);
+        return;
+    }
+
+    int integer = IsIntegerType (type);
+
+    GenX86Typed (ctx, node->left, type);
+    PushValue (ctx, type);
+    GenX86Typed (ctx, node->right, type);
+    fprintf (ctx->output, integer ? "    mov ecx, eax\n" : "    movapd xmm1, xmm0\n");
+    PopValue (ctx, type);
+
+    snprintf (rhs, size, integer ? "ecx" : "xmm1");
+}
+
+static const char* ArithmeticInstruction (NodeType type)
+{
+    switch (type)
+    {
+        case NODE_ADD: return "addsd";
+        case NODE_SUB: return "subsd";
+        case NODE_MUL: return "mulsd";
+        case NODE_DIV: return "divsd";
+        default:       return NULL;
+    }
+}
+
+// 32-   eax. INT_MIN / -1    (#DE),  VM
+//   INT_MIN:   -1 idiv   neg. 
+//   -  
+static void GenX86IntegerArithmetic (X86Context* ctx, Node* node, const char* rhs)
+{
+    switch (node->type)
+    {
+        case NODE_ADD: fprintf (ctx->output, "    add eax, %s\n", rhs); return;
+        case NODE_SUB: fprintf (ctx->output, "    sub eax, %s\n", rhs); return;
+        default:       break;
+    }
+
+    if (strcmp (rhs, "ecx") != 0)
+        fprintf (ctx->output, "    mov ecx, %s\n", rhs);
+
+    if (node->type == NODE_MUL)
+    {
+        fprintf (ctx->output, "    imul eax, ecx\n");
+        return;
+    }
+
+    Node* divisor = node->right;
+    if (divisor->type == NODE_NUMBER && ConvertValue (divisor->data.number_value, NODE_TYPE_INT) != -1)
+    {
+        fprintf (ctx->output, "    cdq\n");
+        fprintf (ctx->output, "    idiv ecx\n");
+        return;
+    }
+
+    int divide_label = NewX86Label (ctx);
+    int done_label = NewX86Label (ctx);
+
+    fprintf (ctx->output, "    cmp ecx, -1\n");
+    fprintf (ctx->output, "    jne .L%d\n", divide_label);
+    fprintf (ctx->output, "    neg eax\n");
+    fprintf (ctx->output, "    jmp .L%d\n", done_label);
+    fprintf (ctx->output, ".L%d:\n", divide_label);
+    fprintf (ctx->output, "    cdq\n");
+    fprintf (ctx->output, "    idiv ecx\n");
+    fprintf (ctx->output, ".L%d:\n", done_label);
+}
+
+//   cmp   g/l; ucomisd  CF/ZF 
+//  ,  a/b  double
+static const char* ConditionSuffix (NodeType type, int integer)
+{
+    switch (type)
+    {
+        case NODE_GT: return integer ? "g" : "a";
+        case NODE_LT: return integer ? "l" : "b";
+        case NODE_EQ: return "e";
+        case NODE_NE: return "ne";
+        default:      return NULL;
+    }
+}
+
+//  NaN ucomisd  ZF, PF  CF : e  b  , ne .
+//    PF -  EQ/LT    PF,  NE 
+static void GenX86UnorderedFixup (X86Context* ctx, NodeType type)
+{
+    if (type == NODE_EQ || type == NODE_LT)
+    {
+        fprintf (ctx->output, "    setnp cl\n");
+        fprintf (ctx->output, "    and al, cl\n");
+    }
+    else if (type == NODE_NE)
+    {
+        fprintf (ctx->output, "    setp cl\n");
+        fprintf (ctx->output, "    or al, cl\n");
+    }
+}
+
+static const char* InverseConditionSuffix (NodeType type, int integer)
+{
+    switch (type)
+    {
+        case NODE_GT: return integer ? "le" : "be";
+        case NODE_LT: return integer ? "ge" : "ae";
+        case NODE_EQ: return "ne";
+        case NODE_NE: return "e";
+        default:      return NULL;
+    }
+}
+
+//      : cmp  , ucomisd  double
+static NodeType CompareType (X86Context* ctx, Node* node)
+{
+    return CommonType (X86ValueType (ctx, node->left), X86ValueType (ctx, node->right));
+}
+
+//  index  System V:     ( - rdi..r9,
+// double - xmm0..xmm7)  -1,  stack_slot -  8-   
+static int ParamRegister (Node* decl, int index, int* stack_slot)
+{
+    int gprs = 0;
+    int xmms = 0;
+    int slots = 0;
+    Node* param = decl ? decl->left : NULL;
+
+    for (int i = 0; param; param = param->right, i++)
+    {
+        int reg = -1;
+        if (IsIntegerType (DeclaredType (param->data.type_value)))
+            reg = gprs < X86_ARG_GPR_COUNT ? gprs++ : -1;
+        else
+            reg = xmms < X86_ARG_XMM_COUNT ? xmms++ : -1;
+
+        if (i == index)
+        {
+            *stack_slot = slots;
+            return reg;
+        }
+
+        if (reg < 0) slots++;
+    }
+
+    *stack_slot = slots;
+    return -1;
+}
+
+//         
+static int StackArgCount (Node* decl)
+{
+    int slots = 0;
+    ParamRegister (decl, CountParameters (decl), &slots);
+    return slots;
+}
+
+//    .    ,
+//    -  [rsp];        
+//    ,  
+static void GenX86Arguments (X86Context* ctx, Node* call, int func)
+{
+    Node* decl = ctx->func_decls[func];
+    int param_count = ctx->func_params[func];
+    int stack_args = StackArgCount (decl);
+    int pushed = 0;
+
+    if (stack_args > 0)
+    {
+        fprintf (ctx->output, "    sub rsp, %d\n", stack_args * X86_SLOT_SIZE);
+        ctx->stack_depth += stack_args;
+    }
+
+    for (int i = param_count - 1; i >= 0; i--)
+    {
+        NodeType type = DeclaredType (NthParameter (decl, i)->data.type_value);
+
+        Node* arg = NthArgument (call, i);
+        if (arg)
+            GenX86Typed (ctx, arg, type);
+        else
+            GenX86Zero (ctx, type);
+
+        int slot = 0;
+        if (ParamRegister (decl, i, &slot) >= 0)
+        {
+            PushValue (ctx, type);
+            pushed++;
+            continue;
+        }
+
+        int offset = (pushed + slot) * X86_SLOT_SIZE;
+        if (IsIntegerType (type))
+            fprintf (ctx->output, "    mov dword ptr [rsp + %d], eax\n", offset);
+        else
+            fprintf (ctx->output, "    movsd qword ptr [rsp + %d], xmm0\n", offset);
+    }
+
+    for (int i = 0; i < param_count; i++)
+    {
+        int slot = 0;
+        int reg = ParamRegister (decl, i, &slot);
+        if (reg < 0) continue;
+
+        if (IsIntegerType (DeclaredType (NthParameter (decl, i)->data.type_value)))
+            fprintf (ctx->output, "    pop %s\n", X86_ARG_GPR64[reg]);
+        else
+        {
+            fprintf (ctx->output, "    movsd xmm%d, qword ptr [rsp]\n", reg);
+            fprintf (ctx->output, "    add rsp, %d\n", X86_SLOT_SIZE);
+        }
+        ctx->stack_depth--;
+    }
+}
+
+static void GenX86Call (X86Context* ctx, Node* node)
+{
+    int func = FindX86Function (ctx, node->data.string_value);
+    if (func < 0)
+    {
+        fprintf (ctx->output, "    # :  '%s'  \n", node->data.string_value);
+        GenX86Zero (ctx, NODE_TYPE_INT);
+        return;
+    }
+
+    int stack_args = StackArgCount (ctx->func_decls[func]);
+
+    //  call      
+    int misaligned = (ctx->stack_depth + stack_args) % 2;
+    if (misaligned)
+    {
+        fprintf (ctx->output, "    sub rsp, %d\n", X86_SLOT_SIZE);
+        ctx->stack_depth++;
+    }
+
+    GenX86Arguments (ctx, node, func);
+
+    fprintf (ctx->output, "    call func_%d\n", func);
+
+    int cleanup = stack_args + misaligned;
+    if (cleanup > 0)
+        fprintf (ctx->output, "    add rsp, %d\n", cleanup * X86_SLOT_SIZE);
+
+    ctx->stack_depth -= cleanup;
+}
+
+static void GenX86Expression (X86Context* ctx, Node* node)
+{
+    if (!node) return;
+
+    char operand[MAX_OPERAND_LENGTH] = "";
+    NodeType type = X86ValueType (ctx, node);
+
+    if (LeafOperand (ctx, node, type, operand, sizeof(operand)))
+    {
+        GenX86Load (ctx, type, operand);
+        return;
+    }
+
+    const char* arithmetic = ArithmeticInstruction (node->type);
+    if (arithmetic)
+    {
+        GenX86Operands (ctx, node, type, operand, sizeof(operand));
+        if (IsIntegerType (type))
+            GenX86IntegerArithmetic (ctx, node, operand);
+        else
+            fprintf (ctx->output, "    %s xmm0, %s\n", arithmetic, operand);
+        return;
+    }
+
+    NodeType compare_type = ConditionSuffix (node->type, 0) ? CompareType (ctx, node) : NODE_TYPE_INT;
+    const char* condition = ConditionSuffix (node->type, IsIntegerType (compare_type));
+    if (condition)
+    {
+        GenX86Operands (ctx, node, compare_type, operand, sizeof(operand));
+
+        if (IsIntegerType (compare_type))
+        {
+            fprintf (ctx->output, "    cmp eax, %s\n", operand);
+            fprintf (ctx->output, "    set%s al\n", condition);
+        }
+        else
+        {
+            fprintf (ctx->output, "    ucomisd xmm0, %s\n", operand);
+            fprintf (ctx->output, "    set%s al\n", condition);
+            GenX86UnorderedFixup (ctx, node->type);
+        }
+
+        fprintf (ctx->output, "    movzx eax, al\n");
+        return;
+    }
+
+    if (node->type == NODE_FUNC_CALL)
+    {
+        GenX86Call (ctx, node);
+        return;
+    }
+
+    fprintf (ctx->output, "    #   : %d\n", node->type);
+    GenX86Zero (ctx, type);
+}
+
+static void GenX86CondJump (X86Context* ctx, Node* cond, int false_label)
+{
+    char operand[MAX_OPERAND_LENGTH] = "";
+
+    if (InverseConditionSuffix (cond->type, 0))
+    {
+        NodeType compare_type = CompareType (ctx, cond);
+        int integer = IsIntegerType (compare_type);
+        const char* jump = InverseConditionSuffix (cond->type, integer);
+
+        GenX86Operands (ctx, cond, compare_type, operand, sizeof(operand));
+
+        if (integer)
+        {
+            fprintf (ctx->output, "    cmp eax, %s\n", operand);
+            fprintf (ctx->output, "    j%s .L%d\n", jump, false_label);
+            return;
+        }
+
+        fprintf (ctx->output, "    ucomisd xmm0, %s\n", operand);
+
+        //  (PF=1): NE ,  
+        if (cond->type == NODE_NE)
+        {
+            int true_label = NewX86Label (ctx);
+            fprintf (ctx->output, "    jp .L%d\n", true_label);
+            fprintf (ctx->output, "    j%s .L%d\n", jump, false_label);
+            fprintf (ctx->output, ".L%d:\n", true_label);
+            return;
+        }
+
+        fprintf (ctx->output, "    jp .L%d\n", false_label);
+        fprintf (ctx->output, "    j%s .L%d\n", jump, false_label);
+        return;
+    }
+
+    GenX86Expression (ctx, cond);
+
+    if (IsIntegerType (X86ValueType (ctx, cond)))
+    {
+        fprintf (ctx->output, "    test eax, eax\n");
+        fprintf (ctx->output, "    je .L%d\n", false_label);
+        return;
+    }
+
+    fprintf (ctx->output, "    xorpd xmm1, xmm1\n");
+    fprintf (ctx->output, "    ucomisd xmm0, xmm1\n");
+    fprintf (ctx->output, "    je .L%d\n", false_label);
+}
+
+static void GenX86Store (X86Context* ctx, const char* name, NodeType type)
+{
+    NodeType storage = StorageType (ctx, name);
+    GenX86Convert (ctx, type, storage);
+
+    Node variable = {};
+    variable.type = NODE_VARIABLE;
+    variable.data.string_value = (char*) name;
+
+    char operand[MAX_OPERAND_LENGTH] = "";
+    LeafOperand (ctx, &variable, storage, operand, sizeof(operand));
+
+    if (IsIntegerType (storage))
+        fprintf (ctx->output, "    mov %s, eax\n", operand);
+    else
+        fprintf (ctx->output, "    movsd %s, xmm0\n", operand);
+}
+
+//    :  -   ,
+//   -  leave,  ret    .
+//        [rbp + 16 + 8k];
+//     :       .
+//      ,      .
+static int GenX86TailCall (X86Context* ctx, Node* call)
+{
+    if (!call || call->type != NODE_FUNC_CALL || ctx->stack_depth != 0) return 0;
+    if (ExpressionType (call) != ctx->return_type) return 0;
+
+    int func = FindX86Function (ctx, call->data.string_value);
+    if (func < 0) return 0;
+
+    int stack_args = StackArgCount (ctx->func_decls[func]);
+    if (stack_args > 0 && func != ctx->current_func) return 0;
+
+    GenX86Arguments (ctx, call, func);
+
+    if (func == ctx->current_func)
+    {
+        // rax   ;   , int  double 
+        for (int slot = 0; slot < stack_args; slot++)
+        {
+            fprintf (ctx->output, "    mov rax, qword ptr [rsp + %d]\n", slot * X86_SLOT_SIZE);
+            fprintf (ctx->output, "    mov qword ptr [rbp + %d], rax\n",
+                     X86_STACK_ARGS_OFFSET + slot * X86_SLOT_SIZE);
+        }
+
+        if (stack_args > 0)
+        {
+            fprintf (ctx->output, "    add rsp, %d\n", stack_args * X86_SLOT_SIZE);
+            ctx->stack_depth -= stack_args;
+        }
+
+        fprintf (ctx->output, "    jmp .L%d    #   \n", ctx->entry_label);
+        return 1;
+    }
+
+    fprintf (ctx->output, "    leave\n");
+    fprintf (ctx->output, "    jmp func_%d    #  \n", func);
+    return 1;
+}
+
+static void GenX86Statement (X86Context* ctx, Node* node)
+{
+    if (!node) return;
+
+    switch (node->type)
+    {
+        case NODE_SEQUENCE:
+            GenX86Statement (ctx, node->left);
+            GenX86Statement (ctx, node->right);
+            break;
+
+        case NODE_ASSIGNMENT:
+            if (node->left && node->left->type == NODE_VARIABLE)
+            {
+                NodeType storage = StorageType (ctx, node->left->data.string_value);
+                GenX86Typed (ctx, node->right, storage);
+                GenX86Store (ctx, node->left->data.string_value, storage);
+            }
+            else
+                GenX86Expression (ctx, node->right);
+            break;
+
+        case NODE_VAR_DECL:
+            if (node->left)
+            {
+                NodeType storage = StorageType (ctx, node->data.string_value);
+                GenX86Typed (ctx, node->left, storage);
+                GenX86Store (ctx, node->data.string_value, storage);
+            }
+            break;
+
+        case NODE_IF:
+        {
+            int false_label = NewX86Label (ctx);
+
+            GenX86CondJump (ctx, node->left, false_label);
+            GenX86Statement (ctx, node->right);
+
+            fprintf (ctx->output, ".L%d:\n", false_label);
+            break;
+        }
+
+        case NODE_WHILE:
+        {
+            int start_label = NewX86Label (ctx);
+            int end_label = NewX86Label (ctx);
+
+            fprintf (ctx->output, ".L%d:\n", start_label);
+            GenX86CondJump (ctx, node->left, end_label);
+            GenX86Statement (ctx, node->right);
+
+            fprintf (ctx->output, "    jmp .L%d\n", start_label);
+            fprintf (ctx->output, ".L%d:\n", end_label);
+            break;
+        }
+
+        case NODE_RETURN:
+            if (GenX86TailCall (ctx, node->left))
+                break;
+
+            if (node->left)
+                GenX86Typed (ctx, node->left, ctx->return_type);
+            else
+                GenX86Zero (ctx, ctx->return_type);
+
+            fprintf (ctx->output, "    jmp .L%d\n", ctx->return_label);
+            break;
+
+        case NODE_FUNC_DECL:
+        case NODE_EMPTY:
+            break;
+
+        default:
+            GenX86Expression (ctx, node);
+            break;
+    }
+}
+
+// : push rbp,   [rbp - 8k],   16   call  
+static void GenX86Function (X86Context* ctx, int func, Node* decl, Node* body)
+{
+    ResetLocals (ctx);
+
+    Node* params = decl ? decl->left : NULL;
+    ctx->return_type = decl ? DeclaredType (decl->data.type_value) : NODE_TYPE_DOUBLE;
+
+    ctx->param_count = 0;
+    for (Node* param = params; param; param = param->right)
+    {
+        AddLocal (ctx, param->data.string_value, param->data.type_value);
+        ctx->param_count = ctx->local_count;
+    }
+
+    //    ,   GenVarDecl
+    if (decl)
+        CollectLocals (ctx, body);
+
+    int frame_size = ctx->local_count * X86_SLOT_SIZE;
+    frame_size = (frame_size + X86_STACK_ALIGN - 1) / X86_STACK_ALIGN * X86_STACK_ALIGN;
+
+    ctx->stack_depth = 0;
+    ctx->current_func = func;
+    ctx->return_label = NewX86Label (ctx);
+    ctx->entry_label = NewX86Label (ctx);
+
+    fprintf (ctx->output, "\n# ===  %s ===\n", ctx->funcs[func]);
+    fprintf (ctx->output, "func_%d:\n", func);
+    fprintf (ctx->output, "    push rbp\n");
+    fprintf (ctx->output, "    mov rbp, rsp\n");
+
+    if (frame_size > 0)
+        fprintf (ctx->output, "    sub rsp, %d\n", frame_size);
+
+    fprintf (ctx->output, ".L%d:\n", ctx->entry_label);
+
+    //          
+    for (int i = 0; i < ctx->param_count; i++)
+    {
+        X86Local* local = &ctx->locals[i];
+        int integer = IsIntegerType (local->type);
+        int slot = 0;
+        int reg = ParamRegister (decl, i, &slot);
+
+        if (reg >= 0 && integer)
+        {
+            fprintf (ctx->output, "    mov dword ptr [rbp - %d], %s    # %s\n",
+                     -local->offset, X86_ARG_GPR32[reg], local->name);
+            continue;
+        }
+
+        if (reg >= 0)
+        {
+            fprintf (ctx->output, "    movsd qword ptr [rbp - %d], xmm%d    # %s\n",
+                     -local->offset, reg, local->name);
+            continue;
+        }
+
+        char operand[MAX_OPERAND_LENGTH] = "";
+        snprintf (operand, sizeof(operand), "%s [rbp + %d]", integer ? "dword ptr" : "qword ptr",
+                  X86_STACK_ARGS_OFFSET + slot * X86_SLOT_SIZE);
+        GenX86Load (ctx, local->type, operand);
+
+        if (integer)
+            fprintf (ctx->output, "    mov dword ptr [rbp - %d], eax    # %s\n", -local->offset, local->name);
+        else
+            fprintf (ctx->output, "    movsd qword ptr [rbp - %d], xmm0    # %s\n", -local->offset, local->name);
+    }
+
+    //      ,   
+    for (int i = ctx->param_count; i < ctx->local_count; i++)
+        fprintf (ctx->output, "    mov qword ptr [rbp - %d], 0    # %s\n",
+                 -ctx->locals[i].offset, ctx->locals[i].name);
+
+    GenX86Statement (ctx, body);
+
+    GenX86Zero (ctx, ctx->return_type);
+    fprintf (ctx->output, ".L%d:\n", ctx->return_label);
+    fprintf (ctx->output, "    leave\n");
+    fprintf (ctx->output, "    ret\n");
+}
+
+static void GenX86Functions (X86Context* ctx, Node* node)
+{
+    if (!node) return;
+
+    if (node->type == NODE_FUNC_DECL)
+    {
+        TRACE_BEGIN ("", "function", node->data.string_value);
+        TraceCapture capture = {};
+        ctx->output = BeginTraceCapture (&capture, ctx->output);
+        GenX86Function (ctx, FindX86Function (ctx, node->data.string_value), node, node->right);
+        ctx->output = EndTraceCapture (&capture);
+        TRACE_END ();
+        return;
+    }
+
+    if (node->type == NODE_SEQUENCE)
+    {
+        GenX86Functions (ctx, node->left);
+        GenX86Functions (ctx, node->right);
+    }
+}
+
+static void GenX86Data (X86Context* ctx)
+{
+    fprintf (ctx->output, "\n    .section .rodata\n");
+    fprintf (ctx->output, ".Lout_format:\n");
+    fprintf (ctx->output, "    .string \"%%g\\n\"\n");
+    fprintf (ctx->output, ".Liout_format:\n");
+    fprintf (ctx->output, "    .string \"%%d\\n\"\n");
+    fprintf (ctx->output, "    .align 8\n");
+
+    for (int i = 0; i < ctx->constant_count; i++)
+    {
+        unsigned long long bits = 0;
+        memcpy (&bits, &ctx->constants[i], sizeof(bits));
+        fprintf (ctx->output, ".LC%d:\n", i);
+        fprintf (ctx->output, "    .quad 0x%llx    # %g\n", bits, ctx->constants[i]);
+    }
+
+    if (ctx->global_count > 0)
+    {
+        fprintf (ctx->output, "\n    .bss\n");
+        fprintf (ctx->output, "    .align 8\n");
+
+        for (int i = 0; i < ctx->global_count; i++)
+        {
+            fprintf (ctx->output, "glob_%d:    # %s\n", i, ctx->globals[i]);
+            fprintf (ctx->output, "    .zero %d\n", X86_SLOT_SIZE);
+        }
+    }
+
+    fprintf (ctx->output, "\n    .section .note.GNU-stack,\"\",@progbits\n");
+}
+
+//    : CALL :func_0 / OUT / HLT
+void GenerateX86Program (X86Context* ctx, Node* root)
+{
+    if (!ctx || !ctx->output || !root) return;
+
+    CollectFunctions (ctx, root);
+    CollectGlobals (ctx, root);
+
+    fprintf (ctx->output, "    .intel_syntax noprefix\n");
+    fprintf (ctx->output, "    .text\n");
+    fprintf (ctx->output, "    .globl main\n");
+    fprintf (ctx->output, "main:\n");
+    fprintf (ctx->output, "    push rbp\n");
+    fprintf (ctx->output, "    mov rbp, rsp\n");
+
+    int has_function = FirstFunction (root) != NULL;
+
+    if (has_function)
+    {
+        //     :   
+        Node* decl = ctx->func_decls[0];
+        int param_count = ctx->func_params[0];
+        int stack_slots = StackArgCount (decl);
+        stack_slots += stack_slots % 2;
+
+        for (int i = 0; i < param_count; i++)
+        {
+            int slot = 0;
+            int reg = ParamRegister (decl, i, &slot);
+            if (reg < 0) continue;
+
+            if (IsIntegerType (DeclaredType (NthParameter (decl, i)->data.type_value)))
+                fprintf (ctx->output, "    xor %s, %s\n", X86_ARG_GPR32[reg], X86_ARG_GPR32[reg]);
+            else
+                fprintf (ctx->output, "    xorpd xmm%d, xmm%d\n", reg, reg);
+        }
+
+        for (int i = 0; i < stack_slots; i++)
+            fprintf (ctx->output, "    push 0\n");
+
+        fprintf (ctx->output, "    call func_0\n");
+
+        if (stack_slots > 0)
+            fprintf (ctx->output, "    add rsp, %d\n", stack_slots * X86_SLOT_SIZE);
+
+        //  IOUT/OUT:    
+        if (IsIntegerType (DeclaredType (decl->data.type_value)))
+        {
+            fprintf (ctx->output, "    mov esi, eax\n");
+            fprintf (ctx->output, "    lea rdi, [rip + .Liout_format]\n");
+            fprintf (ctx->output, "    xor eax, eax\n");
+        }
+        else
+        {
+            fprintf (ctx->output, "    lea rdi, [rip + .Lout_format]\n");
+            fprintf (ctx->output, "    mov eax, 1\n");
+        }
+        fprintf (ctx->output, "    call printf@PLT\n");
+    }
+    else
+    {
+        int top_level = AppendName (&ctx->funcs, &ctx->func_count, &ctx->func_capacity, "");
+        fprintf (ctx->output, "    call func_%d\n", top_level);
+    }
+
+    fprintf (ctx->output, "    xor eax, eax\n");
+    fprintf (ctx->output, "    pop rbp\n");
+    fprintf (ctx->output, "    ret\n");
+
+    GenX86Functions (ctx, root);
+
+    if (!has_function)
+        GenX86Function (ctx, ctx->func_count - 1, NULL, root);
+
+    GenX86Data (ctx);
+}
+
+int BuildNativeExecutable (const char* asm_filename, const char* exe_filename, FILE* report)
+{
+    char command[MAX_COMMAND_LENGTH] = "";
+    snprintf (command, sizeof(command), "cc %s -o %s", asm_filename, exe_filename);
+
+    int result = system (command);
+    if (result != 0)
+    {
+        fprintf (report, "  %s\n", exe_filename);
+        return 0;
+    }
+
+    return 1;
+}
+
+//    : clock()    
+double RunNativeExecutable (const char* exe_filename)
+{
+    double start = NowMs ();
+    system (exe_filename);
+
+    return (NowMs () - start) / 1000;
+}
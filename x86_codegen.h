@@ -0,0 +1,60 @@
+#ifndef X86_CODEGEN_H
+#define X86_CODEGEN_H
+
+#include "tree_base.h"
+#include <stdio.h>
+
+typedef struct
+{
+    char* name;
+    int offset;         //   rbp
+    NodeType type;      //  :   char - dword    
+} X86Local;
+
+typedef struct
+{
+    FILE* output;
+    int label_counter;
+
+    X86Local* locals;
+    int local_count;
+    int local_capacity;
+
+    char** globals;
+    NodeType* global_types; //  globals
+    int global_count;
+    int global_capacity;
+
+    double* constants;
+    int constant_count;
+    int constant_capacity;
+
+    char** funcs;
+    int* func_params;   //  ,  funcs
+    Node** func_decls;  // ,  funcs; NULL    
+    int func_count;
+    int func_capacity;
+
+    int stack_depth;    // 8-    
+    int return_label;
+    int entry_label;    //  :     
+    int current_func;
+    NodeType return_type;   //    
+    int param_count;    //  local_count   - 
+} X86Context;
+
+const int X86_SLOT_SIZE = 8;
+const int X86_STACK_ALIGN = 16;
+const int X86_ARG_GPR_COUNT = 6;    // System V:   rdi, rsi, rdx, rcx, r8, r9
+const int X86_ARG_XMM_COUNT = 8;    // double  xmm0-xmm7,    
+const int X86_STACK_ARGS_OFFSET = 16;   // [rbp + 16]:   rbp   
+
+X86Context* CtorX86CodeGen (FILE* output);
+void DtorX86CodeGen (X86Context* ctx);
+
+void GenerateX86Program (X86Context* ctx, Node* root);
+//   cc;  report -  ,    
+int BuildNativeExecutable (const char* asm_filename, const char* exe_filename, FILE* report);
+double RunNativeExecutable (const char* exe_filename);
+
+#endif